@@ -60,7 +60,8 @@ SensorsHidlInterface::~SensorsHidlInterface(void)
  */
 Return<void> SensorsHidlInterface::getSensorsList(getSensorsList_cb _hidl_cb)
 {
-    const std::vector<stm::core::STMSensor> &list = sensorsCore.getSensorsList().getList();
+    const stm::core::STMSensorsList currentList = sensorsCore.getSensorsList();
+    const std::vector<stm::core::STMSensor> &list = currentList.getList();
     hidl_vec<V1_0::SensorInfo> sensorsList;
     size_t n = 0, count = list.size();
 
@@ -167,8 +168,9 @@ SensorsHidlInterface::initialize(const MQDescriptorSync<Event>& eventQueueDescri
     }
 
     /* load must be called after sensor core initialization because needs sensor list */
-    propertiesManager.load(propertiesLoader, sensorsCore.getSensorsList());
-    addInfoMng = std::make_unique<AdditionalInfoManager>(sensorsCore.getSensorsList());
+    coreSensorsList = sensorsCore.getSensorsList();
+    propertiesManager.load(propertiesLoader, coreSensorsList);
+    addInfoMng = std::make_unique<AdditionalInfoManager>(coreSensorsList);
 
     mSensorProxyMngr.reset();
     mSensorProxyMngr.addChannel(frameworkChHandle);
@@ -471,12 +473,10 @@ SensorsHidlInterface::onNewSensorsData(const std::vector<ISTMSensorsCallbackData
             if (sensor->isOnChange()) {
                 eventsList.push_back(event);
             } else {
-                auto channelsHandles =
-                    mSensorProxyMngr.getValidPushChannels(sdata.getTimestamp(),
-                                                          sdata.getSensorHandle(),
-                                                          sensorCurrentPollrateNs[sdata.getSensorHandle()]);
-
-                for (auto &channel : channelsHandles) {
+                mSensorProxyMngr.forEachValidPushChannel(sdata.getTimestamp(),
+                                                         sdata.getSensorHandle(),
+                                                         sensorCurrentPollrateNs[sdata.getSensorHandle()],
+                                                         [&](int32_t channel) {
                     if (channel == frameworkChHandle) {
                         eventsList.push_back(event);
                     } else {
@@ -485,7 +485,7 @@ SensorsHidlInterface::onNewSensorsData(const std::vector<ISTMSensorsCallbackData
                             mDirectChannelBufferLock.unlock();
                         }
                     }
-                }
+                });
             }
         }
     }
@@ -718,7 +718,7 @@ int SensorsHidlInterface::updateSensorsRequests(int32_t sensorHandle,
  */
 const stm::core::STMSensor *SensorsHidlInterface::getSTMSensor(int32_t sensorHandle) const
 {
-    const std::vector<stm::core::STMSensor> &list = sensorsCore.getSensorsList().getList();
+    const std::vector<stm::core::STMSensor> &list = coreSensorsList.getList();
 
     for (const auto &sensor : list) {
         if ((int32_t)sensor.getHandle() == sensorHandle) {
@@ -171,6 +171,11 @@ private:
      */
     IConsole &console;
 
+    /**
+     * Sensors list of the core, copied at initialization
+     */
+    stm::core::STMSensorsList coreSensorsList;
+
     /**
      * Sensors additional info manager
      */
@@ -138,7 +138,8 @@ ScopedAStatus SensorsAidlInterface::flush(int32_t in_sensorHandle)
 
 ScopedAStatus SensorsAidlInterface::getSensorsList(std::vector<SensorInfo>* _aidl_return)
 {
-    const std::vector<stm::core::STMSensor> &list = sensorsCore.getSensorsList().getList();
+    const stm::core::STMSensorsList currentList = sensorsCore.getSensorsList();
+    const std::vector<stm::core::STMSensor> &list = currentList.getList();
     std::vector<SensorInfo> sensorsList;
     size_t n = 0, count = list.size();
 
@@ -188,8 +189,9 @@ ScopedAStatus SensorsAidlInterface::initialize(
     }
 
     /* load must be called after sensor core initialization because needs sensor list */
-    propertiesManager.load(propertiesLoader, sensorsCore.getSensorsList());
-    addInfoMng = std::make_unique<AdditionalInfoManager>(sensorsCore.getSensorsList());
+    coreSensorsList = sensorsCore.getSensorsList();
+    propertiesManager.load(propertiesLoader, coreSensorsList);
+    addInfoMng = std::make_unique<AdditionalInfoManager>(coreSensorsList);
 
     mSensorProxyMngr.reset();
     mSensorProxyMngr.addChannel(frameworkChHandle);
@@ -447,12 +449,10 @@ SensorsAidlInterface::onNewSensorsData(const std::vector<ISTMSensorsCallbackData
             if (sensor->isOnChange()) {
                 eventsList.push_back(event);
             } else {
-                auto channelsHandles =
-                    mSensorProxyMngr.getValidPushChannels(sdata.getTimestamp(),
-                                                          sdata.getSensorHandle(),
-                                                          sensorCurrentPollrateNs[sdata.getSensorHandle()]);
-
-                for (auto &channel : channelsHandles) {
+                mSensorProxyMngr.forEachValidPushChannel(sdata.getTimestamp(),
+                                                         sdata.getSensorHandle(),
+                                                         sensorCurrentPollrateNs[sdata.getSensorHandle()],
+                                                         [&](int32_t channel) {
                     if (channel == frameworkChHandle) {
                         eventsList.push_back(event);
                     } else {
@@ -461,7 +461,7 @@ SensorsAidlInterface::onNewSensorsData(const std::vector<ISTMSensorsCallbackData
                             mDirectChannelBufferLock.unlock();
                         }
                     }
-                }
+                });
             }
         }
     }
@@ -692,7 +692,7 @@ int SensorsAidlInterface::updateSensorsRequests(int32_t sensorHandle,
  */
 const stm::core::STMSensor *SensorsAidlInterface::getSTMSensor(int32_t sensorHandle) const
 {
-    const std::vector<stm::core::STMSensor> &list = sensorsCore.getSensorsList().getList();
+    const std::vector<stm::core::STMSensor> &list = coreSensorsList.getList();
 
     for (const auto &sensor : list) {
         if ((int32_t)sensor.getHandle() == sensorHandle) {
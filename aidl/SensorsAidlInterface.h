@@ -199,6 +199,11 @@ class SensorsAidlInterface : public BnSensors, public ISTMSensorsCallback {
      */
     IConsole &console;
 
+    /**
+     * Sensors list of the core, copied at initialization
+     */
+    stm::core::STMSensorsList coreSensorsList;
+
     /**
      * Sensors additional info manager
      */
@@ -85,6 +85,9 @@ int AndroidPropertiesLoader::readInt(SensorPropertyId property,
     case SensorPropertyId::MAX_RANGE:
         propName = "persist.vendor.stm.sensors.max-range.";
         break;
+    case SensorPropertyId::DECIMATION_FILTER:
+        propName = "persist.vendor.stm.sensors.decimation-filter.";
+        break;
     default:
         return 0;
     }
@@ -15,22 +15,54 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cerrno>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <IUtils.h>
 
 #include "SensorsDataProxyManager.h"
 
 stm::core::IUtils &utils = stm::core::IUtils::getInstance();
 
+SensorsDataProxyManager::SensorsDataProxyManager(void)
+    : mVersion(0),
+      mSwitchSequence(0),
+      mTable(new RoutingTable()),
+      mReaders(0)
+{
+}
+
+SensorsDataProxyManager::~SensorsDataProxyManager(void)
+{
+    for (auto &sensor : mSensorToChannel) {
+        for (auto &ch : sensor.second) {
+            delete ch.second.state;
+        }
+    }
+
+    delete mTable.load();
+}
+
 /**
  * reset: reset the status of the proxy manager
  */
 void SensorsDataProxyManager::reset(void)
 {
+    std::vector<RouteState *> retired;
+    std::lock_guard<std::mutex> lock(mConfigLock);
+
+    for (auto &sensor : mSensorToChannel) {
+        for (auto &ch : sensor.second) {
+            retired.push_back(ch.second.state);
+        }
+    }
+
     mSensorToChannel.clear();
     mChannelToSensor.clear();
+
+    publishTable(std::move(retired));
 }
 
 /**
@@ -41,6 +73,8 @@ void SensorsDataProxyManager::reset(void)
  */
 int SensorsDataProxyManager::addChannel(int32_t channelHandle)
 {
+    std::lock_guard<std::mutex> lock(mConfigLock);
+
     auto search_channel = mChannelToSensor.find(channelHandle);
     if (search_channel != mChannelToSensor.end()) {
         return -EADDRINUSE;
@@ -59,6 +93,8 @@ int SensorsDataProxyManager::addChannel(int32_t channelHandle)
  */
 int SensorsDataProxyManager::removeChannel(int32_t channelHandle)
 {
+    std::lock_guard<std::mutex> lock(mConfigLock);
+
     auto search_channel = mChannelToSensor.find(channelHandle);
     if (search_channel == mChannelToSensor.end()) {
         return 0;
@@ -83,6 +119,8 @@ int SensorsDataProxyManager::removeChannel(int32_t channelHandle)
 int SensorsDataProxyManager::registerSensorToChannel(int32_t sensorHandle,
                                                      int32_t channelHandle)
 {
+    std::lock_guard<std::mutex> lock(mConfigLock);
+
     auto search_channel = mChannelToSensor.find(channelHandle);
     if (search_channel == mChannelToSensor.end()) {
         return -EINVAL;
@@ -110,11 +148,16 @@ int SensorsDataProxyManager::registerSensorToChannel(int32_t sensorHandle,
 
     struct ProxyData pdata;
     pdata.pollrateNs = 0;
-    pdata.samplesCounter = 0;
+    pdata.state = new RouteState();
+    pdata.state->samplesCounter = 0;
+    pdata.state->pollrateNs = 0;
+    pdata.state->appliedSequence = 0;
 
     search_channel->second.insert(sensorHandle);
     search_sensor_2->second.insert(std::make_pair(channelHandle, std::move(pdata)));
 
+    publishTable();
+
     return 0;
 }
 
@@ -128,6 +171,8 @@ int SensorsDataProxyManager::registerSensorToChannel(int32_t sensorHandle,
 int SensorsDataProxyManager::unregisterSensorFromChannel(int32_t sensorHandle,
                                                          int32_t channelHandle)
 {
+    std::lock_guard<std::mutex> lock(mConfigLock);
+
     auto search_channel = mChannelToSensor.find(channelHandle);
     if (search_channel == mChannelToSensor.end()) {
         return -EINVAL;
@@ -139,7 +184,16 @@ int SensorsDataProxyManager::unregisterSensorFromChannel(int32_t sensorHandle,
     }
 
     search_channel->second.erase(sensorHandle);
-    search_sensor_2->second.erase(channelHandle);
+
+    auto search_channel_2 = search_sensor_2->second.find(channelHandle);
+    if (search_channel_2 == search_sensor_2->second.end()) {
+        return 0;
+    }
+
+    RouteState *state = search_channel_2->second.state;
+    search_sensor_2->second.erase(search_channel_2);
+
+    publishTable({ state });
 
     return 0;
 }
@@ -156,6 +210,8 @@ int SensorsDataProxyManager::configureSensorInChannel(int32_t sensorHandle,
                                                       int32_t channelHandle,
                                                       int64_t pollrateNs)
 {
+    std::lock_guard<std::mutex> lock(mConfigLock);
+
     auto search_sensor = mSensorToChannel.find(sensorHandle);
     if (search_sensor == mSensorToChannel.end()) {
         return -EINVAL;
@@ -167,10 +223,14 @@ int SensorsDataProxyManager::configureSensorInChannel(int32_t sensorHandle,
     }
 
     struct PollrateSwitchData switchData;
+    switchData.sequence = ++mSwitchSequence;
     switchData.timestampOfChange = utils.getTime();
     switchData.pollrateNs = pollrateNs;
 
-    search_channel->second.switchDataFifo.push_back(std::move(switchData));
+    search_channel->second.pollrateNs = pollrateNs;
+    search_channel->second.switchDataFifo.push_back(switchData);
+
+    publishTable();
 
     return 0;
 }
@@ -184,6 +244,7 @@ int SensorsDataProxyManager::configureSensorInChannel(int32_t sensorHandle,
 int64_t SensorsDataProxyManager::getMaxPollrateNs(int32_t sensorHandle) const
 {
     int64_t max = INT64_MAX;
+    std::lock_guard<std::mutex> lock(mConfigLock);
 
     auto search_sensor = mSensorToChannel.find(sensorHandle);
     if (search_sensor == mSensorToChannel.end()) {
@@ -191,15 +252,8 @@ int64_t SensorsDataProxyManager::getMaxPollrateNs(int32_t sensorHandle) const
     }
 
     for (auto &ch : search_sensor->second) {
-        const struct ProxyData &pdata = ch.second;
-        int64_t pollrateNs;
-
-        if (pdata.switchDataFifo.empty()) {
-            pollrateNs = pdata.pollrateNs;
-        } else {
-            const struct PollrateSwitchData &switchDataLast = pdata.switchDataFifo.back();
-            pollrateNs = switchDataLast.pollrateNs;
-        }
+        /* latest requested, pending switches included */
+        int64_t pollrateNs = ch.second.pollrateNs;
 
         if ((max > pollrateNs) && (pollrateNs > 0)) {
             max = pollrateNs;
@@ -218,6 +272,7 @@ int64_t SensorsDataProxyManager::getMaxPollrateNs(int32_t sensorHandle) const
 std::vector<int32_t> SensorsDataProxyManager::getChannels(int32_t sensorHandle) const
 {
     std::vector<int32_t> channelsHandles;
+    std::lock_guard<std::mutex> lock(mConfigLock);
 
     auto search_sensor = mSensorToChannel.find(sensorHandle);
     if (search_sensor == mSensorToChannel.end()) {
@@ -240,8 +295,13 @@ std::vector<int32_t> SensorsDataProxyManager::getChannels(int32_t sensorHandle)
 std::vector<int32_t> SensorsDataProxyManager::getRegisteredSensorsInChannel(int32_t channelHandle) const
 {
     std::vector<int32_t> sensorsHandles;
+    std::lock_guard<std::mutex> lock(mConfigLock);
 
     auto search_channel = mChannelToSensor.find(channelHandle);
+    if (search_channel == mChannelToSensor.end()) {
+        return sensorsHandles;
+    }
+
     for (auto &sh : search_channel->second) {
         sensorsHandles.push_back(sh);
     }
@@ -250,71 +310,115 @@ std::vector<int32_t> SensorsDataProxyManager::getRegisteredSensorsInChannel(int3
 }
 
 /**
- * getValidPushChannels: list if channels where the current sensor sample must be pushed to
+ * getValidPushChannels: list of channels where the current sensor sample must be pushed to
  * @timestamp: timestamp of current sensor sample.
  * @sensorHandle: sensor handle.
  * @pollrateNs: current pollrate of the sensor stream.
+ * @channelsHandles: caller provided array, filled with channels handles.
+ * @maxChannels: channelsHandles array size.
  *
- * Return value: list of channels handles.
+ * Return value: number of channels, only the first maxChannels are stored.
  */
-std::vector<int32_t> SensorsDataProxyManager::getValidPushChannels(int64_t timestamp,
-                                                                   int32_t sensorHandle,
-                                                                   int64_t pollrateNs)
+size_t SensorsDataProxyManager::getValidPushChannels(int64_t timestamp,
+                                                     int32_t sensorHandle,
+                                                     int64_t pollrateNs,
+                                                     int32_t *channelsHandles,
+                                                     size_t maxChannels)
 {
-    std::vector<int32_t> channelsHandles;
+    size_t count = 0;
 
-    auto search_sensor = mSensorToChannel.find(sensorHandle);
-    if (search_sensor == mSensorToChannel.end()) {
-        return channelsHandles;
-    }
+    forEachValidPushChannel(timestamp, sensorHandle, pollrateNs,
+                            [&](int32_t channelHandle) {
+                                if (count < maxChannels) {
+                                    channelsHandles[count] = channelHandle;
+                                }
+                                count++;
+                            });
 
-    for (auto &ch : search_sensor->second) {
-        struct ProxyData &pdata = ch.second;
-        int oldDivisor = calculateDecimator(pdata.pollrateNs, pollrateNs);
-
-        while (!pdata.switchDataFifo.empty()) {
-            struct PollrateSwitchData &switchData = pdata.switchDataFifo.front();
-            if (timestamp >= switchData.timestampOfChange) {
-                pdata.pollrateNs = switchData.pollrateNs;
-                pdata.switchDataFifo.pop_front();
-            } else {
-                break;
-            }
-        }
-
-        int divisor = calculateDecimator(pdata.pollrateNs, pollrateNs);
-        if (divisor) {
-            if (oldDivisor != divisor) {
-                pdata.samplesCounter = divisor - 1;
-            }
+    return count;
+}
 
-            if (++pdata.samplesCounter >= divisor) {
-                pdata.samplesCounter = 0;
-                channelsHandles.push_back(ch.first);
-            }
-        }
-    }
+/**
+ * getVersion: get the version of the routing table in use
+ *
+ * Return value: number of configuration changes published.
+ */
+uint64_t SensorsDataProxyManager::getVersion(void) const
+{
+    std::lock_guard<std::mutex> lock(mConfigLock);
 
-    return channelsHandles;
+    return mVersion;
 }
 
 /**
- * calculateDecimator: calculate decimator factor
- * @dividend: dividend.
- * @divisor: divisor.
- *
- * Return value: >= 1 if divisor is greater than 0. 0 if divisor is also 0.
+ * publishTable: build the routing table from the configuration and swap it
+ *               with the one in use, must be called with mConfigLock held
+ * @retired: routes states removed from the configuration, freed with the
+ *           old table.
  */
-int SensorsDataProxyManager::calculateDecimator(int64_t dividend, int64_t divisor) const
+void SensorsDataProxyManager::publishTable(std::vector<RouteState *> retired)
 {
-    if (!divisor) {
-        return 0;
+    RoutingTable *table = new RoutingTable();
+    std::vector<int32_t> sensorsHandles;
+    const RoutingTable *old;
+
+    table->version = ++mVersion;
+
+    for (auto &sensor : mSensorToChannel) {
+        if ((sensor.first >= 0) && !sensor.second.empty()) {
+            sensorsHandles.push_back(sensor.first);
+        }
+    }
+
+    std::sort(sensorsHandles.begin(), sensorsHandles.end());
+
+    if (!sensorsHandles.empty()) {
+        table->sensorRoutes.resize(sensorsHandles.back() + 2, 0);
+    }
+
+    for (auto sh : sensorsHandles) {
+        for (auto &ch : mSensorToChannel[sh]) {
+            struct ProxyData &pdata = ch.second;
+            uint64_t applied = pdata.state->appliedSequence.load(std::memory_order_acquire);
+            Route route;
+
+            /* drop switches already applied by the reader */
+            pdata.switchDataFifo.erase(std::remove_if(pdata.switchDataFifo.begin(),
+                                                      pdata.switchDataFifo.end(),
+                                                      [applied](const PollrateSwitchData &sw) {
+                                                          return sw.sequence <= applied;
+                                                      }),
+                                       pdata.switchDataFifo.end());
+
+            route.channelHandle = ch.first;
+            route.state = pdata.state;
+            route.firstSwitch = table->switches.size();
+            route.numSwitches = pdata.switchDataFifo.size();
+
+            table->switches.insert(table->switches.end(),
+                                   pdata.switchDataFifo.begin(),
+                                   pdata.switchDataFifo.end());
+            table->routes.push_back(route);
+        }
+
+        table->sensorRoutes[sh + 1] = table->routes.size();
+    }
+
+    /* sensors without routes start where the previous one ends */
+    for (size_t i = 1; i < table->sensorRoutes.size(); i++) {
+        table->sensorRoutes[i] = std::max(table->sensorRoutes[i], table->sensorRoutes[i - 1]);
     }
 
-    int quotient = dividend / divisor;
-    if (quotient < 1) {
-        quotient = 1;
+    old = mTable.exchange(table, std::memory_order_seq_cst);
+
+    /* readers entered after the exchange use the new table */
+    while (mReaders.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
     }
 
-    return quotient;
+    delete old;
+
+    for (auto state : retired) {
+        delete state;
+    }
 }
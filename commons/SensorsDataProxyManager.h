@@ -17,16 +17,31 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <vector>
-#include <list>
 #include <unordered_map>
 #include <unordered_set>
 
+/*
+ * Routing of sensor samples to channels (framework and direct channels).
+ *
+ * Configuration (register, configure, ...) is serialized by an internal
+ * mutex and kept in maps. Every change publishes a new immutable routing
+ * table (dense arrays indexed by sensor handle) with an atomic pointer swap,
+ * the old table is freed once no reader is using it. The per sample query
+ * (forEachValidPushChannel) takes no lock and does not allocate: it must be
+ * called by one thread only (the sensors data callback thread).
+ */
 struct SensorsDataProxyManager {
 public:
-    SensorsDataProxyManager(void) = default;
-    ~SensorsDataProxyManager(void) = default;
+    SensorsDataProxyManager(void);
+    ~SensorsDataProxyManager(void);
+
+    SensorsDataProxyManager(const SensorsDataProxyManager &) = delete;
+    SensorsDataProxyManager &operator=(const SensorsDataProxyManager &) = delete;
 
     void reset(void);
 
@@ -48,21 +63,69 @@ public:
 
     std::vector<int32_t> getRegisteredSensorsInChannel(int32_t channelHandle) const;
 
-    std::vector<int32_t> getValidPushChannels(int64_t timestamp,
-                                              int32_t sensorHandle,
-                                              int64_t pollrateNs);
+    /**
+     * forEachValidPushChannel: call push(channelHandle) for each channel
+     *                          where the current sensor sample must be pushed to
+     * @timestamp: timestamp of current sensor sample.
+     * @sensorHandle: sensor handle.
+     * @pollrateNs: current pollrate of the sensor stream.
+     * @push: callable, void(int32_t channelHandle).
+     *
+     * Return value: number of channels.
+     */
+    template <typename PushFunction>
+    size_t forEachValidPushChannel(int64_t timestamp,
+                                   int32_t sensorHandle,
+                                   int64_t pollrateNs,
+                                   PushFunction &&push);
+
+    size_t getValidPushChannels(int64_t timestamp,
+                                int32_t sensorHandle,
+                                int64_t pollrateNs,
+                                int32_t *channelsHandles,
+                                size_t maxChannels);
+
+    /* routing table version, incremented at each configuration change */
+    uint64_t getVersion(void) const;
 
 private:
     struct PollrateSwitchData {
+        uint64_t sequence;
         int64_t timestampOfChange;
         int64_t pollrateNs;
     };
 
-    struct ProxyData {
+    /* sample decimation status, owned by the reader thread */
+    struct RouteState {
         int samplesCounter;
         int64_t pollrateNs;
 
-        std::list<struct PollrateSwitchData> switchDataFifo;
+        /* last pollrate switch applied, read by the configuration path */
+        std::atomic<uint64_t> appliedSequence;
+    };
+
+    struct Route {
+        int32_t channelHandle;
+        RouteState *state;
+        uint32_t firstSwitch;
+        uint32_t numSwitches;
+    };
+
+    struct RoutingTable {
+        uint64_t version;
+
+        /* routes of sensor h are [sensorRoutes[h], sensorRoutes[h + 1]) */
+        std::vector<uint32_t> sensorRoutes;
+        std::vector<Route> routes;
+        std::vector<PollrateSwitchData> switches;
+    };
+
+    struct ProxyData {
+        int64_t pollrateNs;
+        RouteState *state;
+
+        /* pollrate switches not yet applied by the reader */
+        std::vector<struct PollrateSwitchData> switchDataFifo;
     };
 
     /**
@@ -78,5 +141,94 @@ private:
     std::unordered_map<int32_t,
         std::unordered_set<int32_t>> mChannelToSensor;
 
-    int calculateDecimator(int64_t dividend, int64_t divisor) const;
+    mutable std::mutex mConfigLock;
+    uint64_t mVersion;
+    uint64_t mSwitchSequence;
+
+    std::atomic<const RoutingTable *> mTable;
+    std::atomic<int> mReaders;
+
+    void publishTable(std::vector<RouteState *> retired = {});
+
+    static int calculateDecimator(int64_t dividend, int64_t divisor);
 };
+
+template <typename PushFunction>
+size_t SensorsDataProxyManager::forEachValidPushChannel(int64_t timestamp,
+                                                        int32_t sensorHandle,
+                                                        int64_t pollrateNs,
+                                                        PushFunction &&push)
+{
+    const RoutingTable *table;
+    size_t count = 0;
+
+    /* pairs with the table exchange in publishTable */
+    mReaders.fetch_add(1, std::memory_order_seq_cst);
+    table = mTable.load(std::memory_order_seq_cst);
+
+    if ((sensorHandle >= 0) &&
+        ((size_t)sensorHandle + 1 < table->sensorRoutes.size())) {
+        uint32_t end = table->sensorRoutes[sensorHandle + 1];
+
+        for (uint32_t r = table->sensorRoutes[sensorHandle]; r < end; r++) {
+            const Route &route = table->routes[r];
+            RouteState &state = *route.state;
+            uint64_t applied = state.appliedSequence.load(std::memory_order_relaxed);
+            int oldDivisor = calculateDecimator(state.pollrateNs, pollrateNs);
+
+            for (uint32_t s = route.firstSwitch; s < route.firstSwitch + route.numSwitches; s++) {
+                const PollrateSwitchData &switchData = table->switches[s];
+
+                if (switchData.sequence <= applied) {
+                    continue;
+                }
+
+                if (timestamp < switchData.timestampOfChange) {
+                    break;
+                }
+
+                state.pollrateNs = switchData.pollrateNs;
+                applied = switchData.sequence;
+                state.appliedSequence.store(applied, std::memory_order_release);
+            }
+
+            int divisor = calculateDecimator(state.pollrateNs, pollrateNs);
+            if (divisor) {
+                if (oldDivisor != divisor) {
+                    state.samplesCounter = divisor - 1;
+                }
+
+                if (++state.samplesCounter >= divisor) {
+                    state.samplesCounter = 0;
+                    push(route.channelHandle);
+                    count++;
+                }
+            }
+        }
+    }
+
+    mReaders.fetch_sub(1, std::memory_order_release);
+
+    return count;
+}
+
+/**
+ * calculateDecimator: calculate decimator factor
+ * @dividend: dividend.
+ * @divisor: divisor.
+ *
+ * Return value: >= 1 if divisor is greater than 0. 0 if divisor is also 0.
+ */
+inline int SensorsDataProxyManager::calculateDecimator(int64_t dividend, int64_t divisor)
+{
+    if (!divisor) {
+        return 0;
+    }
+
+    int quotient = dividend / divisor;
+    if (quotient < 1) {
+        quotient = 1;
+    }
+
+    return quotient;
+}
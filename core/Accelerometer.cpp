@@ -34,12 +34,11 @@ Accelerometer::Accelerometer(HWSensorBaseCommonData *data,
     : HWSensorBaseWithPollrate(data, name, sfa, handle,
                                AccelSensorType,
                                hw_fifo_len, power_consumption, module),
-      bias_last_pollrate(0),
-      accelCalibration(STMAccelCalibration::getInstance())
+      bias_last_pollrate(0)
 {
     (void) wakeup;
 
-    rotMatrix = propertiesManager.getRotationMatrix(handle);
+    configureRawTransform(propertiesManager.getRotationMatrix(handle), HW_SENSOR_BASE_AXES_XYZ);
     biasFileName = std::string("accel_bias_") + std::to_string(moduleId) + std::string(".dat");
 
     sensor_t_data.resolution = data->channels[0].scale;
@@ -70,7 +69,19 @@ int Accelerometer::libsInit(void)
 
 void Accelerometer::postSetup(void)
 {
+    calibrationWorker.stop();
+
     loadBiasValues();
+
+    if ((HAL_ENABLE_ACCEL_CALIBRATION != 0) && (HAL_ENABLE_ACCEL_ASYNC_CALIBRATION != 0)) {
+        publishCalibrationBias();
+
+        calibrationWorker.start(HW_SENSOR_BASE_CALIBRATION_RING_LEN,
+                                [this](const SensorBaseData *data, size_t count) {
+                                    runCalibration(data, count);
+                                    publishCalibrationBias();
+                                });
+    }
 }
 
 int Accelerometer::Enable(int handle, bool enable, bool lock_en_mutex)
@@ -113,7 +124,17 @@ void Accelerometer::saveBiasValues(void) const
 {
     Matrix<4, 3, float> bias;
 
-    accelCalibration.getBias(bias);
+    if (HAL_ENABLE_ACCEL_ASYNC_CALIBRATION != 0) {
+        CalibrationBias calibration;
+
+        if (!calibrationBias.read(calibration)) {
+            return;
+        }
+
+        bias = calibration.bias;
+    } else {
+        accelCalibration.getBias(bias);
+    }
 
     if (sensorsCallback != nullptr) {
         if (sensorsCallback->onSaveDataRequest(biasFileName, &bias, sizeof(bias)) <= 0) {
@@ -137,53 +158,107 @@ void Accelerometer::loadBiasValues(void)
     accelCalibration.reset(bias);
 }
 
+/**
+ * runCalibration: feed accel calibration library, on the data thread or on
+ *                 the calibration worker thread
+ * @data: accel samples, in device frame.
+ * @count: number of samples.
+ */
+void Accelerometer::runCalibration(const SensorBaseData *data, unsigned int count)
+{
+    unsigned int i, first;
+
+    if (batchSamples.size() < count) {
+        batchSamples.resize(count);
+        batchTimestamps.resize(count);
+    }
+
+    for (i = 0; i < count; i++) {
+        memcpy(batchSamples[i].data(), data[i].raw, SENSOR_DATA_3AXIS * sizeof(float));
+        batchTimestamps[i] = data[i].timestamp;
+    }
+
+    /* library frequency must follow odr changes inside the batch */
+    for (first = 0, i = 1; i <= count; i++) {
+        if ((i < count) && (data[i].pollrate_ns == data[first].pollrate_ns)) {
+            continue;
+        }
+
+        if (bias_last_pollrate != data[first].pollrate_ns) {
+            bias_last_pollrate = data[first].pollrate_ns;
+            accelCalibration.setFrequency(NS_TO_FREQUENCY(data[first].pollrate_ns));
+        }
+
+        accelCalibration.run(&batchSamples[first], &batchTimestamps[first], i - first);
+        first = i;
+    }
+}
+
+void Accelerometer::publishCalibrationBias(void)
+{
+    CalibrationBias calibration;
+
+    accelCalibration.getBias(calibration.bias);
+    calibration.accuracy = accelCalibration.getAccuracy();
+    calibration.confidence = (float)calibration.accuracy / SENSOR_STATUS_ACCURACY_HIGH;
+
+    calibrationBias.write(calibration);
+}
+
 void Accelerometer::ProcessData(SensorBaseData *data)
 {
-    std::array<float, 3> accelTmp;
+    ProcessDataBatch(data, 1);
+}
+
+void Accelerometer::ProcessDataBatch(SensorBaseData *data, unsigned int count)
+{
+    std::array<float, 3> offset = { 0.0f, 0.0f, 0.0f };
+    Matrix<4, 3, float> bias;
+    int accuracy = SENSOR_STATUS_UNRELIABLE;
+    unsigned int i;
 
-    memcpy(accelTmp.data(), data->raw, SENSOR_DATA_3AXIS * sizeof(float));
-    accelTmp = rotMatrix * accelTmp;
-    memcpy(data->raw, accelTmp.data(), SENSOR_DATA_3AXIS * sizeof(float));
+    STMAccelCalibration::resetBiasMatrix(bias);
 
-    data->accuracy = SENSOR_STATUS_UNRELIABLE;
+    raw_transform.transformBatch(data[0].raw, data[0].raw, count, sizeof(SensorBaseData));
 
     if (HAL_ENABLE_ACCEL_CALIBRATION != 0) {
-        std::array<float, 3> accelData;
-        Matrix<4, 3, float> bias;
+        if (HAL_ENABLE_ACCEL_ASYNC_CALIBRATION != 0) {
+            CalibrationBias calibration;
 
-        memcpy(accelData.data(), data->raw, 3 * sizeof(float));
+            calibrationWorker.push(data, count);
+            if (calibrationBias.read(calibration)) {
+                bias = calibration.bias;
+                accuracy = calibration.accuracy;
+            }
+        } else {
+            runCalibration(data, count);
 
-        if (bias_last_pollrate != data->pollrate_ns) {
-            bias_last_pollrate = data->pollrate_ns;
-            accelCalibration.setFrequency(NS_TO_FREQUENCY(data->pollrate_ns));
+            /* bias is slowly varying, the last estimate is applied to the whole batch */
+            accelCalibration.getBias(bias);
+            accuracy = accelCalibration.getAccuracy();
         }
 
-        accelCalibration.run(accelData, data->timestamp);
-        accelCalibration.getBias(bias);
-
-        data->offset[0] = bias[3][0];
-        data->offset[1] = bias[3][1];
-        data->offset[2] = bias[3][2];
-
-        data->accuracy = SENSOR_STATUS_ACCURACY_HIGH;
-    } else {
-        data->accuracy = SENSOR_STATUS_UNRELIABLE;
-        memset(data->offset, 0, 3 * sizeof(float));
+        offset = { bias[3][0], bias[3][1], bias[3][2] };
     }
 
-    data->processed[0] = data->raw[0] - data->offset[0];
-    data->processed[1] = data->raw[1] - data->offset[1];
-    data->processed[2] = data->raw[2] - data->offset[2];
+    /* offset, then gain correction */
+    setBiasTransform(bias);
+    bias_transform.transformBatch(data[0].raw, data[0].processed, count, sizeof(SensorBaseData));
 
-    sensor_event.data.data2[0] = data->processed[0];
-    sensor_event.data.data2[1] = data->processed[1];
-    sensor_event.data.data2[2] = data->processed[2];
-    sensor_event.data.data2[3] = (float)data->accuracy;
+    for (i = 0; i < count; i++) {
+        data[i].accuracy = accuracy;
+        memcpy(data[i].offset, offset.data(), SENSOR_DATA_3AXIS * sizeof(float));
 
-    sensor_event.timestamp = data->timestamp;
+        sensor_event.data.data2[0] = data[i].processed[0];
+        sensor_event.data.data2[1] = data[i].processed[1];
+        sensor_event.data.data2[2] = data[i].processed[2];
+        sensor_event.data.data2[3] = (float)data[i].accuracy;
 
-    HWSensorBaseWithPollrate::WriteDataToPipe(data->pollrate_ns);
-    HWSensorBaseWithPollrate::ProcessData(data);
+        sensor_event.timestamp = data[i].timestamp;
+
+        HWSensorBaseWithPollrate::WriteDataToPipe(data[i].pollrate_ns);
+        HWSensorBaseWithPollrate::ProcessData(&data[i]);
+    }
 }
 
 } // namespace core
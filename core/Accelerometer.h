@@ -17,7 +17,11 @@
 
 #pragma once
 
+#include <vector>
+
 #include "HWSensorBase.h"
+#include "CalibrationWorker.h"
+#include "SeqLock.h"
 
 #include <STMAccelCalibration.h>
 
@@ -40,18 +44,28 @@ public:
 
     virtual int Enable(int handle, bool enable, bool lock_en_mutex) override;
     virtual void ProcessData(SensorBaseData *data) override;
+    virtual void ProcessDataBatch(SensorBaseData *data, unsigned int count) override;
     virtual void postSetup(void) override;
 
 private:
-    STMAccelCalibration& accelCalibration;
+    STMAccelCalibration accelCalibration;
 
     void saveBiasValues(void) const;
 
     void loadBiasValues(void);
 
-    Matrix<3, 3, float> rotMatrix;
+    void runCalibration(const SensorBaseData *data, unsigned int count);
+    void publishCalibrationBias(void);
 
     std::string biasFileName;
+
+    /* calibration library input, grown on demand to the largest batch */
+    std::vector<std::array<float, 3>> batchSamples;
+    std::vector<int64_t> batchTimestamps;
+
+    SeqLock<CalibrationBias> calibrationBias;
+    /* must stay the last member */
+    CalibrationWorker<SensorBaseData> calibrationWorker;
 };
 
 } // namespace core
@@ -38,12 +38,11 @@ AccelerometerLimitedAxes::AccelerometerLimitedAxes(HWSensorBaseCommonData *data,
                                AccelSensorLimitedAxisType,
                                hw_fifo_len, power_consumption, module,
                                x_is_supp, y_is_supp, z_is_supp),
-      bias_last_pollrate(0),
-      accelCalibration(STMAccelCalibration::getInstance())
+      bias_last_pollrate(0)
 {
     (void) wakeup;
 
-    rotMatrix = propertiesManager.getRotationMatrix(handle);
+    configureRawTransform(propertiesManager.getRotationMatrix(handle), getSupportedAxes());
     biasFileName = std::string("accel_bias_") + std::to_string(moduleId) + std::string(".dat");
 
     sensor_t_data.resolution = data->channels[0].scale;
@@ -141,15 +140,12 @@ void AccelerometerLimitedAxes::loadBiasValues(void)
 
 void AccelerometerLimitedAxes::ProcessData(SensorBaseData *data)
 {
-    std::array<float, 3> accelTmp;
-    int ret;
-
-    ret = copyAxesData(accelTmp, data);
-    if (ret)
+    if (scan_counts_channels == 0) {
         return;
+    }
 
-    accelTmp = rotMatrix * accelTmp;
-    memcpy(data->raw, accelTmp.data(), SENSOR_DATA_3AXIS * sizeof(float));
+    /* unsupported axes have no channel, cleared by DecodeScanBuffer */
+    raw_transform.transform(data->raw, data->raw);
 
     data->accuracy = SENSOR_STATUS_UNRELIABLE;
 
@@ -171,7 +167,7 @@ void AccelerometerLimitedAxes::ProcessData(SensorBaseData *data)
         data->offset[1] = bias[3][1];
         data->offset[2] = bias[3][2];
 
-        data->accuracy = SENSOR_STATUS_ACCURACY_HIGH;
+        data->accuracy = accelCalibration.getAccuracy();
     } else {
         data->accuracy = SENSOR_STATUS_UNRELIABLE;
         memset(data->offset, 0, 3 * sizeof(float));
@@ -44,14 +44,12 @@ public:
     virtual void postSetup(void) override;
 
 private:
-    STMAccelCalibration& accelCalibration;
+    STMAccelCalibration accelCalibration;
 
     void saveBiasValues(void) const;
 
     void loadBiasValues(void);
 
-    Matrix<3, 3, float> rotMatrix;
-
     std::string biasFileName;
 };
 
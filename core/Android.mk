@@ -51,10 +51,18 @@ LOCAL_CFLAGS += \
     -DHAL_ENABLE_SENSORS_FUSION=1 \
     -DHAL_ENABLE_GEOMAG_FUSION=1 \
     -DHAL_ENABLE_TIMESYNC=0 \
+    -DHAL_ENABLE_IIO_HOTPLUG=0 \
+    -DHAL_ENABLE_ADAPTIVE_FUSION_RATE=1 \
+    -DHAL_ENABLE_ACCEL_ASYNC_CALIBRATION=0 \
+    -DHAL_ENABLE_GYRO_ASYNC_CALIBRATION=0 \
+    -DHAL_ENABLE_MAGN_ASYNC_CALIBRATION=0 \
     -DHAL_MAX_ODR_HZ=110 \
     -DHAL_ACCEL_MAX_RANGE_MS2=18 \
     -DHAL_MAGN_MAX_RANGE_UT=2000 \
-    -DHAL_GYRO_MAX_RANGE_RPS=17
+    -DHAL_GYRO_MAX_RANGE_RPS=17 \
+    -DHAL_ACCEL_DECIMATION_FILTER=0 \
+    -DHAL_GYRO_DECIMATION_FILTER=0 \
+    -DHAL_MAGN_DECIMATION_FILTER=0
 
 ifeq ($(DEBUG),y)
 LOCAL_CFLAGS += -g -O0
@@ -64,10 +72,13 @@ endif # DEBUG
 LOCAL_SRC_FILES := \
     ISTMSensorsHAL.cpp \
     STMSensorsHAL.cpp \
+    STMSensorsSubscriptions.cpp \
     STMSensorsList.cpp \
     STMSensorType.cpp \
     STMSensor.cpp \
     ISTMSensorsCallbackData.cpp \
+    ISTMSensorsCallback.cpp \
+    STMSensorsRecordsPool.cpp \
     STMSensorsCallbackData.cpp \
     SensorsSupported.cpp \
     Accelerometer.cpp \
@@ -80,6 +91,10 @@ LOCAL_SRC_FILES := \
     Gyroscope.cpp \
     GyroscopeLimitedAxes.cpp \
     HWSensorBase.cpp \
+    IIORecording.cpp \
+    IIORecorder.cpp \
+    IIOReplay.cpp \
+    IIOScanDecoder.cpp \
     Magnetometer.cpp \
     Pressure.cpp \
     RHumidity.cpp \
@@ -109,6 +124,7 @@ LOCAL_SRC_FILES := \
     SWGravity.cpp \
     SWLinearAccel.cpp \
     SelfTest.cpp \
+    IIODevicesMonitor.cpp \
     PropertiesManager.cpp \
     PropertiesParser.cpp
 
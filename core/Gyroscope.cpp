@@ -22,6 +22,9 @@
 
 #include "Gyroscope.h"
 
+/* above this bias confidence, calibration does not need accel data */
+#define GYRO_CALIBRATION_NO_ACCEL_CONFIDENCE    0.9f
+
 namespace stm {
 namespace core {
 
@@ -33,12 +36,15 @@ Gyroscope::Gyroscope(HWSensorBaseCommonData *data, const char *name,
                                GyroSensorType,
                                hw_fifo_len, power_consumption, module),
       bias_last_pollrate(0),
-      gyroCalibration(STMGyroCalibration::getInstance()),
-      gyroTempCalibration(STMGyroTempCalibration::getInstance())
+      gyro_decimator(0),
+      bias_converged(false),
+      temp_bias_offset({ 0.0f, 0.0f, 0.0f }),
+      bias_temperature(0.0f),
+      bias_temperature_valid(false)
 {
     (void) wakeup;
 
-    rotMatrix = propertiesManager.getRotationMatrix(handle);
+    configureRawTransform(propertiesManager.getRotationMatrix(handle), HW_SENSOR_BASE_AXES_XYZ);
     biasFileName = std::string("gyro_bias_") + std::to_string(moduleId) + std::string(".dat");
     biasTFileName = std::string("gyro_bias_temperature_") + std::to_string(moduleId) + std::string(".dat");
 
@@ -100,7 +106,19 @@ int Gyroscope::libsInit(void)
 
 void Gyroscope::postSetup(void)
 {
+    calibrationWorker.stop();
+
     loadBiasValues();
+
+    if ((HAL_ENABLE_GYRO_CALIBRATION != 0) && (HAL_ENABLE_GYRO_ASYNC_CALIBRATION != 0)) {
+        publishCalibrationBias();
+
+        calibrationWorker.start(HW_SENSOR_BASE_CALIBRATION_RING_LEN,
+                                [this](const SensorBaseData *data, size_t count) {
+                                    runCalibration(data, count);
+                                    publishCalibrationBias();
+                                });
+    }
 }
 
 int Gyroscope::Enable(int handle, bool enable, bool lock_en_mutex)
@@ -143,7 +161,18 @@ void Gyroscope::saveBiasValues(void) const
 {
     Matrix<4, 3, float> bias;
 
-    gyroCalibration.getBias(bias);
+    if (HAL_ENABLE_GYRO_ASYNC_CALIBRATION != 0) {
+        CalibrationBias calibration;
+
+        /* library is owned by the calibration worker */
+        if (!calibrationBias.read(calibration)) {
+            return;
+        }
+
+        bias = calibration.bias;
+    } else {
+        gyroCalibration.getBias(bias);
+    }
 
     if (sensorsCallback != nullptr) {
         if (sensorsCallback->onSaveDataRequest(biasFileName, &bias, sizeof(bias)) <= 0) {
@@ -191,110 +220,236 @@ void Gyroscope::loadBiasValues(void)
     }
 }
 
-void Gyroscope::ProcessData(SensorBaseData *data)
+void Gyroscope::updateTemperatureBias(const std::array<float, 3> &calibrationBias,
+                                      float confidence, float temperature, int64_t timestamp)
 {
-    std::array<float, 3> gyroTmp;
+    std::array<float, 3> predicted, reference = calibrationBias;
+
+    /* temperature model input data are the offset calculated by gyro calibration, when fresh */
+    if (confidence >= GYRO_CALIBRATION_NO_ACCEL_CONFIDENCE) {
+        std::array<float, 3> gyroData = calibrationBias;
+
+        if (gyroTempCalibration.run(gyroData, temperature, timestamp, nullptr) == 0) {
+            bias_temperature = temperature;
+            bias_temperature_valid = true;
+        }
+    }
+
+    if (gyroTempCalibration.getBias(&temperature, predicted) < 0) {
+        return;
+    }
+
+    /*
+     * apply the bias drift predicted since the temperature at which the gyro
+     * calibration bias was estimated, or the whole predicted bias if that
+     * temperature is unknown (stored bias)
+     */
+    if (bias_temperature_valid &&
+        (gyroTempCalibration.getBias(&bias_temperature, reference) < 0)) {
+        return;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        temp_bias_offset[i] = predicted[i] - reference[i];
+    }
+}
+
+/**
+ * runCalibration: feed gyro calibration library, on the data thread or on
+ *                 the calibration worker thread
+ * @data: gyro samples, in device frame.
+ * @count: number of samples.
+ */
+void Gyroscope::runCalibration(const SensorBaseData *data, unsigned int count)
+{
+    const std::array<float, 3> *accel;
     int acc_dep_id = SENSOR_DEPENDENCY_ID_0;
-    int temp_dep_id = SENSOR_DEPENDENCY_ID_0;
+    unsigned int i, j, first, valid;
 
-    memcpy(gyroTmp.data(), data->raw, SENSOR_DATA_3AXIS * sizeof(float));
-    gyroTmp = rotMatrix * gyroTmp;
-    memcpy(data->raw, gyroTmp.data(), SENSOR_DATA_3AXIS * sizeof(float));
+    if (batchSamples.size() < count) {
+        batchAccel.resize(count);
+        batchSamples.resize(count);
+        batchTimestamps.resize(count);
+    }
 
     /*
      * in case both GC and GT libs enabled adjust sensor dependency
      * list accordingly
      */
-    if (HAL_ENABLE_GYRO_CALIBRATION != 0 &&
-        HAL_ENABLE_GYRO_TEMPERATURE_CALIBRATION != 0) {
+    if (HAL_ENABLE_GYRO_TEMPERATURE_CALIBRATION != 0) {
         acc_dep_id = SENSOR_DEPENDENCY_ID_1;
     }
 
-    if (HAL_ENABLE_GYRO_CALIBRATION != 0 &&
-        dependencies_type_list.size() > 0) {
-        SensorBaseData accel_data;
-        int err, nomaxdata = 10;
-
-        do {
-            err = GetLatestValidDataFromDependency(acc_dep_id, &accel_data, data->timestamp);
-            if (err < 0) {
-                nomaxdata--;
-                std::this_thread::sleep_for(std::chrono::microseconds(10));
-                continue;
+    for (first = 0, i = 1; i <= count; i++) {
+        if ((i < count) && (data[i].pollrate_ns == data[first].pollrate_ns)) {
+            continue;
+        }
+
+        if (gyroCalibration.getConfidence() >= GYRO_CALIBRATION_NO_ACCEL_CONFIDENCE) {
+            /* bias is known, library detects stillness from gyro data only */
+            for (valid = 0, j = first; j < i; j++) {
+                batchSamples[valid] = { data[j].raw[0], data[j].raw[1], data[j].raw[2] };
+                batchTimestamps[valid] = data[j].timestamp;
+                valid++;
             }
-        } while ((nomaxdata >= 0) && (err < 0));
 
-        if (nomaxdata > 0) {
-            if (bias_last_pollrate != data->pollrate_ns) {
-                bias_last_pollrate = data->pollrate_ns;
-                gyroCalibration.setFrequency(NS_TO_FREQUENCY(data->pollrate_ns));
+            accel = nullptr;
+        } else {
+            /* only gyro samples with a matching accel sample feed the library */
+            for (valid = 0, j = first; j < i; j++) {
+                SensorBaseData accel_data;
+                int err, nomaxdata = 10;
+
+                do {
+                    err = GetLatestValidDataFromDependency(acc_dep_id, &accel_data, data[j].timestamp);
+                    if (err < 0) {
+                        nomaxdata--;
+                        std::this_thread::sleep_for(std::chrono::microseconds(10));
+                        continue;
+                    }
+                } while ((nomaxdata >= 0) && (err < 0));
+
+                if (nomaxdata > 0) {
+                    batchAccel[valid] = { accel_data.raw[0], accel_data.raw[1], accel_data.raw[2] };
+                    batchSamples[valid] = { data[j].raw[0], data[j].raw[1], data[j].raw[2] };
+                    batchTimestamps[valid] = data[j].timestamp;
+                    valid++;
+                }
             }
 
-            std::array<float, 3> accelData({ accel_data.raw[0], accel_data.raw[1], accel_data.raw[2] });
-            std::array<float, 3> gyroData({ data->raw[0], data->raw[1], data->raw[2] });
-            gyroCalibration.run(accelData, gyroData, data->timestamp);
+            accel = batchAccel.data();
         }
 
-        Matrix<4, 3, float> bias;
-        gyroCalibration.getBias(bias);
+        if (valid > 0) {
+            if (bias_last_pollrate != data[first].pollrate_ns) {
+                bias_last_pollrate = data[first].pollrate_ns;
+                gyroCalibration.setFrequency(NS_TO_FREQUENCY(data[first].pollrate_ns));
+            }
+
+            gyroCalibration.run(accel, batchSamples.data(),
+                                batchTimestamps.data(), valid);
+        }
+
+        first = i;
+    }
 
-        data->offset[0] = bias[3][0];
-        data->offset[1] = bias[3][1];
-        data->offset[2] = bias[3][2];
+    if (!bias_converged && (gyroCalibration.getConvergenceTime() >= 0)) {
+        bias_converged = true;
+        console.info(std::string(GetName()) + ": bias converged in " +
+                     std::to_string((int64_t)NS_TO_MS(gyroCalibration.getConvergenceTime())) + "ms");
+    }
+}
 
-        data->accuracy = SENSOR_STATUS_ACCURACY_HIGH;
+void Gyroscope::getCalibrationBias(CalibrationBias &calibration) const
+{
+    gyroCalibration.getBias(calibration.bias);
+
+    calibration.confidence = gyroCalibration.getConfidence();
+    if (calibration.confidence >= GYRO_CALIBRATION_NO_ACCEL_CONFIDENCE) {
+        calibration.accuracy = SENSOR_STATUS_ACCURACY_HIGH;
+    } else if (calibration.confidence >= 0.5f) {
+        calibration.accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
+    } else if (calibration.confidence > 0.0f) {
+        calibration.accuracy = SENSOR_STATUS_ACCURACY_LOW;
     } else {
-        data->accuracy = SENSOR_STATUS_UNRELIABLE;
-        memset(data->offset, 0, 3 * sizeof(float));
+        calibration.accuracy = SENSOR_STATUS_UNRELIABLE;
     }
+}
+
+void Gyroscope::publishCalibrationBias(void)
+{
+    CalibrationBias calibration;
+
+    getCalibrationBias(calibration);
+    calibrationBias.write(calibration);
+}
+
+void Gyroscope::ProcessData(SensorBaseData *data)
+{
+    ProcessDataBatch(data, 1);
+}
+
+void Gyroscope::ProcessDataBatch(SensorBaseData *data, unsigned int count)
+{
+    std::array<float, 3> offset = { 0.0f, 0.0f, 0.0f };
+    int accuracy = SENSOR_STATUS_UNRELIABLE;
+    int temp_dep_id = SENSOR_DEPENDENCY_ID_0;
+    float confidence = 0.0f;
+    unsigned int i;
+
+    raw_transform.transformBatch(data[0].raw, data[0].raw, count, sizeof(SensorBaseData));
 
     if (HAL_ENABLE_GYRO_CALIBRATION != 0 &&
-        HAL_ENABLE_GYRO_TEMPERATURE_CALIBRATION != 0 &&
         dependencies_type_list.size() > 0) {
-        // Run MotionGT @ 1Hz
-        if ((++gyro_decimator) >= ceil(getHWSamplingRate())) {
-            SensorBaseData temperature_data;
-            int err, nomaxdata = 10, update = 0;
-
-            gyro_decimator = 0;
-
-            do {
-                err = GetLatestValidDataFromDependency(temp_dep_id, &temperature_data, data->timestamp);
-                if (err < 0) {
-                    nomaxdata--;
-                    std::this_thread::sleep_for(std::chrono::microseconds(10));
-                    continue;
-                }
-            } while ((nomaxdata >= 0) && (err < 0));
+        CalibrationBias calibration;
 
-            /* Gyro temperature calibration input data are the offset calculated by gyro calibration */
-            std::array<float, 3> gyroData({ data->offset[0], data->offset[1], data->offset[2] });
-            gyroTempCalibration.run(gyroData, temperature_data.raw[0], data->timestamp, &update);
+        STMGyroCalibration::resetBiasMatrix(calibration.bias);
+        calibration.confidence = 0.0f;
+        calibration.accuracy = SENSOR_STATUS_UNRELIABLE;
 
-            if (update) {
-                std::array<float, 3> bias;
+        if (HAL_ENABLE_GYRO_ASYNC_CALIBRATION != 0) {
+            /* never waits for calibration, the latest published bias is applied */
+            calibrationWorker.push(data, count);
+            calibrationBias.read(calibration);
+        } else {
+            runCalibration(data, count);
 
-                gyroTempCalibration.getBias(&temperature_data.raw[0], bias);
-                data->offset[0] += bias[0];
-                data->offset[1] += bias[1];
-                data->offset[2] += bias[2];
-            }
+            /* bias is slowly varying, the last estimate is applied to the whole batch */
+            getCalibrationBias(calibration);
         }
+
+        offset = { calibration.bias[3][0], calibration.bias[3][1], calibration.bias[3][2] };
+        confidence = calibration.confidence;
+        accuracy = calibration.accuracy;
     }
 
-    data->processed[0] = data->raw[0] - data->offset[0];
-    data->processed[1] = data->raw[1] - data->offset[1];
-    data->processed[2] = data->raw[2] - data->offset[2];
+    for (i = 0; i < count; i++) {
+        data[i].accuracy = accuracy;
+        memcpy(data[i].offset, offset.data(), SENSOR_DATA_3AXIS * sizeof(float));
+
+        if (HAL_ENABLE_GYRO_CALIBRATION != 0 &&
+            HAL_ENABLE_GYRO_TEMPERATURE_CALIBRATION != 0 &&
+            dependencies_type_list.size() > 0) {
+            // Run temperature model @ 1Hz
+            if ((++gyro_decimator) >= ceil(getHWSamplingRate())) {
+                SensorBaseData temperature_data;
+                int err, nomaxdata = 10;
+
+                gyro_decimator = 0;
+
+                do {
+                    err = GetLatestValidDataFromDependency(temp_dep_id, &temperature_data, data[i].timestamp);
+                    if (err < 0) {
+                        nomaxdata--;
+                        std::this_thread::sleep_for(std::chrono::microseconds(10));
+                        continue;
+                    }
+                } while ((nomaxdata >= 0) && (err < 0));
+
+                if (err >= 0) {
+                    updateTemperatureBias(offset, confidence, temperature_data.raw[0], data[i].timestamp);
+                }
+            }
+
+            data[i].offset[0] += temp_bias_offset[0];
+            data[i].offset[1] += temp_bias_offset[1];
+            data[i].offset[2] += temp_bias_offset[2];
+        }
+
+        data[i].processed[0] = data[i].raw[0] - data[i].offset[0];
+        data[i].processed[1] = data[i].raw[1] - data[i].offset[1];
+        data[i].processed[2] = data[i].raw[2] - data[i].offset[2];
 
-    sensor_event.data.data2[0] = data->processed[0];
-    sensor_event.data.data2[1] = data->processed[1];
-    sensor_event.data.data2[2] = data->processed[2];
-    sensor_event.data.data2[3] = (float)data->accuracy;
+        sensor_event.data.data2[0] = data[i].processed[0];
+        sensor_event.data.data2[1] = data[i].processed[1];
+        sensor_event.data.data2[2] = data[i].processed[2];
+        sensor_event.data.data2[3] = (float)data[i].accuracy;
 
-    sensor_event.timestamp = data->timestamp;
+        sensor_event.timestamp = data[i].timestamp;
 
-    HWSensorBaseWithPollrate::WriteDataToPipe(data->pollrate_ns);
-    HWSensorBaseWithPollrate::ProcessData(data);
+        HWSensorBaseWithPollrate::WriteDataToPipe(data[i].pollrate_ns);
+        HWSensorBaseWithPollrate::ProcessData(&data[i]);
+    }
 }
 
 } // namespace core
@@ -17,7 +17,11 @@
 
 #pragma once
 
+#include <vector>
+
 #include "HWSensorBase.h"
+#include "CalibrationWorker.h"
+#include "SeqLock.h"
 
 #include <STMGyroCalibration.h>
 #include <STMGyroTempCalibration.h>
@@ -40,23 +44,47 @@ public:
     virtual int libsInit(void) override;
     virtual int Enable(int handle, bool enable, bool lock_en_mutex) override;
     virtual void ProcessData(SensorBaseData *data) override;
+    virtual void ProcessDataBatch(SensorBaseData *data, unsigned int count) override;
     virtual void postSetup(void) override;
 
 private:
-    STMGyroCalibration& gyroCalibration;
-    STMGyroTempCalibration& gyroTempCalibration;
+    STMGyroCalibration gyroCalibration;
+    STMGyroTempCalibration gyroTempCalibration;
 
     void saveBiasValues(void) const;
 
     void loadBiasValues(void);
 
-    Matrix<3, 3, float> rotMatrix;
+    void runCalibration(const SensorBaseData *data, unsigned int count);
+    void getCalibrationBias(CalibrationBias &calibration) const;
+    void publishCalibrationBias(void);
+
+    void updateTemperatureBias(const std::array<float, 3> &calibrationBias,
+                               float confidence, float temperature, int64_t timestamp);
 
     std::string biasFileName;
     std::string biasTFileName;
 
-    /* for motion-gt */
+    /* for temperature model */
     int gyro_decimator;
+
+    bool bias_converged;
+
+    /* temperature model correction added to the gyro calibration bias */
+    std::array<float, 3> temp_bias_offset;
+    /* temperature of the last gyro calibration bias learned by the model */
+    float bias_temperature;
+    bool bias_temperature_valid;
+
+    /* calibration library input, grown on demand to the largest batch */
+    std::vector<std::array<float, 3>> batchAccel;
+    std::vector<std::array<float, 3>> batchSamples;
+    std::vector<int64_t> batchTimestamps;
+
+    /* latest calibration bias, written by the calibration worker */
+    SeqLock<CalibrationBias> calibrationBias;
+    /* declared last, stopped before the members used by its thread are destroyed */
+    CalibrationWorker<SensorBaseData> calibrationWorker;
 };
 
 } // namespace core
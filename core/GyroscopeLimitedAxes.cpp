@@ -36,12 +36,11 @@ GyroscopeLimitedAxes::GyroscopeLimitedAxes(HWSensorBaseCommonData *data, const c
                                GyroSensorLimitedAxisType,
                                hw_fifo_len, power_consumption, module,
                                x_is_supp, y_is_supp, z_is_supp),
-      bias_last_pollrate(0),
-      gyroCalibration(STMGyroCalibration::getInstance())
+      bias_last_pollrate(0)
 {
     (void) wakeup;
 
-    rotMatrix = propertiesManager.getRotationMatrix(handle);
+    configureRawTransform(propertiesManager.getRotationMatrix(handle), getSupportedAxes());
     biasFileName = std::string("gyro_bias_") + std::to_string(moduleId) + std::string(".dat");
 
     sensor_t_data.resolution = data->channels[0].scale;
@@ -147,15 +146,12 @@ void GyroscopeLimitedAxes::loadBiasValues(void)
 
 void GyroscopeLimitedAxes::ProcessData(SensorBaseData *data)
 {
-    std::array<float, 3> gyroTmp;
-    int ret;
-
-    ret = copyAxesData(gyroTmp, data);
-    if (ret)
+    if (scan_counts_channels == 0) {
         return;
+    }
 
-    gyroTmp = rotMatrix * gyroTmp;
-    memcpy(data->raw, gyroTmp.data(), SENSOR_DATA_3AXIS * sizeof(float));
+    /* unsupported axes have no channel, cleared by DecodeScanBuffer */
+    raw_transform.transform(data->raw, data->raw);
 
     if (HAL_ENABLE_GYRO_CALIBRATION != 0 &&
         dependencies_type_list.size() > 0) {
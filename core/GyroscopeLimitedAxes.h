@@ -43,14 +43,12 @@ public:
     virtual void postSetup(void) override;
 
 private:
-    STMGyroCalibration& gyroCalibration;
+    STMGyroCalibration gyroCalibration;
 
     void saveBiasValues(void) const;
 
     void loadBiasValues(void);
 
-    Matrix<3, 3, float> rotMatrix;
-
     std::string biasFileName;
 };
 
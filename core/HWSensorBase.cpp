@@ -22,8 +22,10 @@
 #include <signal.h>
 #include <unistd.h>
 #include <climits>
+#include <algorithm>
 
 #include "HWSensorBase.h"
+#include "IIOScanDecoder.h"
 
 #include <PropertiesManager.h>
 
@@ -61,139 +63,6 @@ static int size_from_channelarray(struct device_iio_info_channel *channels,
     return bytes;
 }
 
-/**
- * process_2byte_received() - Return channel data from 2 byte
- * @input: 2 byte of data received from buffer channel.
- * @info: information about channel structure.
- **/
-static float process_2byte_received(int input, struct device_iio_info_channel *info)
-{
-    float res;
-    int16_t val;
-
-    if (info->be) {
-        input = be16toh((uint16_t)input);
-    } else {
-        input = le16toh((uint16_t)input);
-    }
-
-    val = input >> info->shift;
-
-    if (info->sign) {
-        val &= (1 << info->bits_used) - 1;
-        val = (int16_t)(val << (16 - info->bits_used)) >> (16 - info->bits_used);
-        res = (float)val;
-    } else {
-        val &= (1 << info->bits_used) - 1;
-        res = (float)((uint16_t)val);
-    }
-
-    return ((res + info->offset) * info->scale);
-}
-
-/**
- * process_3byte_received() - Return channel data from 3 byte
- * @input: 3 byte of data received from buffer channel.
- * @info: information about channel structure.
- **/
-static float process_3byte_received(int input, struct device_iio_info_channel *info)
-{
-    float res;
-    int32_t val;
-
-    if (info->be) {
-        input = be32toh((uint32_t)input);
-    } else {
-        input = le32toh((uint32_t)input);
-    }
-
-    val = input >> info->shift;
-    if (info->sign) {
-        val &= (1 << info->bits_used) - 1;
-        val = (int32_t)(val << (24 - info->bits_used)) >> (24 - info->bits_used);
-        res = (float)val;
-    } else {
-        val &= (1 << info->bits_used) - 1;
-        res = (float)((uint32_t)val);
-    }
-
-    return ((res + info->offset) * info->scale);
-}
-
-/**
- * process_scan() - This functions use channels device information to build data
- * @hw_sensor: pointer to current hardware sensor.
- * @data: sensor data of all channels read from buffer.
- * @channels: information about channel structure.
- * @num_channels: number of channels of the sensor.
- **/
-static int ProcessScanData(uint8_t *data, struct device_iio_info_channel *channels,
-                           int num_channels,
-                           SensorBaseData *sensor_out_data)
-{
-    int k;
-
-    for (k = 0; k < num_channels; k++) {
-        sensor_out_data->offset[k] = 0;
-
-        switch (channels[k].bytes) {
-        case 1:
-            sensor_out_data->raw[k] = *(uint8_t *)(data + channels[k].location);
-            break;
-        case 2:
-            sensor_out_data->raw[k] = process_2byte_received(*(uint16_t *)
-                                                             (data + channels[k].location), &channels[k]);
-            break;
-        case 3:
-            sensor_out_data->raw[k] = process_3byte_received(*(uint32_t *)
-                                                             (data + channels[k].location), &channels[k]);
-            break;
-        case 4:
-            uint32_t val;
-
-            if (channels[k].be) {
-                val = be32toh(*(uint32_t *)(data + channels[k].location));
-            } else {
-                val = le32toh(*(uint32_t *)(data + channels[k].location));
-            }
-
-            val >>= channels[k].shift;
-            val &= channels[k].mask;
-
-            if (channels[k].sign) {
-                sensor_out_data->raw[k] = ((float)(int32_t)val + channels[k].offset) * channels[k].scale;
-            } else {
-                sensor_out_data->raw[k] = ((float)val + channels[k].offset) * channels[k].scale;
-            }
-
-            break;
-        case 8:
-            if (channels[k].sign) {
-                int64_t val = *(int64_t *)(data + channels[k].location);
-                if ((val >> channels[k].bits_used) & 1) {
-                    val = (val & channels[k].mask) | ~channels[k].mask;
-                }
-
-                if (channels[k].type == IIOChannelType::TIMESTAMP) {
-                    sensor_out_data->timestamp = val;
-                } else if (channels[k].type == IIOChannelType::HW_TIMESTAMP) {
-                    sensor_out_data->hwTimestamp = val;
-                    sensor_out_data->hasHwTimestamp = true;
-                } else {
-                    IConsole &console = IConsole::getInstance();
-                    console.warning("cannot process 64bit channel");
-                }
-            }
-
-            break;
-        default:
-            return -EINVAL;
-        }
-    }
-
-    return num_channels;
-}
-
 static int ProcessInjectionData(float *data,
                                 struct device_iio_info_channel *channels,
                                 int num_channels,
@@ -239,6 +108,11 @@ HWSensorBase::HWSensorBase(HWSensorBaseCommonData *data, const char *name,
     lastLSB.timestamp = 0;
     lastMSB.timestamp = 0;
 
+    scan_counts_channels = 0;
+    raw_axes = 0;
+    raw_transform_dirty = false;
+    bias_matrix_valid = false;
+
     memcpy(&common_data, data, sizeof(common_data));
 
     sensor_t_data.power = power_consumption;
@@ -371,6 +245,8 @@ int HWSensorBase::Enable(int handle, bool enable, bool lock_en_mutex)
     bool old_status, old_status_no_handle;
     int64_t timestampEnable;
 
+    recordControl(IIOControlOp::ENABLE, handle, enable, 0, 0.0f);
+
     if (lock_en_mutex) {
         pthread_mutex_lock(&enable_mutex);
     }
@@ -431,13 +307,14 @@ unlock_mutex:
     return err;
 }
 
-int HWSensorBase::SetDelay(int __attribute__((unused))handle,
-                           int64_t __attribute__((unused))period_ns,
+int HWSensorBase::SetDelay(int handle, int64_t period_ns,
                            int64_t timeout, bool lock_en_mutex)
 {
     unsigned int buf_len;
     int err;
 
+    recordControl(IIOControlOp::SET_DELAY, handle, period_ns, timeout, 0.0f);
+
     if (timeout < INT64_MAX) {
         if ((sensor_t_data.fifoMaxEventCount == 0) && (timeout > 0)) {
             return -EINVAL;
@@ -476,13 +353,14 @@ mutex_unlock:
     return err;
 }
 
-int HWSensorBase::SetFullscale(int __attribute__((unused))handle,
-                               float fullscale,
+int HWSensorBase::SetFullscale(int handle, float fullscale,
                                bool __attribute__((unused))lock_en_mute)
 {
     int err;
     device_iio_chan_type_t device_iio_sensor_type;
 
+    recordControl(IIOControlOp::SET_FULLSCALE, handle, 0, 0, fullscale);
+
     if (sensor_t_data.type == AccelSensorType) {
         device_iio_sensor_type = DEVICE_IIO_ACC;
     } else if (sensor_t_data.type == MagnSensorType) {
@@ -499,12 +377,113 @@ int HWSensorBase::SetFullscale(int __attribute__((unused))handle,
                                       device_iio_sensor_type);
 
     /* update fullscale */
-    if (err == 0)
-            common_data.channels[0].scale = fullscale;
+    if (err == 0) {
+        common_data.channels[0].scale = fullscale;
+
+        if (scan_counts_channels > 0) {
+            for (int k = 1; k < scan_counts_channels; k++) {
+                common_data.channels[k].scale = fullscale;
+            }
+
+            /* rebuilt by the data thread before the next read */
+            raw_transform_dirty = true;
+        }
+    }
 
     return err;
 }
 
+/**
+ * configureRawTransform: decode axes channels as counts and fold channels
+ *                        offset and scale, supported axes and placement
+ *                        into one affine transform
+ * @rotation: sensor placement matrix.
+ * @axes: supported axes bitmask (bit 0 x, bit 1 y, bit 2 z).
+ */
+void HWSensorBase::configureRawTransform(const Matrix<3, 3, float> &rotation, unsigned int axes)
+{
+    int channels = 0;
+
+    for (int axis = 0; axis < SENSOR_DATA_3AXIS; axis++) {
+        if (axes & (1U << axis)) {
+            channels++;
+        }
+    }
+
+    if ((channels == 0) || (channels > common_data.num_channels)) {
+        console.error(GetName() + std::string(": invalid axes configuration"));
+        return;
+    }
+
+    raw_rotation = rotation;
+    raw_axes = axes;
+    scan_counts_channels = channels;
+
+    updateRawTransform();
+}
+
+/**
+ * updateRawTransform: rebuild raw = R * (S * counts + S * offset), the k-th
+ *                     counts channel feeds the k-th supported axis
+ */
+void HWSensorBase::updateRawTransform(void)
+{
+    Matrix<3, 3, float> scale;
+    std::array<float, 3> offset = { 0.0f, 0.0f, 0.0f };
+    int k = 0;
+
+    for (int axis = 0; axis < SENSOR_DATA_3AXIS; axis++) {
+        scale[axis].fill(0.0f);
+    }
+
+    for (int axis = 0; axis < SENSOR_DATA_3AXIS; axis++) {
+        if (!(raw_axes & (1U << axis))) {
+            continue;
+        }
+
+        /* 1 byte channels are not scaled by ProcessScanData */
+        if (common_data.channels[k].bytes == 1) {
+            scale[axis][k] = 1.0f;
+        } else {
+            scale[axis][k] = common_data.channels[k].scale;
+            offset[axis] = common_data.channels[k].offset * common_data.channels[k].scale;
+        }
+
+        k++;
+    }
+
+    raw_transform.configure(raw_rotation * scale, raw_rotation * offset);
+}
+
+/**
+ * setBiasTransform: processed = B * (raw - o), the transform is rebuilt only
+ *                   when the calibration bias changes
+ * @bias: calibration bias, rows 0-2 gain matrix B and row 3 offset o.
+ */
+void HWSensorBase::setBiasTransform(const Matrix<4, 3, float> &bias)
+{
+    Matrix<3, 3, float> gain;
+    std::array<float, 3> offset;
+
+    if (bias_matrix_valid && (memcmp(&bias_matrix, &bias, sizeof(bias_matrix)) == 0)) {
+        return;
+    }
+
+    bias_matrix = bias;
+    bias_matrix_valid = true;
+
+    for (int i = 0; i < SENSOR_DATA_3AXIS; i++) {
+        gain[i] = bias[i];
+    }
+
+    offset = gain * bias[3];
+    for (int i = 0; i < SENSOR_DATA_3AXIS; i++) {
+        offset[i] = -offset[i];
+    }
+
+    bias_transform.configure(gain, offset);
+}
+
 int HWSensorBase::AddSensorDependency(SensorBase *p)
 {
     int dependency_id, err;
@@ -581,6 +560,8 @@ int HWSensorBase::flushRequest(int handle, bool lock_en_mutex)
     int err;
     unsigned int i;
 
+    recordControl(IIOControlOp::FLUSH, handle, 0, 0, 0.0f);
+
     if (lock_en_mutex) {
         pthread_mutex_lock(&enable_mutex);
     }
@@ -591,7 +572,7 @@ int HWSensorBase::flushRequest(int handle, bool lock_en_mutex)
             flushRequested.push(handle);
         }
 
-        for (i = 0; i < dependencies.num; i++) {
+        for (i = 0; !planDriven && (i < dependencies.num); i++) {
             dependencies.sb[i]->flushRequest(sensor_t_data.handle, true);
         }
 
@@ -647,6 +628,7 @@ void HWSensorBase::ProcessFlushData(int __attribute__((unused))handle, int64_t t
             WriteFlushEventToPipe();
         }
     } else {
+        std::lock_guard<std::mutex> lock(pushDataLock);
         for (auto i = 0U; i < push_data.num; i++) {
             if (sensor_t_data.handle == push_data.sb[i]->getHandleOfMyTrigger()) {
                 push_data.sb[i]->ProcessFlushData(flush_handle, timestamp);
@@ -657,14 +639,85 @@ void HWSensorBase::ProcessFlushData(int __attribute__((unused))handle, int64_t t
     pthread_mutex_unlock(&sample_in_processing_mutex);
 }
 
+/**
+ * fillRecordingDevice: scan layout of the iio device, as recorded with its
+ *                      buffers by the iio recorder
+ * @device: layout output.
+ */
+void HWSensorBase::fillRecordingDevice(IIORecordingDevice &device) const
+{
+    static_assert(HW_SENSOR_BASE_MAX_CHANNELS <= iioRecordingMaxChannels,
+                  "iio recording channels too small");
+
+    memset(&device, 0, sizeof(device));
+    strncpy(device.name, common_data.device_name, sizeof(device.name) - 1);
+    device.iioDevNum = common_data.device_iio_dev_num;
+    device.scanSize = scan_size;
+    device.numChannels = common_data.num_channels;
+    device.countsChannels = scan_counts_channels;
+
+    for (int k = 0; k < common_data.num_channels; k++) {
+        const struct device_iio_info_channel &channel = common_data.channels[k];
+
+        device.channels[k].scale = channel.scale;
+        device.channels[k].offset = channel.offset;
+        device.channels[k].bytes = channel.bytes;
+        device.channels[k].bitsUsed = channel.bits_used;
+        device.channels[k].shift = channel.shift;
+        device.channels[k].be = channel.be;
+        device.channels[k].sign = channel.sign;
+        device.channels[k].location = channel.location;
+        device.channels[k].type = static_cast<uint32_t>(channel.type);
+        device.channels[k].mask = channel.mask;
+    }
+}
+
+void HWSensorBase::recordControl(IIOControlOp op, int handle,
+                                 int64_t arg0, int64_t arg1, float value)
+{
+    IIORecordingControl control = {};
+
+    if (!recorder.isRecording()) {
+        return;
+    }
+
+    control.op = static_cast<uint32_t>(op);
+    control.handle = handle;
+    control.arg0 = arg0;
+    control.arg1 = arg1;
+    control.value = value;
+
+    recorder.recordControl(sensor_t_data.handle, utils.getTime(), control);
+}
+
+/**
+ * setSampleInProcessing: reference sample of the flush requests, requests
+ *                        not newer than it are completed at once, the
+ *                        others after the first sample that follows them
+ * @data: first sample of the batch in processing, or newest sample delivered.
+ */
+void HWSensorBase::setSampleInProcessing(const SensorBaseData &data)
+{
+    pthread_mutex_lock(&sample_in_processing_mutex);
+    if ((HAL_ENABLE_TIMESYNC != 0) && (data.hasHwTimestamp)) {
+        sample_in_processing_timestamp = data.hwTimestamp;
+    } else {
+        sample_in_processing_timestamp = data.timestamp;
+    }
+    pthread_mutex_unlock(&sample_in_processing_mutex);
+}
+
 void HWSensorBase::ThreadDataTask(std::atomic<bool>& threadsRunning)
 {
     uint8_t *data;
-    unsigned int hw_fifo_len;
-    SensorBaseData sensor_data;
+    unsigned int hw_fifo_len, batch_len;
+    SensorBaseData *batch_data;
+    int64_t *sync_timestamps;
+    unsigned int decoded;
+    bool timesync_valid = false;
     int err, i, read_size, flush_handle;
     int64_t timestamp_flush, timestamp_odr_switch, new_pollrate = 0;
-    int64_t old_pollrate = 0;
+    int64_t old_pollrate = 0, now = 0;
 
     if (sensor_t_data.fifoMaxEventCount > 0) {
         hw_fifo_len = sensor_t_data.fifoMaxEventCount;
@@ -680,7 +733,23 @@ void HWSensorBase::ThreadDataTask(std::atomic<bool>& threadsRunning)
         return;
     }
 
-    while (threadsRunning.load()) {
+    /* decoded samples are processed in batches, one for each FIFO read */
+    batch_data = (SensorBaseData *)malloc(hw_fifo_len * HW_SENSOR_BASE_DEFAULT_IIO_BUFFER_LEN * sizeof(SensorBaseData));
+    if (!batch_data) {
+        console.error(GetName() + std::string(": Failed to allocate sensor batch buffer."));
+        free(data);
+        return;
+    }
+
+    sync_timestamps = (int64_t *)malloc(hw_fifo_len * HW_SENSOR_BASE_DEFAULT_IIO_BUFFER_LEN * sizeof(int64_t));
+    if (!sync_timestamps) {
+        console.error(GetName() + std::string(": Failed to allocate sensor timestamps buffer."));
+        free(batch_data);
+        free(data);
+        return;
+    }
+
+    while (ThreadWaitActive(threadsRunning)) {
         err = poll(&pollfd_iio[0], 1, 200);
         if (err <= 0) {
             continue;
@@ -693,30 +762,53 @@ void HWSensorBase::ThreadDataTask(std::atomic<bool>& threadsRunning)
                 continue;
             }
 
-            for (i = 0; i < (read_size / scan_size); i++) {
-                err = ProcessScanData(data + (i * scan_size), common_data.channels, common_data.num_channels, &sensor_data);
-                if (err < 0) {
-                    continue;
-                }
+            if (raw_transform_dirty.exchange(false)) {
+                updateRawTransform();
+            }
+
+            if (recorder.isRecording()) {
+                IIORecordingDevice device;
+
+                fillRecordingDevice(device);
+                recorder.recordScan(device, sensor_t_data.handle, utils.getTime(), data, read_size);
+            }
+
+            decoded = DecodeScanBuffer(data, read_size, scan_size, common_data.channels,
+                                       common_data.num_channels, scan_counts_channels, batch_data);
+
+            for (i = 0; i < (int)decoded; i++) {
+                sync_timestamps[i] = batch_data[i].hwTimestamp;
+            }
+
+            /* hw timestamps of the whole read are converted with the same fit */
+            if (HAL_ENABLE_TIMESYNC != 0) {
+                std::lock_guard<std::mutex> lock(timesyncLock);
+                timesync_valid = timesync.estimate(sync_timestamps, sync_timestamps, decoded);
+                now = utils.getTime();
+            }
+
+            batch_len = 0;
+
+            for (i = 0; i < (int)decoded; i++) {
+                SensorBaseData &sensor_data = batch_data[i];
 
                 if ((HAL_ENABLE_TIMESYNC != 0) && (sensor_data.hasHwTimestamp)) {
-                    std::lock_guard<std::mutex> lock(timesyncLock);
-                    if (!timesync.estimate(sensor_data.hwTimestamp, sensor_data.timestamp)) {
+                    if (!timesync_valid) {
                         sensor_data.timestamp = 0;
                     } else {
-                        int64_t now = utils.getTime();
-                        if (sensor_data.timestamp > utils.getTime()) {
-                            sensor_data.timestamp = now;
-                        }
+                        sensor_data.timestamp = std::min(sync_timestamps[i], now);
                     }
+                }
 
-                    pthread_mutex_lock(&sample_in_processing_mutex);
-                    sample_in_processing_timestamp = sensor_data.hwTimestamp;
-                    pthread_mutex_unlock(&sample_in_processing_mutex);
-                } else {
-                    pthread_mutex_lock(&sample_in_processing_mutex);
-                    sample_in_processing_timestamp = sensor_data.timestamp;
-                    pthread_mutex_unlock(&sample_in_processing_mutex);
+                /*
+                 * samples of a batch are delivered after all of them are read:
+                 * while it is processed, flush requests newer than its first
+                 * sample are queued and completed after the sample that
+                 * follows them, once it is delivered the newest sample is the
+                 * reference (see setSampleInProcessing).
+                 */
+                if (batch_len == 0) {
+                    setSampleInProcessing(sensor_data);
                 }
 
                 timestamp_odr_switch = odr_switch.readLastElement(&new_pollrate);
@@ -749,12 +841,24 @@ void HWSensorBase::ThreadDataTask(std::atomic<bool>& threadsRunning)
                 } while (tryAgain);
 
                 if (sensor_data.timestamp) {
-                    ProcessData(&sensor_data);
+                    /* dropped samples are removed from the batch */
+                    if ((int)batch_len != i) {
+                        batch_data[batch_len] = sensor_data;
+                    }
+                    batch_len++;
                 } else {
+                    /* flush events must follow the samples already read */
+                    if (batch_len > 0) {
+                        ProcessDataBatch(batch_data, batch_len);
+                        setSampleInProcessing(batch_data[batch_len - 1]);
+                        batch_len = 0;
+                    }
+
                     for (int i = 0; i < sensor_data.flushEventsNum; ++i) {
                         if (sensor_data.flushEventHandles[i] == sensor_t_data.handle) {
                                 WriteFlushEventToPipe();
                         } else {
+                            std::lock_guard<std::mutex> lock(pushDataLock);
                             for (auto j = 0U; j < push_data.num; j++) {
                                 if (sensor_t_data.handle == push_data.sb[j]->getHandleOfMyTrigger()) {
                                     push_data.sb[j]->ProcessFlushData(sensor_data.flushEventHandles[i], 0);
@@ -764,8 +868,17 @@ void HWSensorBase::ThreadDataTask(std::atomic<bool>& threadsRunning)
                     }
                 }
             }
+
+            if (batch_len > 0) {
+                ProcessDataBatch(batch_data, batch_len);
+                setSampleInProcessing(batch_data[batch_len - 1]);
+            }
         }
     }
+
+    free(sync_timestamps);
+    free(batch_data);
+    free(data);
 }
 
 void HWSensorBase::ThreadEventsTask(std::atomic<bool>& threadsRunning)
@@ -773,7 +886,7 @@ void HWSensorBase::ThreadEventsTask(std::atomic<bool>& threadsRunning)
     struct device_iio_events event_data[10];
     int err, i, read_size;
 
-    while (threadsRunning.load()) {
+    while (ThreadWaitActive(threadsRunning)) {
         err = poll(&pollfd_iio[1], 1, 200);
         if (err <= 0) {
             continue;
@@ -786,6 +899,10 @@ void HWSensorBase::ThreadEventsTask(std::atomic<bool>& threadsRunning)
                 continue;
             }
 
+            if (recorder.isRecording()) {
+                recorder.recordEvents(sensor_t_data.handle, utils.getTime(), event_data, read_size);
+            }
+
             for (i = 0; i < (int)(read_size / sizeof(struct device_iio_events)); i++) {
                 ProcessEvent(&event_data[i]);
             }
@@ -912,55 +1029,6 @@ bool HWSensorBaseWithPollrate::isZSupported(void)
     return zSupported;
 }
 
-int HWSensorBaseWithPollrate::copyAxesData(std::array<float, 3> &axesdata, SensorBaseData *data)
-{
-   int axis_bitmask = xSupported | (ySupported << 1) | (zSupported << 2);
-
-    switch (axis_bitmask) {
-    case 1:
-        /* only x supported */
-        axesdata.at(0) = data->raw[0];
-        axesdata.at(1) = 0;
-        axesdata.at(2) = 0;
-        break;
-    case 2:
-        /* only y supported */
-        axesdata.at(0) = 0;
-        axesdata.at(1) = data->raw[0];
-        axesdata.at(2) = 0;
-        break;
-    case 3:
-        /* only xy supported */
-        axesdata.at(0) = data->raw[0];
-        axesdata.at(1) = data->raw[1];
-        axesdata.at(2) = 0;
-        break;
-    case 4:
-        /* only z supported */
-        axesdata.at(0) = 0;
-        axesdata.at(1) = 0;
-        axesdata.at(2) = data->raw[0];
-        break;
-    case 5:
-        /* only xz supported */
-        axesdata.at(0) = data->raw[0];
-        axesdata.at(1) = 0;
-        axesdata.at(2) = data->raw[1];
-        break;
-    case 6:
-        /* only yz supported */
-        axesdata.at(0) = 0;
-        axesdata.at(1) = data->raw[0];
-        axesdata.at(2) = data->raw[1];
-        break;
-    default:
-        console.error("invalid axes configuration");
-        return -1;
-    }
-
-    return 0;
-}
-
 int HWSensorBaseWithPollrate::getSupportedAxes(void)
 {
      return xSupported | (ySupported << 1) | (zSupported << 2);
@@ -984,6 +1052,8 @@ int HWSensorBaseWithPollrate::SetDelay(int handle, int64_t period_ns,
     unsigned int sampling_frequency, buf_len;
     int64_t min_pollrate_ns, min_timeout_ns = 0, timestamp;
 
+    recordControl(IIOControlOp::SET_DELAY, handle, period_ns, timeout, 0.0f);
+
     if (lock_en_mutex) {
         pthread_mutex_lock(&enable_mutex);
     }
@@ -1105,6 +1175,8 @@ int HWSensorBaseWithPollrate::flushRequest(int handle, bool lock_en_mutex)
     int err;
     unsigned int i;
 
+    recordControl(IIOControlOp::FLUSH, handle, 0, 0, 0.0f);
+
     if (lock_en_mutex) {
         pthread_mutex_lock(&enable_mutex);
     }
@@ -1115,7 +1187,7 @@ int HWSensorBaseWithPollrate::flushRequest(int handle, bool lock_en_mutex)
             flushRequested.push(handle);
         }
 
-        for (i = 0; i < dependencies.num; i++) {
+        for (i = 0; !planDriven && (i < dependencies.num); i++) {
             dependencies.sb[i]->flushRequest(sensor_t_data.handle, true);
         }
 
@@ -1162,6 +1234,10 @@ void HWSensorBaseWithPollrate::WriteDataToPipe(int64_t hw_pollrate)
     }
 
     if (ValidDataToPush(sensor_event.timestamp)) {
+        if (WriteConvertedDataToPipe(hw_pollrate, odr_changed)) {
+            return;
+        }
+
         temp = (float)current_real_pollrate / hw_pollrate;
         decimator = (int)(temp + (temp / 20));
         samples_counter++;
@@ -22,8 +22,10 @@
 #include <mutex>
 
 #include "SensorBase.h"
+#include "AffineTransform.h"
 #include <IUtils.h>
 #include <IConsole.h>
+#include <IIORecorder.h>
 #include <STMTimesync.h>
 #include <PropertiesManager.h>
 
@@ -38,6 +40,8 @@ namespace core {
 #define HW_SENSOR_BASE_IIO_SYSFS_PATH_MAX        (200)
 #define HW_SENSOR_BASE_IIO_DEVICE_NAME_MAX       (30)
 #define HW_SENSOR_BASE_MAX_CHANNELS              (8)
+#define HW_SENSOR_BASE_AXES_XYZ                  (0x7)
+#define HW_SENSOR_BASE_CALIBRATION_RING_LEN      (512)
 
 struct HWSensorBaseCommonData {
     char device_iio_sysfs_path[HW_SENSOR_BASE_IIO_SYSFS_PATH_MAX];
@@ -50,6 +54,13 @@ struct HWSensorBaseCommonData {
     struct device_iio_scales sa;
 } typedef HWSensorBaseCommonData;
 
+/* calibration output, published by asynchronous calibration workers */
+struct CalibrationBias {
+    Matrix<4, 3, float> bias;
+    float confidence;
+    int accuracy;
+};
+
 struct selftest_data {
     unsigned int available;
     char mode[5][20];
@@ -78,10 +89,31 @@ protected:
 
     IUtils &utils { IUtils::getInstance() };
     PropertiesManager& propertiesManager { PropertiesManager::getInstance() };
+    IIORecorder &recorder { IIORecorder::getInstance() };
+
+    void fillRecordingDevice(IIORecordingDevice &device) const;
+    void recordControl(IIOControlOp op, int handle, int64_t arg0, int64_t arg1, float value);
 
     std::mutex timesyncLock;
     STMTimesync timesync;
 
+    /* leading axes channels are decoded as counts and scaled by raw_transform */
+    int scan_counts_channels;
+    unsigned int raw_axes;
+    Matrix<3, 3, float> raw_rotation;
+    std::atomic<bool> raw_transform_dirty;
+    AffineTransform raw_transform;
+
+    /* calibration gain and offset, rebuilt only when the bias changes */
+    AffineTransform bias_transform;
+    Matrix<4, 3, float> bias_matrix;
+    bool bias_matrix_valid;
+
+    void configureRawTransform(const Matrix<3, 3, float> &rotation, unsigned int axes);
+    void updateRawTransform(void);
+    void setBiasTransform(const Matrix<4, 3, float> &bias);
+    void setSampleInProcessing(const SensorBaseData &data);
+
     struct syncEventHolder {
         uint32_t val;
         int64_t timestamp;
@@ -109,6 +141,7 @@ public:
     virtual void ProcessData(SensorBaseData *data) override;
     virtual void ProcessEvent(struct device_iio_events *event_data);
     virtual int flushRequest(int handle, bool lock_en_mute) override;
+    virtual int GetFlushForwardHandle(int __attribute__((unused))handle) const override { return sensor_t_data.handle; };
     virtual void ProcessFlushData(int handle, int64_t timestamp) override;
     void processSyncEvent(struct device_iio_events *event_data);
     virtual void ThreadDataTask(std::atomic<bool>& threadsRunning) override;
@@ -153,7 +186,6 @@ public:
     bool isXSupported(void);
     bool isYSupported(void);
     bool isZSupported(void);
-    int copyAxesData(std::array<float, 3> &axesdata, SensorBaseData *data);
     virtual int getSupportedAxes(void);
     float getHWSamplingRate(void);
 };
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+#include <IConsole.h>
+#include "IIODevicesMonitor.h"
+
+#define IIO_MONITOR_SETTLE_TIME_MS		100
+#define IIO_MONITOR_BUFFER_SIZE			4096
+
+namespace stm {
+namespace core {
+
+static IConsole &console { IConsole::getInstance() };
+
+IIODevicesMonitor::IIODevicesMonitor(const std::string &path, std::function<void(void)> onChange)
+    : path(path),
+      onChange(onChange),
+      inotifyFd(-EINVAL),
+      ueventFd(-EINVAL),
+      stopFd(-EINVAL)
+{
+}
+
+IIODevicesMonitor::~IIODevicesMonitor(void)
+{
+    stop();
+}
+
+/**
+ * start: open notification sources and start the monitor thread
+ * Return value: 0 on success, negative number if no source is available.
+ */
+int IIODevicesMonitor::start(void)
+{
+    struct sockaddr_nl addr;
+
+    if (thread) {
+        return 0;
+    }
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0) {
+        if (inotify_add_watch(inotifyFd, path.c_str(),
+                              IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+            close(inotifyFd);
+            inotifyFd = -EINVAL;
+        }
+    }
+
+    ueventFd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (ueventFd >= 0) {
+        memset(&addr, 0, sizeof(addr));
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = 1;
+
+        if (bind(ueventFd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            close(ueventFd);
+            ueventFd = -EINVAL;
+        }
+    }
+
+    if ((inotifyFd < 0) && (ueventFd < 0)) {
+        console.error(path + ": unable to monitor IIO devices");
+        return -ENODEV;
+    }
+
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd < 0) {
+        int err = -errno;
+
+        console.error(path + ": unable to create monitor stop event");
+        stop();
+
+        return err;
+    }
+
+    thread = std::make_unique<std::thread>(ThreadWork, this);
+
+    return 0;
+}
+
+/**
+ * stop: stop the monitor thread and release notification sources
+ */
+void IIODevicesMonitor::stop(void)
+{
+    if (thread && thread->joinable()) {
+        eventfd_write(stopFd, 1);
+        thread->join();
+    }
+    thread.reset();
+
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -EINVAL;
+    }
+
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+        inotifyFd = -EINVAL;
+    }
+
+    if (ueventFd >= 0) {
+        close(ueventFd);
+        ueventFd = -EINVAL;
+    }
+}
+
+/**
+ * drainInotify: read all pending inotify events
+ * Return value: true if an IIO device entry changed.
+ */
+bool IIODevicesMonitor::drainInotify(void)
+{
+    alignas(struct inotify_event) char buffer[IIO_MONITOR_BUFFER_SIZE];
+    bool changed = false;
+    ssize_t len;
+
+    while ((len = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char *ptr = buffer; ptr < buffer + len; ) {
+            struct inotify_event *event = (struct inotify_event *)ptr;
+
+            if ((event->len > 0) && (strncmp(event->name, "iio:device", 10) == 0)) {
+                changed = true;
+            }
+
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return changed;
+}
+
+/**
+ * drainUevent: read all pending kernel uevents
+ * Return value: true if an iio subsystem device was added or removed.
+ */
+bool IIODevicesMonitor::drainUevent(void)
+{
+    char buffer[IIO_MONITOR_BUFFER_SIZE];
+    bool changed = false;
+    ssize_t len;
+
+    while ((len = recv(ueventFd, buffer, sizeof(buffer) - 1, 0)) > 0) {
+        bool iio = false, action = false;
+
+        buffer[len] = '\0';
+
+        /* uevent payload is a list of NUL separated KEY=value strings */
+        for (char *ptr = buffer; ptr < buffer + len; ptr += strlen(ptr) + 1) {
+            if (strcmp(ptr, "SUBSYSTEM=iio") == 0) {
+                iio = true;
+            } else if ((strcmp(ptr, "ACTION=add") == 0) || (strcmp(ptr, "ACTION=remove") == 0)) {
+                action = true;
+            }
+        }
+
+        if (iio && action) {
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+void IIODevicesMonitor::ThreadWork(IIODevicesMonitor *monitor)
+{
+    monitor->ThreadTask();
+}
+
+void IIODevicesMonitor::ThreadTask(void)
+{
+    struct pollfd fds[3];
+    bool pending = false;
+    int err, nfds = 0;
+
+    fds[nfds].fd = stopFd;
+    fds[nfds].events = POLLIN;
+    nfds++;
+
+    if (inotifyFd >= 0) {
+        fds[nfds].fd = inotifyFd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+
+    if (ueventFd >= 0) {
+        fds[nfds].fd = ueventFd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+
+    while (true) {
+        /* sleep until an event, or until the end of the settle time */
+        err = poll(fds, nfds, pending ? IIO_MONITOR_SETTLE_TIME_MS : -1);
+        if (err < 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            return;
+        }
+
+        if (err == 0) {
+            /* sysfs attributes show up after the device entry, wait a quiet period */
+            if (pending) {
+                pending = false;
+                onChange();
+            }
+
+            continue;
+        }
+
+        for (int i = 1; i < nfds; i++) {
+            if (!(fds[i].revents & POLLIN)) {
+                continue;
+            }
+
+            if (fds[i].fd == inotifyFd) {
+                pending |= drainInotify();
+            } else {
+                pending |= drainUevent();
+            }
+        }
+    }
+}
+
+} // namespace core
+} // namespace stm
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <thread>
+#include <memory>
+#include <functional>
+
+namespace stm {
+namespace core {
+
+/*
+ * class IIODevicesMonitor: notify when IIO devices appear or disappear
+ *
+ * Two sources are watched: kernel uevents of the iio subsystem (netlink)
+ * and inotify on the devices directory, the latter is what makes a fake
+ * devices directory usable for testing. Bursts of events are coalesced
+ * and reported with a single callback invocation.
+ */
+class IIODevicesMonitor {
+public:
+    IIODevicesMonitor(const std::string &path, std::function<void(void)> onChange);
+    ~IIODevicesMonitor(void);
+
+    IIODevicesMonitor(const IIODevicesMonitor& rhl) = delete;
+    IIODevicesMonitor& operator=(const IIODevicesMonitor& rhl) = delete;
+
+    int start(void);
+    void stop(void);
+
+private:
+    std::string path;
+    std::function<void(void)> onChange;
+
+    int inotifyFd;
+    int ueventFd;
+
+    /* eventfd waking up the monitor thread to stop it */
+    int stopFd;
+    std::unique_ptr<std::thread> thread;
+
+    bool drainInotify(void);
+    bool drainUevent(void);
+
+    static void ThreadWork(IIODevicesMonitor *monitor);
+    void ThreadTask(void);
+};
+
+} // namespace core
+} // namespace stm
@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <IConsole.h>
+#include <IIORecorder.h>
+#include <IUtils.h>
+
+namespace stm {
+namespace core {
+
+static const uint8_t padding[8] = { 0 };
+
+/* about 10 s of 6 sensors at 833Hz, records are dropped when it is full */
+static const size_t ringSize = 1 << 20;
+
+/* the writer thread is woken up when this much data is queued... */
+static const uint64_t writeThreshold = 64 * 1024;
+
+/* ...or periodically, a crash loses at most this period of data */
+static const std::chrono::milliseconds writePeriod(100);
+
+IIORecorder::IIORecorder(void)
+    : recording(false),
+      ringHead(0),
+      ringTail(0),
+      stopWriter(false),
+      writeFailed(false),
+      fd(-1),
+      offset(0),
+      records(0),
+      dropped(0),
+      sequence(0),
+      lastTimestamp(INT64_MIN)
+{
+}
+
+IIORecorder::~IIORecorder(void)
+{
+    close();
+}
+
+IIORecorder &IIORecorder::getInstance(void)
+{
+    static IIORecorder recorder;
+
+    return recorder;
+}
+
+int IIORecorder::open(const std::string &path)
+{
+    IIORecordingFileHeader header = {};
+    int err;
+
+    close();
+
+    std::lock_guard<std::mutex> control(controlLock);
+    std::lock_guard<std::mutex> guard(lock);
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    header.magic = iioRecordingMagic;
+    header.version = iioRecordingVersion;
+    header.headerSize = sizeof(header);
+    header.startTimestamp = IUtils::getInstance().getTime();
+
+    errno = 0;
+    if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+        err = errno ? -errno : -EIO;
+        ::close(fd);
+        fd = -1;
+        return err;
+    }
+
+    offset = sizeof(header);
+    records = 0;
+    dropped = 0;
+    sequence = 0;
+    lastTimestamp = INT64_MIN;
+    index.clear();
+    devices.clear();
+
+    ring.resize(ringSize);
+    ringHead = 0;
+    ringTail = 0;
+    stopWriter = false;
+    writeFailed = false;
+    writer = std::thread(&IIORecorder::writerLoop, this);
+
+    recording.store(true, std::memory_order_release);
+
+    return 0;
+}
+
+void IIORecorder::close(void)
+{
+    std::lock_guard<std::mutex> control(controlLock);
+
+    recording.store(false, std::memory_order_release);
+
+    if (!writer.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        stopWriter = true;
+    }
+
+    ringCond.notify_one();
+    writer.join();
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (dropped > 0) {
+        IConsole::getInstance().warning(std::to_string(dropped) +
+                                        " iio records dropped, recording ring full");
+    }
+
+    /* without index the records written are still read back */
+    if (!writeFailed && (writeIndex() < 0)) {
+        IConsole::getInstance().error("failed to write iio recording index");
+    }
+
+    ::close(fd);
+    fd = -1;
+    index.clear();
+    index.shrink_to_fit();
+    devices.clear();
+    ring.clear();
+    ring.shrink_to_fit();
+}
+
+/**
+ * writeIndex: write the index and the footer, the writer thread is stopped
+ *
+ * Return value: 0 on success, else a negative error code.
+ */
+int IIORecorder::writeIndex(void)
+{
+    IIORecordHeader header = {};
+    IIORecordingFooter footer = {};
+    size_t len = index.size() * sizeof(IIORecordingIndexEntry);
+    struct iovec iov[3] = {
+        { &header, sizeof(header) },
+        { index.data(), len },
+        { &footer, sizeof(footer) },
+    };
+    ssize_t expected = sizeof(header) + len + sizeof(footer);
+
+    if (len > UINT32_MAX) {
+        return -EINVAL;
+    }
+
+    header.type = static_cast<uint16_t>(IIORecordType::INDEX);
+    header.size = len;
+    header.timestamp = lastTimestamp;
+    header.handle = -1;
+    header.sequence = sequence;
+
+    footer.indexOffset = offset;
+    footer.indexCount = index.size();
+    footer.recordCount = records;
+    footer.indexInterval = iioRecordingIndexInterval;
+    footer.magic = iioRecordingFooterMagic;
+
+    errno = 0;
+    if (writev(fd, iov, 3) != expected) {
+        return errno ? -errno : -EIO;
+    }
+
+    return 0;
+}
+
+/* copy to the ring at its head, lock must be held and space available */
+void IIORecorder::ringCopy(const void *data, size_t len)
+{
+    size_t pos = ringHead % ring.size();
+    size_t first = std::min(len, ring.size() - pos);
+
+    memcpy(ring.data() + pos, data, first);
+    memcpy(ring.data(), static_cast<const uint8_t *>(data) + first, len - first);
+    ringHead += len;
+}
+
+/**
+ * queue: copy a record to the ring for the writer thread, lock must be held
+ *
+ * Sequence numbers are given to the dropped records too, replay can tell
+ * where data is missing.
+ *
+ * Return value: 0 on success, -ENOSPC if the record was dropped.
+ */
+int IIORecorder::queue(IIORecordType type, int32_t handle, int64_t timestamp,
+                       const void *payload, size_t len)
+{
+    IIORecordHeader header = {};
+    uint64_t padded = iioRecordAlign(len);
+    uint64_t size = sizeof(header) + padded;
+    uint64_t queued = ringHead - ringTail;
+
+    header.sequence = sequence++;
+
+    if ((len > UINT32_MAX) || (size > ring.size() - queued)) {
+        dropped++;
+        return -ENOSPC;
+    }
+
+    header.type = static_cast<uint16_t>(type);
+    header.size = len;
+    header.timestamp = timestamp;
+    header.handle = handle;
+
+    ringCopy(&header, sizeof(header));
+    ringCopy(payload, len);
+    ringCopy(padding, padded - len);
+
+    lastTimestamp = std::max(lastTimestamp, timestamp);
+    if (records % iioRecordingIndexInterval == 0) {
+        index.push_back({ lastTimestamp, offset });
+    }
+
+    records++;
+    offset += size;
+
+    if ((queued < writeThreshold) && (queued + size >= writeThreshold)) {
+        ringCond.notify_one();
+    }
+
+    return 0;
+}
+
+/**
+ * writeRing: write queued records, called without lock: the producers do
+ *            not overwrite the ring before ringTail moves past to
+ *
+ * Return value: 0 on success, else a negative error code.
+ */
+int IIORecorder::writeRing(uint64_t from, uint64_t to)
+{
+    while (from < to) {
+        size_t pos = from % ring.size();
+        size_t len = std::min<uint64_t>(to - from, ring.size() - pos);
+        ssize_t ret = write(fd, ring.data() + pos, len);
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return -errno;
+        }
+
+        if (ret == 0) {
+            return -EIO;
+        }
+
+        from += ret;
+    }
+
+    return 0;
+}
+
+void IIORecorder::writerLoop(void)
+{
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (!stopWriter || (ringHead != ringTail)) {
+        ringCond.wait_for(guard, writePeriod, [this] {
+            return stopWriter || (ringHead - ringTail >= writeThreshold);
+        });
+
+        uint64_t from = ringTail;
+        uint64_t to = ringHead;
+        if (from == to) {
+            continue;
+        }
+
+        guard.unlock();
+        int err = writeRing(from, to);
+        guard.lock();
+
+        ringTail = to;
+
+        if (err < 0) {
+            IConsole::getInstance().error("failed to write iio recording, recording stopped");
+            recording.store(false, std::memory_order_release);
+            writeFailed = true;
+            break;
+        }
+    }
+}
+
+void IIORecorder::recordScan(const IIORecordingDevice &device, int32_t handle, int64_t timestamp,
+                             const void *data, size_t len)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (!isRecording()) {
+        return;
+    }
+
+    /* the layout is recorded again when the channels scale changes */
+    auto recorded = devices.find(handle);
+    if ((recorded == devices.end()) ||
+        (memcmp(&recorded->second, &device, sizeof(device)) != 0)) {
+        if (queue(IIORecordType::DEVICE, handle, timestamp, &device, sizeof(device)) < 0) {
+            /* not replayed with a stale layout, the layout is queued again next time */
+            sequence++;
+            dropped++;
+            return;
+        }
+
+        devices[handle] = device;
+    }
+
+    queue(IIORecordType::SCAN, handle, timestamp, data, len);
+}
+
+void IIORecorder::recordEvents(int32_t handle, int64_t timestamp, const void *events, size_t len)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (!isRecording()) {
+        return;
+    }
+
+    queue(IIORecordType::EVENTS, handle, timestamp, events, len);
+}
+
+void IIORecorder::recordControl(int32_t handle, int64_t timestamp, const IIORecordingControl &control)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (!isRecording()) {
+        return;
+    }
+
+    queue(IIORecordType::CONTROL, handle, timestamp, &control, sizeof(control));
+}
+
+} // namespace core
+} // namespace stm
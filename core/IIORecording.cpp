@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <IIORecording.h>
+
+namespace stm {
+namespace core {
+
+IIORecording::IIORecording(void)
+    : base(nullptr),
+      length(0),
+      complete(false)
+{
+}
+
+IIORecording::~IIORecording(void)
+{
+    close();
+}
+
+int IIORecording::open(const std::string &path)
+{
+    const IIORecordingFileHeader *header;
+    IIORecordingFooter footer;
+    struct stat st;
+    void *addr;
+    int err;
+    int fd;
+
+    close();
+
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        err = -errno;
+        ::close(fd);
+        return err;
+    }
+
+    if ((size_t)st.st_size < sizeof(IIORecordingFileHeader)) {
+        ::close(fd);
+        return -EINVAL;
+    }
+
+    addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return -errno;
+    }
+
+    base = static_cast<const uint8_t *>(addr);
+    length = st.st_size;
+
+    header = reinterpret_cast<const IIORecordingFileHeader *>(base);
+    if ((header->magic != iioRecordingMagic) ||
+        (header->version != iioRecordingVersion) ||
+        (header->headerSize != sizeof(IIORecordingFileHeader))) {
+        close();
+        return -EINVAL;
+    }
+
+    if (length >= sizeof(IIORecordingFileHeader) + sizeof(IIORecordHeader) + sizeof(footer)) {
+        memcpy(&footer, base + length - sizeof(footer), sizeof(footer));
+
+        if ((footer.magic == iioRecordingFooterMagic) &&
+            (footer.indexInterval > 0) &&
+            (footer.indexOffset >= sizeof(IIORecordingFileHeader)) &&
+            (footer.indexOffset % 8 == 0) &&
+            (footer.indexOffset <= length - sizeof(footer) - sizeof(IIORecordHeader))) {
+            const IIORecordHeader *indexHeader =
+                reinterpret_cast<const IIORecordHeader *>(base + footer.indexOffset);
+
+            if ((indexHeader->type == static_cast<uint16_t>(IIORecordType::INDEX)) &&
+                (indexHeader->size == footer.indexCount * sizeof(IIORecordingIndexEntry)) &&
+                (indexHeader->size <= length - sizeof(footer) - footer.indexOffset - sizeof(IIORecordHeader)) &&
+                (readRecords(footer.indexOffset) == footer.indexOffset) &&
+                checkIndex(footer, reinterpret_cast<const IIORecordingIndexEntry *>(indexHeader + 1))) {
+                complete = true;
+
+                return 0;
+            }
+
+            index.clear();
+        }
+    }
+
+    readRecords(length);
+
+    return 0;
+}
+
+void IIORecording::close(void)
+{
+    if (base != nullptr) {
+        munmap(const_cast<uint8_t *>(base), length);
+        base = nullptr;
+    }
+
+    length = 0;
+    complete = false;
+    index.clear();
+}
+
+/**
+ * readRecords: locate the records, up to end or to the first truncated one
+ *
+ * Return value: offset following the last record.
+ */
+uint64_t IIORecording::readRecords(uint64_t end)
+{
+    uint64_t offset = sizeof(IIORecordingFileHeader);
+    int64_t timestamp = INT64_MIN;
+
+    while (offset + sizeof(IIORecordHeader) <= end) {
+        const IIORecordHeader *header = reinterpret_cast<const IIORecordHeader *>(base + offset);
+        uint64_t next = offset + sizeof(IIORecordHeader) + iioRecordAlign(header->size);
+
+        if ((header->type < static_cast<uint16_t>(IIORecordType::DEVICE)) ||
+            (header->type > static_cast<uint16_t>(IIORecordType::INDEX)) ||
+            (offset + sizeof(IIORecordHeader) + header->size > end)) {
+            break;
+        }
+
+        if (header->type != static_cast<uint16_t>(IIORecordType::INDEX)) {
+            timestamp = std::max(timestamp, header->timestamp);
+            index.push_back({ timestamp, offset });
+        }
+
+        offset = next;
+    }
+
+    return offset;
+}
+
+/* entries: one record out of footer.indexInterval */
+bool IIORecording::checkIndex(const IIORecordingFooter &footer,
+                              const IIORecordingIndexEntry *entries) const
+{
+    if ((index.size() != footer.recordCount) ||
+        (footer.indexCount != (footer.recordCount + footer.indexInterval - 1) / footer.indexInterval)) {
+        return false;
+    }
+
+    for (uint64_t i = 0; i < footer.indexCount; ++i) {
+        const IIORecordingIndexEntry &entry = index[i * footer.indexInterval];
+
+        if ((entries[i].timestamp != entry.timestamp) || (entries[i].offset != entry.offset)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+IIORecording::Record IIORecording::at(size_t i) const
+{
+    const IIORecordHeader *header = reinterpret_cast<const IIORecordHeader *>(base + index[i].offset);
+
+    return { header, reinterpret_cast<const uint8_t *>(header + 1) };
+}
+
+size_t IIORecording::lowerBound(int64_t timestamp) const
+{
+    auto pos = std::lower_bound(index.begin(), index.end(), timestamp,
+                                [](const IIORecordingIndexEntry &entry, int64_t t) {
+                                    return entry.timestamp < t;
+                                });
+
+    return pos - index.begin();
+}
+
+const IIORecordingDevice *IIORecording::getDevice(int32_t handle) const
+{
+    for (size_t i = 0; i < index.size(); ++i) {
+        Record record = at(i);
+
+        if ((record.header->type == static_cast<uint16_t>(IIORecordType::DEVICE)) &&
+            (record.header->handle == handle) &&
+            (record.header->size >= sizeof(IIORecordingDevice))) {
+            return reinterpret_cast<const IIORecordingDevice *>(record.payload);
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace core
+} // namespace stm
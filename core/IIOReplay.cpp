@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+#include "IIOReplay.h"
+#include "IIOScanDecoder.h"
+
+namespace stm {
+namespace core {
+
+struct ReplayDevice {
+    struct device_iio_info_channel channels[iioRecordingMaxChannels];
+    int numChannels;
+    int countsChannels;
+    size_t scanSize;
+};
+
+/**
+ * setupReplayDevice: decoding layout of a recorded device, layouts whose
+ *                    channels would be read out of the scan are rejected
+ *
+ * Return value: true if the layout is valid.
+ */
+static bool setupReplayDevice(const IIORecordingDevice &device, ReplayDevice &replayDevice)
+{
+    if ((device.scanSize == 0) ||
+        (device.numChannels < 0) || (device.numChannels > iioRecordingMaxChannels) ||
+        (device.countsChannels < 0) || (device.countsChannels > device.numChannels)) {
+        return false;
+    }
+
+    for (int k = 0; k < device.numChannels; ++k) {
+        const IIORecordingChannel &in = device.channels[k];
+        /* 3 bytes channels are loaded as 32 bits words */
+        uint64_t loaded = (in.bytes == 3) ? 4 : in.bytes;
+
+        if ((in.bytes == 0) || (in.bytes > 8) ||
+            ((uint64_t)in.location + loaded > device.scanSize)) {
+            return false;
+        }
+    }
+
+    replayDevice.numChannels = device.numChannels;
+    replayDevice.countsChannels = device.countsChannels;
+    replayDevice.scanSize = device.scanSize;
+
+    for (int k = 0; k < replayDevice.numChannels; ++k) {
+        const IIORecordingChannel &in = device.channels[k];
+        struct device_iio_info_channel &out = replayDevice.channels[k];
+
+        out = device_iio_info_channel();
+        out.scale = in.scale;
+        out.offset = in.offset;
+        out.bytes = in.bytes;
+        out.bits_used = in.bitsUsed;
+        out.shift = in.shift;
+        out.mask = in.mask;
+        out.be = in.be;
+        out.sign = in.sign;
+        out.location = in.location;
+        out.type = static_cast<IIOChannelType>(in.type);
+    }
+
+    return true;
+}
+
+IIOReplay::IIOReplay(const IIORecording &recording)
+    : recording(recording),
+      stopped(false)
+{
+}
+
+int IIOReplay::run(Consumer &consumer, Mode mode, int64_t fromTimestamp, int64_t toTimestamp)
+{
+    std::unordered_map<int32_t, ReplayDevice> devices;
+    std::vector<SensorBaseData> samples;
+    std::chrono::steady_clock::time_point start;
+    size_t first = recording.lowerBound(fromTimestamp);
+    int64_t firstTimestamp = 0;
+    bool started = false;
+    int replayed = 0;
+    int err = 0;
+
+    for (size_t i = 0; i < recording.size(); ++i) {
+        IIORecording::Record record = recording.at(i);
+        const IIORecordHeader &header = *record.header;
+        IIORecordType type = static_cast<IIORecordType>(header.type);
+
+        if (stopped.load()) {
+            err = -ECANCELED;
+            break;
+        }
+
+        /*
+         * layouts recorded before the first replayed record are still needed,
+         * buffers of a device with an invalid layout are not replayed
+         */
+        if (type == IIORecordType::DEVICE) {
+            if ((header.size < sizeof(IIORecordingDevice)) ||
+                !setupReplayDevice(*reinterpret_cast<const IIORecordingDevice *>(record.payload),
+                                   devices[header.handle])) {
+                devices.erase(header.handle);
+            }
+            continue;
+        }
+
+        if (i < first) {
+            continue;
+        }
+
+        if (header.timestamp > toTimestamp) {
+            break;
+        }
+
+        if (mode == Mode::REALTIME) {
+            if (!started) {
+                start = std::chrono::steady_clock::now();
+                firstTimestamp = header.timestamp;
+                started = true;
+            } else {
+                auto deadline = start + std::chrono::nanoseconds(header.timestamp - firstTimestamp);
+                std::unique_lock<std::mutex> guard(lock);
+
+                if (cond.wait_until(guard, deadline, [this] { return stopped.load(); })) {
+                    err = -ECANCELED;
+                    break;
+                }
+            }
+        }
+
+        switch (type) {
+        case IIORecordType::SCAN: {
+            auto device = devices.find(header.handle);
+            if (device == devices.end()) {
+                continue;
+            }
+
+            size_t scans = header.size / device->second.scanSize;
+            if (samples.size() < scans) {
+                samples.resize(scans);
+            }
+
+            unsigned int decoded = DecodeScanBuffer(record.payload, header.size,
+                                                    device->second.scanSize,
+                                                    device->second.channels,
+                                                    device->second.numChannels,
+                                                    device->second.countsChannels,
+                                                    samples.data());
+
+            consumer.onScanData(header.handle, header.timestamp, samples.data(), decoded);
+            break;
+        }
+        case IIORecordType::EVENTS:
+            consumer.onEvents(header.handle, header.timestamp,
+                              reinterpret_cast<const struct device_iio_events *>(record.payload),
+                              header.size / sizeof(struct device_iio_events));
+            break;
+        case IIORecordType::CONTROL:
+            if (header.size < sizeof(IIORecordingControl)) {
+                continue;
+            }
+
+            consumer.onControl(header.handle, header.timestamp,
+                               *reinterpret_cast<const IIORecordingControl *>(record.payload));
+            break;
+        default:
+            continue;
+        }
+
+        replayed++;
+    }
+
+    stopped.store(false);
+
+    return (err < 0) ? err : replayed;
+}
+
+void IIOReplay::stop(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopped.store(true);
+    }
+
+    cond.notify_all();
+}
+
+} // namespace core
+} // namespace stm
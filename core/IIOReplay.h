@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include <IIORecording.h>
+
+#include "CircularBuffer.h"
+#include "utils.h"
+
+namespace stm {
+namespace core {
+
+/*
+ * Replay of a recording: buffers are decoded with the layout recorded for
+ * their device by the same code as the hardware sensors data thread
+ * (DecodeScanBuffer / ProcessScanData), so the samples are bit exact.
+ * Records are delivered in recording order, either at the recorded pace or
+ * as fast as possible.
+ */
+class IIOReplay {
+public:
+    enum class Mode {
+        REALTIME,
+        FAST,
+    };
+
+    class Consumer {
+    public:
+        virtual ~Consumer(void) = default;
+
+        /**
+         * onScanData: samples decoded from a buffer read from the device
+         * @handle: hardware sensor handle.
+         * @timestamp: read time of the buffer.
+         * @data: decoded samples.
+         * @count: number of samples.
+         */
+        virtual void onScanData(int32_t handle, int64_t timestamp,
+                                const SensorBaseData *data, unsigned int count) = 0;
+
+        virtual void onEvents(int32_t handle, int64_t timestamp,
+                              const struct device_iio_events *events, unsigned int count) {
+            (void) handle; (void) timestamp; (void) events; (void) count;
+        }
+
+        virtual void onControl(int32_t handle, int64_t timestamp,
+                               const IIORecordingControl &control) {
+            (void) handle; (void) timestamp; (void) control;
+        }
+    };
+
+    explicit IIOReplay(const IIORecording &recording);
+    ~IIOReplay(void) = default;
+
+    IIOReplay(const IIOReplay &) = delete;
+    IIOReplay &operator=(const IIOReplay &) = delete;
+
+    /**
+     * run: replay the recording in the calling thread
+     * @consumer: receives the replayed records.
+     * @mode: recorded pace or as fast as possible.
+     * @fromTimestamp: first record replayed (read time).
+     * @toTimestamp: records after this time are not replayed.
+     *
+     * Return value: number of records replayed, -ECANCELED if stopped,
+     *               else a negative error code.
+     */
+    int run(Consumer &consumer, Mode mode,
+            int64_t fromTimestamp = INT64_MIN, int64_t toTimestamp = INT64_MAX);
+
+    /* interrupt run, from any thread */
+    void stop(void);
+
+private:
+    const IIORecording &recording;
+
+    std::mutex lock;
+    std::condition_variable cond;
+    std::atomic<bool> stopped;
+};
+
+} // namespace core
+} // namespace stm
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2015-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <endian.h>
+
+#include <IConsole.h>
+
+#include "IIOScanDecoder.h"
+
+namespace stm {
+namespace core {
+
+/**
+ * process_2byte_received() - Return channel counts from 2 byte
+ * @input: 2 byte of data received from buffer channel.
+ * @info: information about channel structure.
+ **/
+static float process_2byte_received(int input, const struct device_iio_info_channel *info)
+{
+    float res;
+    int16_t val;
+
+    if (info->be) {
+        input = be16toh((uint16_t)input);
+    } else {
+        input = le16toh((uint16_t)input);
+    }
+
+    val = input >> info->shift;
+
+    if (info->sign) {
+        val &= (1 << info->bits_used) - 1;
+        val = (int16_t)(val << (16 - info->bits_used)) >> (16 - info->bits_used);
+        res = (float)val;
+    } else {
+        val &= (1 << info->bits_used) - 1;
+        res = (float)((uint16_t)val);
+    }
+
+    return res;
+}
+
+/**
+ * process_3byte_received() - Return channel counts from 3 byte
+ * @input: 3 byte of data received from buffer channel.
+ * @info: information about channel structure.
+ **/
+static float process_3byte_received(int input, const struct device_iio_info_channel *info)
+{
+    float res;
+    int32_t val;
+
+    if (info->be) {
+        input = be32toh((uint32_t)input);
+    } else {
+        input = le32toh((uint32_t)input);
+    }
+
+    val = input >> info->shift;
+    if (info->sign) {
+        val &= (1 << info->bits_used) - 1;
+        val = (int32_t)(val << (24 - info->bits_used)) >> (24 - info->bits_used);
+        res = (float)val;
+    } else {
+        val &= (1 << info->bits_used) - 1;
+        res = (float)((uint32_t)val);
+    }
+
+    return res;
+}
+
+/**
+ * ProcessScanData() - This functions use channels device information to build data
+ * @data: sensor data of all channels read from buffer.
+ * @channels: information about channel structure.
+ * @num_channels: number of channels of the sensor.
+ * @counts_channels: number of leading channels left unscaled (counts).
+ **/
+int ProcessScanData(const uint8_t *data, const struct device_iio_info_channel *channels,
+                    int num_channels, int counts_channels,
+                    SensorBaseData *sensor_out_data)
+{
+    int k;
+
+    for (k = 0; k < num_channels; k++) {
+        sensor_out_data->offset[k] = 0;
+
+        switch (channels[k].bytes) {
+        case 1:
+            sensor_out_data->raw[k] = *(const uint8_t *)(data + channels[k].location);
+            continue;
+        case 2:
+            sensor_out_data->raw[k] = process_2byte_received(*(const uint16_t *)
+                                                             (data + channels[k].location), &channels[k]);
+            break;
+        case 3:
+            sensor_out_data->raw[k] = process_3byte_received(*(const uint32_t *)
+                                                             (data + channels[k].location), &channels[k]);
+            break;
+        case 4:
+            uint32_t val;
+
+            if (channels[k].be) {
+                val = be32toh(*(const uint32_t *)(data + channels[k].location));
+            } else {
+                val = le32toh(*(const uint32_t *)(data + channels[k].location));
+            }
+
+            val >>= channels[k].shift;
+            val &= channels[k].mask;
+
+            if (channels[k].sign) {
+                sensor_out_data->raw[k] = (float)(int32_t)val;
+            } else {
+                sensor_out_data->raw[k] = (float)val;
+            }
+
+            break;
+        case 8:
+            if (channels[k].sign) {
+                int64_t val = *(const int64_t *)(data + channels[k].location);
+                if ((val >> channels[k].bits_used) & 1) {
+                    val = (val & channels[k].mask) | ~channels[k].mask;
+                }
+
+                if (channels[k].type == IIOChannelType::TIMESTAMP) {
+                    sensor_out_data->timestamp = val;
+                } else if (channels[k].type == IIOChannelType::HW_TIMESTAMP) {
+                    sensor_out_data->hwTimestamp = val;
+                    sensor_out_data->hasHwTimestamp = true;
+                } else {
+                    IConsole &console = IConsole::getInstance();
+                    console.warning("cannot process 64bit channel");
+                }
+            }
+
+            continue;
+        default:
+            return -EINVAL;
+        }
+
+        /* counts channels are scaled later by the sensor raw transform */
+        if (k >= counts_channels) {
+            sensor_out_data->raw[k] = (sensor_out_data->raw[k] + channels[k].offset) * channels[k].scale;
+        }
+    }
+
+    return num_channels;
+}
+
+/**
+ * DecodeScanBuffer() - Decode the scans of a buffer read from an iio char device
+ * @data: buffer read from the device.
+ * @len: buffer length.
+ * @scan_size: size of a scan.
+ * @channels: information about channel structure.
+ * @num_channels: number of channels of the sensor.
+ * @counts_channels: number of leading channels left unscaled (counts).
+ * @sensor_out_data: decoded samples, one for each valid scan.
+ **/
+unsigned int DecodeScanBuffer(const uint8_t *data, size_t len, size_t scan_size,
+                              const struct device_iio_info_channel *channels,
+                              int num_channels, int counts_channels,
+                              SensorBaseData *sensor_out_data)
+{
+    unsigned int decoded = 0;
+    size_t i;
+
+    if (scan_size == 0) {
+        return 0;
+    }
+
+    for (i = 0; i < (len / scan_size); i++) {
+        /*
+         * axes without a channel (limited axes sensors) are left to 0: the
+         * raw transform weights them by 0 and must not see stale values
+         */
+        memset(sensor_out_data[decoded].raw, 0, sizeof(sensor_out_data[decoded].raw));
+        sensor_out_data[decoded].hasHwTimestamp = false;
+
+        if (ProcessScanData(data + (i * scan_size), channels, num_channels,
+                            counts_channels, &sensor_out_data[decoded]) < 0) {
+            continue;
+        }
+
+        decoded++;
+    }
+
+    return decoded;
+}
+
+} // namespace core
+} // namespace stm
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2015-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "CircularBuffer.h"
+#include "utils.h"
+
+namespace stm {
+namespace core {
+
+/*
+ * Decoding of the scans read from an iio char device, shared by the hardware
+ * sensors data thread and the replay of recorded iio streams.
+ */
+int ProcessScanData(const uint8_t *data, const struct device_iio_info_channel *channels,
+                    int num_channels, int counts_channels,
+                    SensorBaseData *sensor_out_data);
+
+unsigned int DecodeScanBuffer(const uint8_t *data, size_t len, size_t scan_size,
+                              const struct device_iio_info_channel *channels,
+                              int num_channels, int counts_channels,
+                              SensorBaseData *sensor_out_data);
+
+} // namespace core
+} // namespace stm
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ISTMSensorsCallback.h>
+#include <STMSensorsCallbackData.h>
+
+namespace stm {
+namespace core {
+
+/**
+ * onNewSensorsRecords: adapter for the consumers of onNewSensorsData,
+ *                      reference: ISTMSensorsCallback.h
+ */
+void ISTMSensorsCallback::onNewSensorsRecords(STMSensorsRecordsLease &records)
+{
+    std::vector<ISTMSensorsCallbackData> sensorsData;
+
+    sensorsData.reserve(records.size());
+
+    for (auto &record : records) {
+        sensorsData.push_back(STMSensorsCallbackData(record));
+    }
+
+    onNewSensorsData(sensorsData);
+}
+
+} // namespace core
+} // namespace stm
@@ -38,11 +38,12 @@ Magnetometer::Magnetometer(HWSensorBaseCommonData *data, const char *name,
                                MagnSensorType,
                                hw_fifo_len, power_consumption, module),
       bias_last_pollrate(0),
-      magnCalibration(STMMagnCalibration::getInstance())
+      bias_decimation(0),
+      bias_skipped(0)
 {
     (void) wakeup;
 
-    rotMatrix = propertiesManager.getRotationMatrix(handle);
+    configureRawTransform(propertiesManager.getRotationMatrix(handle), HW_SENSOR_BASE_AXES_XYZ);
     biasFileName = std::string("magn_bias_") + std::to_string(moduleId) + std::string(".dat");
 
     sensor_t_data.resolution = GAUSS_TO_UTESLA(data->channels[0].scale);
@@ -72,7 +73,19 @@ int Magnetometer::libsInit(void)
 
 void Magnetometer::postSetup(void)
 {
+    calibrationWorker.stop();
+
     loadBiasValues();
+
+    if ((HAL_ENABLE_MAGN_CALIBRATION != 0) && (HAL_ENABLE_MAGN_ASYNC_CALIBRATION != 0)) {
+        publishCalibrationBias();
+
+        calibrationWorker.start(HW_SENSOR_BASE_CALIBRATION_RING_LEN,
+                                [this](const SensorBaseData *data, size_t count) {
+                                    runCalibration(data, count);
+                                    publishCalibrationBias();
+                                });
+    }
 }
 
 int Magnetometer::Enable(int handle, bool enable, bool lock_en_mutex)
@@ -115,7 +128,17 @@ void Magnetometer::saveBiasValues(void) const
 {
     Matrix<4, 3, float> bias;
 
-    magnCalibration.getBias(bias);
+    if (HAL_ENABLE_MAGN_ASYNC_CALIBRATION != 0) {
+        CalibrationBias calibration;
+
+        if (!calibrationBias.read(calibration)) {
+            return;
+        }
+
+        bias = calibration.bias;
+    } else {
+        magnCalibration.getBias(bias);
+    }
 
     if (sensorsCallback != nullptr) {
         if (sensorsCallback->onSaveDataRequest(biasFileName, &bias, sizeof(bias)) <= 0) {
@@ -141,48 +164,131 @@ void Magnetometer::loadBiasValues(void)
 
 void Magnetometer::ProcessData(SensorBaseData *data)
 {
-    std::array<float, 3> magnTmp;
+    ProcessDataBatch(data, 1);
+}
+
+/**
+ * setCalibrationPollrate: decimate data to the rates supported by calibration
+ * @pollrate_ns: sensor pollrate.
+ */
+void Magnetometer::setCalibrationPollrate(int64_t pollrate_ns)
+{
+    int frequency = (int)(NS_TO_FREQUENCY((float)pollrate_ns) + 0.5f);
 
-    memcpy(magnTmp.data(), data->raw, SENSOR_DATA_3AXIS * sizeof(float));
-    magnTmp = rotMatrix * magnTmp;
-    memcpy(data->raw, magnTmp.data(), SENSOR_DATA_3AXIS * sizeof(float));
+    bias_skipped = 0;
 
-    if (HAL_ENABLE_MAGN_CALIBRATION != 0) {
-        std::array<float, 3> magnData;
-        Matrix<4, 3, float> bias;
+    if (frequency < STMMagnCalibration::getMinFrequencyHz()) {
+        bias_decimation = 0;
+        return;
+    }
 
-        memcpy(magnData.data(), data->raw, 3 * sizeof(float));
+    bias_decimation = (frequency + STMMagnCalibration::getMaxFrequencyHz() - 1) /
+                      STMMagnCalibration::getMaxFrequencyHz();
 
-        if (bias_last_pollrate != data->pollrate_ns) {
-            bias_last_pollrate = data->pollrate_ns;
-            magnCalibration.setFrequency(NS_TO_FREQUENCY(data->pollrate_ns));
+    magnCalibration.setFrequency(frequency / bias_decimation);
+}
+
+/**
+ * runCalibration: feed magn calibration library, on the data thread or on
+ *                 the calibration worker thread
+ * @data: magn samples, in device frame.
+ * @count: number of samples.
+ */
+void Magnetometer::runCalibration(const SensorBaseData *data, unsigned int count)
+{
+    unsigned int i, first, n;
+
+    if (batchSamples.size() < count) {
+        batchSamples.resize(count);
+        batchTimestamps.resize(count);
+    }
+
+    for (first = 0, i = 1; i <= count; i++) {
+        if ((i < count) && (data[i].pollrate_ns == data[first].pollrate_ns)) {
+            continue;
         }
 
-        magnCalibration.run(magnData, data->timestamp);
-        magnCalibration.getBias(bias);
+        if (bias_last_pollrate != data[first].pollrate_ns) {
+            bias_last_pollrate = data[first].pollrate_ns;
+            setCalibrationPollrate(bias_last_pollrate);
+        }
 
-        data->offset[0] = bias[3][0];
-        data->offset[1] = bias[3][1];
-        data->offset[2] = bias[3][2];
+        for (n = 0; (bias_decimation > 0) && (first < i); first++) {
+            if (++bias_skipped < bias_decimation) {
+                continue;
+            }
 
-        data->accuracy = SENSOR_STATUS_ACCURACY_HIGH;
-    } else {
-        data->accuracy = SENSOR_STATUS_UNRELIABLE;
-        memset(data->offset, 0, 3 * sizeof(float));
+            bias_skipped = 0;
+            memcpy(batchSamples[n].data(), data[first].raw, SENSOR_DATA_3AXIS * sizeof(float));
+            batchTimestamps[n] = data[first].timestamp;
+            n++;
+        }
+
+        if (n > 0) {
+            magnCalibration.run(batchSamples.data(), batchTimestamps.data(), n);
+        }
+        first = i;
     }
+}
+
+void Magnetometer::publishCalibrationBias(void)
+{
+    CalibrationBias calibration;
+
+    magnCalibration.getBias(calibration.bias);
+    calibration.accuracy = magnCalibration.getAccuracy();
+    calibration.confidence = (float)calibration.accuracy / SENSOR_STATUS_ACCURACY_HIGH;
+
+    calibrationBias.write(calibration);
+}
+
+void Magnetometer::ProcessDataBatch(SensorBaseData *data, unsigned int count)
+{
+    std::array<float, 3> offset = { 0.0f, 0.0f, 0.0f };
+    Matrix<4, 3, float> bias;
+    int accuracy = SENSOR_STATUS_UNRELIABLE;
+    unsigned int i;
 
-    data->processed[0] = data->raw[0] - data->offset[0];
-    data->processed[1] = data->raw[1] - data->offset[1];
-    data->processed[2] = data->raw[2] - data->offset[2];
+    STMMagnCalibration::resetBiasMatrix(bias);
 
-    sensor_event.data.data2[0] = data->processed[0];
-    sensor_event.data.data2[1] = data->processed[1];
-    sensor_event.data.data2[2] = data->processed[2];
-    sensor_event.data.data2[3] = (float)data->accuracy;
-    sensor_event.timestamp = data->timestamp;
+    raw_transform.transformBatch(data[0].raw, data[0].raw, count, sizeof(SensorBaseData));
 
-    HWSensorBaseWithPollrate::WriteDataToPipe(data->pollrate_ns);
-    HWSensorBaseWithPollrate::ProcessData(data);
+    if (HAL_ENABLE_MAGN_CALIBRATION != 0) {
+        if (HAL_ENABLE_MAGN_ASYNC_CALIBRATION != 0) {
+            CalibrationBias calibration;
+
+            calibrationWorker.push(data, count);
+            if (calibrationBias.read(calibration)) {
+                bias = calibration.bias;
+                accuracy = calibration.accuracy;
+            }
+        } else {
+            runCalibration(data, count);
+
+            magnCalibration.getBias(bias);
+            accuracy = magnCalibration.getAccuracy();
+        }
+
+        offset = { bias[3][0], bias[3][1], bias[3][2] };
+    }
+
+    /* hard-iron offset, then soft-iron correction */
+    setBiasTransform(bias);
+    bias_transform.transformBatch(data[0].raw, data[0].processed, count, sizeof(SensorBaseData));
+
+    for (i = 0; i < count; i++) {
+        data[i].accuracy = accuracy;
+        memcpy(data[i].offset, offset.data(), SENSOR_DATA_3AXIS * sizeof(float));
+
+        sensor_event.data.data2[0] = data[i].processed[0];
+        sensor_event.data.data2[1] = data[i].processed[1];
+        sensor_event.data.data2[2] = data[i].processed[2];
+        sensor_event.data.data2[3] = (float)data[i].accuracy;
+        sensor_event.timestamp = data[i].timestamp;
+
+        HWSensorBaseWithPollrate::WriteDataToPipe(data[i].pollrate_ns);
+        HWSensorBaseWithPollrate::ProcessData(&data[i]);
+    }
 }
 
 } // namespace core
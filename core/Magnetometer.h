@@ -17,7 +17,11 @@
 
 #pragma once
 
+#include <vector>
+
 #include "HWSensorBase.h"
+#include "CalibrationWorker.h"
+#include "SeqLock.h"
 
 #include <STMMagnCalibration.h>
 
@@ -40,18 +44,33 @@ public:
 
     virtual int Enable(int handle, bool enable, bool lock_en_mutex) override;
     virtual void ProcessData(SensorBaseData *data) override;
+    virtual void ProcessDataBatch(SensorBaseData *data, unsigned int count) override;
     virtual void postSetup(void) override;
 
 private:
-    STMMagnCalibration& magnCalibration;
+    STMMagnCalibration magnCalibration;
 
     void saveBiasValues(void) const;
 
     void loadBiasValues(void);
 
-    Matrix<3, 3, float> rotMatrix;
-
     std::string biasFileName;
+
+    /* calibration is fed one sample every bias_decimation, 0 to not feed it */
+    unsigned int bias_decimation;
+    unsigned int bias_skipped;
+
+    void setCalibrationPollrate(int64_t pollrate_ns);
+
+    void runCalibration(const SensorBaseData *data, unsigned int count);
+    void publishCalibrationBias(void);
+
+    /* calibration library input, grown on demand to the largest batch */
+    std::vector<std::array<float, 3>> batchSamples;
+    std::vector<int64_t> batchTimestamps;
+
+    SeqLock<CalibrationBias> calibrationBias;
+    CalibrationWorker<SensorBaseData> calibrationWorker;
 };
 
 } // namespace core
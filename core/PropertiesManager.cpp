@@ -70,6 +70,10 @@ PropertiesManager::PropertiesManager()
     maxRanges[SensorType::ACCELEROMETER] = HAL_ACCEL_MAX_RANGE_MS2;
     maxRanges[SensorType::GYROSCOPE] = HAL_GYRO_MAX_RANGE_RPS;
     maxRanges[SensorType::MAGNETOMETER] = HAL_MAGN_MAX_RANGE_UT;
+
+    decimationFilters[SensorType::ACCELEROMETER] = HAL_ACCEL_DECIMATION_FILTER;
+    decimationFilters[SensorType::GYROSCOPE] = HAL_GYRO_DECIMATION_FILTER;
+    decimationFilters[SensorType::MAGNETOMETER] = HAL_MAGN_DECIMATION_FILTER;
 }
 
 Matrix<3, 3, float> PropertiesManager::createIdentityMatrix() const
@@ -112,6 +116,7 @@ int PropertiesManager::getMaxRanges(const PropertiesLoader& loader)
 {
     loadMaxRanges(loader);
     loadMaxOdrs(loader);
+    loadDecimationFilters(loader);
 
     return 0;
 }
@@ -261,6 +266,22 @@ void PropertiesManager::loadMaxOdrs(const PropertiesLoader& loader)
     }
 }
 
+void PropertiesManager::loadDecimationFilters(const PropertiesLoader& loader)
+{
+    std::vector<SensorType> sensorsSupported = {
+        SensorType::ACCELEROMETER,
+        SensorType::MAGNETOMETER,
+        SensorType::GYROSCOPE
+    };
+
+    for (auto& sensor : sensorsSupported) {
+        auto filter = loader.readInt(SensorPropertyId::DECIMATION_FILTER, sensor);
+        if (filter > 0) {
+            decimationFilters[sensor] = filter;
+        }
+    }
+}
+
 void PropertiesManager::calculateFinalRotationMatrices()
 {
     for (const auto& [sensorHandle, rotMatrix_1] : rotationMatrices_1) {
@@ -356,5 +377,15 @@ float PropertiesManager::getMaxOdr() const
     return maxOdr;
 }
 
+int PropertiesManager::getDecimationFilter(SensorType sensorType) const
+{
+    auto itr = decimationFilters.find(sensorType);
+    if (itr == decimationFilters.end()) {
+        return 0;
+    }
+
+    return itr->second;
+}
+
 } // namespace core
 } // namespace stm
@@ -32,5 +32,14 @@ STMSensorsCallbackData::STMSensorsCallbackData(uint32_t sensorHandle,
     this->sensorsData.assign(data.begin(), data.end());
 }
 
+STMSensorsCallbackData::STMSensorsCallbackData(const STMSensorsRecord &record)
+{
+    this->sensorHandle = record.sensorHandle;
+    this->sensorType = record.sensorType;
+    this->timestamp = record.timestamp;
+    this->wakeUpSensor = record.wakeUpSensor;
+    this->sensorsData.assign(record.data, record.data + record.dataLen);
+}
+
 } // namespace core
 } // namespace stm
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <ISTMSensorsCallbackData.h>
+#include <STMSensorsRecords.h>
 
 namespace stm {
 namespace core {
@@ -29,6 +30,8 @@ public:
                            int64_t timestamp,
                            const std::vector<float> &data);
 
+    STMSensorsCallbackData(const STMSensorsRecord &record);
+
     virtual ~STMSensorsCallbackData(void) {};
 };
 
@@ -15,13 +15,15 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <functional>
 #include <cerrno>
 #include <cstring>
 
-#include <STMSensorsCallbackData.h>
 #include <STMSensorsHAL.h>
 #include "sensors_legacy.h"
+#include "IIODevicesMonitor.h"
+#include "utils.h"
 
 namespace stm {
 namespace core {
@@ -37,6 +39,13 @@ STMSensorsHAL::STMSensorsHAL(void)
               : sensorsCallback(&emptySTMSensorCallback),
                 console(IConsole::getInstance()),
                 dataReceivedThreadRunning(false),
+                subscriptions([this](uint32_t handle, bool enable) {
+                                  return st_hal_dev_activate(hal_data, handle, enable);
+                              },
+                              [this](uint32_t handle, int64_t periodNs, int64_t latencyNs) {
+                                  return st_hal_dev_batch(hal_data, handle, periodNs, latencyNs);
+                              }),
+                recordsPool(pollEventsMax, recordsPoolBuffers),
                 initialized(false)
 {
 
@@ -51,36 +60,40 @@ STMSensorsHAL::~STMSensorsHAL(void)
 
 void STMSensorsHAL::internalPoll(STMSensorsHAL *hal, std::atomic<bool> *running)
 {
-    struct sensors_event_t sdata[10];
+    struct sensors_event_t sdata[pollEventsMax];
 
     while (running->load()) {
-        auto n = st_hal_dev_poll(hal->hal_data, sdata, 10);
-
-        {
-            std::vector<ISTMSensorsCallbackData> sensorsData;
-            std::vector<float> payload;
-
-            for (auto i = 0; i < n; ++i) {
-                switch (sdata->type) {
-                case SensorType::STEP_COUNTER:
-                    payload.push_back(sdata[i].u64.step_counter);
-                    break;
-                default:
-                    payload.resize(sdata[i].data.dataLen);
-                    memcpy(payload.data(), sdata[i].data.data2, sdata[i].data.dataLen * sizeof(float));
-                    break;
-                }
-
-                sensorsData.push_back(STMSensorsCallbackData(sdata[i].sensor,
-                                                             sdata[i].type,
-                                                             sdata[i].timestamp,
-                                                             payload));
-            }
+        auto n = st_hal_dev_poll(hal->hal_data, sdata, pollEventsMax);
+        if (n <= 0) {
+            continue;
+        }
 
-            if (sensorsData.size() > 0) {
-                hal->sensorsCallback->onNewSensorsData(sensorsData);
+        STMSensorsRecordsLease records = hal->recordsPool.acquire();
+        STMSensorsRecord *record = records.data();
+
+        for (auto i = 0; i < n; ++i, ++record) {
+            record->timestamp = sdata[i].timestamp;
+            record->sensorHandle = sdata[i].sensor;
+            record->sensorType = sdata[i].type;
+            record->wakeUpSensor = 0;
+
+            switch (sdata[i].type) {
+            case SensorType::STEP_COUNTER:
+                record->dataLen = 1;
+                record->data[0] = sdata[i].u64.step_counter;
+                break;
+            default:
+                record->dataLen = std::min<size_t>(sdata[i].data.dataLen, STMSensorsRecord::maxDataLen);
+                memcpy(record->data, sdata[i].data.data2, record->dataLen * sizeof(float));
+                break;
             }
         }
+
+        records.resize(hal->subscriptions.dispatch(records.data(), n));
+
+        if (!records.empty()) {
+            hal->sensorsCallback->onNewSensorsRecords(records);
+        }
     }
 }
 
@@ -94,7 +107,13 @@ int STMSensorsHAL::initialize(const ISTMSensorsCallback &sensorsCallback)
         terminate();
     }
 
-    int err = st_hal_open_sensors(&hal_data, sensorsList);
+    int err;
+
+    {
+        std::lock_guard<std::mutex> lock(sensorsListLock);
+
+        err = st_hal_open_sensors(&hal_data, sensorsList);
+    }
     if (err) {
         return err;
     }
@@ -102,7 +121,8 @@ int STMSensorsHAL::initialize(const ISTMSensorsCallback &sensorsCallback)
     dataReceivedThreadRunning = true;
     dataReceivedThread = std::make_unique<std::thread>(internalPoll, this, &dataReceivedThreadRunning);
 
-    for (auto &sensor : getSensorsList().getList()) {
+    const STMSensorsList list = getSensorsList();
+    for (auto &sensor : list.getList()) {
         activate(sensor.getHandle(), false);
     }
 
@@ -112,15 +132,62 @@ int STMSensorsHAL::initialize(const ISTMSensorsCallback &sensorsCallback)
 
     st_hal_dev_post_setup(hal_data);
 
+    if (HAL_ENABLE_IIO_HOTPLUG != 0) {
+        iioDevicesMonitor = std::make_unique<IIODevicesMonitor>(device_iio_dir,
+                                                                 std::bind(&STMSensorsHAL::hotplug, this));
+        if (iioDevicesMonitor->start() < 0) {
+            console.error("IIO devices hotplug not available");
+            iioDevicesMonitor.reset();
+        }
+    }
+
     return 0;
 }
 
+/**
+ * hotplug: synchronize sensors with the IIO devices currently available,
+ *          consumers are notified if the sensors list changed
+ */
+void STMSensorsHAL::hotplug(void)
+{
+    std::vector<uint32_t> removed;
+    size_t available;
+    int count;
+
+    {
+        std::lock_guard<std::mutex> lock(sensorsListLock);
+
+        for (auto &sensor : sensorsList.getList()) {
+            removed.push_back(sensor.getHandle());
+        }
+
+        count = st_hal_dev_hotplug(hal_data, sensorsList);
+
+        removed.erase(std::remove_if(removed.begin(), removed.end(),
+                                     [this](uint32_t handle) { return sensorsList.hasHandle(handle); }),
+                      removed.end());
+        available = sensorsList.getList().size();
+    }
+
+    for (auto handle : removed) {
+        subscriptions.remove(handle);
+    }
+
+    if (count > 0) {
+        console.info(std::string("sensors list changed, ") +
+                     std::to_string(available) + " sensors available");
+        sensorsCallback->onSensorsListChanged();
+    }
+}
+
 /**
  * getSensorslist: implementation of an interface,
  *                 reference: ISTMSensorsHAL.h
  */
-const STMSensorsList& STMSensorsHAL::getSensorsList(void)
+STMSensorsList STMSensorsHAL::getSensorsList(void)
 {
+    std::lock_guard<std::mutex> lock(sensorsListLock);
+
     return sensorsList;
 }
 
@@ -134,7 +201,7 @@ int STMSensorsHAL::activate(uint32_t handle, bool enable)
         return -EINVAL;
     }
 
-    return st_hal_dev_activate(hal_data, handle, enable);
+    return subscriptions.activate(handle, enable);
 }
 
 /**
@@ -149,7 +216,7 @@ int STMSensorsHAL::setRate(uint32_t handle,
         return -EINVAL;
     }
 
-    return st_hal_dev_batch(hal_data, handle, samplingPeriodNanoSec, maxReportLatencyNanoSec);
+    return subscriptions.setRate(handle, samplingPeriodNanoSec, maxReportLatencyNanoSec);
 }
 
 /**
@@ -174,6 +241,24 @@ int32_t STMSensorsHAL::setFullScale(uint32_t handle, float fullscale)
     return st_hal_dev_set_fullscale(hal_data, handle, fullscale);
 }
 
+/**
+ * subscribe: implementation of an interface,
+ *            reference: ISTMSensorsHAL.h
+ */
+int32_t STMSensorsHAL::subscribe(uint32_t handle,
+                                 int64_t samplingPeriodNanoSec,
+                                 int64_t maxReportLatencyNanoSec,
+                                 size_t queueLength,
+                                 std::unique_ptr<ISTMSensorsSubscription> &subscription)
+{
+    if (!handleIsValid(handle)) {
+        return -EINVAL;
+    }
+
+    return subscriptions.subscribe(handle, samplingPeriodNanoSec, maxReportLatencyNanoSec,
+                                   queueLength, subscription);
+}
+
 /**
  * handleIsValid: check if given handle is valid or not
  * @handle: sensor handle to check
@@ -182,16 +267,20 @@ int32_t STMSensorsHAL::setFullScale(uint32_t handle, float fullscale)
  */
 bool STMSensorsHAL::handleIsValid(uint32_t handle) const
 {
-    if ((handle == 0) || (handle > sensorsList.getList().size())) {
-        return false;
-    }
+    std::lock_guard<std::mutex> lock(sensorsListLock);
 
-    return true;
+    return sensorsList.hasHandle(handle);
 }
 
 void STMSensorsHAL::terminate(void)
 {
-    for (auto &sensor : getSensorsList().getList()) {
+    iioDevicesMonitor.reset();
+
+    /* subscriptions are closed, sensors are disabled for all clients */
+    subscriptions.clear();
+
+    const STMSensorsList list = getSensorsList();
+    for (auto &sensor : list.getList()) {
         activate(sensor.getHandle(), false);
     }
 
@@ -206,7 +295,11 @@ void STMSensorsHAL::terminate(void)
         st_hal_close_sensors(hal_data);
     }
 
-    sensorsList.clear();
+    {
+        std::lock_guard<std::mutex> lock(sensorsListLock);
+
+        sensorsList.clear();
+    }
     initialized = false;
 }
 
@@ -20,12 +20,17 @@
 #include <thread>
 #include <memory>
 #include <atomic>
+#include <mutex>
 
 #include <ISTMSensorsHAL.h>
+#include "STMSensorsRecordsPool.h"
+#include "STMSensorsSubscriptions.h"
 
 namespace stm {
 namespace core {
 
+class IIODevicesMonitor;
+
 class STMSensorsHAL : public ISTMSensorsHAL {
 public:
     static STMSensorsHAL& getInstance(void);
@@ -33,7 +38,7 @@ public:
 
     int initialize(const ISTMSensorsCallback &sensorsCallback) final;
 
-    const STMSensorsList& getSensorsList(void) final;
+    STMSensorsList getSensorsList(void) final;
 
     int activate(uint32_t handle, bool enable) final;
 
@@ -44,6 +49,12 @@ public:
     int flushData(uint32_t handle) final;
     int32_t setFullScale(uint32_t handle, float fullscale) final;
 
+    int32_t subscribe(uint32_t handle,
+                      int64_t samplingPeriodNanoSec,
+                      int64_t maxReportLatencyNanoSec,
+                      size_t queueLength,
+                      std::unique_ptr<ISTMSensorsSubscription> &subscription) final;
+
 private:
     STMSensorsHAL(void);
 
@@ -98,6 +109,35 @@ private:
 
     void *hal_data;
 
+    /**
+     * Protect sensors list against IIO devices hotplug, readers get a copy
+     */
+    mutable std::mutex sensorsListLock;
+
+    std::unique_ptr<IIODevicesMonitor> iioDevicesMonitor;
+
+    /**
+     * Sensors clients: wrapper (activate / setRate) and subscriptions
+     */
+    STMSensorsSubscriptions subscriptions;
+
+    /**
+     * Maximum number of events read by each poll
+     */
+    static constexpr size_t pollEventsMax = 10;
+
+    /**
+     * Buffers preallocated for the consumers keeping records leases
+     */
+    static constexpr size_t recordsPoolBuffers = 4;
+
+    /**
+     * Recycled records buffers delivered to the consumers
+     */
+    STMSensorsRecordsPool recordsPool;
+
+    void hotplug(void);
+
     bool initialized;
 
     bool handleIsValid(uint32_t handle) const;
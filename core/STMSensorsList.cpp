@@ -50,12 +50,55 @@ bool STMSensorsList::addSensor(STMSensor &sensor)
         }
     }
 
-    sensor.setHandle(list.size() + 1);
+    sensor.setHandle(++lastHandle);
     list.push_back(sensor);
 
     return true;
 }
 
+/**
+ * removeSensor: remove a sensor from the list
+ * @handle: handle of the sensor to remove
+ *
+ * Return value: true if removed, false if handle is not in the list.
+ */
+bool STMSensorsList::removeSensor(uint32_t handle)
+{
+    std::vector<STMSensor> newList;
+
+    if (!hasHandle(handle)) {
+        return false;
+    }
+
+    /* STMSensor is not assignable, rebuild the list */
+    newList.reserve(list.size() - 1);
+    for (auto &elem : list) {
+        if (elem.getHandle() != handle) {
+            newList.push_back(elem);
+        }
+    }
+    list.swap(newList);
+
+    return true;
+}
+
+/**
+ * hasHandle: check if a sensor with given handle is in the list
+ * @handle: handle to look for
+ *
+ * Return value: true if present, false otherwise.
+ */
+bool STMSensorsList::hasHandle(uint32_t handle) const
+{
+    for (auto &elem : list) {
+        if (elem.getHandle() == handle) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /**
  * getList: return current sensors list
  *
@@ -69,6 +112,7 @@ const std::vector<STMSensor>& STMSensorsList::getList(void) const
 void STMSensorsList::clear()
 {
     list.clear();
+    lastHandle = 0;
 }
 
 } // namespace core
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "STMSensorsRecordsPool.h"
+
+namespace stm {
+namespace core {
+
+STMSensorsRecordsLease &STMSensorsRecordsLease::operator=(STMSensorsRecordsLease &&other) noexcept
+{
+    if (this != &other) {
+        release();
+
+        pool = other.pool;
+        records = other.records;
+        count = other.count;
+        maxCount = other.maxCount;
+
+        other.pool = nullptr;
+        other.records = nullptr;
+        other.count = 0;
+        other.maxCount = 0;
+    }
+
+    return *this;
+}
+
+/**
+ * release: implementation of an interface,
+ *          reference: STMSensorsRecords.h
+ */
+void STMSensorsRecordsLease::release(void)
+{
+    if (pool != nullptr) {
+        pool->release(records);
+    }
+
+    pool = nullptr;
+    records = nullptr;
+    count = 0;
+    maxCount = 0;
+}
+
+STMSensorsRecordsPool::STMSensorsRecordsPool(size_t recordsPerBuffer, size_t buffersCount)
+    : recordsPerBuffer(recordsPerBuffer),
+      allocatedBuffers(0),
+      leases(0)
+{
+    for (size_t i = 0; i < buffersCount; ++i) {
+        allocateBuffer();
+    }
+}
+
+/* lock must be held */
+void STMSensorsRecordsPool::allocateBuffer(void)
+{
+    buffers.push_back(std::make_unique<STMSensorsRecord[]>(recordsPerBuffer));
+    freeBuffers.reserve(buffers.size());
+    freeBuffers.push_back(buffers.back().get());
+
+    allocatedBuffers.fetch_add(1, std::memory_order_relaxed);
+}
+
+STMSensorsRecordsLease STMSensorsRecordsPool::acquire(void)
+{
+    STMSensorsRecordsLease lease;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (freeBuffers.empty()) {
+            allocateBuffer();
+        }
+
+        lease.records = freeBuffers.back();
+        freeBuffers.pop_back();
+    }
+
+    lease.pool = this;
+    lease.maxCount = recordsPerBuffer;
+    leases.fetch_add(1, std::memory_order_relaxed);
+
+    return lease;
+}
+
+size_t STMSensorsRecordsPool::getLeasedBuffers(void) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    return buffers.size() - freeBuffers.size();
+}
+
+/* freeBuffers capacity always fits all the buffers, no allocations here */
+void STMSensorsRecordsPool::release(STMSensorsRecord *records)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    freeBuffers.push_back(records);
+}
+
+} // namespace core
+} // namespace stm
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <STMSensorsRecords.h>
+
+namespace stm {
+namespace core {
+
+/*
+ * Recycled buffers of sensors records. Buffers are allocated by the
+ * constructor, a new one is allocated only if all of them are leased
+ * (consumers keeping leases), then it stays in the pool. The pool must
+ * outlive its leases.
+ */
+class STMSensorsRecordsPool {
+public:
+    STMSensorsRecordsPool(size_t recordsPerBuffer, size_t buffersCount);
+    ~STMSensorsRecordsPool(void) = default;
+
+    STMSensorsRecordsPool(const STMSensorsRecordsPool &) = delete;
+    STMSensorsRecordsPool &operator=(const STMSensorsRecordsPool &) = delete;
+
+    /**
+     * acquire: lease a free buffer, with no valid records
+     */
+    STMSensorsRecordsLease acquire(void);
+
+    /* buffers allocated, including the ones allocated by the constructor */
+    uint64_t getAllocatedBuffers(void) const { return allocatedBuffers.load(std::memory_order_relaxed); }
+
+    /* leases handed out */
+    uint64_t getLeases(void) const { return leases.load(std::memory_order_relaxed); }
+
+    /* leases not released yet */
+    size_t getLeasedBuffers(void) const;
+
+private:
+    friend class STMSensorsRecordsLease;
+
+    const size_t recordsPerBuffer;
+
+    mutable std::mutex lock;
+    std::vector<std::unique_ptr<STMSensorsRecord[]>> buffers;
+    std::vector<STMSensorsRecord *> freeBuffers;
+
+    std::atomic<uint64_t> allocatedBuffers;
+    std::atomic<uint64_t> leases;
+
+    void allocateBuffer(void);
+    void release(STMSensorsRecord *records);
+};
+
+} // namespace core
+} // namespace stm
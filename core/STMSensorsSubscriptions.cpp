@@ -0,0 +1,587 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <IConsole.h>
+#include <STMSensorsCallbackData.h>
+
+#include "STMSensorsSubscriptions.h"
+
+namespace stm {
+namespace core {
+
+static IConsole &console { IConsole::getInstance() };
+
+/**
+ * isContinuous: samples of continuous sensors are decimated to the
+ *               subscription period, events of the other sensors are all
+ *               delivered
+ */
+static bool isContinuous(SensorType type)
+{
+    switch (type) {
+    case SensorType::PROXIMITY:
+    case SensorType::SIGNIFICANT_MOTION:
+    case SensorType::STEP_DETECTOR:
+    case SensorType::STEP_COUNTER:
+    case SensorType::TILT_DETECTOR:
+    case SensorType::WAKE_GESTURE:
+    case SensorType::GLANCE_GESTURE:
+    case SensorType::PICK_UP_GESTURE:
+    case SensorType::WRIST_TILT_GESTURE:
+    case SensorType::DEVICE_ORIENTATION:
+    case SensorType::STATIONARY_DETECT:
+    case SensorType::MOTION_DETECT:
+    case SensorType::HEART_BEAT:
+    case SensorType::LOW_LATENCY_OFFBODY_DETECT:
+        return false;
+    default:
+        return true;
+    }
+}
+
+/* flush, odr change and additional info events are for the legacy client */
+static bool isSensorSample(SensorType type)
+{
+    return (type != SensorType::META_DATA) &&
+           (type != SensorType::ODR_SWITCH_INFO) &&
+           (type != SensorType::ADDITIONAL_INFO);
+}
+
+class STMSensorsSubscriptions::Subscription : public ISTMSensorsSubscription {
+public:
+    Subscription(STMSensorsSubscriptions *manager,
+                 uint32_t handle,
+                 int64_t periodNs,
+                 int64_t latencyNs,
+                 size_t queueLength)
+        : manager(manager),
+          handle(handle),
+          periodNs(periodNs),
+          latencyNs(latencyNs),
+          queueLength(queueLength),
+          ring(queueLength),
+          head(0),
+          count(0),
+          watermark(1),
+          overflowPolicy(OverflowPolicy::DROP_OLDEST),
+          eventFd(-1),
+          signaled(false),
+          dropped(0),
+          closed(false),
+          delivered(false),
+          lastTimestamp(0) {}
+
+    ~Subscription(void) override {
+        STMSensorsSubscriptions *owner = manager.exchange(nullptr);
+
+        if (owner != nullptr) {
+            owner->unsubscribe(this);
+        }
+
+        if (eventFd >= 0) {
+            ::close(eventFd);
+        }
+    }
+
+    /**
+     * open: create the event file descriptor
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int open(void) {
+        eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (eventFd < 0) {
+            return -errno;
+        }
+
+        return 0;
+    }
+
+    uint32_t getSensorHandle(void) const override { return handle; }
+    int64_t getSamplingPeriodNs(void) const override { return periodNs; }
+    int64_t getMaxReportLatencyNs(void) const override { return latencyNs; }
+
+    int read(std::vector<ISTMSensorsCallbackData> &sensorsData,
+             size_t maxSamples,
+             int64_t timeoutNs) override {
+        std::unique_lock<std::mutex> lock(queueLock);
+        auto ready = [this] { return (count > 0) || closed; };
+        size_t n;
+
+        if (timeoutNs < 0) {
+            queueCond.wait(lock, ready);
+        } else if (timeoutNs > 0) {
+            queueCond.wait_for(lock, std::chrono::nanoseconds(timeoutNs), ready);
+        }
+
+        if (count == 0) {
+            return closed ? -ENODEV : 0;
+        }
+
+        n = std::min(maxSamples, count);
+        for (size_t i = 0; i < n; ++i) {
+            sensorsData.push_back(STMSensorsCallbackData(ring[head]));
+            head = (head + 1) % queueLength;
+        }
+        count -= n;
+        updateEvent();
+
+        return n;
+    }
+
+    int read(STMSensorsRecord *records, size_t maxRecords) override {
+        std::lock_guard<std::mutex> lock(queueLock);
+        size_t n, first;
+
+        if (count == 0) {
+            return closed ? -ENODEV : 0;
+        }
+
+        /* at most two copies, ring wraps once */
+        n = std::min(maxRecords, count);
+        first = std::min(n, queueLength - head);
+        std::copy_n(&ring[head], first, records);
+        std::copy_n(&ring[0], n - first, records + first);
+
+        head = (head + n) % queueLength;
+        count -= n;
+        updateEvent();
+
+        return n;
+    }
+
+    int getEventFd(void) const override { return eventFd; }
+
+    int setWatermark(size_t samples) override {
+        std::lock_guard<std::mutex> lock(queueLock);
+
+        if ((samples == 0) || (samples > queueLength)) {
+            return -EINVAL;
+        }
+
+        watermark = samples;
+        updateEvent();
+
+        return 0;
+    }
+
+    void setOverflowPolicy(OverflowPolicy policy) override {
+        std::lock_guard<std::mutex> lock(queueLock);
+
+        overflowPolicy = policy;
+    }
+
+    uint64_t getDroppedSamples(void) const override {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    /* sensors data thread only */
+    void push(const STMSensorsRecord &record) {
+        /* same tolerance of the sensors decimation (5%) */
+        if (delivered && isContinuous(record.sensorType) &&
+            ((record.timestamp - lastTimestamp) * 21 < periodNs * 20)) {
+            return;
+        }
+
+        delivered = true;
+        lastTimestamp = record.timestamp;
+
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+
+            if (count == queueLength) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+
+                if (overflowPolicy == OverflowPolicy::DROP_NEWEST) {
+                    return;
+                }
+
+                head = (head + 1) % queueLength;
+                count--;
+            }
+
+            ring[(head + count) % queueLength] = record;
+            count++;
+            updateEvent();
+        }
+
+        queueCond.notify_one();
+    }
+
+    void close(void) {
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            closed = true;
+            updateEvent();
+        }
+
+        queueCond.notify_all();
+    }
+
+    /* not registered in the manager, which may be destroyed before us */
+    void detach(void) {
+        manager = nullptr;
+    }
+
+private:
+    std::atomic<STMSensorsSubscriptions *> manager;
+    const uint32_t handle;
+    const int64_t periodNs;
+    const int64_t latencyNs;
+    const size_t queueLength;
+
+    std::mutex queueLock;
+    std::condition_variable queueCond;
+    std::vector<STMSensorsRecord> ring;
+    size_t head;
+    size_t count;
+    size_t watermark;
+    OverflowPolicy overflowPolicy;
+    int eventFd;
+    bool signaled;
+    std::atomic<uint64_t> dropped;
+    bool closed;
+
+    /* decimation status, sensors data thread only */
+    bool delivered;
+    int64_t lastTimestamp;
+
+    /**
+     * updateEvent: event fd is readable while the watermark is reached or
+     *              the subscription is closed, queueLock must be held
+     */
+    void updateEvent(void) {
+        bool ready = (count >= watermark) || closed;
+        uint64_t value = 1;
+
+        if (eventFd < 0 || ready == signaled) {
+            return;
+        }
+
+        if (ready) {
+            (void)!::write(eventFd, &value, sizeof(value));
+        } else {
+            (void)!::read(eventFd, &value, sizeof(value));
+        }
+
+        signaled = ready;
+    }
+};
+
+STMSensorsSubscriptions::STMSensorsSubscriptions(ActivateFunction activateFunction,
+                                                 BatchFunction batchFunction)
+    : activateFunction(activateFunction),
+      batchFunction(batchFunction),
+      subscriptionsCount(0)
+{
+}
+
+STMSensorsSubscriptions::~STMSensorsSubscriptions(void)
+{
+    clear();
+}
+
+/**
+ * activate: legacy client enable / disable,
+ *           reference: ISTMSensorsHAL.h
+ */
+int STMSensorsSubscriptions::activate(uint32_t handle, bool enable)
+{
+    std::lock_guard<std::mutex> lock(configLock);
+    SensorClients &clients = getSensorClients(handle);
+    bool previous = clients.legacyEnabled;
+    int err;
+
+    {
+        std::lock_guard<std::mutex> lock(dispatchLock);
+        clients.legacyEnabled = enable;
+    }
+
+    err = applyConfiguration(handle, clients);
+    if (err < 0) {
+        std::lock_guard<std::mutex> lock(dispatchLock);
+        clients.legacyEnabled = previous;
+    }
+
+    return err;
+}
+
+/**
+ * setRate: legacy client rate and latency,
+ *          reference: ISTMSensorsHAL.h
+ */
+int STMSensorsSubscriptions::setRate(uint32_t handle, int64_t periodNs, int64_t latencyNs)
+{
+    std::lock_guard<std::mutex> lock(configLock);
+    SensorClients &clients = getSensorClients(handle);
+    int64_t previousPeriodNs = clients.legacyPeriodNs;
+    int64_t previousLatencyNs = clients.legacyLatencyNs;
+    int err;
+
+    clients.legacyPeriodNs = periodNs;
+    clients.legacyLatencyNs = latencyNs;
+
+    err = applyConfiguration(handle, clients);
+    if (err < 0) {
+        clients.legacyPeriodNs = previousPeriodNs;
+        clients.legacyLatencyNs = previousLatencyNs;
+    }
+
+    return err;
+}
+
+/**
+ * subscribe: add an in-process client,
+ *            reference: ISTMSensorsHAL.h
+ */
+int STMSensorsSubscriptions::subscribe(uint32_t handle,
+                                       int64_t periodNs,
+                                       int64_t latencyNs,
+                                       size_t queueLength,
+                                       std::unique_ptr<ISTMSensorsSubscription> &subscription)
+{
+    std::unique_ptr<Subscription> s;
+    int err;
+
+    if ((periodNs < 0) || (latencyNs < 0) || (queueLength == 0)) {
+        return -EINVAL;
+    }
+
+    s = std::make_unique<Subscription>(this, handle, periodNs, latencyNs, queueLength);
+
+    err = s->open();
+    if (err < 0) {
+        return err;
+    }
+
+    std::lock_guard<std::mutex> lock(configLock);
+    SensorClients &clients = getSensorClients(handle);
+
+    {
+        std::lock_guard<std::mutex> lock(dispatchLock);
+        clients.subscriptions.push_back(s.get());
+        subscriptionsCount++;
+    }
+
+    err = applyConfiguration(handle, clients);
+    if (err < 0) {
+        {
+            std::lock_guard<std::mutex> lock(dispatchLock);
+            clients.subscriptions.pop_back();
+            subscriptionsCount--;
+        }
+
+        s->detach();
+        applyConfiguration(handle, clients);
+
+        return err;
+    }
+
+    subscription = std::move(s);
+
+    return 0;
+}
+
+void STMSensorsSubscriptions::unsubscribe(Subscription *subscription)
+{
+    std::lock_guard<std::mutex> lock(configLock);
+    uint32_t handle = subscription->getSensorHandle();
+
+    auto itr = sensors.find(handle);
+    if (itr == sensors.end()) {
+        return;
+    }
+
+    auto &list = itr->second.subscriptions;
+    auto pos = std::find(list.begin(), list.end(), subscription);
+    if (pos == list.end()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(dispatchLock);
+        list.erase(pos);
+        subscriptionsCount--;
+    }
+
+    if (applyConfiguration(handle, itr->second) < 0) {
+        console.error("failed to configure sensor " + std::to_string(handle) + " after unsubscribe");
+    }
+}
+
+size_t STMSensorsSubscriptions::dispatch(STMSensorsRecord *records, size_t count)
+{
+    std::lock_guard<std::mutex> lock(dispatchLock);
+    size_t kept = 0;
+
+    if (subscriptionsCount == 0) {
+        return count;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const STMSensorsRecord &record = records[i];
+        bool legacy = true;
+
+        if (isSensorSample(record.sensorType)) {
+            auto itr = sensors.find(record.sensorHandle);
+
+            if ((itr != sensors.end()) && !itr->second.subscriptions.empty()) {
+                for (auto *subscription : itr->second.subscriptions) {
+                    subscription->push(record);
+                }
+
+                legacy = itr->second.legacyEnabled;
+            }
+        }
+
+        if (legacy) {
+            if (kept != i) {
+                records[kept] = record;
+            }
+            kept++;
+        }
+    }
+
+    return kept;
+}
+
+void STMSensorsSubscriptions::remove(uint32_t handle)
+{
+    std::lock_guard<std::mutex> lock(configLock);
+
+    auto itr = sensors.find(handle);
+    if (itr == sensors.end()) {
+        return;
+    }
+
+    closeSubscriptions(itr->second);
+
+    std::lock_guard<std::mutex> dispatchGuard(dispatchLock);
+    sensors.erase(itr);
+}
+
+void STMSensorsSubscriptions::clear(void)
+{
+    std::lock_guard<std::mutex> lock(configLock);
+
+    for (auto &sensor : sensors) {
+        closeSubscriptions(sensor.second);
+    }
+
+    std::lock_guard<std::mutex> dispatchGuard(dispatchLock);
+    sensors.clear();
+}
+
+/*
+ * closed subscriptions are not in the lists anymore, their queue can still
+ * be read and they can be destroyed after the manager
+ */
+void STMSensorsSubscriptions::closeSubscriptions(SensorClients &clients)
+{
+    std::lock_guard<std::mutex> lock(dispatchLock);
+
+    for (auto *subscription : clients.subscriptions) {
+        subscription->close();
+        subscription->detach();
+    }
+
+    subscriptionsCount -= clients.subscriptions.size();
+    clients.subscriptions.clear();
+}
+
+STMSensorsSubscriptions::SensorClients &STMSensorsSubscriptions::getSensorClients(uint32_t handle)
+{
+    auto itr = sensors.find(handle);
+    if (itr != sensors.end()) {
+        return itr->second;
+    }
+
+    SensorClients clients;
+
+    clients.legacyEnabled = false;
+    clients.legacyPeriodNs = -1;
+    clients.legacyLatencyNs = -1;
+    clients.applied = false;
+    clients.appliedEnable = false;
+    clients.appliedPeriodNs = -1;
+    clients.appliedLatencyNs = -1;
+
+    std::lock_guard<std::mutex> lock(dispatchLock);
+
+    return sensors.emplace(handle, std::move(clients)).first->second;
+}
+
+/**
+ * applyConfiguration: configure the sensor for its enabled clients
+ * @handle: sensor handle.
+ * @clients: clients of the sensor.
+ *
+ * Return value: 0 on success, else a negative error code.
+ */
+int STMSensorsSubscriptions::applyConfiguration(uint32_t handle, SensorClients &clients)
+{
+    bool enable = clients.legacyEnabled || !clients.subscriptions.empty();
+    int64_t periodNs = INT64_MAX, latencyNs = INT64_MAX;
+    int err;
+
+    /* legacy rate is also applied while the sensor is disabled (batch before activate) */
+    if ((clients.legacyEnabled || !enable) && (clients.legacyPeriodNs >= 0)) {
+        periodNs = clients.legacyPeriodNs;
+        latencyNs = clients.legacyLatencyNs;
+    }
+
+    for (auto *subscription : clients.subscriptions) {
+        periodNs = std::min(periodNs, subscription->getSamplingPeriodNs());
+        latencyNs = std::min(latencyNs, subscription->getMaxReportLatencyNs());
+    }
+
+    if ((periodNs != INT64_MAX) &&
+        ((periodNs != clients.appliedPeriodNs) || (latencyNs != clients.appliedLatencyNs))) {
+        err = batchFunction(handle, periodNs, latencyNs);
+        if (err < 0) {
+            return err;
+        }
+
+        clients.appliedPeriodNs = periodNs;
+        clients.appliedLatencyNs = latencyNs;
+    }
+
+    if (!clients.applied || (enable != clients.appliedEnable)) {
+        err = activateFunction(handle, enable);
+        if (err < 0) {
+            return err;
+        }
+
+        clients.applied = true;
+        clients.appliedEnable = enable;
+    }
+
+    return 0;
+}
+
+} // namespace core
+} // namespace stm
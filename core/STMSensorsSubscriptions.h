@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <ISTMSensorsSubscription.h>
+#include <STMSensorsRecords.h>
+
+namespace stm {
+namespace core {
+
+/*
+ * Clients of the sensors: the legacy client (activate / setRate, the
+ * wrapper) and the in-process subscriptions. For each sensor the hardware is
+ * configured with the fastest period and the shortest latency of the enabled
+ * clients, samples are then decimated for each subscription.
+ *
+ * Configuration calls are serialized by configLock, which is held while the
+ * sensors are configured. dispatch (sensors data thread) only takes
+ * dispatchLock, held for short updates of the subscriptions lists.
+ */
+class STMSensorsSubscriptions {
+public:
+    using ActivateFunction = std::function<int(uint32_t handle, bool enable)>;
+    using BatchFunction = std::function<int(uint32_t handle, int64_t periodNs, int64_t latencyNs)>;
+
+    STMSensorsSubscriptions(ActivateFunction activateFunction, BatchFunction batchFunction);
+
+    /* open subscriptions are closed, they can be destroyed after the object */
+    ~STMSensorsSubscriptions(void);
+
+    STMSensorsSubscriptions(const STMSensorsSubscriptions &) = delete;
+    STMSensorsSubscriptions &operator=(const STMSensorsSubscriptions &) = delete;
+
+    /* legacy client */
+    int activate(uint32_t handle, bool enable);
+    int setRate(uint32_t handle, int64_t periodNs, int64_t latencyNs);
+
+    int subscribe(uint32_t handle, int64_t periodNs, int64_t latencyNs, size_t queueLength,
+                  std::unique_ptr<ISTMSensorsSubscription> &subscription);
+
+    /**
+     * dispatch: queue samples to the subscriptions, samples of sensors only
+     *           enabled by subscriptions are removed from records
+     *
+     * Return value: number of records left for the legacy client.
+     */
+    size_t dispatch(STMSensorsRecord *records, size_t count);
+
+    /* the sensor is not available anymore, its subscriptions are closed */
+    void remove(uint32_t handle);
+
+    /* close all subscriptions and forget sensors configuration */
+    void clear(void);
+
+private:
+    class Subscription;
+
+    struct SensorClients {
+        bool legacyEnabled;
+        int64_t legacyPeriodNs;
+        int64_t legacyLatencyNs;
+
+        std::vector<Subscription *> subscriptions;
+
+        /* last hardware configuration */
+        bool applied;
+        bool appliedEnable;
+        int64_t appliedPeriodNs;
+        int64_t appliedLatencyNs;
+    };
+
+    ActivateFunction activateFunction;
+    BatchFunction batchFunction;
+
+    std::mutex configLock;
+    std::mutex dispatchLock;
+    std::unordered_map<uint32_t, SensorClients> sensors;
+    size_t subscriptionsCount;
+
+    SensorClients &getSensorClients(uint32_t handle);
+    int applyConfiguration(uint32_t handle, SensorClients &clients);
+    void unsubscribe(Subscription *subscription);
+    void closeSubscriptions(SensorClients &clients);
+};
+
+} // namespace core
+} // namespace stm
@@ -27,8 +27,7 @@ namespace core {
 SWAccelGyroFusion6X::SWAccelGyroFusion6X(const char *name, int handle, int module)
     : SWSensorBaseWithPollrate(name, handle,
                                AccelGyroFusion6XSensorType,
-                               false, false, true, false, module),
-      sensorsFusion(STMSensorsFusion6Axis::getInstance())
+                               false, false, true, false, module)
 {
     sensor_t_data.minRateHz = CONFIG_ST_HAL_MIN_FUSION_POLLRATE;
 
@@ -89,6 +88,9 @@ int SWAccelGyroFusion6X::Enable(int handle, bool enable, bool lock_en_mutex)
         return err;
     }
 
+    UpdateOutputMask();
+    UpdateFusionPeriod();
+
     if ((enable && !old_status) || (!enable && !old_status_no_handle)) {
         if (enable) {
             if (HAL_ENABLE_SENSORS_FUSION != 0) {
@@ -130,6 +132,8 @@ int SWAccelGyroFusion6X::SetDelay(int handle, int64_t period_ns, int64_t timeout
         return err;
     }
 
+    UpdateFusionPeriod();
+
     if (lock_en_mutex) {
         pthread_mutex_unlock(&enable_mutex);
     }
@@ -138,81 +142,178 @@ int SWAccelGyroFusion6X::SetDelay(int handle, int64_t period_ns, int64_t timeout
 }
 
 void SWAccelGyroFusion6X::ProcessData(SensorBaseData *data)
+{
+    ProcessDataBatch(data, 1);
+}
+
+void SWAccelGyroFusion6X::ProcessDataBatch(SensorBaseData *data, unsigned int count)
 {
     if (HAL_ENABLE_SENSORS_FUSION != 0) {
-        unsigned int i;
-        SensorBaseData accel_data;
-        int err, nomaxdata = 10;
-
-        do {
-            err = GetLatestValidDataFromDependency(SENSOR_DEPENDENCY_ID_0, &accel_data, data->timestamp);
-            if (err < 0) {
-                std::this_thread::sleep_for(std::chrono::microseconds(10));
-                nomaxdata--;
-                continue;
+        unsigned int i, n, valid, pushed = 0;
+        unsigned int mask = outputMask.load();
+
+        if (batchGyro.size() < count) {
+            batchAccel.resize(count);
+            batchGyro.resize(count);
+            batchTimestamps.resize(count);
+            batchIndex.resize(count);
+            batchOutputs.resize(count);
+        }
+
+        for (valid = 0, i = 0; i < count; i++) {
+            SensorBaseData accel_data;
+            int err, nomaxdata = 10;
+
+            do {
+                err = GetLatestValidDataFromDependency(SENSOR_DEPENDENCY_ID_0, &accel_data, data[i].timestamp);
+                if (err < 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                    nomaxdata--;
+                    continue;
+                }
+            } while ((nomaxdata >= 0) && (err < 0));
+
+            if (nomaxdata > 0) {
+                memcpy(batchAccel[valid].data(), accel_data.raw, 3 * sizeof(float));
+                memcpy(batchGyro[valid].data(), data[i].processed, 3 * sizeof(float));
+                batchTimestamps[valid] = data[i].timestamp;
+                batchIndex[valid] = i;
+                valid++;
             }
-        } while ((nomaxdata >= 0) && (err < 0));
+        }
 
-        if (nomaxdata > 0) {
-            std::array<float, 3> accelData;
-            std::array<float, 3> gyroData;
+        /*
+         * every sample is pushed to consumers with the fusion outputs of the
+         * latest processed sample, samples without accel data included
+         */
+        sensorsFusion.setUpdatePeriod(fusionPeriod.load());
+        sensorsFusion.run(batchAccel.data(), batchGyro.data(), batchTimestamps.data(), valid,
+                          mask, batchOutputs.data());
+
+        for (n = 0; n < valid; n++) {
+            for (; pushed <= batchIndex[n]; pushed++) {
+                PushFusionData(&data[pushed], batchOutputs[n]);
+            }
+        }
 
-            memcpy(accelData.data(), accel_data.raw, 3 * sizeof(float));
-            memcpy(gyroData.data(), data->processed, 3 * sizeof(float));
+        if (pushed < count) {
+            STMSensorsFusionOutput fusionOutput;
 
-            sensorsFusion.run(accelData, gyroData, data->timestamp);
+            sensorsFusion.getOutputs(mask, fusionOutput);
+            for (; pushed < count; pushed++) {
+                PushFusionData(&data[pushed], fusionOutput);
+            }
         }
+    }
+}
 
-        sensor_event.timestamp = data->timestamp;
-        outdata.timestamp = data->timestamp;
-        outdata.flushEventHandles = data->flushEventHandles;
-        outdata.flushEventsNum = data->flushEventsNum;
-        outdata.accuracy = data->accuracy;
-        outdata.pollrate_ns = data->pollrate_ns;
+void SWAccelGyroFusion6X::PushFusionData(SensorBaseData *data,
+                                         const STMSensorsFusionOutput &fusionOutput)
+{
+    unsigned int i;
+
+    sensor_event.timestamp = data->timestamp;
+    outdata.timestamp = data->timestamp;
+    outdata.flushEventHandles = data->flushEventHandles;
+    outdata.flushEventsNum = data->flushEventsNum;
+    outdata.accuracy = data->accuracy;
+    outdata.pollrate_ns = data->pollrate_ns;
+
+    std::lock_guard<std::mutex> lock(pushDataLock);
+    for (i = 0; i < push_data.num; i++) {
+        if (!push_data.sb[i]->ValidDataToPush(outdata.timestamp)) {
+            continue;
+        }
 
-        for (i = 0; i < push_data.num; i++) {
-            if (!push_data.sb[i]->ValidDataToPush(outdata.timestamp)) {
+        switch ((SensorType)push_data.sb[i]->GetType()) {
+        case SensorType::GAME_ROTATION_VECTOR:
+            if (!(fusionOutput.mask & STMSensorsFusionOutput::QUATERNION))
                 continue;
-            }
 
-            switch ((SensorType)push_data.sb[i]->GetType()) {
-            case SensorType::GAME_ROTATION_VECTOR:
-                std::array<float, 4> quaternion;
+            memcpy(outdata.processed, fusionOutput.quaternion.data(), 4 * sizeof(float));
+            break;
 
-                err = sensorsFusion.getQuaternion(quaternion);
-                if (err < 0)
-                    continue;
+        case SensorType::GRAVITY:
+            if (!(fusionOutput.mask & STMSensorsFusionOutput::GRAVITY))
+                continue;
 
-                memcpy(outdata.processed, quaternion.data(), 4 * sizeof(float));
-                break;
+            memcpy(outdata.processed, fusionOutput.gravity.data(), 3 * sizeof(float));
+            break;
 
-            case SensorType::GRAVITY:
-                std::array<float, 3> gravity;
+        case SensorType::LINEAR_ACCELERATION:
+            if (!(fusionOutput.mask & STMSensorsFusionOutput::LINEAR_ACCEL))
+                continue;
 
-                err = sensorsFusion.getGravity(gravity);
-                if (err < 0)
-                    continue;
+            memcpy(outdata.processed, fusionOutput.linearAccel.data(), 3 * sizeof(float));
+            break;
 
-                memcpy(outdata.processed, gravity.data(), 3 * sizeof(float));
-                break;
+        default:
+            return;
+        }
 
-            case SensorType::LINEAR_ACCELERATION:
-                std::array<float, 3> linearAccel;
+        push_data.sb[i]->ReceiveDataFromDependency(sensor_t_data.handle, &outdata);
+    }
+}
 
-                err = sensorsFusion.getLinearAccel(linearAccel);
-                if (err < 0)
-                    continue;
+/**
+ * UpdateOutputMask: select fusion outputs having enabled consumers,
+ *                   called with enable_mutex held
+ */
+void SWAccelGyroFusion6X::UpdateOutputMask(void)
+{
+    unsigned int i, mask = 0;
 
-                memcpy(outdata.processed, linearAccel.data(), 3 * sizeof(float));
-                break;
+    std::lock_guard<std::mutex> lock(pushDataLock);
+    for (i = 0; i < push_data.num; i++) {
+        if (!GetStatusOfHandle(push_data.sb[i]->GetHandle())) {
+            continue;
+        }
 
-            default:
-                return;
-            }
+        switch ((SensorType)push_data.sb[i]->GetType()) {
+        case SensorType::GAME_ROTATION_VECTOR:
+            mask |= STMSensorsFusionOutput::QUATERNION;
+            break;
+
+        case SensorType::GRAVITY:
+            mask |= STMSensorsFusionOutput::GRAVITY;
+            break;
 
-            push_data.sb[i]->ReceiveDataFromDependency(sensor_t_data.handle, &outdata);
+        case SensorType::LINEAR_ACCELERATION:
+            mask |= STMSensorsFusionOutput::LINEAR_ACCEL;
+            break;
+
+        default:
+            break;
         }
     }
+
+    outputMask.store(mask);
+}
+
+/**
+ * UpdateFusionPeriod: run fusion step at the rate of the fastest enabled
+ *                     consumer, gyroscope samples in between are integrated
+ */
+void SWAccelGyroFusion6X::UpdateFusionPeriod(void)
+{
+    int i;
+    int64_t period_ns = 0;
+
+    if (HAL_ENABLE_ADAPTIVE_FUSION_RATE == 0) {
+        return;
+    }
+
+    for (i = 0; i < ST_HAL_IIO_MAX_DEVICES; i++) {
+        if (!GetStatusOfHandle(i) || (sensors_pollrates[i] <= 0)) {
+            continue;
+        }
+
+        if ((period_ns == 0) || (sensors_pollrates[i] < period_ns)) {
+            period_ns = sensors_pollrates[i];
+        }
+    }
+
+    fusionPeriod.store(period_ns);
 }
 
 } // namespace core
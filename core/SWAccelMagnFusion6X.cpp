@@ -15,6 +15,7 @@
 #include <signal.h>
 #include <unistd.h>
 
+#include "Utils.h"
 #include "SWAccelMagnFusion6X.h"
 
 namespace stm {
@@ -23,7 +24,7 @@ namespace core {
 SWAccelMagnFusion6X::SWAccelMagnFusion6X(const char *name, int handle, int module)
     : SWSensorBaseWithPollrate(name, handle, AccelMagnFusion6XSensorType,
                                false, false, true, false, module),
-      geomagFusion(STMGeomagFusion::getInstance())
+      last_timestamp(0)
 {
     sensor_t_data.minRateHz = CONFIG_ST_HAL_MIN_FUSION_POLLRATE;
 
@@ -88,6 +89,9 @@ int SWAccelMagnFusion6X::Enable(int handle, bool enable, bool lock_en_mutex)
             sensor_global_enable = utils.getTime();
         else
             sensor_global_disable = utils.getTime();
+
+        /* no time delta for the first sample after (re)enable */
+        last_timestamp = 0;
     }
 
     if (lock_en_mutex) {
@@ -130,6 +134,7 @@ void SWAccelMagnFusion6X::ProcessData(SensorBaseData *data)
         unsigned int i;
         int err, nomaxdata = 10;
         SensorBaseData magn_data;
+        std::array<float, 4> quaternion;
 
         do {
             err = GetLatestValidDataFromDependency(SENSOR_DEPENDENCY_ID_1,
@@ -143,17 +148,30 @@ void SWAccelMagnFusion6X::ProcessData(SensorBaseData *data)
         } while ((nomaxdata >= 0) && (err < 0));
 
         if (nomaxdata > 0) {
-            int64_t delta_ms;
             std::array<float, 3> accelData;
             std::array<float, 3> magnData;
+            float delta_ms = 0.0f;
 
-            memcpy(magnData.data(), magn_data.raw, 3 * sizeof(float));
             memcpy(accelData.data(), data->processed, 3 * sizeof(float));
 
-            delta_ms = (data->timestamp - sensor_event.timestamp) / 1000000;
+            /* calibrated magnetometer data, library works in uT */
+            for (auto j = 0U; j < magnData.size(); ++j) {
+                magnData[j] = Conversion::G_to_uTesla(magn_data.processed[j]);
+            }
+
+            if ((last_timestamp > 0) && (data->timestamp > last_timestamp)) {
+                delta_ms = NS_TO_MS(data->timestamp - last_timestamp);
+            }
+            last_timestamp = data->timestamp;
+
             geomagFusion.run(accelData, magnData, delta_ms);
         }
 
+        /* same quaternion for all consumers */
+        if (geomagFusion.getQuaternion(quaternion) < 0) {
+            return;
+        }
+
         sensor_event.timestamp = data->timestamp;
         outdata.timestamp = data->timestamp;
         outdata.flushEventHandles = data->flushEventHandles;
@@ -161,6 +179,7 @@ void SWAccelMagnFusion6X::ProcessData(SensorBaseData *data)
         outdata.accuracy = data->accuracy;
         outdata.pollrate_ns = data->pollrate_ns;
 
+        std::lock_guard<std::mutex> lock(pushDataLock);
         for (i = 0; i < push_data.num; i++) {
             if (!push_data.sb[i]->ValidDataToPush(outdata.timestamp))
                 continue;
@@ -168,20 +187,14 @@ void SWAccelMagnFusion6X::ProcessData(SensorBaseData *data)
             switch ((SensorType)push_data.sb[i]->GetType()) {
             case SensorType::ROTATION_VECTOR:
             case SensorType::GEOMAGNETIC_ROTATION_VECTOR:
-                std::array<float, 4> quaternion;
-
-                err = geomagFusion.getQuaternion(quaternion);
-                if (err < 0)
-                    continue;
-
                 memcpy(outdata.processed, quaternion.data(), 4 * sizeof(float));
 
                 break;
             default:
-                return;
+                continue;
             }
 
-        push_data.sb[i]->ReceiveDataFromDependency(sensor_t_data.handle, &outdata);
+            push_data.sb[i]->ReceiveDataFromDependency(sensor_t_data.handle, &outdata);
         }
     }
 }
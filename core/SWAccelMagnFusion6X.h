@@ -40,7 +40,10 @@ public:
     virtual void ProcessData(SensorBaseData *data) override;
 
 private:
-    STMGeomagFusion& geomagFusion;
+    STMGeomagFusion geomagFusion;
+
+    /* timestamp of the last sample run by the library */
+    int64_t last_timestamp;
 };
 
 } // namespace core
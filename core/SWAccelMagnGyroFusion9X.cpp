@@ -28,8 +28,7 @@ namespace core {
 SWAccelMagnGyroFusion9X::SWAccelMagnGyroFusion9X(const char *name, int handle, int module)
     : SWSensorBaseWithPollrate(name, handle,
                                AccelMagnGyroFusion9XSensorType,
-                               false, false, true, false, module),
-      sensorsFusion(STMSensorsFusion9Axis::getInstance())
+                               false, false, true, false, module)
 {
     sensor_t_data.minRateHz = CONFIG_ST_HAL_MIN_FUSION_POLLRATE;
     sensor_t_data.resolution = ST_SENSOR_FUSION_RESOLUTION(1.0f);
@@ -90,6 +89,9 @@ int SWAccelMagnGyroFusion9X::Enable(int handle, bool enable, bool lock_en_mutex)
         return err;
     }
 
+    UpdateOutputMask();
+    UpdateFusionPeriod();
+
     if ((enable && !old_status) || (!enable && !old_status_no_handle)) {
         if (enable) {
             if (HAL_ENABLE_SENSORS_FUSION != 0) {
@@ -131,6 +133,8 @@ int SWAccelMagnGyroFusion9X::SetDelay(int handle, int64_t period_ns, int64_t tim
         return err;
     }
 
+    UpdateFusionPeriod();
+
     if (lock_en_mutex) {
         pthread_mutex_unlock(&enable_mutex);
     }
@@ -139,106 +143,204 @@ int SWAccelMagnGyroFusion9X::SetDelay(int handle, int64_t period_ns, int64_t tim
 }
 
 void SWAccelMagnGyroFusion9X::ProcessData(SensorBaseData *data)
+{
+    ProcessDataBatch(data, 1);
+}
+
+void SWAccelMagnGyroFusion9X::ProcessDataBatch(SensorBaseData *data, unsigned int count)
 {
     if (HAL_ENABLE_SENSORS_FUSION != 0) {
-        unsigned int i;
-        SensorBaseData accel_data, magn_data;
-        int err, nomaxdata_accel = 10, nomaxdata_magn = 10;
-
-        do {
-            err = GetLatestValidDataFromDependency(SENSOR_DEPENDENCY_ID_1, &accel_data, data->timestamp);
-            if (err < 0) {
-                std::this_thread::sleep_for(std::chrono::microseconds(10));
-                nomaxdata_accel--;
-                continue;
-            }
-        } while ((nomaxdata_accel >= 0) && (err < 0));
+        unsigned int i, n, valid, pushed = 0;
+        unsigned int mask = outputMask.load();
+
+        if (batchGyro.size() < count) {
+            batchAccel.resize(count);
+            batchMagn.resize(count);
+            batchGyro.resize(count);
+            batchTimestamps.resize(count);
+            batchIndex.resize(count);
+            batchOutputs.resize(count);
+            batchMagnAccuracy.resize(count);
+        }
 
-        do {
-            err = GetLatestValidDataFromDependency(SENSOR_DEPENDENCY_ID_0, &magn_data, data->timestamp);
-            if (err < 0) {
-                std::this_thread::sleep_for(std::chrono::microseconds(10));
-                nomaxdata_magn--;
-                continue;
+        for (valid = 0, i = 0; i < count; i++) {
+            SensorBaseData accel_data, magn_data;
+            int err, nomaxdata_accel = 10, nomaxdata_magn = 10;
+
+            do {
+                err = GetLatestValidDataFromDependency(SENSOR_DEPENDENCY_ID_1, &accel_data, data[i].timestamp);
+                if (err < 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                    nomaxdata_accel--;
+                    continue;
+                }
+            } while ((nomaxdata_accel >= 0) && (err < 0));
+
+            do {
+                err = GetLatestValidDataFromDependency(SENSOR_DEPENDENCY_ID_0, &magn_data, data[i].timestamp);
+                if (err < 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                    nomaxdata_magn--;
+                    continue;
+                }
+            } while ((nomaxdata_magn >= 0) && (err < 0));
+
+            batchMagnAccuracy[i] = (nomaxdata_magn > 0) ? (int)magn_data.accuracy : (int)SENSOR_STATUS_UNRELIABLE;
+
+            if ((nomaxdata_accel > 0) && (nomaxdata_magn > 0)) {
+                memcpy(batchAccel[valid].data(), accel_data.raw, 3 * sizeof(float));
+                memcpy(batchGyro[valid].data(), data[i].processed, 3 * sizeof(float));
+                batchTimestamps[valid] = data[i].timestamp;
+                batchIndex[valid] = i;
+
+                for (auto j = 0U; j < batchMagn[valid].size(); ++j) {
+                    batchMagn[valid][j] = Conversion::G_to_uTesla(magn_data.raw[j]);
+                }
+
+                valid++;
             }
-        } while ((nomaxdata_magn >= 0) && (err < 0));
+        }
 
-        if ((nomaxdata_accel > 0) && (nomaxdata_magn > 0)) {
-            std::array<float, 3> accelData;
-            std::array<float, 3> magnData;
-            std::array<float, 3> gyroData;
+        /* see SWAccelGyroFusion6X::ProcessDataBatch */
+        sensorsFusion.setUpdatePeriod(fusionPeriod.load());
+        sensorsFusion.run(batchAccel.data(), batchMagn.data(), batchGyro.data(),
+                          batchTimestamps.data(), valid,
+                          mask, batchOutputs.data());
 
-            memcpy(accelData.data(), accel_data.raw, 3 * sizeof(float));
-            memcpy(magnData.data(), magn_data.raw, 3 * sizeof(float));
-            memcpy(gyroData.data(), data->processed, 3 * sizeof(float));
+        for (n = 0; n < valid; n++) {
+            for (; pushed <= batchIndex[n]; pushed++) {
+                PushFusionData(&data[pushed], batchMagnAccuracy[pushed], batchOutputs[n]);
+            }
+        }
+
+        if (pushed < count) {
+            STMSensorsFusionOutput fusionOutput;
 
-            for (auto i = 0U; i < magnData.size(); ++i) {
-                magnData[i] = Conversion::G_to_uTesla(magnData[i]);
+            sensorsFusion.getOutputs(mask, fusionOutput);
+            for (; pushed < count; pushed++) {
+                PushFusionData(&data[pushed], batchMagnAccuracy[pushed], fusionOutput);
             }
+        }
+    }
+}
 
-            sensorsFusion.run(accelData, magnData, gyroData, data->timestamp);
+void SWAccelMagnGyroFusion9X::PushFusionData(SensorBaseData *data, int magnAccuracy,
+                                             const STMSensorsFusionOutput &fusionOutput)
+{
+    unsigned int i;
+
+    sensor_event.timestamp = data->timestamp;
+    outdata.timestamp = data->timestamp;
+    outdata.flushEventHandles = data->flushEventHandles;
+    outdata.flushEventsNum = data->flushEventsNum;
+    outdata.accuracy = data->accuracy < magnAccuracy ? data->accuracy : magnAccuracy;
+    outdata.pollrate_ns = data->pollrate_ns;
+
+    std::lock_guard<std::mutex> lock(pushDataLock);
+    for (i = 0; i < push_data.num; i++) {
+        if (!push_data.sb[i]->ValidDataToPush(outdata.timestamp)) {
+            continue;
         }
 
-        sensor_event.timestamp = data->timestamp;
-        outdata.timestamp = data->timestamp;
-        outdata.flushEventHandles = data->flushEventHandles;
-        outdata.flushEventsNum = data->flushEventsNum;
-        outdata.accuracy = data->accuracy < magn_data.accuracy ? data->accuracy : magn_data.accuracy;
-        outdata.pollrate_ns = data->pollrate_ns;
+        switch ((SensorType)push_data.sb[i]->GetType()) {
+        case SensorType::ROTATION_VECTOR:
+            if (!(fusionOutput.mask & STMSensorsFusionOutput::QUATERNION))
+                continue;
+
+            memcpy(outdata.processed, fusionOutput.quaternion.data(), 4 * sizeof(float));
+            break;
 
-        for (i = 0; i < push_data.num; i++) {
-            if (!push_data.sb[i]->ValidDataToPush(outdata.timestamp)) {
+        case SensorType::ORIENTATION:
+            if (!(fusionOutput.mask & STMSensorsFusionOutput::EULER_ANGLES))
                 continue;
-            }
 
-            switch ((SensorType)push_data.sb[i]->GetType()) {
-            case SensorType::ROTATION_VECTOR:
-                std::array<float, 4> quaternion;
+            memcpy(outdata.processed, fusionOutput.eulerAngles.data(), 3 * sizeof(float));
+            break;
 
-                err = sensorsFusion.getQuaternion(quaternion);
-                if (err < 0)
-                    continue;
+        case SensorType::GRAVITY:
+            if (!(fusionOutput.mask & STMSensorsFusionOutput::GRAVITY))
+                continue;
 
-                memcpy(outdata.processed, quaternion.data(), 4 * sizeof(float));
-                break;
+            memcpy(outdata.processed, fusionOutput.gravity.data(), 3 * sizeof(float));
+            break;
 
-            case SensorType::ORIENTATION:
-                std::array<float, 3> orientation;
+        case SensorType::LINEAR_ACCELERATION:
+            if (!(fusionOutput.mask & STMSensorsFusionOutput::LINEAR_ACCEL))
+                continue;
 
-                err = sensorsFusion.getEulerAngles(orientation);
-                if (err < 0)
-                    continue;
+            memcpy(outdata.processed, fusionOutput.linearAccel.data(), 3 * sizeof(float));
+            break;
 
-                memcpy(outdata.processed, orientation.data(), 3 * sizeof(float));
-                break;
+        default:
+            return;
+        }
 
-            case SensorType::GRAVITY:
-                std::array<float, 3> gravity;
+        push_data.sb[i]->ReceiveDataFromDependency(sensor_t_data.handle, &outdata);
+    }
+}
 
-                err = sensorsFusion.getGravity(gravity);
-                if (err < 0)
-                    continue;
+/**
+ * UpdateOutputMask: select fusion outputs having enabled consumers,
+ *                   called with enable_mutex held
+ */
+void SWAccelMagnGyroFusion9X::UpdateOutputMask(void)
+{
+    unsigned int i, mask = 0;
 
-                memcpy(outdata.processed, gravity.data(), 3 * sizeof(float));
-                break;
+    std::lock_guard<std::mutex> lock(pushDataLock);
+    for (i = 0; i < push_data.num; i++) {
+        if (!GetStatusOfHandle(push_data.sb[i]->GetHandle())) {
+            continue;
+        }
 
-            case SensorType::LINEAR_ACCELERATION:
-                std::array<float, 3> linearAccel;
+        switch ((SensorType)push_data.sb[i]->GetType()) {
+        case SensorType::ROTATION_VECTOR:
+            mask |= STMSensorsFusionOutput::QUATERNION;
+            break;
 
-                err = sensorsFusion.getLinearAccel(linearAccel);
-                if (err < 0)
-                    continue;
+        case SensorType::ORIENTATION:
+            mask |= STMSensorsFusionOutput::EULER_ANGLES;
+            break;
 
-                memcpy(outdata.processed, linearAccel.data(), 3 * sizeof(float));
-                break;
+        case SensorType::GRAVITY:
+            mask |= STMSensorsFusionOutput::GRAVITY;
+            break;
 
-            default:
-                return;
-            }
+        case SensorType::LINEAR_ACCELERATION:
+            mask |= STMSensorsFusionOutput::LINEAR_ACCEL;
+            break;
 
-            push_data.sb[i]->ReceiveDataFromDependency(sensor_t_data.handle, &outdata);
+        default:
+            break;
         }
     }
+
+    outputMask.store(mask);
+}
+
+/**
+ * UpdateFusionPeriod: fusion step period from enabled consumers pollrates
+ */
+void SWAccelMagnGyroFusion9X::UpdateFusionPeriod(void)
+{
+    int i;
+    int64_t period_ns = 0;
+
+    if (HAL_ENABLE_ADAPTIVE_FUSION_RATE == 0) {
+        return;
+    }
+
+    for (i = 0; i < ST_HAL_IIO_MAX_DEVICES; i++) {
+        if (!GetStatusOfHandle(i) || (sensors_pollrates[i] <= 0)) {
+            continue;
+        }
+
+        if ((period_ns == 0) || (sensors_pollrates[i] < period_ns)) {
+            period_ns = sensors_pollrates[i];
+        }
+    }
+
+    fusionPeriod.store(period_ns);
 }
 
 } // namespace core
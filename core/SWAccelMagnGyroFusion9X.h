@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <vector>
+
 #include "SWSensorBase.h"
 
 #include <STMSensorsFusion9Axis.h>
@@ -38,9 +41,30 @@ public:
     virtual int Enable(int handle, bool enable, bool lock_en_mutex) override;
     virtual int SetDelay(int handle, int64_t period_ns, int64_t timeout, bool lock_en_mutex) override;
     virtual void ProcessData(SensorBaseData *data) override;
+    virtual void ProcessDataBatch(SensorBaseData *data, unsigned int count) override;
 
 private:
-    STMSensorsFusion9Axis& sensorsFusion;
+    STMSensorsFusion9Axis sensorsFusion;
+
+    /* fusion library input, grown on demand to the largest batch */
+    std::vector<std::array<float, 3>> batchAccel;
+    std::vector<std::array<float, 3>> batchMagn;
+    std::vector<std::array<float, 3>> batchGyro;
+    std::vector<int64_t> batchTimestamps;
+    std::vector<unsigned int> batchIndex;
+    std::vector<STMSensorsFusionOutput> batchOutputs;
+    std::vector<int> batchMagnAccuracy;
+
+    /* STMSensorsFusionOutput flags of outputs with enabled consumers */
+    std::atomic<unsigned int> outputMask { 0 };
+
+    /* fusion step period, 0 to run it on every gyroscope sample */
+    std::atomic<int64_t> fusionPeriod { 0 };
+
+    void UpdateOutputMask(void);
+    void UpdateFusionPeriod(void);
+    void PushFusionData(SensorBaseData *data, int magnAccuracy,
+                        const STMSensorsFusionOutput &fusionOutput);
 };
 
 } // namespace core
@@ -183,7 +183,7 @@ int SWSensorBase::flushRequest(int handle, bool lock_en_mutex)
     }
 
     if (GetStatus(false)) {
-        for (i = 0; i < dependencies.num; i++) {
+        for (i = 0; !planDriven && (i < dependencies.num); i++) {
             err = dependencies.sb[i]->flushRequest(handle, true);
             if (err < 0) {
                 goto unlock_mutex;
@@ -228,6 +228,7 @@ void SWSensorBase::ProcessFlushData(int handle, int64_t timestamp)
     int err;
 
     pthread_mutex_lock(&sample_in_processing_mutex);
+    std::unique_lock<std::mutex> lock(pushDataLock);
 
     if (sensor_t_data.type.isInternal()) {
         for (i = 0; i < push_data.num; i++) {
@@ -252,6 +253,7 @@ void SWSensorBase::ProcessFlushData(int handle, int64_t timestamp)
         }
     }
 
+    lock.unlock();
     pthread_mutex_unlock(&sample_in_processing_mutex);
 }
 
@@ -285,7 +287,7 @@ void SWSensorBase::ReceiveDataFromDependency(int handle, SensorBaseData *data)
 void SWSensorBase::ThreadDataTask(std::atomic<bool>& threadsRunning)
 {
     int err, flush_handle;
-    unsigned int i, fifo_len;
+    unsigned int i, count, fifo_len;
     int64_t timestamp_flush;
 
     if (sensor_t_data.fifoMaxEventCount > 0) {
@@ -300,7 +302,7 @@ void SWSensorBase::ThreadDataTask(std::atomic<bool>& threadsRunning)
         return;
     }
 
-    while (threadsRunning.load()) {
+    while (ThreadWaitActive(threadsRunning)) {
         err = poll(&android_pollfd, 1, 200);
         if (err < 0)
             continue;
@@ -312,14 +314,19 @@ void SWSensorBase::ThreadDataTask(std::atomic<bool>& threadsRunning)
                 continue;
             }
 
-            for (i = 0; i < err / sizeof(SensorBaseData); i++) {
-                pthread_mutex_lock(&sample_in_processing_mutex);
-                if ((HAL_ENABLE_TIMESYNC != 0) && sensors_tmp_data[i].hasHwTimestamp) {
-                    sample_in_processing_timestamp = sensors_tmp_data[i].hwTimestamp;
-                } else {
-                    sample_in_processing_timestamp = sensors_tmp_data[i].timestamp;
+            count = err / sizeof(SensorBaseData);
+
+            for (i = 0; i < count; i++) {
+                /* see HWSensorBase::ThreadDataTask, samples are processed as a batch */
+                if (i == 0) {
+                    pthread_mutex_lock(&sample_in_processing_mutex);
+                    if ((HAL_ENABLE_TIMESYNC != 0) && sensors_tmp_data[i].hasHwTimestamp) {
+                        sample_in_processing_timestamp = sensors_tmp_data[i].hwTimestamp;
+                    } else {
+                        sample_in_processing_timestamp = sensors_tmp_data[i].timestamp;
+                    }
+                    pthread_mutex_unlock(&sample_in_processing_mutex);
                 }
-                pthread_mutex_unlock(&sample_in_processing_mutex);
 
                 bool retry = false;
 
@@ -340,9 +347,9 @@ void SWSensorBase::ThreadDataTask(std::atomic<bool>& threadsRunning)
                         retry = false;
                     }
                 } while (retry);
-
-                this->ProcessData(&sensors_tmp_data[i]);
             }
+
+            this->ProcessDataBatch(sensors_tmp_data, count);
         }
     }
 }
@@ -446,7 +453,7 @@ int SWSensorBaseWithPollrate::flushRequest(int handle, bool lock_en_mutex)
     }
 
     if (GetStatus(false)) {
-        for (i = 0; i < dependencies.num; i++) {
+        for (i = 0; !planDriven && (i < dependencies.num); i++) {
             err = dependencies.sb[i]->flushRequest(handle, true);
             if (err < 0) {
                 goto unlock_mutex;
@@ -484,6 +491,10 @@ void SWSensorBaseWithPollrate::WriteDataToPipe(int64_t hw_pollrate)
         odr_changed = true;
     }
 
+    if (WriteConvertedDataToPipe(hw_pollrate, odr_changed)) {
+        return;
+    }
+
     temp = (float)current_real_pollrate / hw_pollrate;
     decimator = (int)(temp + (temp / 20));
     samples_counter++;
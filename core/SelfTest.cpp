@@ -124,6 +124,8 @@ void SelfTest::ThreadCmdTask()
                 continue;
             }
 
+            std::lock_guard<std::mutex> lock(hal_data->planLock);
+
             if ((cmd_data.handle == 0) || (cmd_data.handle > (int)hal_data->handleToNodeId_.size())) {
                 return;
             }
@@ -21,17 +21,65 @@
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
+#include <system_error>
 
 #include "SensorBase.h"
 
+#include <PropertiesManager.h>
+
 namespace stm {
 namespace core {
 
 static IConsole &console { IConsole::getInstance() };
 
+/*
+ * Rate conversion applies to the axes data of accelerometer, gyroscope and
+ * magnetometer sensors (also uncalibrated and limited axes variants) and is
+ * configured by the decimation filter of the base sensor type. Accuracy and
+ * axes flags are not filtered.
+ */
+static size_t GetRateConverterChannels(const STMSensorType &type, SensorType *baseType)
+{
+    if (type.isInternal()) {
+        return 0;
+    }
+
+    switch ((SensorType)type) {
+    case SensorType::ACCELEROMETER:
+    case SensorType::ACCELEROMETER_LIMITED_AXES:
+        *baseType = SensorType::ACCELEROMETER;
+        return SENSOR_DATA_3AXIS;
+    case SensorType::ACCELEROMETER_UNCALIBRATED:
+    case SensorType::ACCELEROMETER_LIMITED_AXES_UNCALIBRATED:
+        *baseType = SensorType::ACCELEROMETER;
+        return 2 * SENSOR_DATA_3AXIS;
+    case SensorType::GYROSCOPE:
+    case SensorType::GYROSCOPE_LIMITED_AXES:
+        *baseType = SensorType::GYROSCOPE;
+        return SENSOR_DATA_3AXIS;
+    case SensorType::GYROSCOPE_UNCALIBRATED:
+    case SensorType::GYROSCOPE_LIMITED_AXES_UNCALIBRATED:
+        *baseType = SensorType::GYROSCOPE;
+        return 2 * SENSOR_DATA_3AXIS;
+    case SensorType::MAGNETOMETER:
+        *baseType = SensorType::MAGNETOMETER;
+        return SENSOR_DATA_3AXIS;
+    case SensorType::MAGNETOMETER_UNCALIBRATED:
+        *baseType = SensorType::MAGNETOMETER;
+        return 2 * SENSOR_DATA_3AXIS;
+    default:
+        return 0;
+    }
+}
+
+std::atomic<int> SensorBase::liveThreadsCount { 0 };
+
 SensorBase::SensorBase(const char *name, int handle, const STMSensorType &type, int module)
     : sensor_t_data(type),
       threadsRunning(true),
+      threadsParked(true),
+      threadsStarted(false),
+      planDriven(false),
       sensorsCallback(nullptr),
       moduleId(module)
 {
@@ -64,6 +112,14 @@ SensorBase::SensorBase(const char *name, int handle, const STMSensorType &type,
 
     sensor_t_data.name = android_name;
     sensor_t_data.handle = handle;
+    sensor_t_data.resolution = 0.0f;
+    sensor_t_data.maxRange = 0.0f;
+    sensor_t_data.power = 0.0f;
+    sensor_t_data.fifoRsvdCount = 0;
+    sensor_t_data.fifoMaxEventCount = 0;
+    sensor_t_data.minRateHz = 0.0f;
+    sensor_t_data.maxRateHz = 0.0f;
+    sensor_t_data.moduleId = module;
     //sensor_t_data.type = type;
     sensor_t_data.vendor = "STMicroelectronics";
 
@@ -80,6 +136,23 @@ SensorBase::SensorBase(const char *name, int handle, const STMSensorType &type,
     decimator = 1;
     samples_counter = 0;
 
+    rate_converter_mode = RateConverter::Mode::PICK;
+    rate_converter_hw_pollrate = 0;
+    rate_converter_pollrate = 0;
+
+    SensorType baseType;
+    rate_converter_channels = GetRateConverterChannels(type, &baseType);
+    if (rate_converter_channels > 0) {
+        int filter = PropertiesManager::getInstance().getDecimationFilter(baseType);
+
+        if ((filter >= (int)RateConverter::Mode::PICK) &&
+            (filter <= (int)RateConverter::Mode::RESAMPLE)) {
+            rate_converter_mode = (RateConverter::Mode)filter;
+        } else {
+            console.warning(GetName() + std::string(": invalid decimation filter, using pick"));
+        }
+    }
+
     injection_mode = SENSOR_INJECTION_NONE;
 
     write_pipe_fd = -EINVAL;
@@ -107,7 +180,12 @@ invalid_the_class:
 
 SensorBase::~SensorBase()
 {
-    threadsRunning = false;
+    {
+        std::lock_guard<std::mutex> lock(threadsParkLock);
+        threadsRunning = false;
+        threadsParked = false;
+    }
+    threadsParkCond.notify_all();
 
     close(write_pipe_fd);
     close(read_pipe_fd);
@@ -254,6 +332,13 @@ int SensorBase::Enable(int handle, bool enable, bool lock_en_mutex)
             SetBitEnableMask(handle);
             flush_stack.resetBuffer();
             lastDecimatedPollrate = 0;
+
+            /* threads must be ready before dependencies start pushing data */
+            err = startThreads();
+            if (err < 0) {
+                ResetBitEnableMask(handle);
+                goto enable_unlock_mutex;
+            }
         } else {
             err = SetDelay(handle, 0, INT64_MAX, false);
             if (err < 0) {
@@ -263,7 +348,7 @@ int SensorBase::Enable(int handle, bool enable, bool lock_en_mutex)
             ResetBitEnableMask(handle);
         }
 
-        for (i = 0; i < dependencies.num; i++) {
+        for (i = 0; !planDriven && (i < dependencies.num); i++) {
             err = dependencies.sb[i]->Enable(sensor_t_data.handle, enable, true);
             if (err < 0) {
                 goto restore_enable_dependencies;
@@ -271,9 +356,12 @@ int SensorBase::Enable(int handle, bool enable, bool lock_en_mutex)
         }
 
         if (enable) {
-            console.debug(GetName() + std::string(": power-on"));
+            console.debug(GetName() + std::string(": power-on, live threads: ") +
+                          std::to_string(getLiveThreadsCount()));
         }  else {
-            console.debug(GetName() + std::string(": power-off"));
+            stopThreads();
+            console.debug(GetName() + std::string(": power-off, live threads: ") +
+                          std::to_string(getLiveThreadsCount()));
         }
     } else {
         if (enable) {
@@ -302,6 +390,7 @@ restore_enable_dependencies:
 
     if (enable) {
         ResetBitEnableMask(handle);
+        stopThreads();
     }  else {
         SetBitEnableMask(handle);
     }
@@ -376,7 +465,7 @@ int SensorBase::SetDelay(int handle, int64_t period_ns, int64_t timeout, bool lo
     sensors_pollrates[handle] = period_ns;
     sensors_timeout[handle] = timeout;
 
-    for (i = 0; i < (int)dependencies.num; i++) {
+    for (i = 0; !planDriven && (i < (int)dependencies.num); i++) {
         err = dependencies.sb[i]->SetDelay(sensor_t_data.handle, GetMinPeriod(false), GetMinTimeout(false), true);
         if (err < 0) {
             goto restore_delay_dependencies;
@@ -404,6 +493,27 @@ int SensorBase::SetDelay(int handle, int64_t period_ns, int64_t timeout, bool lo
     return err;
 }
 
+/**
+ * GetDelay: read pollrate and timeout requested by a handle
+ * @handle: handle of the requesting sensor.
+ * @period_ns: requested period.
+ * @timeout: requested timeout.
+ * @lock_en_mutex: take enable mutex.
+ */
+void SensorBase::GetDelay(int handle, int64_t *period_ns, int64_t *timeout, bool lock_en_mutex)
+{
+    if (lock_en_mutex) {
+        pthread_mutex_lock(&enable_mutex);
+    }
+
+    *period_ns = sensors_pollrates[handle];
+    *timeout = sensors_timeout[handle];
+
+    if (lock_en_mutex) {
+        pthread_mutex_unlock(&enable_mutex);
+    }
+}
+
 int SensorBase::SetFullscale(int handle, float fullscale, bool lock_en_mute)
 {
     (void)handle;
@@ -441,6 +551,7 @@ int SensorBase::AddSensorToDataPush(SensorBase *t)
         return -ENOMEM;
     }
 
+    std::lock_guard<std::mutex> lock(pushDataLock);
     push_data.sb[push_data.num] = t;
     push_data.num++;
 
@@ -450,6 +561,7 @@ int SensorBase::AddSensorToDataPush(SensorBase *t)
 void SensorBase::RemoveSensorToDataPush(SensorBase *t)
 {
     unsigned int i;
+    std::lock_guard<std::mutex> lock(pushDataLock);
 
     for (i = 0; i < push_data.num; i++) {
         if (t == push_data.sb[i]) {
@@ -516,22 +628,71 @@ void SensorBase::RemoveSensorDependency(SensorBase *p)
     dependencies.num--;
 }
 
+/**
+ * startThreads: create sensor threads on first call, wake them up otherwise
+ * Return value: 0 on success, negative number if thread creation failed.
+ *
+ * Threads created before a failure are left parked, the missing ones are
+ * created again by the next call.
+ */
 int SensorBase::startThreads(void)
 {
-    if (hasDataChannels()) {
-        dataThread = std::make_unique<std::thread>(ThreadDataWork, this, std::ref(threadsRunning));
-    }
+    std::unique_lock<std::mutex> lock(threadsParkLock);
+
+    if (!threadsStarted) {
+        try {
+            if (hasDataChannels() && !dataThread) {
+                dataThread = std::make_unique<std::thread>(ThreadDataWork, this, std::ref(threadsRunning));
+                liveThreadsCount++;
+            }
 
-    if (hasEventChannels()) {
-        eventsThread = std::make_unique<std::thread>(ThreadEventsWork, this, std::ref(threadsRunning));
+            if (hasEventChannels() && !eventsThread) {
+                eventsThread = std::make_unique<std::thread>(ThreadEventsWork, this, std::ref(threadsRunning));
+                liveThreadsCount++;
+            }
+        } catch (const std::system_error &e) {
+            console.error(GetName() + std::string(": failed to create thread: ") + e.what());
+            return -ENOMEM;
+        }
+
+        threadsStarted = true;
     }
 
+    threadsParked = false;
+
+    lock.unlock();
+    threadsParkCond.notify_all();
+
     return 0;
 }
 
+/**
+ * stopThreads: park sensor threads, they stay alive but do not poll anymore
+ */
 void SensorBase::stopThreads(void)
 {
+    std::lock_guard<std::mutex> lock(threadsParkLock);
+
+    threadsParked = true;
+}
+
+/**
+ * ThreadWaitActive: block the calling sensor thread while parked
+ * @threadsRunning: running flag of the thread.
+ * Return value: true if the thread must continue its work, false if it must exit.
+ */
+bool SensorBase::ThreadWaitActive(std::atomic<bool>& threadsRunning)
+{
+    if (!threadsParked.load()) {
+        return threadsRunning.load();
+    }
+
+    std::unique_lock<std::mutex> lock(threadsParkLock);
+    threadsParkCond.wait(lock, [&] {
+        return !threadsParked.load() || !threadsRunning.load();
+    });
 
+    return threadsRunning.load();
 }
 
 struct sensor_t SensorBase::GetSensor_tData(void)
@@ -580,6 +741,62 @@ void SensorBase::WriteFlushEventToPipe()
     }
 }
 
+/**
+ * WriteConvertedDataToPipe: write sensor_event through the rate converter
+ * @hw_pollrate: pollrate of the data stream [ns].
+ * @odr_changed: a new requested pollrate is applied from this sample.
+ *
+ * Return value: false if the rate converter is not used for this sample,
+ *               the caller must apply the legacy decimation.
+ */
+bool SensorBase::WriteConvertedDataToPipe(int64_t hw_pollrate, bool odr_changed)
+{
+    int err;
+
+    if ((rate_converter_mode == RateConverter::Mode::PICK) ||
+        (rate_converter_channels == 0) || (hw_pollrate <= 0) ||
+        (current_real_pollrate <= hw_pollrate)) {
+        rate_converter_pollrate = 0;
+        return false;
+    }
+
+    if (odr_changed || (hw_pollrate != rate_converter_hw_pollrate) ||
+        (current_real_pollrate != rate_converter_pollrate)) {
+        err = rate_converter.configure(rate_converter_mode, rate_converter_channels,
+                                       hw_pollrate, current_real_pollrate);
+        if (err < 0) {
+            rate_converter_pollrate = 0;
+            return false;
+        }
+
+        rate_converter_hw_pollrate = hw_pollrate;
+        rate_converter_pollrate = current_real_pollrate;
+    }
+
+    int64_t outputPollrate = rate_converter.getOutputPeriodNs();
+    if (outputPollrate != lastDecimatedPollrate) {
+        WriteOdrChangeEventToPipe(sensor_event.timestamp, outputPollrate);
+    }
+    lastDecimatedPollrate = outputPollrate;
+
+    rate_converter.process(sensor_event.timestamp, sensor_event.data.data2,
+                           [this](int64_t timestamp, const float *out) {
+        sensors_event_t event = sensor_event;
+
+        memcpy(event.data.data2, out, rate_converter_channels * sizeof(float));
+        event.timestamp = timestamp;
+
+        if (write(write_pipe_fd, &event, sizeof(sensors_event_t)) <= 0) {
+            console.error(android_name + std::string(": Failed to write sensor data to pipe."));
+            return;
+        }
+
+        last_data_timestamp = timestamp;
+    });
+
+    return true;
+}
+
 void SensorBase::WriteDataToPipe(int64_t __attribute__((unused))hw_pollrate)
 {
     int err;
@@ -607,11 +824,25 @@ void SensorBase::ProcessData(SensorBaseData *data)
         }
     }
 
+    std::lock_guard<std::mutex> lock(pushDataLock);
     for (i = 0; i < push_data.num; i++) {
         push_data.sb[i]->ReceiveDataFromDependency(sensor_t_data.handle, data);
     }
 }
 
+/**
+ * ProcessDataBatch: process consecutive samples read at once from FIFO/pipe,
+ *                   sensors running algorithms on batches override it
+ * @data: array of samples.
+ * @count: number of samples.
+ */
+void SensorBase::ProcessDataBatch(SensorBaseData *data, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++) {
+        ProcessData(&data[i]);
+    }
+}
+
 void SensorBase::ReceiveDataFromDependency(int handle, SensorBaseData *data)
 {
     bool fill_buffer = false;
@@ -685,6 +916,7 @@ void *SensorBase::ThreadDataWork(void *context, std::atomic<bool>& threadsRunnin
     SensorBase *mypointer = (SensorBase *)context;
 
     mypointer->ThreadDataTask(threadsRunning);
+    liveThreadsCount--;
 
     return mypointer;
 }
@@ -699,6 +931,7 @@ void *SensorBase::ThreadEventsWork(void *context, std::atomic<bool>& threadsRunn
     SensorBase *mypointer = (SensorBase *)context;
 
     mypointer->ThreadEventsTask(threadsRunning);
+    liveThreadsCount--;
 
     return mypointer;
 }
@@ -30,6 +30,8 @@
 #include <vector>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <IConsole.h>
 #include <STMSensorType.h>
@@ -40,6 +42,7 @@
 #include <ChangeODRTimestampStack.h>
 #include <ISTMSensorsCallback.h>
 #include <SelfTest.h>
+#include <RateConverter.h>
 
 namespace stm {
 namespace core {
@@ -128,6 +131,13 @@ protected:
     uint8_t samples_counter;
     int64_t lastDecimatedPollrate = 0;
 
+    /* output rate conversion, selected per sensor type (decimation-filter) */
+    RateConverter rate_converter;
+    RateConverter::Mode rate_converter_mode;
+    size_t rate_converter_channels;
+    int64_t rate_converter_hw_pollrate;
+    int64_t rate_converter_pollrate;
+
     push_data_t push_data;
     dependencies_t dependencies;
 
@@ -145,6 +155,20 @@ protected:
     std::unique_ptr<std::thread> eventsThread;
     std::atomic<bool> threadsRunning;
 
+    /* threads are created on first enable and parked while the sensor is disabled */
+    std::mutex threadsParkLock;
+    std::condition_variable threadsParkCond;
+    std::atomic<bool> threadsParked;
+    bool threadsStarted;
+
+    static std::atomic<int> liveThreadsCount;
+
+    /* protect push_data against sensors added or removed at run-time */
+    std::mutex pushDataLock;
+
+    /* dependencies are driven by the HAL activation plans, do not recurse */
+    bool planDriven;
+
     ISTMSensorsCallback *sensorsCallback;
 
     int moduleId;
@@ -153,8 +177,6 @@ protected:
     bool GetStatusExcludeHandle(int handle);
     bool GetStatusOfHandle(int handle);
     bool GetStatusOfHandle(int handle, bool lock_en_mutex);
-    int64_t GetMinTimeout(bool lock_en_mutex);
-    int64_t GetMinPeriod(bool lock_en_mutex);
     DependencyID GetDependencyIDFromHandle(int handle);
 
     int AllocateBufferForDependencyData(DependencyID id, unsigned int max_fifo_len);
@@ -163,6 +185,10 @@ protected:
     void SetBitEnableMask(int handle);
     void ResetBitEnableMask(int handle);
 
+    bool ThreadWaitActive(std::atomic<bool>& threadsRunning);
+
+    bool WriteConvertedDataToPipe(int64_t hw_pollrate, bool odr_changed);
+
     int AddNewPollrate(int64_t timestamp, int64_t pollrate);
     int CheckLatestNewPollrate(int64_t *timestamp, int64_t *pollrate);
     void DeleteLatestNewPollrate();
@@ -195,6 +221,8 @@ public:
 
     virtual int startThreads(void);
     virtual void stopThreads(void);
+    bool threadsActive(void) const { return threadsStarted && !threadsParked.load(); };
+    static int getLiveThreadsCount(void) { return liveThreadsCount.load(); };
 
     virtual selftest_status ExecuteSelfTest();
 
@@ -203,9 +231,13 @@ public:
     void SetEnableTimestamp(int handle, bool enable, int64_t timestamp);
 
     virtual int SetDelay(int handle, int64_t period_ns, int64_t timeout, bool lock_en_mutex);
+    void GetDelay(int handle, int64_t *period_ns, int64_t *timeout, bool lock_en_mutex);
+    int64_t GetMinTimeout(bool lock_en_mutex);
+    int64_t GetMinPeriod(bool lock_en_mutex);
     virtual int SetFullscale(int handle, float fullscale, bool lock_en_mute);
 
     virtual int flushRequest(int handle, bool lock_en_mutex) = 0;
+    virtual int GetFlushForwardHandle(int handle) const { return handle; };
     virtual void ProcessFlushData(int handle, int64_t timestamp) = 0;
 
     void WriteOdrChangeEventToPipe(int64_t timestamp, int64_t pollrate);
@@ -213,6 +245,7 @@ public:
     virtual void WriteDataToPipe(int64_t hw_pollrate);
 
     virtual void ProcessData(SensorBaseData *data);
+    virtual void ProcessDataBatch(SensorBaseData *data, unsigned int count);
     virtual void ReceiveDataFromDependency(int handle, SensorBaseData *data);
     virtual int GetLatestValidDataFromDependency(int dependency_id, SensorBaseData *data, int64_t timesync);
 
@@ -234,6 +267,7 @@ public:
     virtual int getHandleOfMyTrigger(void) const;
 
     int getModuleId(void) const { return moduleId; };
+    void setPlanDriven(bool enable) { planDriven = enable; };
     virtual int getSupportedAxes(void);
 };
 
@@ -24,6 +24,7 @@
 #include <pthread.h>
 #include <endian.h>
 #include <unistd.h>
+#include <sys/eventfd.h>
 #include <memory>
 #include <array>
 #include <algorithm>
@@ -505,7 +506,8 @@ static bool isSensorSupported(const std::string &driverName,
     return false;
 }
 
-static int loadIIODevices(std::vector<STSensorHAL_iio_devices_data> &iioDeviceDataList)
+static int loadIIODevices(std::vector<STSensorHAL_iio_devices_data> &iioDeviceDataList,
+                          const std::unordered_set<unsigned int> &skipDevices = {})
 {
     struct device_iio_type_name iio_devices[ST_HAL_IIO_MAX_DEVICES];
     struct STSensorHAL_iio_devices_data data;
@@ -521,6 +523,10 @@ static int loadIIODevices(std::vector<STSensorHAL_iio_devices_data> &iioDeviceDa
     for (auto i = 0; i < len; i++) {
         const struct SensorsSupported *sensor;
 
+        if (skipDevices.count(iio_devices[i].num)) {
+            continue;
+        }
+
         if (!isSensorSupported(iio_devices[i].name, &sensor)) {
             continue;
         }
@@ -628,6 +634,264 @@ __attribute__((unused)) static void st_hal_free_iio_devices_data(STSensorHAL_iio
     }
 }
 
+enum {
+    PLAN_STEP_UNTOUCHED = 0,
+    PLAN_STEP_SYNC_DELAY,
+    PLAN_STEP_TRANSITION,
+};
+
+/**
+ * st_hal_compile_graph() - Build the flat graph and activation plans
+ * @hal_data: HAL data.
+ *
+ * Once compiled, sensors stop recursing through their dependencies and
+ * activation, rate changes and flushes are driven by the plans.
+ */
+static void st_hal_compile_graph(STSensorHAL_data *hal_data)
+{
+    hal_data->compiledGraph.compile(hal_data->graph);
+
+    hal_data->planState.assign(hal_data->compiledGraph.size(), PLAN_STEP_UNTOUCHED);
+    hal_data->planFlushHandle.assign(hal_data->compiledGraph.size(), 0);
+
+    for (uint32_t i = 0; i < hal_data->compiledGraph.size(); i++) {
+        hal_data->compiledGraph.payload(i)->setPlanDriven(true);
+    }
+
+    console.debug("sensors graph compiled: " + std::to_string(hal_data->compiledGraph.size()) +
+                  " nodes, " + std::to_string(hal_data->compiledGraph.edgesCount()) + " edges");
+}
+
+/**
+ * st_hal_plan_step_state() - Evaluate how a plan step must be propagated
+ * @sensor: sensor of the step.
+ * @was_on: sensor status before the step.
+ * @enable: enable/ disable flag.
+ *
+ * Return value: state to apply to the dependencies of the step.
+ */
+static int8_t st_hal_plan_step_state(SensorBase *sensor, bool was_on, bool enable)
+{
+    if (was_on != sensor->GetStatus(true)) {
+        return PLAN_STEP_TRANSITION;
+    }
+
+    /* a disable with other requesters still active changes the min pollrate */
+    return enable ? PLAN_STEP_UNTOUCHED : PLAN_STEP_SYNC_DELAY;
+}
+
+/**
+ * st_hal_plan_sync_delay() - Propagate pollrate/timeout along a plan
+ * @hal_data: HAL data.
+ * @plan: plan to walk.
+ *
+ * Return value: 0 on success, negative number on fail.
+ */
+static int st_hal_plan_sync_delay(STSensorHAL_data *hal_data,
+                                  const CompiledGraph<SensorBase>::Plan &plan)
+{
+    int err;
+
+    for (uint32_t s = 1; s < plan.size(); s++) {
+        SensorBase *sensor = hal_data->compiledGraph.payload(plan.steps[s]);
+
+        for (uint32_t r = plan.requestersOffset[s]; r < plan.requestersOffset[s + 1]; r++) {
+            SensorBase *requester = hal_data->compiledGraph.payload(plan.steps[plan.requesters[r]]);
+
+            err = sensor->SetDelay(requester->GetHandle(),
+                                   requester->GetMinPeriod(true),
+                                   requester->GetMinTimeout(true), true);
+            if (err < 0) {
+                return err;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * st_hal_plan_activate() - Enable or Disable a sensor walking its plan
+ * @hal_data: HAL data.
+ * @plan: plan of the sensor.
+ * @enable: enable/ disable flag.
+ *
+ * Return value: 0 on success, negative number on fail.
+ */
+static int st_hal_plan_activate(STSensorHAL_data *hal_data,
+                                const CompiledGraph<SensorBase>::Plan &plan,
+                                bool enable)
+{
+    int err = 0;
+    bool was_on;
+    uint32_t s, r = 0;
+    std::vector<int8_t> &state = hal_data->planState;
+    SensorBase *root = hal_data->compiledGraph.payload(plan.steps[0]);
+
+    was_on = root->GetStatus(true);
+    err = root->Enable(root->GetHandle(), enable, true);
+    if (err < 0) {
+        return err;
+    }
+
+    state[0] = st_hal_plan_step_state(root, was_on, enable);
+
+    for (s = 1; s < plan.size(); s++) {
+        SensorBase *sensor = hal_data->compiledGraph.payload(plan.steps[s]);
+        bool touched = false;
+
+        was_on = sensor->GetStatus(true);
+        state[s] = PLAN_STEP_UNTOUCHED;
+
+        for (r = plan.requestersOffset[s]; r < plan.requestersOffset[s + 1]; r++) {
+            uint32_t requesterStep = plan.requesters[r];
+            SensorBase *requester = hal_data->compiledGraph.payload(plan.steps[requesterStep]);
+
+            if (state[requesterStep] == PLAN_STEP_TRANSITION) {
+                err = sensor->Enable(requester->GetHandle(), enable, true);
+            } else if (state[requesterStep] == PLAN_STEP_SYNC_DELAY) {
+                err = sensor->SetDelay(requester->GetHandle(),
+                                       requester->GetMinPeriod(true),
+                                       requester->GetMinTimeout(true), true);
+            } else {
+                continue;
+            }
+            if (err < 0) {
+                goto restore_plan;
+            }
+
+            touched = true;
+        }
+
+        if (touched) {
+            state[s] = st_hal_plan_step_state(sensor, was_on, enable);
+        }
+    }
+
+    return 0;
+
+restore_plan:
+    /* undo the enable steps already applied, in reverse order */
+    for (;;) {
+        SensorBase *sensor = hal_data->compiledGraph.payload(plan.steps[s]);
+
+        while (r > plan.requestersOffset[s]) {
+            uint32_t requesterStep = plan.requesters[--r];
+
+            if (state[requesterStep] == PLAN_STEP_TRANSITION) {
+                SensorBase *requester = hal_data->compiledGraph.payload(plan.steps[requesterStep]);
+
+                sensor->Enable(requester->GetHandle(), !enable, true);
+            }
+        }
+
+        if (--s == 0) {
+            break;
+        }
+
+        r = plan.requestersOffset[s + 1];
+    }
+
+    root->Enable(root->GetHandle(), !enable, true);
+
+    return err;
+}
+
+/**
+ * st_hal_plan_batch() - Set sensor pollrate/timeout walking its plan
+ * @hal_data: HAL data.
+ * @plan: plan of the sensor.
+ * @period_ns: sampling period.
+ * @timeout: max batch latency.
+ *
+ * Return value: 0 on success, negative number on fail.
+ */
+static int st_hal_plan_batch(STSensorHAL_data *hal_data,
+                             const CompiledGraph<SensorBase>::Plan &plan,
+                             int64_t period_ns, int64_t timeout)
+{
+    int err;
+    int64_t restore_period_ns, restore_timeout;
+    SensorBase *root = hal_data->compiledGraph.payload(plan.steps[0]);
+
+    root->GetDelay(root->GetHandle(), &restore_period_ns, &restore_timeout, true);
+
+    err = root->SetDelay(root->GetHandle(), period_ns, timeout, true);
+    if (err < 0) {
+        return err;
+    }
+
+    err = st_hal_plan_sync_delay(hal_data, plan);
+    if (err < 0) {
+        root->SetDelay(root->GetHandle(), restore_period_ns, restore_timeout, true);
+        st_hal_plan_sync_delay(hal_data, plan);
+    }
+
+    return err;
+}
+
+/**
+ * st_hal_plan_flush() - Flush a sensor walking its plan
+ * @hal_data: HAL data.
+ * @plan: plan of the sensor.
+ *
+ * Every node is asked to flush once for each distinct handle forwarded
+ * by its requesters (virtual sensors forward the handle they received,
+ * hw sensors forward their own).
+ *
+ * Return value: 0 on success, negative number on fail.
+ */
+static int st_hal_plan_flush(STSensorHAL_data *hal_data,
+                             const CompiledGraph<SensorBase>::Plan &plan)
+{
+    int err;
+    std::vector<int> &flushHandle = hal_data->planFlushHandle;
+    SensorBase *root = hal_data->compiledGraph.payload(plan.steps[0]);
+
+    err = root->flushRequest(root->GetHandle(), true);
+    if (err < 0) {
+        return err;
+    }
+
+    flushHandle[0] = root->GetHandle();
+
+    for (uint32_t s = 1; s < plan.size(); s++) {
+        SensorBase *sensor = hal_data->compiledGraph.payload(plan.steps[s]);
+        uint32_t first = plan.requestersOffset[s];
+
+        for (uint32_t r = first; r < plan.requestersOffset[s + 1]; r++) {
+            uint32_t requesterStep = plan.requesters[r];
+            SensorBase *requester = hal_data->compiledGraph.payload(plan.steps[requesterStep]);
+            int handle = requester->GetFlushForwardHandle(flushHandle[requesterStep]);
+            bool duplicated = false;
+
+            for (uint32_t p = first; p < r; p++) {
+                uint32_t prevStep = plan.requesters[p];
+                SensorBase *prev = hal_data->compiledGraph.payload(plan.steps[prevStep]);
+
+                if (prev->GetFlushForwardHandle(flushHandle[prevStep]) == handle) {
+                    duplicated = true;
+                    break;
+                }
+            }
+            if (duplicated) {
+                continue;
+            }
+
+            if (r == first) {
+                flushHandle[s] = handle;
+            }
+
+            err = sensor->flushRequest(handle, true);
+            if (err < 0) {
+                return err;
+            }
+        }
+    }
+
+    return 0;
+}
+
 /**
  * st_hal_dev_flush() - Flush sensor data
  * @dev: sensors device.
@@ -639,11 +903,16 @@ int st_hal_dev_flush(void *data, uint32_t handle)
 {
     STSensorHAL_data *hal_data = (STSensorHAL_data *)data;
 
+    std::lock_guard<std::mutex> lock(hal_data->planLock);
+
     auto nodeId = hal_data->handleToNodeId_.find(handle);
+    if (nodeId == hal_data->handleToNodeId_.end()) {
+        return -EINVAL;
+    }
 
-    auto sensor = hal_data->graph[nodeId->second];
-    if (sensor != nullptr) {
-        return sensor->flushRequest(sensor->GetHandle(), true);
+    auto plan = hal_data->compiledGraph.plan(nodeId->second);
+    if (plan != nullptr) {
+        return st_hal_plan_flush(hal_data, *plan);
     }
 
     return -EINVAL;
@@ -660,7 +929,12 @@ int st_hal_dev_set_fullscale(void *data, uint32_t handle, float fullscale)
 {
     STSensorHAL_data *hal_data = (STSensorHAL_data *)data;
 
+    std::lock_guard<std::mutex> lock(hal_data->planLock);
+
     auto nodeId = hal_data->handleToNodeId_.find(handle);
+    if (nodeId == hal_data->handleToNodeId_.end()) {
+        return -EINVAL;
+    }
 
     auto sensor = hal_data->graph[nodeId->second];
     if (sensor != nullptr) {
@@ -706,11 +980,16 @@ int st_hal_dev_batch(void *data, int handle, int64_t period_ns, int64_t timeout)
 {
     STSensorHAL_data *hal_data = (STSensorHAL_data *)data;
 
+    std::lock_guard<std::mutex> lock(hal_data->planLock);
+
     auto nodeId = hal_data->handleToNodeId_.find(handle);
+    if (nodeId == hal_data->handleToNodeId_.end()) {
+        return -EINVAL;
+    }
 
-    auto sensor = hal_data->graph[nodeId->second];
-    if (sensor != nullptr) {
-        return sensor->SetDelay(sensor->GetHandle(), period_ns, timeout, true);
+    auto plan = hal_data->compiledGraph.plan(nodeId->second);
+    if (plan != nullptr) {
+        return st_hal_plan_batch(hal_data, *plan, period_ns, timeout);
     }
 
     return -EINVAL;
@@ -730,21 +1009,57 @@ static void indexRemapping(STSensorHAL_data *hal_data, struct sensors_event_t *s
  * @data: data structure used to push data to the upper layer.
  * @count: maximum number of events in the same time.
  *
+ * pollLock is not held while waiting for data, hotplug wakes up the poll
+ * through pollWakeFd and the pipes are polled again at the next call.
+ *
  * Return value: 0 on success, negative number on fail.
  */
 int st_hal_dev_poll(void *data, sensors_event_t *sdata, int count)
 {
     int err, read_size, remaining_event = count, event_read;
     STSensorHAL_data *hal_data = (STSensorHAL_data *)data;
+    std::vector<struct pollfd> &pollFds = hal_data->pollFdsPolled;
+    uint64_t version;
+    size_t sensorsFds;
+
+    {
+        std::lock_guard<std::mutex> lock(hal_data->pollLock);
+
+        pollFds = hal_data->androidPollFd;
+        version = hal_data->androidPollFdVersion;
+    }
+
+    sensorsFds = pollFds.size();
+    if (hal_data->pollWakeFd >= 0) {
+        struct pollfd wakePollFd = { };
+
+        wakePollFd.fd = hal_data->pollWakeFd;
+        wakePollFd.events = POLLIN;
+        pollFds.push_back(wakePollFd);
+    }
 
-    err = poll(hal_data->androidPollFd.data(), hal_data->androidPollFd.size(), 200);
+    /* hotplug must not wait for the poll timeout to update androidPollFd */
+    err = poll(pollFds.data(), pollFds.size(), 200);
     if (err <= 0) {
         return 0;
     }
 
-    for (auto &fd : hal_data->androidPollFd) {
-        if (fd.revents & POLLIN) {
-            read_size = read(fd.fd, sdata, remaining_event * sizeof(sensors_event_t));
+    if ((pollFds.size() > sensorsFds) && (pollFds.back().revents & POLLIN)) {
+        eventfd_t value;
+
+        eventfd_read(hal_data->pollWakeFd, &value);
+    }
+
+    std::lock_guard<std::mutex> lock(hal_data->pollLock);
+
+    /* pipes polled may be closed already, poll again the new ones */
+    if (version != hal_data->androidPollFdVersion) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < sensorsFds; i++) {
+        if (pollFds[i].revents & POLLIN) {
+            read_size = read(pollFds[i].fd, sdata, remaining_event * sizeof(sensors_event_t));
             if (read_size <= 0) {
                 continue;
             }
@@ -757,8 +1072,6 @@ int st_hal_dev_poll(void *data, sensors_event_t *sdata, int count)
             if (remaining_event == 0) {
                 return count;
             }
-        } else {
-            continue;
         }
     }
 
@@ -777,11 +1090,16 @@ int st_hal_dev_activate(void *data, uint32_t handle, bool enable)
 {
     STSensorHAL_data *hal_data = (STSensorHAL_data *)data;
 
+    std::lock_guard<std::mutex> lock(hal_data->planLock);
+
     auto nodeId = hal_data->handleToNodeId_.find(handle);
+    if (nodeId == hal_data->handleToNodeId_.end()) {
+        return -EINVAL;
+    }
 
-    auto sensor = hal_data->graph[nodeId->second];
-    if (sensor != nullptr) {
-        return sensor->Enable(sensor->GetHandle(), enable, true);
+    auto plan = hal_data->compiledGraph.plan(nodeId->second);
+    if (plan != nullptr) {
+        return st_hal_plan_activate(hal_data, *plan, enable);
     }
 
     return -EINVAL;
@@ -791,54 +1109,45 @@ void st_hal_close_sensors(void *pdata)
 {
     STSensorHAL_data *hal_data = (STSensorHAL_data *)pdata;
 
+    if (hal_data->pollWakeFd >= 0) {
+        close(hal_data->pollWakeFd);
+    }
+
     delete(hal_data);
 }
 
 /**
- * open_sensors() - Open sensor device
- * see Android documentation.
+ * st_hal_alloc_node_id() - Get the lowest node id not in use
+ * @hal_data: HAL data.
  *
- * Return value: 0 on success, negative number on fail.
+ * Node ids are used to index per-sensor arrays and enable masks, ids
+ * freed by removed sensors are reused.
+ *
+ * Return value: node id on success, negative number on fail.
  */
-int st_hal_open_sensors(void **pdata, STMSensorsList &sensorsList)
+int st_hal_alloc_node_id(STSensorHAL_data *hal_data)
 {
-    std::vector<STSensorHAL_iio_devices_data> iioDataList;
-    unsigned int internalSensorId = 4;
-
-    *pdata = new STSensorHAL_data();
-    if (!*pdata) {
-        *pdata = nullptr;
-        return -ENOMEM;
-    }
-
-    STSensorHAL_data *hal_data = (STSensorHAL_data *)*pdata;
-
-    int deviceFoundNum = loadIIODevices(iioDataList);
-    if (deviceFoundNum < 0) {
-        console.error("Failed to read IIO sensors");
-        free(*pdata);
-        *pdata = nullptr;
-        return deviceFoundNum;
-    }
-    if (iioDataList.size() == 0) {
-        console.error("No IIO sensors found!");
-        free(*pdata);
-        *pdata = nullptr;
-        return -ENODEV;
-    }
-
-    std::unordered_set<int> modulesIdAvailable;
-
-    /* check for two or more sensor device having same type and module id */
-    for (auto i = 0U; i < iioDataList.size(); ++i) {
-        for (auto j = i + 1; j < iioDataList.size(); ++j) {
-            if ((iioDataList[i].moduleId == iioDataList[j].moduleId) &&
-                (iioDataList[i].sensor_type == iioDataList[j].sensor_type)) {
-                    console.warning("detected two sensors of the same type in the same module (may not work correctly)!");
-            }
+    for (int id = ST_HAL_FIRST_NODE_ID; id < ST_HAL_IIO_MAX_DEVICES; id++) {
+        if (hal_data->graph[id] == nullptr) {
+            return id;
         }
     }
 
+    return -ENOMEM;
+}
+
+/**
+ * st_hal_add_hw_sensors() - Create HW sensors classes and add them to the graph
+ * @hal_data: HAL data.
+ * @iioDataList: IIO devices to create.
+ * @newNodes: ids of the nodes added.
+ * @modulesId: module ids of the nodes added.
+ */
+static void st_hal_add_hw_sensors(STSensorHAL_data *hal_data,
+                                  std::vector<STSensorHAL_iio_devices_data> &iioDataList,
+                                  std::unordered_set<int> &newNodes,
+                                  std::unordered_set<int> &modulesId)
+{
     /* order devices based on module id */
     std::sort(iioDataList.begin(), iioDataList.end(),
               [] (const auto& lhs, const auto& rhs) {
@@ -846,8 +1155,14 @@ int st_hal_open_sensors(void **pdata, STMSensorsList &sensorsList)
               });
 
     for (auto &iioDeviceData : iioDataList) {
+        int nodeId = st_hal_alloc_node_id(hal_data);
+        if (nodeId < 0) {
+            console.error(iioDeviceData.deviceName + ": too many sensors.");
+            break;
+        }
+
         std::shared_ptr<SensorBase> sensor = st_hal_create_class_sensor(&iioDeviceData,
-                                                                        internalSensorId,
+                                                                        nodeId,
                                                                         iioDeviceData.moduleId);
         if (sensor == nullptr) {
             console.error(iioDeviceData.deviceName + ": failed to create HW sensor class.");
@@ -855,24 +1170,44 @@ int st_hal_open_sensors(void **pdata, STMSensorsList &sensorsList)
         }
 
         if (!sensor->libsInit() && sensor->IsValidClass()) {
-            modulesIdAvailable.insert(iioDeviceData.moduleId);
-            struct sensor_t sensorData = sensor->GetSensor_tData();
-            sensorData.moduleId = sensor->getModuleId();
+            modulesId.insert(iioDeviceData.moduleId);
             hal_data->graph.addNode(sensor->GetHandle(), sensor);
-            internalSensorId++;
+            hal_data->iioDeviceToNodeId[iioDeviceData.dev_id] = std::make_pair(iioDeviceData.deviceName,
+                                                                               sensor->GetHandle());
+            newNodes.insert(sensor->GetHandle());
         }
     }
-    if (hal_data->graph.empty()) {
-        console.error("no hardware sensors!");
-        free(*pdata);
-        *pdata = nullptr;
-        return -ENODEV;
-    }
+}
 
-    for (auto& moduleId : modulesIdAvailable) {
+/**
+ * st_hal_add_virtual_sensors() - Create missing virtual sensors of modules
+ * @hal_data: HAL data.
+ * @modulesId: module ids to populate.
+ * @newNodes: ids of the nodes added.
+ */
+static void st_hal_add_virtual_sensors(STSensorHAL_data *hal_data,
+                                       const std::unordered_set<int> &modulesId,
+                                       std::unordered_set<int> &newNodes)
+{
+    for (auto& moduleId : modulesId) {
         for (auto &virtualSensor : sensorsSWSupportedList) {
+            bool exist = std::any_of(hal_data->graph.begin(), hal_data->graph.end(),
+                                     [&](const auto& node) {
+                                         return (node.second.payload->GetType() == virtualSensor.type) &&
+                                                (node.second.payload->getModuleId() == moduleId);
+                                     });
+            if (exist) {
+                continue;
+            }
+
+            int nodeId = st_hal_alloc_node_id(hal_data);
+            if (nodeId < 0) {
+                console.error("too many sensors, virtual sensors not created.");
+                return;
+            }
+
             std::shared_ptr<SensorBase> sensor = st_hal_create_virtual_class_sensor(virtualSensor.type,
-                                                                                    internalSensorId,
+                                                                                    nodeId,
                                                                                     moduleId);
             if (sensor == nullptr) {
                 console.error(": failed to create SW sensor class.");
@@ -881,15 +1216,27 @@ int st_hal_open_sensors(void **pdata, STMSensorsList &sensorsList)
 
             if (!sensor->libsInit() && sensor->IsValidClass()) {
                 hal_data->graph.addNode(sensor->GetHandle(), sensor);
-                internalSensorId++;
+                newNodes.insert(sensor->GetHandle());
             }
         }
     }
+}
 
+/**
+ * st_hal_link_sensors() - Resolve dependencies of new nodes
+ * @hal_data: HAL data.
+ * @newNodes: ids of the nodes added, nodes with missing dependencies are dropped.
+ */
+static void st_hal_link_sensors(STSensorHAL_data *hal_data, std::unordered_set<int> &newNodes)
+{
     std::vector<int> nodesToRemove;
 
     for (auto& sensor : hal_data->graph) {
         auto s = sensor.second.payload;
+        if (!newNodes.count(s->GetHandle())) {
+            continue;
+        }
+
         auto &listDependenciesType = s->GetDepenciesTypeList();
         bool validDependencies = true;
 
@@ -919,14 +1266,48 @@ int st_hal_open_sensors(void **pdata, STMSensorsList &sensorsList)
         hal_data->graph.removeNodeAnd(id);
     }
 
+    for (auto itr = newNodes.begin(); itr != newNodes.end(); ) {
+        if (hal_data->graph[*itr] == nullptr) {
+            itr = newNodes.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+
     auto sortedNodesToVisit = hal_data->graph.getTopologicalSortReverse();
     for (auto& dependencyNodeId : sortedNodesToVisit) {
         for (auto& nodeId : hal_data->graph.getArrivingNodesId(dependencyNodeId)) {
-            hal_data->graph[nodeId]->AddSensorDependency(hal_data->graph[dependencyNodeId].get());
+            if (newNodes.count(nodeId)) {
+                hal_data->graph[nodeId]->AddSensorDependency(hal_data->graph[dependencyNodeId].get());
+            }
         }
     }
+}
+
+/**
+ * st_hal_publish_sensors() - Expose new nodes in the sensors list
+ * @hal_data: HAL data.
+ * @sensorsList: sensors list.
+ * @newNodes: ids of the nodes added.
+ *
+ * Return value: number of sensors added to the list.
+ */
+static int st_hal_publish_sensors(STSensorHAL_data *hal_data,
+                                  STMSensorsList &sensorsList,
+                                  const std::unordered_set<int> &newNodes)
+{
+    int count = 0;
 
     for (auto &node : hal_data->graph) {
+        if (!newNodes.count(node.first)) {
+            continue;
+        }
+
+        if (hal_data->sensorsCallback != nullptr) {
+            node.second.payload->setCallbacks(*hal_data->sensorsCallback);
+            node.second.payload->postSetup();
+        }
+
         struct sensor_t sensorData = node.second.payload->GetSensor_tData();
         if (sensorData.type.isInternal()) {
             continue;
@@ -963,17 +1344,314 @@ int st_hal_open_sensors(void **pdata, STMSensorsList &sensorsList)
         sensorPollFd.fd = node.second.payload->GetFdPipeToRead();
 
         hal_data->androidPollFd.push_back(sensorPollFd);
+        count++;
     }
 
-    for (auto &node : hal_data->graph) {
-        node.second.payload->startThreads();
+    return count;
+}
+
+/**
+ * st_hal_attach_sensors() - Complete the nodes just added to the graph
+ * @hal_data: HAL data.
+ * @sensorsList: sensors list.
+ * @newNodes: ids of the nodes added, updated with the virtual sensors created.
+ * @modulesId: module ids of the nodes added.
+ *
+ * Missing virtual sensors of the modules are created, dependencies resolved,
+ * plans rebuilt and new sensors exposed in the list. Caller holds planLock
+ * and pollLock if the HAL is already in use.
+ *
+ * Return value: number of sensors added to the list.
+ */
+int st_hal_attach_sensors(STSensorHAL_data *hal_data,
+                          STMSensorsList &sensorsList,
+                          std::unordered_set<int> &newNodes,
+                          const std::unordered_set<int> &modulesId)
+{
+    st_hal_add_virtual_sensors(hal_data, modulesId, newNodes);
+    st_hal_link_sensors(hal_data, newNodes);
+    st_hal_compile_graph(hal_data);
+
+    return st_hal_publish_sensors(hal_data, sensorsList, newNodes);
+}
+
+/**
+ * st_hal_plan_release() - Release dependencies held by nodes going away
+ * @hal_data: HAL data.
+ * @plan: plan rooted at the nodes to remove.
+ * @removedNodes: ids of the nodes to remove.
+ *
+ * Nodes to remove are not touched (their device may be gone already),
+ * surviving dependencies are disabled or get their pollrate updated.
+ */
+static void st_hal_plan_release(STSensorHAL_data *hal_data,
+                                const CompiledGraph<SensorBase>::Plan &plan,
+                                const std::unordered_set<int> &removedNodes)
+{
+    std::vector<int8_t> &state = hal_data->planState;
+
+    for (uint32_t s = 0; s < plan.size(); s++) {
+        SensorBase *sensor = hal_data->compiledGraph.payload(plan.steps[s]);
+        bool touched = false, was_on;
+
+        if (removedNodes.count(sensor->GetHandle())) {
+            state[s] = sensor->GetStatus(true) ? PLAN_STEP_TRANSITION : PLAN_STEP_UNTOUCHED;
+            continue;
+        }
+
+        was_on = sensor->GetStatus(true);
+        state[s] = PLAN_STEP_UNTOUCHED;
+
+        for (uint32_t r = plan.requestersOffset[s]; r < plan.requestersOffset[s + 1]; r++) {
+            uint32_t requesterStep = plan.requesters[r];
+            SensorBase *requester = hal_data->compiledGraph.payload(plan.steps[requesterStep]);
+            int err;
+
+            if (state[requesterStep] == PLAN_STEP_TRANSITION) {
+                err = sensor->Enable(requester->GetHandle(), false, true);
+            } else if (state[requesterStep] == PLAN_STEP_SYNC_DELAY) {
+                err = sensor->SetDelay(requester->GetHandle(),
+                                       requester->GetMinPeriod(true),
+                                       requester->GetMinTimeout(true), true);
+            } else {
+                continue;
+            }
+            if (err < 0) {
+                console.error(std::string(sensor->GetName()) + ": failed to release dependency.");
+            }
+
+            touched = true;
+        }
+
+        if (touched) {
+            state[s] = st_hal_plan_step_state(sensor, was_on, false);
+        }
+    }
+}
+
+/**
+ * st_hal_remove_sensors() - Remove nodes and every sensor depending on them
+ * @hal_data: HAL data.
+ * @sensorsList: sensors list.
+ * @rootNodes: ids of the nodes to remove.
+ *
+ * Node ids are freed for the next st_hal_alloc_node_id(), list handles are
+ * not reused. Caller holds planLock and pollLock if the HAL is in use.
+ *
+ * Return value: number of sensors removed from the list.
+ */
+int st_hal_remove_sensors(STSensorHAL_data *hal_data,
+                          STMSensorsList &sensorsList,
+                          const std::vector<int> &rootNodes)
+{
+    std::unordered_set<int> removedNodes;
+    std::vector<uint32_t> roots;
+    std::queue<int> nodesToVisit;
+    CompiledGraph<SensorBase>::Plan plan;
+    std::vector<std::shared_ptr<SensorBase>> sensors;
+    int count = 0;
+
+    for (auto id : rootNodes) {
+        nodesToVisit.push(id);
+    }
+
+    while (!nodesToVisit.empty()) {
+        int id = nodesToVisit.front();
+        nodesToVisit.pop();
+
+        if (!removedNodes.insert(id).second) {
+            continue;
+        }
+
+        roots.push_back(hal_data->compiledGraph.index(id));
+        for (auto arrivingNodeId : hal_data->graph.getArrivingNodesId(id)) {
+            nodesToVisit.push(arrivingNodeId);
+        }
+    }
+
+    hal_data->compiledGraph.buildPlan(roots, plan);
+    st_hal_plan_release(hal_data, plan, removedNodes);
+
+    /* plan lists dependent sensors first, destroy them dependencies first */
+    for (auto itr = plan.steps.rbegin(); itr != plan.steps.rend(); ++itr) {
+        SensorBase *sensor = hal_data->compiledGraph.payload(*itr);
+        int id = sensor->GetHandle();
+
+        if (!removedNodes.count(id)) {
+            continue;
+        }
+
+        for (auto leavingNodeId : hal_data->graph.getLeavingNodesId(id)) {
+            if (!removedNodes.count(leavingNodeId)) {
+                sensor->RemoveSensorDependency(hal_data->graph[leavingNodeId].get());
+            }
+        }
+
+        auto handle = hal_data->sensorIdToHandle.find(id);
+        if (handle != hal_data->sensorIdToHandle.end()) {
+            sensorsList.removeSensor(handle->second);
+            hal_data->handleToNodeId_.erase(handle->second);
+            hal_data->sensorIdToHandle.erase(handle);
+            count++;
+        }
+
+        hal_data->androidPollFd.erase(std::remove_if(hal_data->androidPollFd.begin(),
+                                                     hal_data->androidPollFd.end(),
+                                                     [&](const struct pollfd &fd) {
+                                                         return fd.fd == sensor->GetFdPipeToRead();
+                                                     }),
+                                      hal_data->androidPollFd.end());
+
+        console.debug(std::string(sensor->GetName()) + ": sensor removed");
+
+        sensors.push_back(hal_data->graph[id]);
+        hal_data->graph.removeNode(id);
+    }
+
+    for (auto itr = hal_data->iioDeviceToNodeId.begin(); itr != hal_data->iioDeviceToNodeId.end(); ) {
+        if (removedNodes.count(itr->second.second)) {
+            itr = hal_data->iioDeviceToNodeId.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+
+    st_hal_compile_graph(hal_data);
+
+    /* last references, threads of the producers are joined before the consumers go away */
+    for (auto &sensor : sensors) {
+        sensor.reset();
+    }
+
+    return count;
+}
+
+/**
+ * st_hal_dev_hotplug() - Synchronize sensors with the IIO devices available
+ * @data: HAL data.
+ * @sensorsList: sensors list, updated in place.
+ *
+ * Sensors of IIO devices that disappeared are removed together with the
+ * virtual sensors depending on them, new IIO devices are loaded and their
+ * virtual sensors created. Streams of unrelated sensors are not touched.
+ *
+ * Return value: number of sensors added or removed, negative number on fail.
+ */
+int st_hal_dev_hotplug(void *data, STMSensorsList &sensorsList)
+{
+    STSensorHAL_data *hal_data = (STSensorHAL_data *)data;
+    struct device_iio_type_name iio_devices[ST_HAL_IIO_MAX_DEVICES];
+    std::vector<STSensorHAL_iio_devices_data> iioDataList;
+    std::unordered_set<unsigned int> knownDevices;
+    std::unordered_set<int> newNodes, modulesId;
+    std::vector<int> removedNodes;
+    int len, count = 0;
+
+    std::unique_lock<std::mutex> planLock(hal_data->planLock, std::defer_lock);
+    std::unique_lock<std::mutex> pollLock(hal_data->pollLock, std::defer_lock);
+    std::lock(planLock, pollLock);
+
+    len = device_iio_utils::get_devices_name(iio_devices, ST_HAL_IIO_MAX_DEVICES);
+    if (len < 0) {
+        return len;
+    }
+
+    for (auto &device : hal_data->iioDeviceToNodeId) {
+        bool found = false;
+
+        for (int i = 0; i < len; i++) {
+            if ((iio_devices[i].num == device.first) &&
+                (device.second.first == iio_devices[i].name)) {
+                found = true;
+                break;
+            }
+        }
+
+        if (found) {
+            knownDevices.insert(device.first);
+        } else {
+            console.info(device.second.first + ": IIO device removed");
+            removedNodes.push_back(device.second.second);
+        }
+    }
+
+    if (!removedNodes.empty()) {
+        count += st_hal_remove_sensors(hal_data, sensorsList, removedNodes);
+    }
+
+    loadIIODevices(iioDataList, knownDevices);
+    if (!iioDataList.empty()) {
+        for (auto &iioDeviceData : iioDataList) {
+            console.info(iioDeviceData.deviceName + ": IIO device added");
+        }
+
+        st_hal_add_hw_sensors(hal_data, iioDataList, newNodes, modulesId);
+        count += st_hal_attach_sensors(hal_data, sensorsList, newNodes, modulesId);
+    }
+
+    if (count > 0) {
+        hal_data->androidPollFdVersion++;
+        if (hal_data->pollWakeFd >= 0) {
+            eventfd_write(hal_data->pollWakeFd, 1);
+        }
+    }
+
+    return count;
+}
+
+/**
+ * open_sensors() - Open sensor device
+ * see Android documentation.
+ *
+ * Return value: 0 on success, negative number on fail.
+ */
+int st_hal_open_sensors(void **pdata, STMSensorsList &sensorsList)
+{
+    std::vector<STSensorHAL_iio_devices_data> iioDataList;
+    std::unordered_set<int> newNodes, modulesIdAvailable;
+
+    *pdata = new STSensorHAL_data();
+    if (!*pdata) {
+        *pdata = nullptr;
+        return -ENOMEM;
     }
 
+    STSensorHAL_data *hal_data = (STSensorHAL_data *)*pdata;
+
+    int deviceFoundNum = loadIIODevices(iioDataList);
+    if (deviceFoundNum < 0) {
+        console.error("Failed to read IIO sensors");
+        delete hal_data;
+        *pdata = nullptr;
+        return deviceFoundNum;
+    }
+    if (iioDataList.size() == 0) {
+        console.error("No IIO sensors found!");
+        delete hal_data;
+        *pdata = nullptr;
+        return -ENODEV;
+    }
+
+    st_hal_add_hw_sensors(hal_data, iioDataList, newNodes, modulesIdAvailable);
+    if (hal_data->graph.empty()) {
+        console.error("no hardware sensors!");
+        delete hal_data;
+        *pdata = nullptr;
+        return -ENODEV;
+    }
+
+    st_hal_attach_sensors(hal_data, sensorsList, newNodes, modulesIdAvailable);
+
     hal_data->selfTest = std::make_shared<SelfTest>(hal_data);
     if (!hal_data->selfTest->IsValidClass()) {
         console.error("selftest functions cannot be loaded correctly");
     }
 
+    hal_data->pollWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (hal_data->pollWakeFd < 0) {
+        console.warning("failed to create poll wake-up eventfd, hotplug may wait for poll timeout");
+    }
+
     console.debug(std::to_string(sensorsList.getList().size()) + " sensors available and ready");
 
     return 0;
@@ -1000,6 +1678,8 @@ void st_hal_dev_set_callbacks(void *data, const ISTMSensorsCallback &sensorsCall
         node.second.payload->setCallbacks(sensorsCallback);
     }
 
+    hal_data->sensorsCallback = &sensorsCallback;
+
     st_hal_print_timesync_version();
 }
 
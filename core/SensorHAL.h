@@ -20,6 +20,8 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
 
 #include <poll.h>
 
@@ -110,16 +112,51 @@ namespace core {
 #define ST_HAL_NO_MOTION_SUFFIX_IIO			"_no_motion"
 #define ST_HAL_DEVICE_ORIENTATION_SUFFIX_IIO		"_dev_orientation"
 
+/*
+ * first id assigned to sensors graph nodes
+ */
+#define ST_HAL_FIRST_NODE_ID				4
+
 struct STSensorHAL_data {
     Graph<SensorBase> graph;
 
+    /* flat snapshot of graph used by activate, batch and flush */
+    CompiledGraph<SensorBase> compiledGraph;
+    std::mutex planLock;
+    std::vector<int8_t> planState;
+    std::vector<int> planFlushHandle;
+
+    /* iio:deviceX number -> (IIO device name, node id), used by hotplug */
+    std::map<unsigned int, std::pair<std::string, int>> iioDeviceToNodeId;
+    const ISTMSensorsCallback *sensorsCallback = nullptr;
+
     std::map<uint32_t, int> handleToNodeId_;
     std::map<int, uint32_t> sensorIdToHandle;
 
     std::shared_ptr<SelfTest> selfTest;
 
+    /* androidPollFd is changed by hotplug only, under pollLock */
+    std::mutex pollLock;
     std::vector<struct pollfd> androidPollFd;
+    uint64_t androidPollFdVersion = 0;
+
+    /* eventfd waking up st_hal_dev_poll() when androidPollFd changes */
+    int pollWakeFd = -1;
+
+    /* copy of androidPollFd polled without holding pollLock */
+    std::vector<struct pollfd> pollFdsPolled;
 } typedef STSensorHAL_data;
 
+int st_hal_alloc_node_id(STSensorHAL_data *hal_data);
+
+int st_hal_attach_sensors(STSensorHAL_data *hal_data,
+                          STMSensorsList &sensorsList,
+                          std::unordered_set<int> &newNodes,
+                          const std::unordered_set<int> &modulesId);
+
+int st_hal_remove_sensors(STSensorHAL_data *hal_data,
+                          STMSensorsList &sensorsList,
+                          const std::vector<int> &rootNodes);
+
 } // namespace core
 } // namespace stm
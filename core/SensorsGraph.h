@@ -22,6 +22,8 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <queue>
+#include <vector>
+#include <algorithm>
 
 namespace stm {
 namespace core {
@@ -152,6 +154,21 @@ public:
         return arrivingNodesId;
     }
 
+    std::vector<int> getLeavingNodesId(int id) {
+        std::vector<int> leavingNodesId;
+
+        auto itr = adjList.find(id);
+        if (itr == adjList.end()) {
+            return leavingNodesId;
+        }
+
+        for (auto& id : itr->second.leavingEdges) {
+            leavingNodesId.push_back(id);
+        }
+
+        return leavingNodesId;
+    }
+
     std::vector<int> getTopologicalSortReverse() {
         std::vector<int> nodesIdSorted;
         std::queue<int> results;
@@ -265,5 +282,151 @@ private:
     }
 };
 
+/*
+ * class CompiledGraph: flat (CSR) read-only snapshot of a Graph
+ *
+ * Nodes are stored in dense arrays, edges point from a node to its
+ * dependencies. For every node an activation plan is precomputed: the
+ * list of nodes reachable from it, in topological order (the node itself
+ * first), each with the list of plan steps that are requesting it.
+ */
+template<typename T>
+class CompiledGraph {
+public:
+    struct Plan {
+        std::vector<uint32_t> steps;
+        std::vector<uint32_t> requestersOffset;
+        std::vector<uint32_t> requesters;
+
+        size_t size() const { return steps.size(); }
+    };
+
+    CompiledGraph() = default;
+    ~CompiledGraph() = default;
+
+    CompiledGraph(const CompiledGraph& rhl) = delete;
+    CompiledGraph& operator=(const CompiledGraph& rhl) = delete;
+
+    void compile(Graph<T>& graph) {
+        std::vector<int> sorted = graph.getTopologicalSortReverse();
+        int maxId = -1;
+
+        clear();
+
+        for (auto id : sorted) {
+            maxId = std::max(maxId, id);
+        }
+        idToIndex.assign(maxId + 1, -1);
+
+        /* dependencies first, same order used to call AddSensorDependency */
+        for (uint32_t i = 0; i < sorted.size(); i++) {
+            idToIndex[sorted[i]] = i;
+            ids.push_back(sorted[i]);
+            payloads.push_back(graph[sorted[i]]);
+        }
+
+        edgesOffset.push_back(0);
+        for (uint32_t i = 0; i < sorted.size(); i++) {
+            size_t first = edgesTarget.size();
+
+            for (auto leavingNodeId : graph.getLeavingNodesId(sorted[i])) {
+                edgesTarget.push_back(idToIndex[leavingNodeId]);
+            }
+            std::sort(edgesTarget.begin() + first, edgesTarget.end());
+            edgesOffset.push_back(edgesTarget.size());
+        }
+
+        plans.resize(ids.size());
+        for (uint32_t i = 0; i < ids.size(); i++) {
+            buildPlan({ i }, plans[i]);
+        }
+    }
+
+    void clear() {
+        ids.clear();
+        idToIndex.clear();
+        payloads.clear();
+        edgesOffset.clear();
+        edgesTarget.clear();
+        plans.clear();
+    }
+
+    size_t size() const { return ids.size(); }
+
+    int index(int id) const {
+        if ((id < 0) || (id >= (int)idToIndex.size())) {
+            return -1;
+        }
+
+        return idToIndex[id];
+    }
+
+    T *payload(uint32_t index) const { return payloads[index].get(); }
+
+    const Plan *plan(int id) const {
+        int i = index(id);
+
+        return i < 0 ? nullptr : &plans[i];
+    }
+
+    size_t edgesCount() const { return edgesTarget.size(); }
+
+    void buildPlan(const std::vector<uint32_t>& roots, Plan& plan) const {
+        std::vector<int> stepOfNode(ids.size(), -1);
+        std::vector<bool> reachable(ids.size(), false);
+        std::queue<uint32_t> nodesToVisit;
+
+        for (auto root : roots) {
+            if (!reachable[root]) {
+                reachable[root] = true;
+                nodesToVisit.push(root);
+            }
+        }
+
+        while (!nodesToVisit.empty()) {
+            uint32_t n = nodesToVisit.front();
+            nodesToVisit.pop();
+
+            for (uint32_t e = edgesOffset[n]; e < edgesOffset[n + 1]; e++) {
+                if (!reachable[edgesTarget[e]]) {
+                    reachable[edgesTarget[e]] = true;
+                    nodesToVisit.push(edgesTarget[e]);
+                }
+            }
+        }
+
+        /* nodes are sorted dependencies first, walk them backward */
+        for (int n = ids.size() - 1; n >= 0; n--) {
+            if (reachable[n]) {
+                stepOfNode[n] = plan.steps.size();
+                plan.steps.push_back(n);
+            }
+        }
+
+        std::vector<std::vector<uint32_t>> requesters(plan.steps.size());
+        for (uint32_t s = 0; s < plan.steps.size(); s++) {
+            uint32_t n = plan.steps[s];
+
+            for (uint32_t e = edgesOffset[n]; e < edgesOffset[n + 1]; e++) {
+                requesters[stepOfNode[edgesTarget[e]]].push_back(s);
+            }
+        }
+
+        plan.requestersOffset.push_back(0);
+        for (auto& r : requesters) {
+            plan.requesters.insert(plan.requesters.end(), r.begin(), r.end());
+            plan.requestersOffset.push_back(plan.requesters.size());
+        }
+    }
+
+private:
+    std::vector<int> ids;
+    std::vector<int> idToIndex;
+    std::vector<std::shared_ptr<T>> payloads;
+    std::vector<uint32_t> edgesOffset;
+    std::vector<uint32_t> edgesTarget;
+    std::vector<Plan> plans;
+};
+
 } // namespace core
 } // namespace stm
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2021 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <STMAccelCalibration.h>
+
+/*
+ * Per-sample cost of the accelerometer calibration at 100Hz, with the
+ * device still (stationary blocks become poses) or moving (early exit).
+ */
+
+static const int64_t periodNs = 10000000LL;
+static const size_t traceLength = 4096;
+
+struct AccelTrace {
+    std::vector<std::array<float, 3>> still;
+    std::vector<std::array<float, 3>> moving;
+
+    AccelTrace(void) {
+        for (size_t i = 0; i < traceLength; ++i) {
+            /* a new pose every 2s */
+            float angle = 0.8f * (i / 200);
+            float noise = 0.01f * std::sin(1.7f * i);
+
+            still.push_back({ 9.8f * std::sin(angle) + noise,
+                              9.8f * std::cos(angle) * std::sin(2.0f * angle) - noise,
+                              9.8f * std::cos(angle) * std::cos(2.0f * angle) + noise });
+            moving.push_back({ 4.0f * std::sin(0.3f * i), 2.0f * std::cos(0.7f * i), 9.8f });
+        }
+    }
+};
+
+static const AccelTrace trace;
+
+static void BM_AccelCalibration(benchmark::State &state)
+{
+    const std::vector<std::array<float, 3>> &samples = state.range(0) ? trace.moving : trace.still;
+    STMAccelCalibration calibration;
+    Matrix<4, 3, float> bias;
+    int64_t timestamp = periodNs;
+    size_t i = 0;
+
+    STMAccelCalibration::resetBiasMatrix(bias);
+    calibration.init(40.0f);
+    calibration.reset(bias);
+
+    for (auto _ : state) {
+        calibration.run(samples[i], timestamp);
+        timestamp += periodNs;
+        i = (i + 1) % traceLength;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_AccelCalibration)
+    ->ArgName("moving")
+    ->Arg(0)
+    ->Arg(1);
+
+BENCHMARK_MAIN();
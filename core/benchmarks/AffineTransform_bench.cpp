@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2021 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <AffineTransform.h>
+
+/*
+ * Axes remapping of a batch of 3-axis samples laid out as the core
+ * SensorBaseData (4 floats raw data, 128 bytes per sample): reference
+ * Matrix * std::array per sample against AffineTransform kernels, for a
+ * signed axes permutation and a generic rotation.
+ */
+
+struct Sample {
+    float raw[4];
+    float other[28];
+};
+
+static const size_t batchLength = 32;
+
+/* matrix from its rows */
+template <ssize_t rows>
+static Matrix<rows, 3, float> matrix(std::array<std::array<float, 3>, rows> data)
+{
+    return Matrix<rows, 3, float>(data);
+}
+
+static const Matrix<3, 3, float> matrices[] = {
+    matrix<3>({ { { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } } }),
+    matrix<3>({ { { 0.36f, 0.48f, -0.8f }, { -0.8f, 0.6f, 0.0f }, { 0.48f, 0.64f, 0.6f } } }),
+};
+
+static void fillBatch(std::vector<Sample> &batch)
+{
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i].raw[0] = 0.1f * i;
+        batch[i].raw[1] = -0.2f * i;
+        batch[i].raw[2] = 9.8f;
+        batch[i].raw[3] = 0.0f;
+    }
+}
+
+static void BM_MatrixPerSample(benchmark::State &state)
+{
+    const Matrix<3, 3, float> &m = matrices[state.range(0)];
+    std::vector<Sample> batch(batchLength);
+
+    fillBatch(batch);
+
+    for (auto _ : state) {
+        for (auto &sample : batch) {
+            std::array<float, 3> v;
+
+            memcpy(v.data(), sample.raw, sizeof(v));
+            v = m * v;
+            memcpy(sample.raw, v.data(), sizeof(v));
+        }
+        benchmark::DoNotOptimize(batch.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * batchLength);
+}
+
+static void BM_AffineTransformBatch(benchmark::State &state)
+{
+    std::vector<Sample> batch(batchLength);
+    AffineTransform transform;
+
+    fillBatch(batch);
+    transform.configure(matrices[state.range(0)]);
+    if (transform.setKernel(state.range(1) ? AffineTransform::Kernel::VECTOR :
+                                             AffineTransform::Kernel::SCALAR) < 0) {
+        state.SkipWithError("kernel not supported");
+        return;
+    }
+
+    for (auto _ : state) {
+        transform.transformBatch(batch[0].raw, batch[0].raw, batch.size(), sizeof(Sample));
+        benchmark::DoNotOptimize(batch.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * batchLength);
+}
+
+BENCHMARK(BM_MatrixPerSample)
+    ->ArgName("generic")
+    ->Arg(0)
+    ->Arg(1);
+
+BENCHMARK(BM_AffineTransformBatch)
+    ->ArgNames({ "generic", "vector" })
+    ->ArgsProduct({ { 0, 1 }, { 0, 1 } });
+
+BENCHMARK_MAIN();
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <CalibrationWorker.h>
+#include <SeqLock.h>
+#include <STMMagnCalibration.h>
+
+/*
+ * Data thread latency of a batch of magnetometer samples (100Hz, device
+ * slowly rotating) with calibration run inline, against samples queued to
+ * a calibration worker and bias read from a SeqLock. Both apply the bias to
+ * the batch. p99 and max batch latency [ns] are reported as counters. The
+ * worker drops samples when the producer outpaces it, this does not happen
+ * at sensor rates.
+ */
+
+struct Sample {
+    std::array<float, 3> raw;
+    std::array<float, 3> processed;
+    int64_t timestamp;
+};
+
+static const int64_t periodNs = 10000000LL;
+static const size_t traceLength = 4096;
+
+struct MagnTrace {
+    std::vector<Sample> samples;
+
+    MagnTrace(void) {
+        for (size_t i = 0; i < traceLength; ++i) {
+            float z = 1.0f - 2.0f * (i + 0.5f) / traceLength;
+            float r = std::sqrt(1.0f - z * z);
+            Sample sample;
+
+            sample.raw = { 30.0f + 48.0f * r * std::cos(2.4f * i),
+                           -20.0f + 43.0f * r * std::sin(2.4f * i),
+                           45.0f + 45.0f * z };
+            sample.processed = { 0.0f, 0.0f, 0.0f };
+            sample.timestamp = (i + 1) * periodNs;
+            samples.push_back(sample);
+        }
+    }
+};
+
+static const MagnTrace trace;
+
+static void initCalibration(STMMagnCalibration &calibration)
+{
+    Matrix<4, 3, float> bias;
+
+    STMMagnCalibration::resetBiasMatrix(bias);
+    calibration.init(2000.0f);
+    calibration.reset(bias);
+    calibration.setFrequency(100);
+}
+
+static void applyBias(std::vector<Sample> &batch, const Matrix<4, 3, float> &bias)
+{
+    for (auto &sample : batch) {
+        std::array<float, 3> v;
+
+        for (int i = 0; i < 3; ++i) {
+            v[i] = sample.raw[i] - bias[3][i];
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            sample.processed[i] = bias[i][0] * v[0] + bias[i][1] * v[1] + bias[i][2] * v[2];
+        }
+    }
+}
+
+static void nextBatch(std::vector<Sample> &batch, size_t &index, int64_t &timestamp)
+{
+    for (auto &sample : batch) {
+        sample = trace.samples[index];
+        sample.timestamp = timestamp;
+        timestamp += periodNs;
+        index = (index + 1) % traceLength;
+    }
+}
+
+static void reportLatency(benchmark::State &state, std::vector<int64_t> &latency)
+{
+    if (latency.empty()) {
+        return;
+    }
+
+    std::sort(latency.begin(), latency.end());
+    state.counters["p99_ns"] = latency[latency.size() * 99 / 100];
+    state.counters["max_ns"] = latency.back();
+}
+
+static void BM_InlineCalibration(benchmark::State &state)
+{
+    STMMagnCalibration calibration;
+    std::vector<Sample> batch(state.range(0));
+    std::vector<std::array<float, 3>> samples(batch.size());
+    std::vector<int64_t> timestamps(batch.size());
+    std::vector<int64_t> latency;
+    Matrix<4, 3, float> bias;
+    int64_t timestamp = periodNs;
+    size_t index = 0;
+
+    initCalibration(calibration);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        nextBatch(batch, index, timestamp);
+        state.ResumeTiming();
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            samples[i] = batch[i].raw;
+            timestamps[i] = batch[i].timestamp;
+        }
+
+        calibration.run(samples.data(), timestamps.data(), batch.size());
+        calibration.getBias(bias);
+        applyBias(batch, bias);
+
+        latency.push_back((std::chrono::steady_clock::now() - start).count());
+        benchmark::DoNotOptimize(batch.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * batch.size());
+    reportLatency(state, latency);
+}
+
+static void BM_AsyncCalibration(benchmark::State &state)
+{
+    STMMagnCalibration calibration;
+    SeqLock<Matrix<4, 3, float>> published;
+    std::vector<Sample> batch(state.range(0));
+    std::vector<std::array<float, 3>> samples;
+    std::vector<int64_t> timestamps;
+    std::vector<int64_t> latency;
+    Matrix<4, 3, float> bias;
+    int64_t timestamp = periodNs;
+    size_t index = 0;
+
+    initCalibration(calibration);
+    calibration.getBias(bias);
+    published.write(bias);
+
+    {
+        CalibrationWorker<Sample> worker;
+
+        worker.start(512, [&](const Sample *data, size_t count) {
+            Matrix<4, 3, float> workerBias;
+
+            samples.resize(count);
+            timestamps.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                samples[i] = data[i].raw;
+                timestamps[i] = data[i].timestamp;
+            }
+
+            calibration.run(samples.data(), timestamps.data(), count);
+            calibration.getBias(workerBias);
+            published.write(workerBias);
+        });
+
+        for (auto _ : state) {
+            state.PauseTiming();
+            nextBatch(batch, index, timestamp);
+            state.ResumeTiming();
+
+            auto start = std::chrono::steady_clock::now();
+
+            worker.push(batch.data(), batch.size());
+            published.read(bias);
+            applyBias(batch, bias);
+
+            latency.push_back((std::chrono::steady_clock::now() - start).count());
+            benchmark::DoNotOptimize(batch.data());
+        }
+
+        state.counters["dropped"] = worker.getDropped();
+    }
+
+    state.SetItemsProcessed(state.iterations() * batch.size());
+    reportLatency(state, latency);
+}
+
+BENCHMARK(BM_InlineCalibration)->Arg(1)->Arg(32);
+BENCHMARK(BM_AsyncCalibration)->Arg(1)->Arg(32);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2021 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <STMGeomagFusion.h>
+
+/*
+ * Per-sample cost of the eCompass (run and quaternion output) on a
+ * rotating device.
+ */
+
+static const size_t traceLength = 4096;
+
+struct GeomagTrace {
+    std::vector<std::array<float, 3>> accel;
+    std::vector<std::array<float, 3>> magn;
+
+    GeomagTrace(void) {
+        for (size_t i = 0; i < traceLength; ++i) {
+            float roll = 0.5f * std::sin(0.01f * i), yaw = 0.003f * i;
+            float cr = std::cos(roll), sr = std::sin(roll);
+            float cy = std::cos(yaw), sy = std::sin(yaw);
+
+            accel.push_back({ 0.0f, GRAVITY_EARTH * sr, GRAVITY_EARTH * cr });
+            magn.push_back({ 25.0f * sy, 25.0f * cy * cr + 43.3f * sr, -25.0f * cy * sr - 43.3f * cr });
+        }
+    }
+};
+
+static const GeomagTrace trace;
+
+static void BM_GeomagFusion(benchmark::State &state)
+{
+    STMGeomagFusion fusion;
+    std::array<float, 4> quaternion;
+    size_t i = 0;
+
+    fusion.init(100.0f);
+
+    for (auto _ : state) {
+        fusion.run(trace.accel[i], trace.magn[i], 10.0f);
+        fusion.getQuaternion(quaternion);
+        benchmark::DoNotOptimize(quaternion);
+        i = (i + 1) % traceLength;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_GeomagFusion);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2021 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <STMGyroCalibration.h>
+
+/*
+ * Per-sample cost of the gyroscope bias estimation at 100Hz on a still
+ * device, with accel data or gyroscope only (once the bias is known).
+ */
+
+static const int64_t periodNs = 10000000LL;
+static const size_t traceLength = 4096;
+
+struct GyroTrace {
+    std::vector<std::array<float, 3>> accel;
+    std::vector<std::array<float, 3>> gyro;
+
+    GyroTrace(void) {
+        for (size_t i = 0; i < traceLength; ++i) {
+            float noise = 0.001f * std::sin(1.7f * i);
+
+            accel.push_back({ noise, -noise, 9.8f + noise });
+            gyro.push_back({ 0.01f + noise, -0.02f - noise, 0.005f + noise });
+        }
+    }
+};
+
+static const GyroTrace trace;
+
+static void BM_GyroCalibration(benchmark::State &state)
+{
+    STMGyroCalibration calibration;
+    Matrix<4, 3, float> bias;
+    int64_t timestamp = periodNs;
+    size_t i = 0;
+
+    STMGyroCalibration::resetBiasMatrix(bias);
+    calibration.init(1.0f, 1.0f, 20.0f, 35.0f);
+    calibration.reset(bias);
+
+    for (auto _ : state) {
+        if (state.range(0)) {
+            calibration.run(trace.gyro[i], timestamp);
+        } else {
+            calibration.run(trace.accel[i], trace.gyro[i], timestamp);
+        }
+        timestamp += periodNs;
+        i = (i + 1) % traceLength;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_GyroCalibration)
+    ->ArgName("gyro_only")
+    ->Arg(0)
+    ->Arg(1);
+
+BENCHMARK_MAIN();
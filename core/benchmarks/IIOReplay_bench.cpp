@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include <IConsole.h>
+#include <IIORecorder.h>
+#include <IIORecording.h>
+#include <IUtils.h>
+
+#include "IIOReplay.h"
+
+using stm::core::IConsole;
+using stm::core::IIOChannelType;
+using stm::core::IIORecorder;
+using stm::core::IIORecording;
+using stm::core::IIORecordingDevice;
+using stm::core::IIOReplay;
+using stm::core::IUtils;
+
+/*
+ * One second of raw iio data of 6 sensors at 833Hz, in buffers of 10 scans
+ * (one read of the data thread). Items are scans.
+ */
+
+class Console : public IConsole {
+    void info(const std::string &message) const override { (void) message; }
+    void warning(const std::string &message) const override { (void) message; }
+    void error(const std::string &message) const override { (void) message; }
+    void debug(const std::string &message) const override { (void) message; }
+    void verbose(const std::string &message) const override { (void) message; }
+};
+
+IConsole &IConsole::getInstance(void)
+{
+    static Console instance;
+
+    return instance;
+}
+
+class Utils : public IUtils {
+public:
+    int64_t getTime(void) const override
+    {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_BOOTTIME, &ts);
+
+        return (ts.tv_sec * 1000000000LL) + ts.tv_nsec;
+    }
+};
+
+IUtils &IUtils::getInstance(void)
+{
+    static Utils instance;
+
+    return instance;
+}
+
+static const int sensorsCount = 6;
+static const unsigned int scansPerSensor = 833;
+static const unsigned int scansPerRead = 10;
+static const size_t scanSize = 16;
+static const int64_t period = 1200480;
+
+/* x, y, z: le:s16/16>>0, timestamp: le:s64/63>>0 */
+static IIORecordingDevice makeDevice(void)
+{
+    IIORecordingDevice device;
+
+    memset(&device, 0, sizeof(device));
+    device.scanSize = scanSize;
+    device.numChannels = 4;
+
+    for (int k = 0; k < 3; ++k) {
+        device.channels[k].scale = 0.000598f;
+        device.channels[k].bytes = 2;
+        device.channels[k].bitsUsed = 16;
+        device.channels[k].sign = 1;
+        device.channels[k].location = 2 * k;
+        device.channels[k].type = static_cast<uint32_t>(IIOChannelType::UNKNOWN);
+        device.channels[k].mask = 0xffff;
+    }
+
+    device.channels[3].scale = 1.0f;
+    device.channels[3].bytes = 8;
+    device.channels[3].bitsUsed = 63;
+    device.channels[3].sign = 1;
+    device.channels[3].location = 8;
+    device.channels[3].type = static_cast<uint32_t>(IIOChannelType::TIMESTAMP);
+    device.channels[3].mask = 0x7fffffffffffffffULL;
+
+    return device;
+}
+
+static std::vector<uint8_t> makeBuffer(int64_t timestamp)
+{
+    std::vector<uint8_t> buffer(scansPerRead * scanSize);
+
+    for (unsigned int i = 0; i < scansPerRead; ++i) {
+        uint8_t *scan = buffer.data() + i * scanSize;
+        int64_t ts = timestamp + i * period;
+
+        for (int k = 0; k < 6; ++k) {
+            scan[k] = (i * 31 + k * 7) & 0xff;
+        }
+
+        memcpy(scan + 8, &ts, sizeof(ts));
+    }
+
+    return buffer;
+}
+
+static std::string recordingPath(void)
+{
+    return "/tmp/stm-bench-iio-replay-" + std::to_string(getpid());
+}
+
+static void writeRecording(IIORecorder &recorder, const IIORecordingDevice &device,
+                           const std::vector<uint8_t> &buffer)
+{
+    for (unsigned int n = 0; n < scansPerSensor / scansPerRead; ++n) {
+        int64_t timestamp = n * scansPerRead * period;
+
+        for (int handle = 0; handle < sensorsCount; ++handle) {
+            recorder.recordScan(device, handle, timestamp, buffer.data(), buffer.size());
+        }
+    }
+}
+
+static void BM_Record(benchmark::State &state)
+{
+    IIORecordingDevice device = makeDevice();
+    std::vector<uint8_t> buffer = makeBuffer(0);
+    std::string path = recordingPath();
+    IIORecorder recorder;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        recorder.open(path);
+        state.ResumeTiming();
+
+        writeRecording(recorder, device, buffer);
+        recorder.close();
+    }
+
+    unlink(path.c_str());
+    state.SetItemsProcessed(state.iterations() * sensorsCount *
+                            (scansPerSensor / scansPerRead) * scansPerRead);
+}
+
+class CountingConsumer : public IIOReplay::Consumer {
+public:
+    uint64_t scans = 0;
+
+    void onScanData(int32_t handle, int64_t timestamp,
+                    const SensorBaseData *data, unsigned int count) override
+    {
+        (void) handle; (void) timestamp;
+        benchmark::DoNotOptimize(data);
+        scans += count;
+    }
+};
+
+static void BM_ReplayFast(benchmark::State &state)
+{
+    std::string path = recordingPath();
+    IIORecording recording;
+    CountingConsumer consumer;
+
+    {
+        IIORecorder recorder;
+
+        recorder.open(path);
+        writeRecording(recorder, makeDevice(), makeBuffer(0));
+        recorder.close();
+    }
+
+    if (recording.open(path) < 0) {
+        state.SkipWithError("failed to open recording");
+        return;
+    }
+
+    IIOReplay replay(recording);
+
+    for (auto _ : state) {
+        replay.run(consumer, IIOReplay::Mode::FAST);
+    }
+
+    unlink(path.c_str());
+    state.SetItemsProcessed(consumer.scans);
+}
+
+BENCHMARK(BM_Record);
+BENCHMARK(BM_ReplayFast);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2021 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <STMMagnCalibration.h>
+
+/*
+ * Per-sample cost of the magnetometer calibration at 100Hz, including the
+ * fits run about once per second, on a device slowly rotating in all
+ * directions (reservoir bins keep being replaced).
+ */
+
+static const int64_t periodNs = 10000000LL;
+static const size_t traceLength = 4096;
+
+struct MagnTrace {
+    std::vector<std::array<float, 3>> samples;
+
+    MagnTrace(void) {
+        for (size_t i = 0; i < traceLength; ++i) {
+            float z = 1.0f - 2.0f * (i + 0.5f) / traceLength;
+            float r = std::sqrt(1.0f - z * z);
+
+            samples.push_back({ 30.0f + 48.0f * r * std::cos(2.4f * i),
+                                -20.0f + 43.0f * r * std::sin(2.4f * i),
+                                45.0f + 45.0f * z });
+        }
+    }
+};
+
+static const MagnTrace trace;
+
+static void BM_MagnCalibration(benchmark::State &state)
+{
+    STMMagnCalibration calibration;
+    Matrix<4, 3, float> bias;
+    int64_t timestamp = periodNs;
+    size_t i = 0;
+
+    STMMagnCalibration::resetBiasMatrix(bias);
+    calibration.init(2000.0f);
+    calibration.reset(bias);
+    calibration.setFrequency(100);
+
+    for (auto _ : state) {
+        calibration.run(trace.samples[i], timestamp);
+        timestamp += periodNs;
+        i = (i + 1) % traceLength;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_MagnCalibration);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <RateConverter.h>
+
+/*
+ * Output rate conversion of one second of a 3-axis stream at 416Hz for the
+ * requested output rates. Items are input samples, the per_channel counter
+ * is the CPU time per input sample of one axis.
+ */
+
+static const int64_t inputPeriodNs = 2403846;
+static const size_t inputSamples = 416;
+static const size_t channels = 3;
+
+static void BM_RateConverter(benchmark::State &state)
+{
+    RateConverter::Mode mode = (RateConverter::Mode)state.range(0);
+    int64_t outputPeriodNs = 1000000000LL / state.range(1);
+    std::vector<float> samples(inputSamples * channels);
+    RateConverter converter;
+    int64_t timestamp = 0;
+    float sink = 0.0f;
+
+    for (size_t i = 0; i < inputSamples; ++i) {
+        samples[i * channels] = sinf(0.1f * i);
+        samples[i * channels + 1] = cosf(0.3f * i);
+        samples[i * channels + 2] = 9.8f;
+    }
+
+    if (converter.configure(mode, channels, inputPeriodNs, outputPeriodNs) < 0) {
+        state.SkipWithError("configuration not supported");
+        return;
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < inputSamples; ++i) {
+            converter.process(timestamp, &samples[i * channels],
+                              [&](int64_t, const float *out) { sink += out[0]; });
+            timestamp += inputPeriodNs;
+        }
+        benchmark::DoNotOptimize(sink);
+    }
+
+    state.SetItemsProcessed(state.iterations() * inputSamples);
+    state.counters["taps"] = converter.getTaps();
+    state.counters["per_channel"] = benchmark::Counter(state.iterations() * inputSamples * channels,
+                                                       benchmark::Counter::kIsRate |
+                                                       benchmark::Counter::kInvert);
+}
+
+BENCHMARK(BM_RateConverter)
+    ->ArgNames({ "mode", "hz" })
+    ->ArgsProduct({ { (int)RateConverter::Mode::PICK, (int)RateConverter::Mode::FIR,
+                      (int)RateConverter::Mode::CIC, (int)RateConverter::Mode::RESAMPLE },
+                    { 100, 50, 10 } });
+
+BENCHMARK_MAIN();
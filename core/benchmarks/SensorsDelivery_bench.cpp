@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <ISTMSensorsCallback.h>
+#include <STMSensorsCallbackData.h>
+#include <STMSensorsRecordsPool.h>
+
+using stm::core::ISTMSensorsCallback;
+using stm::core::ISTMSensorsCallbackData;
+using stm::core::STMSensorsCallbackData;
+using stm::core::STMSensorsRecord;
+using stm::core::STMSensorsRecordsLease;
+using stm::core::STMSensorsRecordsPool;
+using stm::core::SensorType;
+
+/*
+ * Delivery of one second of data of 6 sensors at 833Hz to the consumer, in
+ * batches of 10 events (one poll of the data thread). Items are samples, the
+ * allocs counter is the number of heap allocations per sample.
+ */
+
+static std::atomic<uint64_t> allocations { 0 };
+
+static void *allocate(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    void *p = malloc(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+__attribute__((noinline)) static void deallocate(void *p)
+{
+    free(p);
+}
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void operator delete(void *p) noexcept { deallocate(p); }
+void operator delete[](void *p) noexcept { deallocate(p); }
+void operator delete(void *p, size_t) noexcept { deallocate(p); }
+void operator delete[](void *p, size_t) noexcept { deallocate(p); }
+
+static const size_t sensorsCount = 6;
+static const size_t samplesPerSensor = 833;
+static const size_t pollEventsMax = 10;
+
+static std::vector<STMSensorsRecord> pollEvents(void)
+{
+    std::vector<STMSensorsRecord> events(sensorsCount * samplesPerSensor);
+
+    for (size_t i = 0; i < events.size(); ++i) {
+        events[i] = {};
+        events[i].timestamp = (i / sensorsCount) * 1200480LL;
+        events[i].sensorHandle = i % sensorsCount;
+        events[i].sensorType = SensorType::ACCELEROMETER;
+        events[i].dataLen = 3;
+        events[i].data[0] = 0.01f * i;
+        events[i].data[2] = 9.8f;
+    }
+
+    return events;
+}
+
+class Consumer : public ISTMSensorsCallback {
+public:
+    float sink = 0.0f;
+
+    void onNewSensorsData(const std::vector<ISTMSensorsCallbackData> &sensorsData) override
+    {
+        for (auto &data : sensorsData) {
+            sink += data.getData()[0];
+        }
+    }
+
+    int onSaveDataRequest(const std::string& resourceID, const void *data, ssize_t len) override
+    {
+        (void) resourceID;
+        (void) data;
+        (void) len;
+
+        return -EIO;
+    }
+
+    int onLoadDataRequest(const std::string& resourceID, void *data, ssize_t len) override
+    {
+        (void) resourceID;
+        (void) data;
+        (void) len;
+
+        return -EIO;
+    }
+};
+
+class LeaseConsumer : public Consumer {
+public:
+    void onNewSensorsRecords(STMSensorsRecordsLease &records) override
+    {
+        for (auto &record : records) {
+            sink += record.data[0];
+        }
+    }
+};
+
+static void setCounters(benchmark::State &state, uint64_t allocs)
+{
+    uint64_t samples = state.iterations() * sensorsCount * samplesPerSensor;
+
+    state.SetItemsProcessed(samples);
+    state.counters["allocs"] = (double)allocs / samples;
+}
+
+/* vector of ISTMSensorsCallbackData built for each poll */
+static void BM_DeliveryVector(benchmark::State &state)
+{
+    std::vector<STMSensorsRecord> events = pollEvents();
+    Consumer consumer;
+    uint64_t allocs;
+
+    allocs = allocations.load();
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < events.size(); i += pollEventsMax) {
+            std::vector<ISTMSensorsCallbackData> sensorsData;
+            std::vector<float> payload;
+
+            for (size_t j = i; j < std::min(i + pollEventsMax, events.size()); ++j) {
+                payload.resize(events[j].dataLen);
+                memcpy(payload.data(), events[j].data, events[j].dataLen * sizeof(float));
+
+                sensorsData.push_back(STMSensorsCallbackData(events[j].sensorHandle,
+                                                             events[j].sensorType,
+                                                             events[j].timestamp,
+                                                             payload));
+            }
+
+            consumer.onNewSensorsData(sensorsData);
+        }
+        benchmark::DoNotOptimize(consumer.sink);
+    }
+
+    setCounters(state, allocations.load() - allocs);
+}
+
+/* leased records, delivered with the callback implementation of the consumer */
+template <class ConsumerType>
+static void BM_DeliveryLease(benchmark::State &state)
+{
+    std::vector<STMSensorsRecord> events = pollEvents();
+    STMSensorsRecordsPool pool(pollEventsMax, 4);
+    ConsumerType consumer;
+    uint64_t allocs;
+
+    allocs = allocations.load();
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < events.size(); i += pollEventsMax) {
+            STMSensorsRecordsLease records = pool.acquire();
+            size_t n = std::min(pollEventsMax, events.size() - i);
+
+            memcpy(records.data(), &events[i], n * sizeof(STMSensorsRecord));
+            records.resize(n);
+
+            consumer.onNewSensorsRecords(records);
+        }
+        benchmark::DoNotOptimize(consumer.sink);
+    }
+
+    setCounters(state, allocations.load() - allocs);
+    state.counters["pool_buffers"] = pool.getAllocatedBuffers();
+}
+
+BENCHMARK(BM_DeliveryVector);
+BENCHMARK_TEMPLATE(BM_DeliveryLease, Consumer)->Name("BM_DeliveryLeaseAdapter");
+BENCHMARK_TEMPLATE(BM_DeliveryLease, LeaseConsumer);
+
+BENCHMARK_MAIN();
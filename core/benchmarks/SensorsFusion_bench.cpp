@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2021 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <STMSensorsFusion6Axis.h>
+#include <STMSensorsFusion9Axis.h>
+
+/*
+ * Single sample benchmarks process one sample per iteration, so the reported
+ * time is the cost in ns/sample of the selected filter kernel. Batch
+ * benchmarks report it in the per_sample counter.
+ */
+
+static const int64_t periodNs = 2500000LL;
+static const size_t traceLength = 4096;
+
+struct MotionTrace {
+    std::vector<std::array<float, 3>> accel;
+    std::vector<std::array<float, 3>> magn;
+    std::vector<std::array<float, 3>> gyro;
+
+    MotionTrace(void) {
+        for (size_t i = 0; i < traceLength; ++i) {
+            float t = i * 0.0025f;
+
+            accel.push_back({ 9.8f * std::sin(t), 0.3f * std::cos(3.0f * t), 9.8f * std::cos(t) });
+            magn.push_back({ 10.0f * std::cos(t), 22.0f, -40.0f + std::sin(t) });
+            gyro.push_back({ 0.2f * std::sin(2.0f * t), 1.0f, -0.5f * std::cos(t) });
+        }
+    }
+};
+
+static const MotionTrace trace;
+
+static void BM_Fusion6Axis(benchmark::State &state)
+{
+    STMSensorsFusion6Axis fusion;
+    int64_t timestamp = periodNs;
+    size_t i = 0;
+
+    fusion.init();
+    if (fusion.setKernel((MadgwickFilter::Kernel)state.range(0)) < 0) {
+        state.SkipWithError("kernel not supported");
+        return;
+    }
+
+    for (auto _ : state) {
+        fusion.run(trace.accel[i], trace.gyro[i], timestamp);
+        timestamp += periodNs;
+        i = (i + 1) % traceLength;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Fusion9Axis(benchmark::State &state)
+{
+    STMSensorsFusion9Axis fusion;
+    int64_t timestamp = periodNs;
+    size_t i = 0;
+
+    fusion.init();
+    if (fusion.setKernel((MadgwickFilter::Kernel)state.range(0)) < 0) {
+        state.SkipWithError("kernel not supported");
+        return;
+    }
+
+    for (auto _ : state) {
+        fusion.run(trace.accel[i], trace.magn[i], trace.gyro[i], timestamp);
+        timestamp += periodNs;
+        i = (i + 1) % traceLength;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Fusion6AxisBatch(benchmark::State &state)
+{
+    STMSensorsFusion6Axis fusion;
+    size_t batchLen = state.range(0);
+    std::vector<int64_t> timestamps(traceLength);
+    int64_t timestamp = periodNs;
+    size_t i = 0;
+
+    fusion.init();
+
+    for (auto _ : state) {
+        for (size_t n = 0; n < batchLen; ++n) {
+            timestamps[i + n] = timestamp;
+            timestamp += periodNs;
+        }
+
+        fusion.run(&trace.accel[i], &trace.gyro[i], &timestamps[i], batchLen);
+        i = (i + batchLen) % traceLength;
+    }
+
+    state.SetItemsProcessed(state.iterations() * batchLen);
+    state.counters["per_sample"] = benchmark::Counter(state.iterations() * batchLen,
+                                                      benchmark::Counter::kIsRate |
+                                                      benchmark::Counter::kInvert);
+}
+
+/* 9X fusion of a 400Hz gyroscope, filter step period [ms] from argument */
+static void BM_Fusion9AxisStepPeriod(benchmark::State &state)
+{
+    STMSensorsFusion9Axis fusion;
+    int64_t timestamp = periodNs;
+    size_t i = 0;
+
+    fusion.init();
+    fusion.setUpdatePeriod(state.range(0) * 1000000LL);
+
+    for (auto _ : state) {
+        fusion.run(trace.accel[i], trace.magn[i], trace.gyro[i], timestamp);
+        timestamp += periodNs;
+        i = (i + 1) % traceLength;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+/* all outputs of 9X fusion, read one by one or computed at once */
+static void BM_Fusion9AxisOutputs(benchmark::State &state)
+{
+    STMSensorsFusion9Axis fusion;
+    STMSensorsFusionOutput output;
+    bool shared = state.range(0);
+
+    fusion.init();
+    fusion.run(trace.accel[0], trace.magn[0], trace.gyro[0], periodNs);
+
+    for (auto _ : state) {
+        if (shared) {
+            fusion.getOutputs(STMSensorsFusionOutput::ALL, output);
+        } else {
+            fusion.getQuaternion(output.quaternion);
+            fusion.getEulerAngles(output.eulerAngles);
+            fusion.getGravity(output.gravity);
+            fusion.getLinearAccel(output.linearAccel);
+        }
+        benchmark::DoNotOptimize(output);
+    }
+}
+
+BENCHMARK(BM_Fusion6Axis)
+    ->ArgName("vector")
+    ->Arg((int)MadgwickFilter::Kernel::SCALAR)
+    ->Arg((int)MadgwickFilter::Kernel::VECTOR);
+
+BENCHMARK(BM_Fusion9Axis)
+    ->ArgName("vector")
+    ->Arg((int)MadgwickFilter::Kernel::SCALAR)
+    ->Arg((int)MadgwickFilter::Kernel::VECTOR);
+
+/* batch length must divide traceLength */
+BENCHMARK(BM_Fusion6AxisBatch)
+    ->ArgName("batch")
+    ->Arg(32)
+    ->Arg(256);
+
+BENCHMARK(BM_Fusion9AxisStepPeriod)
+    ->ArgName("period_ms")
+    ->Arg(0)
+    ->Arg(5)
+    ->Arg(20);
+
+BENCHMARK(BM_Fusion9AxisOutputs)
+    ->ArgName("shared")
+    ->Arg(0)
+    ->Arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2019-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <AffineTransform.h>
+
+#include "CircularBuffer.h"
+
+/* matrix from its rows */
+template <ssize_t rows>
+static Matrix<rows, 3, float> matrix(std::array<std::array<float, 3>, rows> data)
+{
+    return Matrix<rows, 3, float>(data);
+}
+
+static const std::array<AffineTransform::Kernel, 2> kernels = {
+    AffineTransform::Kernel::SCALAR,
+    AffineTransform::Kernel::VECTOR,
+};
+
+static std::vector<float> randomSamples(size_t n, float range)
+{
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> value(-range, range);
+    std::vector<float> samples(3 * n);
+
+    for (auto &v : samples) {
+        v = value(gen);
+    }
+
+    return samples;
+}
+
+/* reference: previous per sample axes remapping */
+static void expectSameAsMatrix(const Matrix<3, 3, float> &m,
+                               const std::vector<float> &in,
+                               const std::vector<float> &out)
+{
+    for (size_t i = 0; i < in.size() / 3; ++i) {
+        std::array<float, 3> v = { in[3 * i], in[3 * i + 1], in[3 * i + 2] };
+
+        v = m * v;
+        for (int j = 0; j < 3; ++j) {
+            ASSERT_EQ(v[j], out[3 * i + j]) << i;
+        }
+    }
+}
+
+TEST(Matrix, products)
+{
+    Matrix<3, 3, float> a = matrix<3>({ { { 1.0f, 2.0f, 3.0f }, { 0.0f, 1.0f, 4.0f }, { 5.0f, 6.0f, 0.0f } } });
+    Matrix<3, 3, float> b = matrix<3>({ { { 0.0f, 1.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } });
+    Matrix<4, 3, float> c = matrix<4>({ { { 1.0f, 0.0f, 0.0f }, { 0.0f, 2.0f, 0.0f }, { 0.0f, 0.0f, 3.0f }, { 1.0f, 1.0f, 1.0f } } });
+    Matrix<3, 3, float> ab = a * b;
+    Matrix<4, 3, float> ca = c * a;
+    std::array<float, 4> cv = c * std::array<float, 3>({ 1.0f, 1.0f, 1.0f });
+
+    /* operands are not modified */
+    EXPECT_EQ(std::string("1.000000,2.000000,3.000000;0.000000,1.000000,4.000000;5.000000,6.000000,0.000000"),
+              (std::string)a);
+    EXPECT_EQ(std::string("0.000000,1.000000,0.000000;-1.000000,0.000000,0.000000;0.000000,0.000000,1.000000"),
+              (std::string)b);
+
+    EXPECT_EQ(-2.0f, ab[0][0]);
+    EXPECT_EQ(1.0f, ab[0][1]);
+    EXPECT_EQ(3.0f, ab[0][2]);
+    EXPECT_EQ(-6.0f, ab[2][0]);
+    EXPECT_EQ(5.0f, ab[2][1]);
+
+    EXPECT_EQ(0.0f, ca[1][0]);
+    EXPECT_EQ(15.0f, ca[2][0]);
+    EXPECT_EQ(9.0f, ca[3][1]);
+    EXPECT_EQ(7.0f, ca[3][2]);
+
+    EXPECT_EQ(3.0f, cv[2]);
+    EXPECT_EQ(3.0f, cv[3]);
+}
+
+TEST(AffineTransform, typeDetection)
+{
+    AffineTransform transform;
+
+    EXPECT_EQ(AffineTransform::Type::IDENTITY, transform.getType());
+
+    transform.configure(matrix<3>({ { { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } } }));
+    EXPECT_EQ(AffineTransform::Type::PERMUTATION, transform.getType());
+
+    /* same axis used twice */
+    transform.configure(matrix<3>({ { { 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } }));
+    EXPECT_EQ(AffineTransform::Type::GENERIC, transform.getType());
+
+    transform.configure(matrix<4>({ { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.5f, 0.0f } } }));
+    EXPECT_EQ(AffineTransform::Type::GENERIC, transform.getType());
+
+    transform.configure(matrix<3>({ { { 0.6f, -0.8f, 0.0f }, { 0.8f, 0.6f, 0.0f }, { 0.0f, 0.0f, 1.0f } } }));
+    EXPECT_EQ(AffineTransform::Type::GENERIC, transform.getType());
+}
+
+TEST(AffineTransform, sameResultsAsMatrix)
+{
+    const std::array<Matrix<3, 3, float>, 4> matrices = { {
+        matrix<3>({ { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } }),
+        matrix<3>({ { { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } }),
+        matrix<3>({ { { 0.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } } }),
+        matrix<3>({ { { 0.36f, 0.48f, -0.8f }, { -0.8f, 0.6f, 0.0f }, { 0.48f, 0.64f, 0.6f } } }),
+    } };
+    std::vector<float> in = randomSamples(37, 20.0f);
+
+    for (const auto &m : matrices) {
+        for (auto kernel : kernels) {
+            AffineTransform transform;
+            std::vector<float> out(in.size()), inplace = in;
+
+            transform.configure(m);
+            if (transform.setKernel(kernel) < 0) {
+                continue;
+            }
+
+            transform.transformBatch(in.data(), out.data(), in.size() / 3);
+            expectSameAsMatrix(m, in, out);
+
+            transform.transformBatch(inplace.data(), inplace.data(), in.size() / 3);
+            expectSameAsMatrix(m, in, inplace);
+        }
+    }
+}
+
+TEST(AffineTransform, sensorDataBatch)
+{
+    Matrix<3, 3, float> m = matrix<3>({ { { 0.36f, 0.48f, -0.8f }, { -0.8f, 0.6f, 0.0f }, { 0.48f, 0.64f, 0.6f } } });
+    std::vector<float> in = randomSamples(16, 500.0f);
+
+    for (auto kernel : kernels) {
+        std::array<SensorBaseData, 16> data;
+        std::vector<float> out(in.size());
+        AffineTransform transform;
+
+        transform.configure(m);
+        if (transform.setKernel(kernel) < 0) {
+            continue;
+        }
+
+        for (auto i = 0U; i < data.size(); ++i) {
+            memcpy(data[i].raw, &in[3 * i], 3 * sizeof(float));
+            data[i].raw[3] = i;
+            data[i].offset[0] = -1.0f;
+        }
+
+        transform.transformBatch(data[0].raw, data[0].raw, data.size(), sizeof(SensorBaseData));
+
+        for (auto i = 0U; i < data.size(); ++i) {
+            memcpy(&out[3 * i], data[i].raw, 3 * sizeof(float));
+            EXPECT_EQ((float)i, data[i].raw[3]);
+            EXPECT_EQ(-1.0f, data[i].offset[0]);
+        }
+
+        expectSameAsMatrix(m, in, out);
+    }
+}
+
+TEST(AffineTransform, affine)
+{
+    Matrix<4, 3, float> m = matrix<4>({ { { 0.0f, 2.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 2.0f, 3.0f } } });
+    std::array<float, 3> v = { 1.0f, 2.0f, 3.0f };
+
+    for (auto kernel : kernels) {
+        std::array<float, 6> samples = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+        AffineTransform transform;
+
+        transform.configure(m);
+        if (transform.setKernel(kernel) < 0) {
+            continue;
+        }
+
+        transform.transformBatch(samples.data(), samples.data(), 2);
+        EXPECT_EQ(5.0f, samples[0]);
+        EXPECT_EQ(1.0f, samples[1]);
+        EXPECT_EQ(6.0f, samples[2]);
+        EXPECT_EQ(11.0f, samples[3]);
+        EXPECT_EQ(-2.0f, samples[4]);
+        EXPECT_EQ(9.0f, samples[5]);
+
+        transform.transform(v.data(), v.data());
+        EXPECT_EQ(5.0f, v[0]);
+        v = { 1.0f, 2.0f, 3.0f };
+    }
+}
+
+/* counts to processed data with the transforms precomposed by HW sensors */
+TEST(AffineTransform, precomposedScanAndCalibration)
+{
+    Matrix<3, 3, float> r = matrix<3>({ { { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } });
+    Matrix<3, 3, float> b = matrix<3>({ { { 1.02f, 0.01f, 0.0f }, { 0.01f, 0.97f, -0.02f }, { 0.0f, -0.02f, 1.05f } } });
+    std::array<float, 3> o = { 0.12f, -0.3f, 0.05f };
+    const std::array<float, 2> scale = { 0.000598f, 0.000612f };
+    const std::array<float, 2> offset = { 3.0f, -5.0f };
+    std::vector<float> counts = randomSamples(16, 32768.0f);
+
+    /* x and z axes only, 2 channels */
+    Matrix<3, 3, float> s = matrix<3>({ { { scale[0], 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, scale[1], 0.0f } } });
+    std::array<float, 3> t = { scale[0] * offset[0], 0.0f, scale[1] * offset[1] };
+    std::array<float, 3> bo = b * o;
+
+    for (auto kernel : kernels) {
+        std::array<SensorBaseData, 16> data;
+        AffineTransform raw, processed;
+
+        raw.configure(r * s, r * t);
+        processed.configure(b, { -bo[0], -bo[1], -bo[2] });
+        if ((raw.setKernel(kernel) < 0) || (processed.setKernel(kernel) < 0)) {
+            continue;
+        }
+
+        for (auto i = 0U; i < data.size(); ++i) {
+            data[i].raw[0] = std::round(counts[3 * i]);
+            data[i].raw[1] = std::round(counts[3 * i + 1]);
+            data[i].raw[2] = 0.0f;
+            data[i].processed[3] = i;
+        }
+
+        raw.transformBatch(data[0].raw, data[0].raw, data.size(), sizeof(SensorBaseData));
+        processed.transformBatch(data[0].raw, data[0].processed, data.size(), sizeof(SensorBaseData));
+
+        for (auto i = 0U; i < data.size(); ++i) {
+            std::array<float, 3> axes = {
+                (std::round(counts[3 * i]) + offset[0]) * scale[0],
+                0.0f,
+                (std::round(counts[3 * i + 1]) + offset[1]) * scale[1],
+            };
+            std::array<float, 3> expected = r * axes;
+
+            for (auto j = 0U; j < 3; ++j) {
+                EXPECT_NEAR(expected[j], data[i].raw[j], 1e-5f);
+                axes[j] = expected[j] - o[j];
+            }
+
+            expected = b * axes;
+            for (auto j = 0U; j < 3; ++j) {
+                EXPECT_NEAR(expected[j], data[i].processed[j], 1e-5f);
+            }
+
+            EXPECT_EQ((float)i, data[i].processed[3]);
+        }
+    }
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <CalibrationWorker.h>
+#include <SeqLock.h>
+
+struct TestBias {
+    std::array<float, 12> bias;
+    int64_t sequence;
+};
+
+TEST(SeqLock, readWrite)
+{
+    SeqLock<TestBias> lock;
+    TestBias value, out;
+
+    EXPECT_FALSE(lock.read(out));
+    EXPECT_EQ(0U, lock.getVersion());
+
+    value.bias.fill(1.5f);
+    value.sequence = 7;
+    lock.write(value);
+
+    ASSERT_TRUE(lock.read(out));
+    EXPECT_EQ(1U, lock.getVersion());
+    EXPECT_EQ(7, out.sequence);
+    EXPECT_EQ(1.5f, out.bias[11]);
+}
+
+/* readers never see a partially written value */
+TEST(SeqLock, concurrentReaders)
+{
+    SeqLock<TestBias> lock;
+    std::atomic<bool> running(true);
+    std::atomic<int> torn(0);
+    std::vector<std::thread> readers;
+
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&] {
+            TestBias out;
+
+            while (running) {
+                if (!lock.read(out)) {
+                    continue;
+                }
+
+                for (auto v : out.bias) {
+                    if (v != (float)out.sequence) {
+                        torn++;
+                    }
+                }
+            }
+        });
+    }
+
+    for (int64_t i = 0; i < 100000; ++i) {
+        TestBias value;
+
+        value.bias.fill((float)i);
+        value.sequence = i;
+        lock.write(value);
+    }
+
+    running = false;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(0, torn.load());
+}
+
+TEST(CalibrationWorker, processInOrder)
+{
+    CalibrationWorker<int> worker;
+    std::vector<int> processed;
+    std::vector<int> samples(1000);
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = i;
+    }
+
+    ASSERT_EQ(0, worker.start(100, [&](const int *data, size_t count) {
+        processed.insert(processed.end(), data, data + count);
+    }));
+    EXPECT_EQ(-EINVAL, worker.start(100, [](const int *, size_t) {}));
+
+    /* the ring (128 samples) is flushed before it can be full */
+    for (size_t i = 0; i < samples.size(); i += 10) {
+        EXPECT_EQ(10U, worker.push(&samples[i], 10));
+
+        if (i % 100 == 0) {
+            worker.flush();
+        }
+    }
+
+    worker.flush();
+
+    ASSERT_EQ(samples.size(), processed.size());
+    EXPECT_EQ(samples, processed);
+    EXPECT_EQ(0U, worker.getDropped());
+}
+
+TEST(CalibrationWorker, dropWhenFull)
+{
+    CalibrationWorker<int> worker;
+    std::atomic<bool> blocked(true);
+    std::vector<int> samples(64, 1);
+    std::atomic<size_t> processed(0);
+    size_t queued;
+
+    ASSERT_EQ(0, worker.start(16, [&](const int *, size_t count) {
+        while (blocked) {
+            std::this_thread::yield();
+        }
+
+        processed += count;
+    }));
+
+    /* producer never blocks, samples exceeding the ring length are dropped */
+    queued = worker.push(samples.data(), samples.size());
+    EXPECT_EQ(16U, queued);
+    EXPECT_EQ(samples.size() - queued, worker.getDropped());
+
+    blocked = false;
+    worker.flush();
+    EXPECT_EQ(queued, processed.load());
+}
+
+TEST(CalibrationWorker, stopDrainsRing)
+{
+    CalibrationWorker<int> worker;
+    std::vector<int> samples(32, 1);
+    size_t processed = 0;
+
+    ASSERT_EQ(0, worker.start(32, [&](const int *, size_t count) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        processed += count;
+    }));
+
+    EXPECT_EQ(samples.size(), worker.push(samples.data(), samples.size()));
+    worker.stop();
+
+    EXPECT_FALSE(worker.isRunning());
+    EXPECT_EQ(samples.size(), processed);
+}
+
+/* an idle worker waits with no timeout, the first push wakes it up */
+TEST(CalibrationWorker, idleWokenByPush)
+{
+    CalibrationWorker<int> worker;
+    std::atomic<size_t> processed(0);
+    int sample = 1;
+
+    ASSERT_EQ(0, worker.start(64, [&](const int *, size_t count) {
+        processed += count;
+    }));
+
+    for (int round = 0; round < 3; ++round) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        EXPECT_EQ(1U, worker.push(&sample, 1));
+
+        for (int i = 0; (i < 1000) && (processed.load() < (size_t)round + 1); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        EXPECT_EQ((size_t)round + 1, processed.load());
+    }
+
+    worker.stop();
+    EXPECT_FALSE(worker.isRunning());
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "HWSensorBase.h"
+
+using stm::core::AccelSensorType;
+using stm::core::HWSensorBase;
+using stm::core::HWSensorBaseCommonData;
+using stm::core::IIOChannelType;
+using stm::core::SensorType;
+
+static const int sensorHandle = 1;
+static const size_t scanSize = 16;
+
+/*
+ * Hardware sensor reading its scans from a pipe instead of the iio char
+ * device, samples and flush completions are written in order to its pipe.
+ */
+class PipeSensor : public HWSensorBase {
+public:
+    PipeSensor(HWSensorBaseCommonData *data)
+        : HWSensorBase(data, "pipe-accel", sensorHandle, AccelSensorType, 10, 0.1f, 0) {}
+
+    void setDataFd(int fd)
+    {
+        pollfd_iio[0].fd = fd;
+        pollfd_iio[0].events = POLLIN;
+    }
+
+    int getReadFd(void) const { return read_pipe_fd; }
+
+    /* the reference moves to the newest sample once the read is delivered */
+    bool waitSampleInProcessing(int64_t timestamp)
+    {
+        for (int i = 0; (i < 2000) && (sample_in_processing_timestamp != timestamp); ++i) {
+            usleep(1000);
+        }
+
+        return sample_in_processing_timestamp == timestamp;
+    }
+
+    void completeFlush(int64_t timestamp)
+    {
+        {
+            std::lock_guard<std::mutex> lock(flushRequesteLock);
+            flushRequested.push(sensorHandle);
+        }
+
+        ProcessFlushData(sensorHandle, timestamp);
+    }
+
+    void ProcessData(SensorBaseData *data) override
+    {
+        sensors_event_t event = {};
+
+        event.sensor = sensorHandle;
+        event.type = AccelSensorType;
+        event.timestamp = data->timestamp;
+        ASSERT_EQ(write(write_pipe_fd, &event, sizeof(event)), (ssize_t)sizeof(event));
+
+        HWSensorBase::ProcessData(data);
+    }
+};
+
+class HWSensorBaseTest : public ::testing::Test {
+protected:
+    int dataFd[2] = { -1, -1 };
+    std::unique_ptr<PipeSensor> sensor;
+
+    void SetUp() override
+    {
+        HWSensorBaseCommonData data = {};
+
+        strcpy(data.device_name, "pipe-accel");
+        data.device_iio_dev_num = 99999;
+        data.num_channels = 4;
+
+        /* x, y, z: le:s16/16>>0, timestamp: le:s64/63>>0 */
+        for (int k = 0; k < 3; ++k) {
+            data.channels[k].scale = 1.0f;
+            data.channels[k].bytes = 2;
+            data.channels[k].bits_used = 16;
+            data.channels[k].sign = 1;
+            data.channels[k].mask = 0xffff;
+            data.channels[k].type = IIOChannelType::UNKNOWN;
+        }
+
+        data.channels[3].scale = 1.0f;
+        data.channels[3].bytes = 8;
+        data.channels[3].bits_used = 63;
+        data.channels[3].sign = 1;
+        data.channels[3].mask = 0x7fffffffffffffffULL;
+        data.channels[3].type = IIOChannelType::TIMESTAMP;
+
+        ASSERT_EQ(pipe(dataFd), 0);
+        fcntl(dataFd[0], F_SETFL, O_NONBLOCK);
+
+        sensor = std::make_unique<PipeSensor>(&data);
+        sensor->setDataFd(dataFd[0]);
+        ASSERT_EQ(sensor->startThreads(), 0);
+    }
+
+    void TearDown() override
+    {
+        /* the data thread is joined before its fd is closed */
+        sensor.reset();
+        close(dataFd[0]);
+        close(dataFd[1]);
+    }
+
+    void writeScans(const std::vector<int64_t> &timestamps)
+    {
+        std::vector<uint8_t> buffer(timestamps.size() * scanSize, 0);
+
+        for (size_t i = 0; i < timestamps.size(); ++i) {
+            memcpy(buffer.data() + i * scanSize + 8, &timestamps[i], sizeof(int64_t));
+        }
+
+        ASSERT_EQ(write(dataFd[1], buffer.data(), buffer.size()), (ssize_t)buffer.size());
+    }
+
+    /* events written by the sensor, -1 for a flush completion */
+    std::vector<int64_t> readEvents(size_t count)
+    {
+        std::vector<int64_t> events;
+        struct pollfd pfd = { sensor->getReadFd(), POLLIN, 0 };
+        sensors_event_t event;
+
+        while ((events.size() < count) && (poll(&pfd, 1, 2000) > 0)) {
+            while (read(pfd.fd, &event, sizeof(event)) == sizeof(event)) {
+                events.push_back((event.type == SensorType::META_DATA) ? -1 : event.timestamp);
+            }
+        }
+
+        return events;
+    }
+};
+
+/**
+ * flushOrdering: a flush completes after every sample read before it and
+ *                before the samples that follow it, samples being delivered
+ *                once the whole FIFO read is processed
+ */
+TEST_F(HWSensorBaseTest, flushOrdering)
+{
+    writeScans({ 10, 20, 30, 40 });
+    ASSERT_EQ(readEvents(4), std::vector<int64_t>({ 10, 20, 30, 40 }));
+    ASSERT_TRUE(sensor->waitSampleInProcessing(40));
+
+    /* not newer than the delivered samples: completed at once */
+    sensor->completeFlush(5);
+    sensor->completeFlush(35);
+    sensor->completeFlush(40);
+    ASSERT_EQ(readEvents(3), std::vector<int64_t>({ -1, -1, -1 }));
+
+    /* newer: completed after the first sample that follows it */
+    sensor->completeFlush(45);
+    sensor->completeFlush(65);
+    EXPECT_EQ(readEvents(0), std::vector<int64_t>());
+
+    writeScans({ 50, 60, 70, 80 });
+    ASSERT_EQ(readEvents(6), std::vector<int64_t>({ 50, -1, 60, 70, -1, 80 }));
+    ASSERT_TRUE(sensor->waitSampleInProcessing(80));
+
+    /* queued before the read: completed inside it, after the sample that follows it */
+    sensor->completeFlush(95);
+    writeScans({ 90, 100 });
+    ASSERT_EQ(readEvents(3), std::vector<int64_t>({ 90, 100, -1 }));
+}
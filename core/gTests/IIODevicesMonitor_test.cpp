@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2015-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <IIODevicesMonitor.h>
+
+using stm::core::IIODevicesMonitor;
+
+class IIODevicesMonitorTest : public ::testing::Test {
+protected:
+    std::string devicesDir;
+    std::mutex lock;
+    std::condition_variable cond;
+    int changes = 0;
+
+    void SetUp() override {
+        char dirTemplate[] = "/tmp/iio-devices-XXXXXX";
+
+        ASSERT_NE(nullptr, mkdtemp(dirTemplate));
+        devicesDir = dirTemplate;
+    }
+
+    void TearDown() override {
+        rmdir((devicesDir + "/iio:device0").c_str());
+        rmdir((devicesDir + "/iio:device1").c_str());
+        rmdir(devicesDir.c_str());
+    }
+
+    void onChange(void) {
+        std::lock_guard<std::mutex> guard(lock);
+        changes++;
+        cond.notify_all();
+    }
+
+    bool waitChanges(int count) {
+        std::unique_lock<std::mutex> guard(lock);
+
+        return cond.wait_for(guard, std::chrono::seconds(2), [&] { return changes >= count; });
+    }
+};
+
+/**
+ * notifyAddRemove: verify that adding/removing device entries is notified
+ * once per burst and unrelated entries are ignored
+ */
+TEST_F(IIODevicesMonitorTest, notifyAddRemove)
+{
+    IIODevicesMonitor monitor(devicesDir, [this] { onChange(); });
+
+    ASSERT_EQ(0, monitor.start());
+
+    ASSERT_EQ(0, mkdir((devicesDir + "/iio:device0").c_str(), S_IRWXU));
+    ASSERT_EQ(0, mkdir((devicesDir + "/iio:device1").c_str(), S_IRWXU));
+    ASSERT_TRUE(waitChanges(1));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(1, changes);
+
+    ASSERT_EQ(0, mkdir((devicesDir + "/trigger0").c_str(), S_IRWXU));
+    ASSERT_EQ(0, rmdir((devicesDir + "/trigger0").c_str()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(1, changes);
+
+    ASSERT_EQ(0, rmdir((devicesDir + "/iio:device1").c_str()));
+    ASSERT_TRUE(waitChanges(2));
+
+    monitor.stop();
+}
@@ -0,0 +1,588 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <IIORecorder.h>
+#include <IIORecording.h>
+
+#include "IIOReplay.h"
+#include "IIOScanDecoder.h"
+
+using stm::core::DecodeScanBuffer;
+using stm::core::IIOChannelType;
+using stm::core::IIOControlOp;
+using stm::core::IIORecordHeader;
+using stm::core::IIORecordType;
+using stm::core::IIORecorder;
+using stm::core::IIORecording;
+using stm::core::IIORecordingControl;
+using stm::core::IIORecordingDevice;
+using stm::core::IIORecordingFooter;
+using stm::core::IIORecordingIndexEntry;
+using stm::core::IIOReplay;
+using stm::core::device_iio_events;
+using stm::core::device_iio_info_channel;
+using stm::core::iioRecordAlign;
+using stm::core::iioRecordingIndexInterval;
+
+static const size_t scanSize = 16;
+static const int64_t ms = 1000000LL;
+
+class IIOReplayTest : public ::testing::Test {
+protected:
+    std::string path;
+    IIORecorder recorder;
+    IIORecordingDevice device;
+    struct device_iio_info_channel channels[4];
+    std::mt19937 rng { 42 };
+
+    void SetUp() override
+    {
+        char name[] = "/tmp/stm-iio-recording-XXXXXX";
+        int fd = mkstemp(name);
+
+        ASSERT_GE(fd, 0);
+        close(fd);
+        path = name;
+
+        /* x, y, z: le:s16/16>>0, timestamp: le:s64/63>>0 at offset 8 */
+        memset(&device, 0, sizeof(device));
+        strcpy(device.name, "lsm6dsv_accel");
+        device.scanSize = scanSize;
+        device.numChannels = 4;
+        device.countsChannels = 0;
+
+        for (int k = 0; k < 3; ++k) {
+            device.channels[k].scale = 0.000598f;
+            device.channels[k].offset = 0.0f;
+            device.channels[k].bytes = 2;
+            device.channels[k].bitsUsed = 16;
+            device.channels[k].sign = 1;
+            device.channels[k].location = 2 * k;
+            device.channels[k].type = static_cast<uint32_t>(IIOChannelType::UNKNOWN);
+            device.channels[k].mask = 0xffff;
+        }
+
+        device.channels[3].scale = 1.0f;
+        device.channels[3].bytes = 8;
+        device.channels[3].bitsUsed = 63;
+        device.channels[3].sign = 1;
+        device.channels[3].location = 8;
+        device.channels[3].type = static_cast<uint32_t>(IIOChannelType::TIMESTAMP);
+        device.channels[3].mask = 0x7fffffffffffffffULL;
+
+        updateChannels();
+
+        ASSERT_EQ(recorder.open(path), 0);
+    }
+
+    void TearDown() override
+    {
+        recorder.close();
+        unlink(path.c_str());
+    }
+
+    void updateChannels(void)
+    {
+        for (int k = 0; k < device.numChannels; ++k) {
+            channels[k] = device_iio_info_channel();
+            channels[k].scale = device.channels[k].scale;
+            channels[k].offset = device.channels[k].offset;
+            channels[k].bytes = device.channels[k].bytes;
+            channels[k].bits_used = device.channels[k].bitsUsed;
+            channels[k].shift = device.channels[k].shift;
+            channels[k].mask = device.channels[k].mask;
+            channels[k].be = device.channels[k].be;
+            channels[k].sign = device.channels[k].sign;
+            channels[k].location = device.channels[k].location;
+            channels[k].type = static_cast<IIOChannelType>(device.channels[k].type);
+        }
+    }
+
+    std::vector<uint8_t> makeBuffer(unsigned int scans, int64_t timestamp)
+    {
+        std::vector<uint8_t> buffer(scans * scanSize);
+
+        for (unsigned int i = 0; i < scans; ++i) {
+            uint8_t *scan = buffer.data() + i * scanSize;
+            int64_t ts = timestamp + i * 5 * ms;
+
+            for (int k = 0; k < 6; ++k) {
+                scan[k] = rng() & 0xff;
+            }
+
+            memcpy(scan + 8, &ts, sizeof(ts));
+        }
+
+        return buffer;
+    }
+
+    void recordScan(int32_t handle, int64_t timestamp, const std::vector<uint8_t> &buffer)
+    {
+        recorder.recordScan(device, handle, timestamp, buffer.data(), buffer.size());
+    }
+};
+
+struct ReplayedScan {
+    int32_t handle;
+    int64_t timestamp;
+    std::vector<SensorBaseData> samples;
+};
+
+class ReplayConsumer : public IIOReplay::Consumer {
+public:
+    std::vector<ReplayedScan> scans;
+    std::vector<std::string> order;
+    std::vector<IIORecordingControl> controls;
+    std::vector<struct device_iio_events> events;
+
+    void onScanData(int32_t handle, int64_t timestamp,
+                    const SensorBaseData *data, unsigned int count) override
+    {
+        scans.push_back({ handle, timestamp, std::vector<SensorBaseData>(data, data + count) });
+        order.push_back("scan");
+    }
+
+    void onEvents(int32_t handle, int64_t timestamp,
+                  const struct device_iio_events *data, unsigned int count) override
+    {
+        (void) handle; (void) timestamp;
+        events.insert(events.end(), data, data + count);
+        order.push_back("events");
+    }
+
+    void onControl(int32_t handle, int64_t timestamp,
+                   const IIORecordingControl &control) override
+    {
+        (void) handle; (void) timestamp;
+        controls.push_back(control);
+        order.push_back("control");
+    }
+};
+
+static void expectSameSamples(const SensorBaseData *expected, const SensorBaseData *actual,
+                              unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i) {
+        EXPECT_EQ(memcmp(expected[i].raw, actual[i].raw, 3 * sizeof(float)), 0) << "sample " << i;
+        EXPECT_EQ(expected[i].timestamp, actual[i].timestamp) << "sample " << i;
+        EXPECT_EQ(expected[i].hasHwTimestamp, actual[i].hasHwTimestamp) << "sample " << i;
+    }
+}
+
+TEST_F(IIOReplayTest, recordingReadBack)
+{
+    std::vector<std::vector<uint8_t>> buffers;
+    IIORecording recording;
+
+    for (int i = 0; i < 3; ++i) {
+        buffers.push_back(makeBuffer(4, i * 20 * ms));
+        recordScan(1, i * 20 * ms, buffers.back());
+    }
+
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+    EXPECT_TRUE(recording.isComplete());
+    ASSERT_EQ(recording.size(), 4U);
+
+    EXPECT_EQ(recording.at(0).header->type, static_cast<uint16_t>(IIORecordType::DEVICE));
+    ASSERT_NE(recording.getDevice(1), nullptr);
+    EXPECT_EQ(memcmp(recording.getDevice(1), &device, sizeof(device)), 0);
+    EXPECT_EQ(recording.getDevice(2), nullptr);
+
+    for (size_t i = 1; i < recording.size(); ++i) {
+        IIORecording::Record record = recording.at(i);
+
+        EXPECT_EQ(record.header->type, static_cast<uint16_t>(IIORecordType::SCAN));
+        EXPECT_EQ(record.header->handle, 1);
+        EXPECT_EQ(record.header->sequence, i);
+        ASSERT_EQ(record.header->size, buffers[i - 1].size());
+        EXPECT_EQ(memcmp(record.payload, buffers[i - 1].data(), record.header->size), 0);
+    }
+
+    EXPECT_EQ(recording.lowerBound(20 * ms), 2U);
+    EXPECT_EQ(recording.lowerBound(21 * ms), 3U);
+    EXPECT_EQ(recording.lowerBound(100 * ms), 4U);
+}
+
+TEST_F(IIOReplayTest, replayIsBitExact)
+{
+    std::vector<std::vector<uint8_t>> buffers;
+    IIORecording recording;
+    ReplayConsumer consumer;
+
+    for (int i = 0; i < 50; ++i) {
+        buffers.push_back(makeBuffer(1 + (i % 7), i * 10 * ms));
+        recordScan(3, i * 10 * ms, buffers.back());
+    }
+
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+
+    IIOReplay replay(recording);
+    ASSERT_EQ(replay.run(consumer, IIOReplay::Mode::FAST), 50);
+    ASSERT_EQ(consumer.scans.size(), buffers.size());
+
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        std::vector<SensorBaseData> expected(buffers[i].size() / scanSize);
+        unsigned int decoded = DecodeScanBuffer(buffers[i].data(), buffers[i].size(), scanSize,
+                                                channels, device.numChannels,
+                                                device.countsChannels, expected.data());
+
+        EXPECT_EQ(consumer.scans[i].handle, 3);
+        EXPECT_EQ(consumer.scans[i].timestamp, (int64_t)i * 10 * ms);
+        ASSERT_EQ(consumer.scans[i].samples.size(), decoded);
+        expectSameSamples(expected.data(), consumer.scans[i].samples.data(), decoded);
+    }
+
+    /* a second run replays the same samples */
+    ReplayConsumer again;
+    ASSERT_EQ(replay.run(again, IIOReplay::Mode::FAST), 50);
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        ASSERT_EQ(again.scans[i].samples.size(), consumer.scans[i].samples.size());
+        expectSameSamples(consumer.scans[i].samples.data(), again.scans[i].samples.data(),
+                          consumer.scans[i].samples.size());
+    }
+}
+
+TEST_F(IIOReplayTest, layoutChangeIsReplayed)
+{
+    std::vector<uint8_t> first = makeBuffer(2, 0);
+    std::vector<uint8_t> second = makeBuffer(2, 10 * ms);
+    std::vector<SensorBaseData> expected(2);
+    IIORecording recording;
+    ReplayConsumer consumer;
+
+    recordScan(1, 0, first);
+
+    for (int k = 0; k < 3; ++k) {
+        device.channels[k].scale *= 2.0f;
+    }
+    updateChannels();
+
+    recordScan(1, 10 * ms, second);
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+    ASSERT_EQ(recording.size(), 4U);
+    EXPECT_EQ(recording.at(2).header->type, static_cast<uint16_t>(IIORecordType::DEVICE));
+
+    IIOReplay replay(recording);
+    ASSERT_EQ(replay.run(consumer, IIOReplay::Mode::FAST), 2);
+    ASSERT_EQ(consumer.scans.size(), 2U);
+
+    DecodeScanBuffer(second.data(), second.size(), scanSize, channels,
+                     device.numChannels, device.countsChannels, expected.data());
+    expectSameSamples(expected.data(), consumer.scans[1].samples.data(), 2);
+}
+
+TEST_F(IIOReplayTest, truncatedRecording)
+{
+    IIORecording recording;
+    ReplayConsumer consumer;
+    off_t lastRecord;
+
+    for (int i = 0; i < 5; ++i) {
+        recordScan(1, i * 10 * ms, makeBuffer(3, i * 10 * ms));
+    }
+
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+    ASSERT_EQ(recording.size(), 6U);
+    lastRecord = reinterpret_cast<const uint8_t *>(recording.at(5).header) -
+                 reinterpret_cast<const uint8_t *>(recording.at(0).header) +
+                 sizeof(stm::core::IIORecordingFileHeader);
+    recording.close();
+
+    /* crash while writing the last buffer: no index, no footer */
+    ASSERT_EQ(truncate(path.c_str(), lastRecord + 30), 0);
+
+    ASSERT_EQ(recording.open(path), 0);
+    EXPECT_FALSE(recording.isComplete());
+    ASSERT_EQ(recording.size(), 5U);
+
+    IIOReplay replay(recording);
+    EXPECT_EQ(replay.run(consumer, IIOReplay::Mode::FAST), 4);
+}
+
+TEST_F(IIOReplayTest, sparseIndex)
+{
+    const size_t scans = 2 * iioRecordingIndexInterval + 10;
+    std::vector<uint8_t> buffer = makeBuffer(1, 0);
+    IIORecordingFooter footer;
+    IIORecordingIndexEntry entry;
+    IIORecording recording;
+    uint64_t indexOffset;
+
+    /* written by several threads, queued to the writer thread */
+    std::vector<std::thread> threads;
+    for (int32_t handle = 0; handle < 2; ++handle) {
+        threads.emplace_back([&, handle] {
+            for (size_t i = handle; i < scans; i += 2) {
+                recordScan(handle, i * ms, buffer);
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+    EXPECT_TRUE(recording.isComplete());
+    ASSERT_EQ(recording.size(), scans + 2);
+
+    for (size_t i = 0; i < recording.size(); ++i) {
+        EXPECT_EQ(recording.at(i).header->sequence, i);
+    }
+
+    /* one entry out of iioRecordingIndexInterval records */
+    indexOffset = reinterpret_cast<const uint8_t *>(recording.at(scans + 1).header) -
+                  reinterpret_cast<const uint8_t *>(recording.at(0).header) +
+                  sizeof(stm::core::IIORecordingFileHeader) + sizeof(IIORecordHeader) +
+                  iioRecordAlign(buffer.size());
+    recording.close();
+
+    FILE *file = fopen(path.c_str(), "r+");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(fseek(file, -(long)sizeof(footer), SEEK_END), 0);
+    ASSERT_EQ(fread(&footer, sizeof(footer), 1, file), 1U);
+    EXPECT_EQ(footer.indexOffset, indexOffset);
+    EXPECT_EQ(footer.indexCount, 3U);
+    EXPECT_EQ(footer.recordCount, scans + 2);
+
+    /* index not matching the records: read as a recording not closed */
+    ASSERT_EQ(fseek(file, footer.indexOffset + sizeof(IIORecordHeader) + sizeof(entry), SEEK_SET), 0);
+    ASSERT_EQ(fread(&entry, sizeof(entry), 1, file), 1U);
+    entry.offset += 8;
+    ASSERT_EQ(fseek(file, footer.indexOffset + sizeof(IIORecordHeader) + sizeof(entry), SEEK_SET), 0);
+    ASSERT_EQ(fwrite(&entry, sizeof(entry), 1, file), 1U);
+    fclose(file);
+
+    ASSERT_EQ(recording.open(path), 0);
+    EXPECT_FALSE(recording.isComplete());
+    EXPECT_EQ(recording.size(), scans + 2);
+    EXPECT_EQ(recording.lowerBound(scans * ms), scans + 2);
+}
+
+TEST_F(IIOReplayTest, invalidRecording)
+{
+    IIORecording recording;
+
+    recorder.close();
+
+    ASSERT_EQ(truncate(path.c_str(), 4), 0);
+    EXPECT_EQ(recording.open(path), -EINVAL);
+    EXPECT_EQ(recording.open(path + ".missing"), -ENOENT);
+}
+
+TEST_F(IIOReplayTest, invalidLayoutIsNotReplayed)
+{
+    IIORecording recording;
+    ReplayConsumer consumer;
+
+    recordScan(1, 0, makeBuffer(2, 0));
+
+    /* timestamp channel past the end of the scan */
+    device.channels[3].location = scanSize - 4;
+    recordScan(1, 10 * ms, makeBuffer(2, 10 * ms));
+
+    device.channels[3].location = 8;
+    device.numChannels = 64;
+    recordScan(2, 20 * ms, makeBuffer(2, 20 * ms));
+
+    device.numChannels = 4;
+    device.countsChannels = 5;
+    recordScan(3, 30 * ms, makeBuffer(2, 30 * ms));
+
+    device.countsChannels = 0;
+    recordScan(1, 40 * ms, makeBuffer(2, 40 * ms));
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+
+    /* the scans recorded with a valid layout are still replayed */
+    IIOReplay replay(recording);
+    ASSERT_EQ(replay.run(consumer, IIOReplay::Mode::FAST), 2);
+    ASSERT_EQ(consumer.scans.size(), 2U);
+    EXPECT_EQ(consumer.scans[0].timestamp, 0);
+    EXPECT_EQ(consumer.scans[1].timestamp, 40 * ms);
+}
+
+TEST_F(IIOReplayTest, recordsOrderIsPreserved)
+{
+    IIORecordingControl control = {};
+    struct device_iio_events events[2];
+    IIORecording recording;
+    ReplayConsumer consumer;
+
+    control.op = static_cast<uint32_t>(IIOControlOp::ENABLE);
+    control.handle = 1;
+    control.arg0 = 1;
+    recorder.recordControl(1, 0, control);
+
+    recordScan(1, 5 * ms, makeBuffer(1, 5 * ms));
+
+    memset(events, 0, sizeof(events));
+    events[0].event_id = 0x1234;
+    events[0].event_timestamp = 6 * ms;
+    events[1].event_id = 0x5678;
+    events[1].event_timestamp = 7 * ms;
+    recorder.recordEvents(1, 7 * ms, events, sizeof(events));
+
+    control.op = static_cast<uint32_t>(IIOControlOp::SET_DELAY);
+    control.arg0 = 10 * ms;
+    control.arg1 = 0;
+    recorder.recordControl(1, 8 * ms, control);
+
+    recordScan(1, 9 * ms, makeBuffer(1, 9 * ms));
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+
+    IIOReplay replay(recording);
+    ASSERT_EQ(replay.run(consumer, IIOReplay::Mode::FAST), 5);
+
+    std::vector<std::string> expected = { "control", "scan", "events", "control", "scan" };
+    EXPECT_EQ(consumer.order, expected);
+
+    ASSERT_EQ(consumer.events.size(), 2U);
+    EXPECT_EQ(consumer.events[0].event_id, 0x1234U);
+    EXPECT_EQ(consumer.events[1].event_timestamp, 7 * ms);
+
+    ASSERT_EQ(consumer.controls.size(), 2U);
+    EXPECT_EQ(consumer.controls[0].op, static_cast<uint32_t>(IIOControlOp::ENABLE));
+    EXPECT_EQ(consumer.controls[1].op, static_cast<uint32_t>(IIOControlOp::SET_DELAY));
+    EXPECT_EQ(consumer.controls[1].arg0, 10 * ms);
+}
+
+TEST_F(IIOReplayTest, timestampRange)
+{
+    IIORecording recording;
+    ReplayConsumer consumer;
+
+    for (int i = 0; i < 10; ++i) {
+        recordScan(1, i * 10 * ms, makeBuffer(2, i * 10 * ms));
+    }
+
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+
+    /* the device layout recorded before the range is still used */
+    IIOReplay replay(recording);
+    ASSERT_EQ(replay.run(consumer, IIOReplay::Mode::FAST, 35 * ms, 70 * ms), 4);
+    ASSERT_EQ(consumer.scans.size(), 4U);
+    EXPECT_EQ(consumer.scans.front().timestamp, 40 * ms);
+    EXPECT_EQ(consumer.scans.back().timestamp, 70 * ms);
+    EXPECT_EQ(consumer.scans.front().samples.size(), 2U);
+}
+
+TEST_F(IIOReplayTest, realtimePacing)
+{
+    IIORecording recording;
+    ReplayConsumer consumer;
+
+    for (int i = 0; i < 4; ++i) {
+        recordScan(1, 1000 * ms + i * 20 * ms, makeBuffer(1, i * 20 * ms));
+    }
+
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+
+    IIOReplay replay(recording);
+    auto start = std::chrono::steady_clock::now();
+
+    ASSERT_EQ(replay.run(consumer, IIOReplay::Mode::REALTIME), 4);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(60));
+}
+
+TEST_F(IIOReplayTest, stopInterruptsReplay)
+{
+    IIORecording recording;
+    ReplayConsumer consumer;
+    int ret = 0;
+
+    recordScan(1, 0, makeBuffer(1, 0));
+    recordScan(1, 3600000 * ms, makeBuffer(1, 3600000 * ms));
+    recorder.close();
+
+    ASSERT_EQ(recording.open(path), 0);
+
+    IIOReplay replay(recording);
+    auto start = std::chrono::steady_clock::now();
+    std::thread runner([&] { ret = replay.run(consumer, IIOReplay::Mode::REALTIME); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    replay.stop();
+    runner.join();
+
+    EXPECT_EQ(ret, -ECANCELED);
+    EXPECT_EQ(consumer.scans.size(), 1U);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+
+    /* a stopped replay can run again */
+    ReplayConsumer again;
+    EXPECT_EQ(replay.run(again, IIOReplay::Mode::FAST), 2);
+}
+
+/**
+ * decoderClearsMissingAxes: a 1 axis scan (x counts + timestamp) must leave
+ *                           the y and z slots to 0, whatever the buffer held
+ */
+TEST_F(IIOReplayTest, decoderClearsMissingAxes)
+{
+    std::vector<uint8_t> buffer = makeBuffer(3, 0);
+    std::vector<SensorBaseData> samples(3);
+    struct device_iio_info_channel limited[2] = { channels[0], channels[3] };
+
+    for (auto &sample : samples) {
+        std::fill(std::begin(sample.raw), std::end(sample.raw), NAN);
+    }
+
+    ASSERT_EQ(DecodeScanBuffer(buffer.data(), buffer.size(), scanSize, limited, 2, 1,
+                               samples.data()), 3U);
+
+    for (unsigned int i = 0; i < 3; ++i) {
+        int16_t x;
+
+        memcpy(&x, buffer.data() + i * scanSize, sizeof(x));
+        EXPECT_EQ(samples[i].raw[0], (float)x);
+        EXPECT_EQ(samples[i].raw[1], 0.0f);
+        EXPECT_EQ(samples[i].raw[2], 0.0f);
+        EXPECT_EQ(samples[i].timestamp, (int64_t)i * 5 * ms);
+    }
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <RateConverter.h>
+
+static const double pi = 3.14159265358979323846;
+
+/* 400Hz input, 50Hz requested: decimation by 8 */
+static const int64_t inputPeriodNs = 2500000;
+static const int64_t outputPeriodNs = 20000000;
+
+/* 416Hz input (non integer ratio) for the resampler */
+static const int64_t resamplerInputPeriodNs = 2403846;
+
+struct Output {
+    int64_t timestamp;
+    float value[3];
+};
+
+/* sine of frequency hz on the 3 channels (with different phase) */
+static std::vector<Output> runSine(RateConverter::Mode mode, int64_t inPeriodNs,
+                                   double hz, double seconds)
+{
+    RateConverter converter;
+    std::vector<Output> outputs;
+    size_t n = seconds * 1e9 / inPeriodNs;
+
+    EXPECT_EQ(0, converter.configure(mode, 3, inPeriodNs, outputPeriodNs));
+
+    for (size_t i = 0; i < n; ++i) {
+        int64_t timestamp = 1000000000LL + i * inPeriodNs;
+        double t = timestamp * 1e-9;
+        float in[3];
+
+        for (int ch = 0; ch < 3; ++ch) {
+            in[ch] = sin(2.0 * pi * hz * t + ch);
+        }
+
+        converter.process(timestamp, in, [&](int64_t ts, const float *out) {
+            outputs.push_back({ ts, { out[0], out[1], out[2] } });
+        });
+    }
+
+    return outputs;
+}
+
+/* amplitude at frequency hz of the output, first second (transient) excluded */
+static double amplitude(const std::vector<Output> &outputs, double hz, int ch)
+{
+    double re = 0.0, im = 0.0;
+    size_t n = 0;
+
+    for (auto &out : outputs) {
+        double t = out.timestamp * 1e-9;
+
+        if (out.timestamp < outputs.front().timestamp + 1000000000LL) {
+            continue;
+        }
+
+        re += out.value[ch] * cos(2.0 * pi * hz * t);
+        im += out.value[ch] * sin(2.0 * pi * hz * t);
+        n++;
+    }
+
+    return 2.0 * sqrt(re * re + im * im) / n;
+}
+
+static double gainDb(const std::vector<Output> &outputs, double hz)
+{
+    double a = 0.0;
+
+    for (int ch = 0; ch < 3; ++ch) {
+        a = std::max(a, amplitude(outputs, hz, ch));
+    }
+
+    return 20.0 * log10(a);
+}
+
+TEST(RateConverter, decimationFactor)
+{
+    EXPECT_EQ(8, RateConverter::decimationFactor(inputPeriodNs, outputPeriodNs));
+    EXPECT_EQ(1, RateConverter::decimationFactor(inputPeriodNs, inputPeriodNs / 2));
+
+    RateConverter converter;
+    EXPECT_EQ(0, converter.configure(RateConverter::Mode::FIR, 3, inputPeriodNs, outputPeriodNs));
+    EXPECT_EQ(outputPeriodNs, converter.getOutputPeriodNs());
+    EXPECT_LE(converter.getTaps(), RateConverter::maxTaps);
+
+    EXPECT_EQ(-EINVAL, converter.configure(RateConverter::Mode::CIC, 3, 1000, 10000000));
+    EXPECT_EQ(-EINVAL, converter.configure(RateConverter::Mode::FIR,
+                                           RateConverter::maxChannels + 1,
+                                           inputPeriodNs, outputPeriodNs));
+}
+
+TEST(RateConverter, passbandGain)
+{
+    /* 5Hz, 1/10 of the output rate */
+    EXPECT_NEAR(0.0, gainDb(runSine(RateConverter::Mode::PICK, inputPeriodNs, 5.0, 10.0), 5.0), 0.1);
+    EXPECT_NEAR(0.0, gainDb(runSine(RateConverter::Mode::FIR, inputPeriodNs, 5.0, 10.0), 5.0), 0.1);
+    EXPECT_NEAR(0.0, gainDb(runSine(RateConverter::Mode::CIC, inputPeriodNs, 5.0, 10.0), 5.0), 0.5);
+    EXPECT_NEAR(0.0, gainDb(runSine(RateConverter::Mode::RESAMPLE, resamplerInputPeriodNs, 5.0, 10.0), 5.0), 0.1);
+}
+
+TEST(RateConverter, aliasRejection)
+{
+    /* 45Hz is above the 25Hz output Nyquist frequency and aliases to 5Hz */
+    EXPECT_NEAR(0.0, gainDb(runSine(RateConverter::Mode::PICK, inputPeriodNs, 45.0, 10.0), 5.0), 0.1);
+    EXPECT_LT(gainDb(runSine(RateConverter::Mode::FIR, inputPeriodNs, 45.0, 10.0), 5.0), -60.0);
+    EXPECT_LT(gainDb(runSine(RateConverter::Mode::CIC, inputPeriodNs, 45.0, 10.0), 5.0), -40.0);
+    EXPECT_LT(gainDb(runSine(RateConverter::Mode::RESAMPLE, resamplerInputPeriodNs, 45.0, 10.0), 5.0), -60.0);
+}
+
+TEST(RateConverter, resamplerExactRate)
+{
+    auto outputs = runSine(RateConverter::Mode::RESAMPLE, resamplerInputPeriodNs, 5.0, 10.0);
+
+    /* 416Hz / 50Hz is not an integer: PICK and FIR would output 52Hz */
+    ASSERT_NEAR(500, (int)outputs.size(), 1);
+    for (size_t i = 1; i < outputs.size(); ++i) {
+        ASSERT_EQ(outputPeriodNs, outputs[i].timestamp - outputs[i - 1].timestamp);
+    }
+}
+
+TEST(RateConverter, dcGain)
+{
+    const RateConverter::Mode modes[] = {
+        RateConverter::Mode::PICK,
+        RateConverter::Mode::FIR,
+        RateConverter::Mode::CIC,
+        RateConverter::Mode::RESAMPLE,
+    };
+    const float in[6] = { 9.80665f, -0.5f, 0.0f, 1234.5f, -2000.0f, 0.001f };
+
+    for (auto mode : modes) {
+        RateConverter converter;
+        size_t count = 0;
+
+        ASSERT_EQ(0, converter.configure(mode, 6, resamplerInputPeriodNs, outputPeriodNs));
+
+        for (int64_t i = 0; i < 2000; ++i) {
+            count += converter.process(i * resamplerInputPeriodNs, in,
+                                       [&](int64_t, const float *out) {
+                for (int ch = 0; ch < 6; ++ch) {
+                    EXPECT_NEAR(in[ch], out[ch], 1e-5f * std::max(1.0f, fabsf(in[ch])));
+                }
+            });
+        }
+
+        EXPECT_GT(count, 0U);
+    }
+}
+
+TEST(RateConverter, gapPrimesFilter)
+{
+    RateConverter converter;
+    const float a[3] = { 1.0f, 2.0f, 3.0f };
+    const float b[3] = { -1.0f, -2.0f, -3.0f };
+    std::vector<Output> outputs;
+    int64_t timestamp = 0;
+
+    ASSERT_EQ(0, converter.configure(RateConverter::Mode::FIR, 3, inputPeriodNs, outputPeriodNs));
+
+    auto emit = [&](int64_t ts, const float *out) {
+        outputs.push_back({ ts, { out[0], out[1], out[2] } });
+    };
+
+    for (int i = 0; i < 100; ++i, timestamp += inputPeriodNs) {
+        converter.process(timestamp, a, emit);
+    }
+
+    /* sensor disabled for 1s, first sample after the gap is emitted as is */
+    outputs.clear();
+    timestamp += 1000000000LL;
+    EXPECT_EQ(1U, converter.process(timestamp, b, emit));
+    ASSERT_EQ(1U, outputs.size());
+    EXPECT_EQ(timestamp, outputs[0].timestamp);
+    EXPECT_EQ(b[0], outputs[0].value[0]);
+    EXPECT_EQ(b[2], outputs[0].value[2]);
+}
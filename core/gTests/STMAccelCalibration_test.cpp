@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2019-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <STMAccelCalibration.h>
+
+TEST(STMAccelCalibration, instancesDoNotShareState)
+{
+    STMAccelCalibration module0, module1;
+    Matrix<4, 3, float> bias0, bias1, out;
+
+    STMAccelCalibration::resetBiasMatrix(bias0);
+    STMAccelCalibration::resetBiasMatrix(bias1);
+    bias1[3][0] = 0.5f;
+
+    EXPECT_EQ(0, module0.reset(bias0));
+    EXPECT_EQ(0, module1.reset(bias1));
+
+    EXPECT_EQ(0, module0.run({ 0.0f, 0.0f, 9.8f }, 100));
+    /* timestamps are tracked per instance */
+    EXPECT_EQ(0, module1.run({ 0.0f, 0.0f, 9.8f }, 50));
+
+    module0.getBias(out);
+    EXPECT_FLOAT_EQ(0.0f, out[3][0]);
+    module1.getBias(out);
+    EXPECT_FLOAT_EQ(0.5f, out[3][0]);
+
+    EXPECT_NE(&module0, &STMAccelCalibration::getInstance());
+    EXPECT_EQ(&STMAccelCalibration::getInstance(), &STMAccelCalibration::getInstance());
+}
+
+TEST(STMAccelCalibration, batchRun)
+{
+    STMAccelCalibration calibration;
+    Matrix<4, 3, float> bias;
+    std::array<std::array<float, 3>, 4> samples = {{ { 0.0f, 0.0f, 9.8f }, { 0.0f, 0.0f, 9.8f },
+                                                     { 0.0f, 0.0f, 9.8f }, { 0.0f, 0.0f, 9.8f } }};
+    std::array<int64_t, 4> timestamps = { 10, 20, 20, 30 };
+
+    STMAccelCalibration::resetBiasMatrix(bias);
+    calibration.reset(bias);
+
+    /* non increasing timestamp is reported, other samples are processed */
+    EXPECT_GT(0, calibration.run(samples.data(), timestamps.data(), samples.size()));
+
+    /* calibration state follows the last accepted sample */
+    EXPECT_GT(0, calibration.run(samples[0], 30));
+    EXPECT_EQ(0, calibration.run(samples[0], 31));
+}
+
+static const float gravityEarth = 9.80665f;
+static const int64_t periodNs = 10000000LL;
+
+/*
+ * synthetic accelerometer, raw = gravity / gain + offset: the device is held
+ * still for 1s in each pose, then moved for 0.3s
+ */
+struct AccelTrace {
+    std::array<float, 3> offset = { 0.3f, -0.2f, 0.15f };
+    std::array<float, 3> gain = { 1.02f, 0.98f, 1.01f };
+    std::vector<std::array<float, 3>> samples;
+    std::mt19937 gen { 1234 };
+
+    void addPose(std::array<float, 3> direction) {
+        std::normal_distribution<float> noise(0.0f, 0.02f);
+        std::uniform_real_distribution<float> motion(-12.0f, 12.0f);
+        float norm = std::sqrt(direction[0] * direction[0] +
+                               direction[1] * direction[1] +
+                               direction[2] * direction[2]);
+
+        for (int n = 0; n < 100; ++n) {
+            std::array<float, 3> sample;
+
+            for (int i = 0; i < 3; ++i) {
+                sample[i] = gravityEarth * direction[i] / norm / gain[i] + offset[i] + noise(gen);
+            }
+            samples.push_back(sample);
+        }
+
+        for (int n = 0; n < 30; ++n) {
+            samples.push_back({ motion(gen), motion(gen), motion(gen) });
+        }
+    }
+};
+
+static void runTrace(STMAccelCalibration &calibration, const AccelTrace &trace)
+{
+    std::vector<int64_t> timestamps;
+
+    for (size_t i = 0; i < trace.samples.size(); ++i) {
+        timestamps.push_back((i + 1) * periodNs);
+    }
+
+    ASSERT_EQ(0, calibration.run(trace.samples.data(), timestamps.data(), trace.samples.size()));
+}
+
+TEST(STMAccelCalibration, multiPoseOffsetAndGain)
+{
+    STMAccelCalibration calibration, restored;
+    Matrix<4, 3, float> bias, out;
+    AccelTrace trace;
+
+    for (int x = -1; x <= 1; ++x) {
+        for (int y = -1; y <= 1; ++y) {
+            for (int z = -1; z <= 1; ++z) {
+                if ((x != 0) || (y != 0) || (z != 0)) {
+                    trace.addPose({ (float)x, (float)y, (float)z });
+                }
+            }
+        }
+    }
+
+    STMAccelCalibration::resetBiasMatrix(bias);
+    ASSERT_EQ(0, calibration.init(40.0f));
+    ASSERT_EQ(0, calibration.reset(bias));
+    runTrace(calibration, trace);
+
+    calibration.getBias(bias);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NEAR(trace.offset[i], bias[3][i], 0.02f);
+        EXPECT_NEAR(trace.gain[i], bias[i][i], 0.005f);
+    }
+    EXPECT_FLOAT_EQ(0.0f, bias[0][1]);
+
+    /* estimate round-trips through reset, as stored by the HAL */
+    restored.reset(bias);
+    restored.getBias(out);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            EXPECT_FLOAT_EQ(bias[i][j], out[i][j]);
+        }
+    }
+}
+
+TEST(STMAccelCalibration, offsetOnlyFromFewPoses)
+{
+    STMAccelCalibration calibration;
+    Matrix<4, 3, float> bias;
+    AccelTrace trace;
+
+    /* upper hemisphere only: per-axis gains are not observable */
+    trace.gain = { 1.0f, 1.0f, 1.0f };
+    trace.addPose({ 0.0f, 0.0f, 1.0f });
+    trace.addPose({ 1.0f, 0.0f, 1.0f });
+    trace.addPose({ 0.0f, 1.0f, 1.0f });
+    trace.addPose({ -1.0f, 0.0f, 1.0f });
+    trace.addPose({ 0.0f, -1.0f, 1.0f });
+    trace.addPose({ 1.0f, 0.0f, 0.0f });
+
+    STMAccelCalibration::resetBiasMatrix(bias);
+    calibration.reset(bias);
+    runTrace(calibration, trace);
+
+    calibration.getBias(bias);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NEAR(trace.offset[i], bias[3][i], 0.05f);
+        EXPECT_FLOAT_EQ(bias[0][0], bias[i][i]);
+    }
+}
+
+TEST(STMAccelCalibration, accuracyFollowsFit)
+{
+    STMAccelCalibration calibration, restored;
+    Matrix<4, 3, float> bias;
+    std::vector<int64_t> timestamps;
+    AccelTrace trace;
+    size_t done = 0;
+
+    /* poses added one at a time, the accuracy after each of them */
+    const std::vector<std::pair<std::array<float, 3>, int>> steps = {
+        { { 0.0f, 0.0f, 1.0f }, STMAccelCalibration::UNRELIABLE },
+        { { 1.0f, 0.0f, 1.0f }, STMAccelCalibration::UNRELIABLE },
+        { { 0.0f, 1.0f, 1.0f }, STMAccelCalibration::UNRELIABLE },
+        { { -1.0f, 0.0f, 1.0f }, STMAccelCalibration::LOW },
+        { { 0.0f, -1.0f, 1.0f }, STMAccelCalibration::LOW },
+        { { 1.0f, 0.0f, 0.0f }, STMAccelCalibration::LOW },
+        { { 0.0f, 1.0f, 0.0f }, STMAccelCalibration::MEDIUM },
+        { { 0.0f, 0.0f, -1.0f }, STMAccelCalibration::HIGH },
+    };
+
+    /* gains close enough to 1 for offset only fits to match the poses */
+    trace.gain = { 1.005f, 0.995f, 1.0f };
+
+    STMAccelCalibration::resetBiasMatrix(bias);
+    calibration.reset(bias);
+    EXPECT_EQ(STMAccelCalibration::UNRELIABLE, calibration.getAccuracy());
+
+    for (size_t n = 0; n < steps.size(); ++n) {
+        trace.addPose(steps[n].first);
+        while (timestamps.size() < trace.samples.size()) {
+            timestamps.push_back((timestamps.size() + 1) * periodNs);
+        }
+
+        ASSERT_EQ(0, calibration.run(&trace.samples[done], &timestamps[done],
+                                     trace.samples.size() - done));
+        done = trace.samples.size();
+
+        EXPECT_EQ(steps[n].second, calibration.getAccuracy()) << "after " << n + 1 << " poses";
+    }
+
+    /* stored calibration: used, not verified */
+    calibration.getBias(bias);
+    restored.reset(bias);
+    EXPECT_EQ(STMAccelCalibration::LOW, restored.getAccuracy());
+
+    STMAccelCalibration::resetBiasMatrix(bias);
+    restored.reset(bias);
+    EXPECT_EQ(STMAccelCalibration::UNRELIABLE, restored.getAccuracy());
+}
+
+TEST(STMAccelCalibration, movingDeviceKeepsBias)
+{
+    STMAccelCalibration calibration;
+    Matrix<4, 3, float> bias;
+    AccelTrace trace;
+
+    /* motion segments only */
+    trace.addPose({ 0.0f, 0.0f, 1.0f });
+    trace.samples.erase(trace.samples.begin(), trace.samples.begin() + 100);
+    for (int i = 0; i < 5; ++i) {
+        trace.samples.insert(trace.samples.end(), trace.samples.begin(), trace.samples.begin() + 30);
+    }
+
+    STMAccelCalibration::resetBiasMatrix(bias);
+    bias[3][2] = 0.1f;
+    calibration.reset(bias);
+    runTrace(calibration, trace);
+
+    calibration.getBias(bias);
+    EXPECT_FLOAT_EQ(0.0f, bias[3][0]);
+    EXPECT_FLOAT_EQ(0.1f, bias[3][2]);
+    EXPECT_FLOAT_EQ(1.0f, bias[2][2]);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2019-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <STMGeomagFusion.h>
+
+/* earth frame (East-North-Up) references: accelerometer at rest and
+ * magnetic field with 60deg inclination [uT] */
+static const std::array<float, 3> earthAccel = { 0.0f, 0.0f, GRAVITY_EARTH };
+static const std::array<float, 3> earthMagn = { 0.0f, 25.0f, -43.3f };
+
+static std::array<float, 4> axisAngle(float x, float y, float z, float deg)
+{
+    float n = std::sqrt(x * x + y * y + z * z);
+    float half = DEG2RAD(deg) / 2.0f;
+    float s = std::sin(half) / n;
+
+    return { x * s, y * s, z * s, (float)std::cos(half) };
+}
+
+/* earth frame vector seen in sensor frame, q rotates sensor to earth frame */
+static std::array<float, 3> toSensor(const std::array<float, 4> &q,
+                                     const std::array<float, 3> &v)
+{
+    float x = -q[0], y = -q[1], z = -q[2], w = q[3];
+    std::array<float, 3> t = { 2.0f * (y * v[2] - z * v[1]),
+                               2.0f * (z * v[0] - x * v[2]),
+                               2.0f * (x * v[1] - y * v[0]) };
+
+    return { v[0] + w * t[0] + y * t[2] - z * t[1],
+             v[1] + w * t[1] + z * t[0] - x * t[2],
+             v[2] + w * t[2] + x * t[1] - y * t[0] };
+}
+
+/* angle between two rotations [deg] */
+static float angleBetween(const std::array<float, 4> &a, const std::array<float, 4> &b)
+{
+    float dot = std::fabs(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+
+    return 2.0f * std::acos(std::fmin(1.0f, dot)) * 180.0f / 3.14159265f;
+}
+
+TEST(STMGeomagFusion, staticOrientations)
+{
+    const std::array<std::array<float, 4>, 6> orientations = { {
+        axisAngle(0.0f, 0.0f, 1.0f, 0.0f),
+        axisAngle(0.0f, 0.0f, 1.0f, 90.0f),
+        axisAngle(0.0f, 0.0f, 1.0f, -135.0f),
+        axisAngle(1.0f, 0.0f, 0.0f, 60.0f),
+        axisAngle(1.0f, 1.0f, 0.0f, 170.0f),
+        axisAngle(0.3f, -0.5f, 0.8f, 75.0f),
+    } };
+
+    for (const auto &q : orientations) {
+        STMGeomagFusion fusion;
+        std::array<float, 4> out;
+
+        ASSERT_EQ(0, fusion.init(100.0f));
+        EXPECT_EQ(-1, fusion.getQuaternion(out));
+        ASSERT_EQ(0, fusion.run(toSensor(q, earthAccel), toSensor(q, earthMagn), 0.0f));
+        ASSERT_EQ(0, fusion.getQuaternion(out));
+        EXPECT_LT(angleBetween(q, out), 0.1f);
+        EXPECT_GE(out[3], 0.0f);
+    }
+}
+
+TEST(STMGeomagFusion, eulerAndGravity)
+{
+    std::array<float, 4> q = axisAngle(0.0f, 0.0f, 1.0f, -30.0f);
+    std::array<float, 3> euler, gravity, linear;
+    STMGeomagFusion fusion;
+
+    /* heading 30deg East of North, flat */
+    ASSERT_EQ(0, fusion.init(100.0f));
+    ASSERT_EQ(0, fusion.run(toSensor(q, earthAccel), toSensor(q, earthMagn), 0.0f));
+    ASSERT_EQ(0, fusion.getEulerAngles(euler));
+    EXPECT_NEAR(30.0f, euler[0], 0.1f);
+    EXPECT_NEAR(0.0f, euler[1], 0.1f);
+    EXPECT_NEAR(0.0f, euler[2], 0.1f);
+
+    ASSERT_EQ(0, fusion.getGravity(gravity));
+    ASSERT_EQ(0, fusion.getLinearAccel(linear));
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NEAR(earthAccel[i], gravity[i], 1e-3f);
+        EXPECT_NEAR(0.0f, linear[i], 1e-3f);
+    }
+
+    /* free fall gives no orientation */
+    STMGeomagFusion freeFall;
+    ASSERT_EQ(0, freeFall.init(100.0f));
+    EXPECT_EQ(-1, freeFall.run({ 0.0f, 0.0f, 0.1f }, earthMagn, 0.0f));
+    EXPECT_EQ(-1, freeFall.getQuaternion(q));
+}
+
+TEST(STMGeomagFusion, rotationTracking)
+{
+    std::mt19937 gen(42);
+    std::normal_distribution<float> accelNoise(0.0f, 0.05f);
+    std::normal_distribution<float> magnNoise(0.0f, 0.5f);
+
+    /* rotation around a tilted axis at 30deg/s, sampled at 50 and 200Hz */
+    for (float rate : { 50.0f, 200.0f }) {
+        STMGeomagFusion fusion;
+        float deltaMs = 1000.0f / rate, maxError = 0.0f;
+
+        ASSERT_EQ(0, fusion.init(rate));
+
+        for (int n = 0; n < 10 * rate; ++n) {
+            std::array<float, 4> q = axisAngle(0.2f, 0.1f, 1.0f, 30.0f * n / rate), out;
+            std::array<float, 3> accel = toSensor(q, earthAccel);
+            std::array<float, 3> magn = toSensor(q, earthMagn);
+
+            for (int i = 0; i < 3; ++i) {
+                accel[i] += accelNoise(gen);
+                magn[i] += magnNoise(gen);
+            }
+
+            ASSERT_EQ(0, fusion.run(accel, magn, n ? deltaMs : 0.0f));
+            ASSERT_EQ(0, fusion.getQuaternion(out));
+
+            /* skip the initial settling time */
+            if (n > rate) {
+                maxError = std::fmax(maxError, angleBetween(q, out));
+            }
+        }
+
+        /* lag of the filters at 30deg/s plus noise */
+        EXPECT_LT(maxError, 10.0f) << rate;
+    }
+}
+
+TEST(STMGeomagFusion, noiseIsFiltered)
+{
+    std::mt19937 gen(7);
+    std::normal_distribution<float> magnNoise(0.0f, 2.0f);
+    std::array<float, 4> q = axisAngle(1.0f, -1.0f, 0.5f, 40.0f), out;
+    STMGeomagFusion fusion;
+    float maxError = 0.0f;
+
+    ASSERT_EQ(0, fusion.init(100.0f));
+
+    for (int n = 0; n < 1000; ++n) {
+        std::array<float, 3> magn = toSensor(q, earthMagn);
+
+        for (int i = 0; i < 3; ++i) {
+            magn[i] += magnNoise(gen);
+        }
+
+        ASSERT_EQ(0, fusion.run(toSensor(q, earthAccel), magn, 10.0f));
+        ASSERT_EQ(0, fusion.getQuaternion(out));
+
+        if (n > 100) {
+            maxError = std::fmax(maxError, angleBetween(q, out));
+        }
+    }
+
+    /* single sample heading error would be several degrees */
+    EXPECT_LT(maxError, 2.0f);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2019-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <STMGyroCalibration.h>
+
+static const int64_t periodNs = 10000000LL;
+
+struct GyroTrace {
+    std::array<float, 3> bias = { 0.01f, -0.02f, 0.005f };
+    std::mt19937 gen { 1234 };
+    std::normal_distribution<float> gyroNoise { 0.0f, 0.001f };
+    std::normal_distribution<float> accelNoise { 0.0f, 0.01f };
+    int64_t timestamp = periodNs;
+
+    /* rate: device angular rate [rad/s] */
+    int run(STMGyroCalibration &calibration, int samples, bool withAccel,
+            const std::array<float, 3> &rate = { 0.0f, 0.0f, 0.0f }) {
+        for (int n = 0; n < samples; ++n, timestamp += periodNs) {
+            std::array<float, 3> gyro, accel = { 0.0f, 0.0f, 9.8f };
+            int err;
+
+            for (int i = 0; i < 3; ++i) {
+                gyro[i] = rate[i] + bias[i] + gyroNoise(gen);
+                accel[i] += accelNoise(gen);
+            }
+
+            err = withAccel ? calibration.run(accel, gyro, timestamp) :
+                              calibration.run(gyro, timestamp);
+            if (err < 0) {
+                return err;
+            }
+        }
+
+        return 0;
+    }
+};
+
+static void expectBias(const STMGyroCalibration &calibration,
+                       const std::array<float, 3> &expected, float tolerance)
+{
+    Matrix<4, 3, float> bias;
+
+    calibration.getBias(bias);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NEAR(expected[i], bias[3][i], tolerance);
+    }
+}
+
+TEST(STMGyroCalibration, stillDeviceConverges)
+{
+    STMGyroCalibration calibration;
+    Matrix<4, 3, float> bias;
+    GyroTrace trace;
+
+    STMGyroCalibration::resetBiasMatrix(bias);
+    ASSERT_EQ(0, calibration.init(1.0f, 1.0f, 20.0f, 35.0f));
+    calibration.reset(bias);
+    EXPECT_FLOAT_EQ(0.0f, calibration.getConfidence());
+    EXPECT_EQ(-1, calibration.getConvergenceTime());
+
+    /* first still window sets the bias */
+    ASSERT_EQ(0, trace.run(calibration, 110, true));
+    expectBias(calibration, trace.bias, 5e-4f);
+    EXPECT_LT(0.0f, calibration.getConfidence());
+    EXPECT_EQ(-1, calibration.getConvergenceTime());
+
+    ASSERT_EQ(0, trace.run(calibration, 1000, true));
+    EXPECT_LE(0.9f, calibration.getConfidence());
+    EXPECT_LT(0, calibration.getConvergenceTime());
+    EXPECT_GE(10000000000LL, calibration.getConvergenceTime());
+    expectBias(calibration, trace.bias, 5e-4f);
+}
+
+TEST(STMGyroCalibration, motionIsNotBias)
+{
+    STMGyroCalibration calibration;
+    Matrix<4, 3, float> bias;
+    GyroTrace trace;
+
+    STMGyroCalibration::resetBiasMatrix(bias);
+    calibration.reset(bias);
+
+    /* gyro only windows are not trusted before convergence */
+    ASSERT_EQ(0, trace.run(calibration, 500, false));
+    expectBias(calibration, { 0.0f, 0.0f, 0.0f }, 0.0f);
+
+    /* rotation changing speed */
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(0, trace.run(calibration, 25, true, { 0.0f, 0.2f * (i % 2), 0.0f }));
+    }
+    expectBias(calibration, { 0.0f, 0.0f, 0.0f }, 0.0f);
+    EXPECT_FLOAT_EQ(0.0f, calibration.getConfidence());
+
+    /* timestamps must increase */
+    EXPECT_GT(0, calibration.run({ 0.0f, 0.0f, 0.0f }, trace.timestamp - periodNs));
+}
+
+TEST(STMGyroCalibration, gyroOnlyTracking)
+{
+    STMGyroCalibration calibration;
+    Matrix<4, 3, float> bias;
+    GyroTrace trace;
+
+    STMGyroCalibration::resetBiasMatrix(bias);
+    calibration.reset(bias);
+    ASSERT_EQ(0, trace.run(calibration, 1000, true));
+    ASSERT_LE(0.9f, calibration.getConfidence());
+
+    /* slow constant rotation looks still to the gyroscope only */
+    ASSERT_EQ(0, trace.run(calibration, 500, false, { 0.0f, 0.0f, 0.05f }));
+    expectBias(calibration, trace.bias, 5e-4f);
+
+    /* small bias drift is tracked from gyroscope only */
+    trace.bias[0] += 0.004f;
+    ASSERT_EQ(0, trace.run(calibration, 6000, false));
+    expectBias(calibration, trace.bias, 5e-4f);
+    EXPECT_LE(0.9f, calibration.getConfidence());
+
+    /* stored bias starts with partial confidence */
+    calibration.getBias(bias);
+    calibration.reset(bias);
+    EXPECT_FLOAT_EQ(0.5f, calibration.getConfidence());
+}
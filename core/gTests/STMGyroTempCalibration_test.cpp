@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2019-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <STMGyroTempCalibration.h>
+
+/* linear bias drift with temperature [rad/s] */
+static std::array<float, 3> biasAt(float temperature)
+{
+    return { 0.01f + 0.0005f * temperature,
+             -0.02f - 0.0002f * temperature,
+             0.003f };
+}
+
+/* sweep the temperature range at 1Hz, 0.1 Celsius per sample */
+static void learnRamp(STMGyroTempCalibration &calibration, float from, float to,
+                      uint64_t &timestamp)
+{
+    for (float t = from; t <= to; t += 0.1f, timestamp += 1000000000ULL) {
+        std::array<float, 3> bias = biasAt(t);
+
+        ASSERT_EQ(0, calibration.run(bias, t, timestamp, nullptr));
+    }
+}
+
+TEST(STMGyroTempCalibration, interpolatesLearnedRange)
+{
+    STMGyroTempCalibration calibration;
+    std::array<float, 3> bias;
+    uint64_t timestamp = 1;
+    float temperature = 25.0f;
+    int update = 0;
+
+    ASSERT_EQ(0, calibration.initialize());
+    EXPECT_EQ(-1, calibration.getBias(&temperature, bias));
+
+    learnRamp(calibration, 0.0f, 45.0f, timestamp);
+
+    for (temperature = 10.0f; temperature <= 40.0f; temperature += 2.5f) {
+        std::array<float, 3> expected = biasAt(temperature);
+
+        ASSERT_EQ(0, calibration.getBias(&temperature, bias));
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_NEAR(expected[i], bias[i], 5e-4f) << temperature;
+        }
+    }
+
+    /* outside the learned range the closest learned bin is held */
+    temperature = 70.0f;
+    ASSERT_EQ(0, calibration.getBias(&temperature, bias));
+    EXPECT_NEAR(biasAt(44.0f)[0], bias[0], 2e-3f);
+
+    bias = biasAt(30.0f);
+    EXPECT_EQ(0, calibration.run(bias, 30.0f, timestamp, &update));
+    EXPECT_EQ(1, update);
+
+    /* timestamps must increase */
+    EXPECT_EQ(-1, calibration.run(bias, 30.0f, timestamp, &update));
+}
+
+TEST(STMGyroTempCalibration, stateRoundTrip)
+{
+    std::array<unsigned char, STMGyroTempCalibration::STMGyroTempCalibrationStateSize> state = { 0 };
+    STMGyroTempCalibration calibration, restored;
+    std::array<float, 3> bias, restoredBias;
+    uint64_t timestamp = 1;
+
+    /* empty (never saved) state */
+    EXPECT_EQ(-1, restored.setState(state.data()));
+
+    learnRamp(calibration, -10.0f, 30.0f, timestamp);
+    ASSERT_EQ(0, calibration.getState(state.data()));
+    ASSERT_EQ(0, restored.setState(state.data()));
+
+    for (float temperature = -10.0f; temperature <= 30.0f; temperature += 5.0f) {
+        ASSERT_EQ(0, calibration.getBias(&temperature, bias));
+        ASSERT_EQ(0, restored.getBias(&temperature, restoredBias));
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_NEAR(bias[i], restoredBias[i], 1e-5f);
+        }
+    }
+
+    /* bins never learned are not restored */
+    float temperature = 60.0f;
+    ASSERT_EQ(0, restored.getBias(&temperature, restoredBias));
+    ASSERT_EQ(0, calibration.getBias(&temperature, bias));
+    EXPECT_NEAR(bias[0], restoredBias[0], 1e-5f);
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2019-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <STMMagnCalibration.h>
+
+static const float fieldUt = 45.0f;
+static const int64_t periodNs = 10000000LL;
+
+/*
+ * synthetic magnetometer, raw = distortion * field + hardIron: field
+ * directions cover the sphere along a spiral, as in a figure-8 motion
+ */
+struct MagnTrace {
+    std::array<float, 3> hardIron = { 30.0f, -20.0f, 45.0f };
+    std::array<std::array<float, 3>, 3> distortion = {{ { 1.10f, 0.05f, 0.00f },
+                                                        { 0.05f, 0.95f, 0.02f },
+                                                        { 0.00f, 0.02f, 1.00f } }};
+    std::vector<std::array<float, 3>> samples;
+
+    std::array<float, 3> raw(const std::array<float, 3> &field) const {
+        std::array<float, 3> out;
+
+        for (int i = 0; i < 3; ++i) {
+            out[i] = hardIron[i] + distortion[i][0] * field[0] +
+                     distortion[i][1] * field[1] + distortion[i][2] * field[2];
+        }
+
+        return out;
+    }
+
+    MagnTrace(size_t count, float noiseUt) {
+        std::mt19937 gen(1234);
+        std::normal_distribution<float> noise(0.0f, noiseUt);
+        const float golden = 2.39996323f;
+
+        for (size_t i = 0; i < count; ++i) {
+            float z = 1.0f - 2.0f * (i + 0.5f) / count;
+            float r = std::sqrt(1.0f - z * z);
+            std::array<float, 3> sample = raw({ fieldUt * r * std::cos(golden * i),
+                                                fieldUt * r * std::sin(golden * i),
+                                                fieldUt * z });
+
+            for (auto &value : sample) {
+                value += noise(gen);
+            }
+            samples.push_back(sample);
+        }
+    }
+};
+
+static std::array<float, 3> calibrate(const Matrix<4, 3, float> &bias,
+                                      const std::array<float, 3> &raw)
+{
+    std::array<float, 3> d, out;
+
+    for (int i = 0; i < 3; ++i) {
+        d[i] = raw[i] - bias[3][i];
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        out[i] = bias[i][0] * d[0] + bias[i][1] * d[1] + bias[i][2] * d[2];
+    }
+
+    return out;
+}
+
+static float norm(const std::array<float, 3> &v)
+{
+    return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+TEST(STMMagnCalibration, hardAndSoftIron)
+{
+    STMMagnCalibration calibration;
+    MagnTrace trace(2000, 0.2f);
+    Matrix<4, 3, float> bias;
+    int64_t timestamp = periodNs;
+    float radius, determinant;
+
+    STMMagnCalibration::resetBiasMatrix(bias);
+    ASSERT_EQ(0, calibration.init(1000.0f));
+    ASSERT_EQ(0, calibration.reset(bias));
+    ASSERT_EQ(0, calibration.setFrequency(100));
+    EXPECT_EQ(STMMagnCalibration::UNRELIABLE, calibration.getAccuracy());
+
+    for (const auto &sample : trace.samples) {
+        ASSERT_EQ(0, calibration.run(sample, timestamp));
+        timestamp += periodNs;
+    }
+
+    EXPECT_EQ(STMMagnCalibration::HIGH, calibration.getAccuracy());
+
+    calibration.getBias(bias);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NEAR(trace.hardIron[i], bias[3][i], 0.5f);
+    }
+
+    determinant = bias[0][0] * (bias[1][1] * bias[2][2] - bias[1][2] * bias[2][1]) -
+                  bias[0][1] * (bias[1][0] * bias[2][2] - bias[1][2] * bias[2][0]) +
+                  bias[0][2] * (bias[1][0] * bias[2][1] - bias[1][1] * bias[2][0]);
+    EXPECT_NEAR(1.0f, determinant, 1e-3f);
+
+    /* calibrated field lies on a sphere, whatever the direction */
+    radius = norm(calibrate(bias, trace.raw({ fieldUt, 0.0f, 0.0f })));
+    EXPECT_NEAR(fieldUt, radius, 0.05f * fieldUt);
+
+    for (float angle = 0.0f; angle < 6.0f; angle += 0.5f) {
+        std::array<float, 3> field = { fieldUt * std::cos(angle) * std::cos(2.0f * angle),
+                                       fieldUt * std::sin(angle) * std::cos(2.0f * angle),
+                                       fieldUt * std::sin(2.0f * angle) };
+
+        EXPECT_NEAR(radius, norm(calibrate(bias, trace.raw(field))), 0.01f * radius);
+    }
+
+    /* field magnitude change is reported as disturbance */
+    ASSERT_EQ(0, calibration.run(trace.raw({ 0.0f, 0.0f, 2.0f * fieldUt }), timestamp));
+    EXPECT_EQ(STMMagnCalibration::LOW, calibration.getAccuracy());
+    timestamp += periodNs;
+    ASSERT_EQ(0, calibration.run(trace.raw({ 0.0f, 0.0f, fieldUt }), timestamp));
+    EXPECT_EQ(STMMagnCalibration::HIGH, calibration.getAccuracy());
+}
+
+TEST(STMMagnCalibration, noMotionNoCalibration)
+{
+    STMMagnCalibration calibration;
+    MagnTrace trace(1, 0.0f);
+    Matrix<4, 3, float> bias;
+
+    STMMagnCalibration::resetBiasMatrix(bias);
+    calibration.reset(bias);
+
+    for (int i = 1; i <= 500; ++i) {
+        ASSERT_EQ(0, calibration.run(trace.samples[0], i * periodNs));
+    }
+
+    EXPECT_EQ(STMMagnCalibration::UNRELIABLE, calibration.getAccuracy());
+    calibration.getBias(bias);
+    EXPECT_FLOAT_EQ(0.0f, bias[3][0]);
+    EXPECT_FLOAT_EQ(1.0f, bias[0][0]);
+
+    /* timestamps must increase */
+    EXPECT_GT(0, calibration.run(trace.samples[0], 500 * periodNs));
+}
+
+TEST(STMMagnCalibration, batchMatchesSingleSampleRun)
+{
+    STMMagnCalibration single, batch;
+    MagnTrace trace(1000, 0.2f);
+    Matrix<4, 3, float> bias, singleBias, batchBias;
+    std::vector<int64_t> timestamps;
+    const size_t batchSize = 37;
+
+    for (size_t i = 0; i < trace.samples.size(); ++i) {
+        timestamps.push_back((i + 1) * periodNs);
+    }
+
+    /* out of order sample and saturated sample inside a batch */
+    timestamps[500] = timestamps[499];
+    trace.samples[600][0] = 1000.0f;
+
+    STMMagnCalibration::resetBiasMatrix(bias);
+    for (auto *calibration : { &single, &batch }) {
+        ASSERT_EQ(0, calibration->init(1000.0f));
+        ASSERT_EQ(0, calibration->reset(bias));
+        ASSERT_EQ(0, calibration->setFrequency(100));
+    }
+
+    for (size_t i = 0; i < trace.samples.size(); i += batchSize) {
+        size_t count = std::min(batchSize, trace.samples.size() - i);
+        int expected = 0;
+
+        for (size_t n = i; n < i + count; ++n) {
+            if (single.run(trace.samples[n], timestamps[n]) < 0) {
+                expected = -1;
+            }
+        }
+
+        ASSERT_EQ(expected, batch.run(&trace.samples[i], &timestamps[i], count));
+        ASSERT_EQ(single.getAccuracy(), batch.getAccuracy());
+    }
+
+    single.getBias(singleBias);
+    batch.getBias(batchBias);
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            EXPECT_FLOAT_EQ(singleBias[r][c], batchBias[r][c]);
+        }
+    }
+}
+
+TEST(STMMagnCalibration, storedBiasAndFrequencies)
+{
+    STMMagnCalibration calibration;
+    Matrix<4, 3, float> bias, out;
+
+    EXPECT_GT(0, calibration.init(0.0f));
+    EXPECT_GT(0, calibration.setFrequency(STMMagnCalibration::getMinFrequencyHz() - 1));
+    EXPECT_GT(0, calibration.setFrequency(STMMagnCalibration::getMaxFrequencyHz() + 1));
+    EXPECT_EQ(0, calibration.setFrequency(STMMagnCalibration::getMaxFrequencyHz()));
+
+    /* stored calibration is used until verified by a new fit */
+    STMMagnCalibration::resetBiasMatrix(bias);
+    bias[3] = { 10.0f, 20.0f, 30.0f };
+    calibration.reset(bias);
+    EXPECT_EQ(STMMagnCalibration::LOW, calibration.getAccuracy());
+
+    calibration.getBias(out);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_FLOAT_EQ(bias[3][i], out[3][i]);
+    }
+}
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2021 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <STMSensorsFusion6Axis.h>
+#include <STMSensorsFusion9Axis.h>
+
+static const float gravity = 9.80665f;
+static const int64_t periodNs = 10000000LL;
+
+TEST(STMSensorsFusion, notAlignedBeforeFirstSample)
+{
+    STMSensorsFusion6Axis fusion;
+    std::array<float, 4> quaternion;
+    std::array<float, 3> vector;
+
+    fusion.init();
+
+    EXPECT_GT(0, fusion.getQuaternion(quaternion));
+    EXPECT_GT(0, fusion.getGravity(vector));
+    EXPECT_GT(0, fusion.getLinearAccel(vector));
+}
+
+TEST(STMSensorsFusion, staticFlat6Axis)
+{
+    STMSensorsFusion6Axis fusion;
+    std::array<float, 4> quaternion;
+    std::array<float, 3> vector;
+    int64_t timestamp = periodNs;
+
+    fusion.init();
+    for (int i = 0; i < 100; ++i, timestamp += periodNs) {
+        EXPECT_EQ(0, fusion.run({ 0.0f, 0.0f, gravity }, { 0.0f, 0.0f, 0.0f }, timestamp));
+    }
+
+    /* timestamps must increase */
+    EXPECT_GT(0, fusion.run({ 0.0f, 0.0f, gravity }, { 0.0f, 0.0f, 0.0f }, timestamp - periodNs));
+
+    ASSERT_EQ(0, fusion.getQuaternion(quaternion));
+    EXPECT_NEAR(0.0f, quaternion[0], 1e-4f);
+    EXPECT_NEAR(0.0f, quaternion[1], 1e-4f);
+    EXPECT_NEAR(0.0f, quaternion[2], 1e-4f);
+    EXPECT_NEAR(1.0f, quaternion[3], 1e-4f);
+
+    ASSERT_EQ(0, fusion.getGravity(vector));
+    EXPECT_NEAR(gravity, vector[2], 1e-3f);
+
+    ASSERT_EQ(0, fusion.getLinearAccel(vector));
+    for (auto v : vector) {
+        EXPECT_NEAR(0.0f, v, 1e-3f);
+    }
+}
+
+TEST(STMSensorsFusion, gyroIntegration6Axis)
+{
+    STMSensorsFusion6Axis fusion;
+    std::array<float, 4> quaternion;
+    int64_t timestamp = periodNs;
+
+    fusion.init();
+
+    /* 1 rad/s around z for 1 s, gravity is unaffected */
+    for (int i = 0; i <= 100; ++i, timestamp += periodNs) {
+        fusion.run({ 0.0f, 0.0f, gravity }, { 0.0f, 0.0f, 1.0f }, timestamp);
+    }
+
+    ASSERT_EQ(0, fusion.getQuaternion(quaternion));
+    EXPECT_NEAR(0.0f, quaternion[0], 1e-3f);
+    EXPECT_NEAR(0.0f, quaternion[1], 1e-3f);
+    EXPECT_NEAR(std::sin(0.5f), quaternion[2], 1e-3f);
+    EXPECT_NEAR(std::cos(0.5f), quaternion[3], 1e-3f);
+}
+
+TEST(STMSensorsFusion, convergesToTiltedGravity)
+{
+    STMSensorsFusion6Axis fusion;
+    std::array<float, 3> accel = { 0.0f, gravity * std::sin(0.5f), gravity * std::cos(0.5f) };
+    std::array<float, 3> vector;
+    int64_t timestamp = periodNs;
+
+    fusion.init();
+    fusion.run({ 0.0f, 0.0f, gravity }, { 0.0f, 0.0f, 0.0f }, timestamp);
+
+    for (int i = 0; i < 2000; ++i) {
+        timestamp += periodNs;
+        fusion.run(accel, { 0.0f, 0.0f, 0.0f }, timestamp);
+    }
+
+    ASSERT_EQ(0, fusion.getGravity(vector));
+    for (auto i = 0U; i < vector.size(); ++i) {
+        EXPECT_NEAR(accel[i], vector[i], 0.05f);
+    }
+}
+
+TEST(STMSensorsFusion, heading9Axis)
+{
+    STMSensorsFusion9Axis fusion;
+    std::array<float, 3> orientation;
+    std::array<float, 4> quaternion;
+    int64_t timestamp = periodNs;
+
+    fusion.init();
+
+    /* flat, y axis pointing to magnetic north */
+    for (int i = 0; i < 100; ++i, timestamp += periodNs) {
+        fusion.run({ 0.0f, 0.0f, gravity }, { 0.0f, 22.0f, -40.0f }, { 0.0f, 0.0f, 0.0f }, timestamp);
+    }
+
+    ASSERT_EQ(0, fusion.getQuaternion(quaternion));
+    EXPECT_NEAR(1.0f, quaternion[3], 1e-3f);
+
+    ASSERT_EQ(0, fusion.getEulerAngles(orientation));
+    EXPECT_NEAR(0.0f, std::fmod(orientation[0] + 180.0f, 360.0f) - 180.0f, 0.5f);
+    EXPECT_NEAR(0.0f, orientation[1], 0.5f);
+    EXPECT_NEAR(0.0f, orientation[2], 0.5f);
+
+    /* flat, y axis pointing to east after a gap: filter re-aligns */
+    timestamp += 1000000000LL;
+    for (int i = 0; i < 100; ++i, timestamp += periodNs) {
+        fusion.run({ 0.0f, 0.0f, gravity }, { -22.0f, 0.0f, -40.0f }, { 0.0f, 0.0f, 0.0f }, timestamp);
+    }
+
+    ASSERT_EQ(0, fusion.getEulerAngles(orientation));
+    EXPECT_NEAR(90.0f, orientation[0], 0.5f);
+}
+
+TEST(STMSensorsFusion, scalarAndVectorKernelsMatch)
+{
+    STMSensorsFusion9Axis scalar, vector;
+    std::array<float, 4> qScalar, qVector;
+    int64_t timestamp = periodNs;
+
+    if (!MadgwickFilter::isVectorKernelSupported()) {
+        GTEST_SKIP();
+    }
+
+    scalar.init();
+    vector.init();
+    ASSERT_EQ(0, scalar.setKernel(MadgwickFilter::Kernel::SCALAR));
+    ASSERT_EQ(0, vector.setKernel(MadgwickFilter::Kernel::VECTOR));
+
+    for (int i = 0; i < 1000; ++i, timestamp += periodNs) {
+        float t = i * 0.01f;
+        std::array<float, 3> accel = { gravity * std::sin(t), 0.3f * std::cos(3.0f * t), gravity * std::cos(t) };
+        std::array<float, 3> magn = { 10.0f * std::cos(t), 22.0f, -40.0f + std::sin(t) };
+        std::array<float, 3> gyro = { 0.2f * std::sin(2.0f * t), 1.0f, -0.5f * std::cos(t) };
+
+        scalar.run(accel, magn, gyro, timestamp);
+        vector.run(accel, magn, gyro, timestamp);
+    }
+
+    ASSERT_EQ(0, scalar.getQuaternion(qScalar));
+    ASSERT_EQ(0, vector.getQuaternion(qVector));
+    for (auto i = 0U; i < qScalar.size(); ++i) {
+        EXPECT_NEAR(qScalar[i], qVector[i], 1e-4f);
+    }
+}
+
+TEST(STMSensorsFusion, batchMatchesSingleSampleRun)
+{
+    STMSensorsFusion6Axis single, batch;
+    std::vector<std::array<float, 3>> accel, gyro;
+    std::vector<int64_t> timestamps;
+    std::vector<STMSensorsFusionOutput> outputs;
+    STMSensorsFusionOutput expected;
+    std::array<float, 4> qSingle, qBatch;
+
+    for (int i = 0; i < 200; ++i) {
+        float t = i * 0.01f;
+
+        accel.push_back({ gravity * std::sin(t), 0.0f, gravity * std::cos(t) });
+        gyro.push_back({ 0.0f, 1.0f, 0.1f });
+        timestamps.push_back((i + 1) * periodNs);
+    }
+
+    /* out of order sample, discarded keeping outputs of previous one */
+    timestamps[100] = timestamps[99];
+    outputs.resize(accel.size());
+
+    single.init();
+    batch.init();
+
+    /* filter steps every other sample, gyroscope integrated in between */
+    single.setUpdatePeriod(2 * periodNs);
+    batch.setUpdatePeriod(2 * periodNs);
+
+    EXPECT_GT(0, batch.run(accel.data(), gyro.data(), timestamps.data(), accel.size(),
+                           STMSensorsFusionOutput::ALL, outputs.data()));
+
+    for (auto i = 0U; i < accel.size(); ++i) {
+        ASSERT_EQ(i == 100 ? -1 : 0, single.run(accel[i], gyro[i], timestamps[i]));
+        ASSERT_EQ(0, single.getOutputs(STMSensorsFusionOutput::ALL, expected));
+        ASSERT_EQ(expected.mask, outputs[i].mask);
+
+        for (auto k = 0U; k < expected.quaternion.size(); ++k) {
+            EXPECT_FLOAT_EQ(expected.quaternion[k], outputs[i].quaternion[k]);
+        }
+        for (auto k = 0U; k < expected.linearAccel.size(); ++k) {
+            EXPECT_FLOAT_EQ(expected.linearAccel[k], outputs[i].linearAccel[k]);
+        }
+    }
+
+    ASSERT_EQ(0, single.getQuaternion(qSingle));
+    ASSERT_EQ(0, batch.getQuaternion(qBatch));
+    for (auto i = 0U; i < qSingle.size(); ++i) {
+        EXPECT_FLOAT_EQ(qSingle[i], qBatch[i]);
+    }
+
+    /* outputs of last sample only */
+    batch.reset(NULL);
+    EXPECT_GT(0, batch.run(accel.data(), gyro.data(), timestamps.data(), accel.size()));
+    ASSERT_EQ(0, batch.getQuaternion(qBatch));
+    for (auto i = 0U; i < qSingle.size(); ++i) {
+        EXPECT_FLOAT_EQ(qSingle[i], qBatch[i]);
+    }
+}
+
+TEST(STMSensorsFusion, outputsMatchSingleGetters)
+{
+    STMSensorsFusion9Axis fusion;
+    STMSensorsFusionOutput output;
+    std::array<float, 4> quaternion;
+    std::array<float, 3> vector;
+    int64_t timestamp = periodNs;
+
+    fusion.init();
+    EXPECT_GT(0, fusion.getOutputs(STMSensorsFusionOutput::ALL, output));
+    EXPECT_EQ(0U, output.mask);
+
+    for (int i = 0; i < 100; ++i, timestamp += periodNs) {
+        float t = i * 0.01f;
+
+        fusion.run({ gravity * std::sin(t), 0.5f, gravity * std::cos(t) },
+                   { 0.0f, 22.0f, -40.0f }, { 0.0f, 1.0f, 0.2f }, timestamp);
+    }
+
+    ASSERT_EQ(0, fusion.getOutputs(STMSensorsFusionOutput::ALL, output));
+    EXPECT_EQ((unsigned int)STMSensorsFusionOutput::ALL, output.mask);
+
+    ASSERT_EQ(0, fusion.getQuaternion(quaternion));
+    for (auto i = 0U; i < quaternion.size(); ++i) {
+        EXPECT_FLOAT_EQ(quaternion[i], output.quaternion[i]);
+    }
+
+    ASSERT_EQ(0, fusion.getEulerAngles(vector));
+    for (auto i = 0U; i < vector.size(); ++i) {
+        EXPECT_FLOAT_EQ(vector[i], output.eulerAngles[i]);
+    }
+
+    ASSERT_EQ(0, fusion.getGravity(vector));
+    for (auto i = 0U; i < vector.size(); ++i) {
+        EXPECT_FLOAT_EQ(vector[i], output.gravity[i]);
+    }
+
+    ASSERT_EQ(0, fusion.getLinearAccel(vector));
+    for (auto i = 0U; i < vector.size(); ++i) {
+        EXPECT_FLOAT_EQ(vector[i], output.linearAccel[i]);
+    }
+
+    /* only requested outputs are reported */
+    ASSERT_EQ(0, fusion.getOutputs(STMSensorsFusionOutput::LINEAR_ACCEL, output));
+    EXPECT_EQ((unsigned int)STMSensorsFusionOutput::LINEAR_ACCEL, output.mask);
+
+    ASSERT_EQ(0, fusion.getOutputs(0, output));
+    EXPECT_EQ(0U, output.mask);
+}
+
+TEST(STMSensorsFusion, adaptiveUpdateRate)
+{
+    STMSensorsFusion6Axis everySample, adaptive;
+    std::array<float, 3> tilted = { 0.0f, gravity * std::sin(0.5f), gravity * std::cos(0.5f) };
+    std::array<float, 4> qEverySample, qAdaptive;
+    std::array<float, 3> vector;
+    const int64_t gyroPeriodNs = 2500000LL;
+    int64_t timestamp = gyroPeriodNs;
+
+    /* longest step period is limited */
+    EXPECT_EQ(0, adaptive.setUpdatePeriod(-1));
+    EXPECT_EQ(20000000LL, adaptive.setUpdatePeriod(1000000000LL));
+    EXPECT_EQ(20000000LL, adaptive.setUpdatePeriod(4 * periodNs));
+
+    everySample.init();
+    adaptive.init();
+
+    /* 400Hz gyroscope, 1 rad/s around z for 1 s, 50Hz filter steps */
+    for (int i = 0; i <= 400; ++i, timestamp += gyroPeriodNs) {
+        ASSERT_EQ(0, everySample.run({ 0.0f, 0.0f, gravity }, { 0.0f, 0.0f, 1.0f }, timestamp));
+        ASSERT_EQ(0, adaptive.run({ 0.0f, 0.0f, gravity }, { 0.0f, 0.0f, 1.0f }, timestamp));
+
+        /* outputs between filter steps include integrated gyroscope data */
+        if (i == 203) {
+            ASSERT_EQ(0, everySample.getQuaternion(qEverySample));
+            ASSERT_EQ(0, adaptive.getQuaternion(qAdaptive));
+            for (auto n = 0U; n < qEverySample.size(); ++n) {
+                EXPECT_NEAR(qEverySample[n], qAdaptive[n], 1e-4f);
+            }
+        }
+    }
+
+    ASSERT_EQ(0, everySample.getQuaternion(qEverySample));
+    ASSERT_EQ(0, adaptive.getQuaternion(qAdaptive));
+    for (auto i = 0U; i < qEverySample.size(); ++i) {
+        EXPECT_NEAR(qEverySample[i], qAdaptive[i], 1e-4f);
+    }
+
+    /* correction steps still converge to gravity */
+    for (int i = 0; i < 8000; ++i, timestamp += gyroPeriodNs) {
+        adaptive.run(tilted, { 0.0f, 0.0f, 0.0f }, timestamp);
+    }
+
+    ASSERT_EQ(0, adaptive.getGravity(vector));
+    for (auto i = 0U; i < vector.size(); ++i) {
+        EXPECT_NEAR(tilted[i], vector[i], 0.05f);
+    }
+}
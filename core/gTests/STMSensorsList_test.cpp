@@ -185,3 +185,25 @@ TEST_F(STMSensorsListTest, addSensor_fifoRsvdAndFifoMax)
     ASSERT_FALSE(sensorsList.addSensor(accelFifoRsvdBigger));
     ASSERT_EQ(0, sensorsList.getList().size());
 }
+
+/**
+ * removeSensor_handlesNotReused: verify that removing a sensor keeps other handles
+ * and that handles are not reused
+ */
+TEST_F(STMSensorsListTest, removeSensor_handlesNotReused)
+{
+    ASSERT_TRUE(sensorsList.addSensor(accel));
+    ASSERT_TRUE(sensorsList.addSensor(accelName2));
+    ASSERT_EQ(2, sensorsList.getList().size());
+
+    ASSERT_TRUE(sensorsList.removeSensor(1));
+    ASSERT_FALSE(sensorsList.removeSensor(1));
+    ASSERT_EQ(1, sensorsList.getList().size());
+    ASSERT_FALSE(sensorsList.hasHandle(1));
+    ASSERT_TRUE(sensorsList.hasHandle(2));
+
+    // Same sensor added again gets a new handle
+    ASSERT_TRUE(sensorsList.addSensor(accel));
+    ASSERT_TRUE(sensorsList.hasHandle(3));
+    ASSERT_FALSE(sensorsList.hasHandle(1));
+}
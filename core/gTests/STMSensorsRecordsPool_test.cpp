@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ISTMSensorsCallback.h>
+#include <STMSensorsRecordsPool.h>
+
+using stm::core::ISTMSensorsCallback;
+using stm::core::ISTMSensorsCallbackData;
+using stm::core::STMSensorsRecord;
+using stm::core::STMSensorsRecordsLease;
+using stm::core::STMSensorsRecordsPool;
+using stm::core::SensorType;
+
+class LegacyCallback : public ISTMSensorsCallback {
+public:
+    std::vector<ISTMSensorsCallbackData> received;
+
+    void onNewSensorsData(const std::vector<ISTMSensorsCallbackData> &sensorsData) override
+    {
+        received = sensorsData;
+    }
+
+    int onSaveDataRequest(const std::string& resourceID, const void *data, ssize_t len) override
+    {
+        (void) resourceID;
+        (void) data;
+        (void) len;
+
+        return -EIO;
+    }
+
+    int onLoadDataRequest(const std::string& resourceID, void *data, ssize_t len) override
+    {
+        (void) resourceID;
+        (void) data;
+        (void) len;
+
+        return -EIO;
+    }
+};
+
+TEST(STMSensorsRecordsPool, buffersRecycled)
+{
+    STMSensorsRecordsPool pool(10, 2);
+
+    for (int i = 0; i < 100; ++i) {
+        STMSensorsRecordsLease lease = pool.acquire();
+
+        EXPECT_EQ(10U, lease.capacity());
+        EXPECT_TRUE(lease.empty());
+        EXPECT_EQ(1U, pool.getLeasedBuffers());
+    }
+
+    EXPECT_EQ(2U, pool.getAllocatedBuffers());
+    EXPECT_EQ(100U, pool.getLeases());
+    EXPECT_EQ(0U, pool.getLeasedBuffers());
+}
+
+TEST(STMSensorsRecordsPool, retainedLease)
+{
+    STMSensorsRecordsPool pool(4, 1);
+    STMSensorsRecordsLease retained;
+
+    {
+        STMSensorsRecordsLease lease = pool.acquire();
+
+        lease[0].timestamp = 1234;
+        lease.resize(1);
+
+        retained = std::move(lease);
+        EXPECT_EQ(nullptr, lease.data());
+    }
+
+    /* retained buffer is not handed out again, pool grows */
+    STMSensorsRecordsLease other = pool.acquire();
+    EXPECT_NE(retained.data(), other.data());
+    EXPECT_EQ(2U, pool.getAllocatedBuffers());
+
+    ASSERT_EQ(1U, retained.size());
+    EXPECT_EQ(1234, retained[0].timestamp);
+
+    retained.release();
+    EXPECT_TRUE(retained.empty());
+    EXPECT_EQ(1U, pool.getLeasedBuffers());
+}
+
+TEST(STMSensorsRecordsPool, resizeBoundedByCapacity)
+{
+    STMSensorsRecordsPool pool(4, 1);
+    STMSensorsRecordsLease lease = pool.acquire();
+
+    lease.resize(10);
+    EXPECT_EQ(4U, lease.size());
+}
+
+TEST(STMSensorsRecordsPool, legacyAdapter)
+{
+    STMSensorsRecordsPool pool(4, 1);
+    STMSensorsRecordsLease lease = pool.acquire();
+    LegacyCallback callback;
+
+    for (size_t i = 0; i < 2; ++i) {
+        lease[i] = {};
+        lease[i].timestamp = 1000 + i;
+        lease[i].sensorHandle = 3 + i;
+        lease[i].sensorType = SensorType::GYROSCOPE;
+        lease[i].dataLen = 3;
+        lease[i].data[0] = 0.5f;
+        lease[i].data[2] = -1.0f * i;
+    }
+    lease.resize(2);
+
+    callback.onNewSensorsRecords(lease);
+
+    ASSERT_EQ(2U, callback.received.size());
+    for (size_t i = 0; i < 2; ++i) {
+        const ISTMSensorsCallbackData &data = callback.received[i];
+
+        EXPECT_EQ(1000 + (int64_t)i, data.getTimestamp());
+        EXPECT_EQ(3 + i, data.getSensorHandle());
+        EXPECT_EQ(SensorType::GYROSCOPE, data.getSensorType());
+        ASSERT_EQ(3U, data.getData().size());
+        EXPECT_EQ(0.5f, data.getData()[0]);
+        EXPECT_EQ(-1.0f * i, data.getData()[2]);
+    }
+}
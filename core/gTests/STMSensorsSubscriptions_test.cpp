@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <map>
+#include <memory>
+
+#include <poll.h>
+
+#include <gtest/gtest.h>
+
+#include <STMSensorsSubscriptions.h>
+
+using stm::core::ISTMSensorsCallbackData;
+using stm::core::ISTMSensorsSubscription;
+using stm::core::STMSensorsRecord;
+using stm::core::STMSensorsSubscriptions;
+using stm::core::SensorType;
+
+class STMSensorsSubscriptionsTest : public ::testing::Test {
+protected:
+    struct HWConfig {
+        bool enable = false;
+        int64_t periodNs = -1;
+        int64_t latencyNs = -1;
+        int batchCalls = 0;
+    };
+
+    std::map<uint32_t, HWConfig> hw;
+
+    STMSensorsSubscriptions subscriptions {
+        [this](uint32_t handle, bool enable) {
+            hw[handle].enable = enable;
+            return 0;
+        },
+        [this](uint32_t handle, int64_t periodNs, int64_t latencyNs) {
+            hw[handle].periodNs = periodNs;
+            hw[handle].latencyNs = latencyNs;
+            hw[handle].batchCalls++;
+            return 0;
+        }
+    };
+
+    static STMSensorsRecord record(uint32_t handle, SensorType type, int64_t timestamp) {
+        STMSensorsRecord record = {};
+
+        record.timestamp = timestamp;
+        record.sensorHandle = handle;
+        record.sensorType = type;
+        record.dataLen = 3;
+        record.data[2] = 9.8f;
+
+        return record;
+    }
+
+    static std::vector<STMSensorsRecord> samples(uint32_t handle, int64_t periodNs,
+                                                 size_t count, int64_t start = 0) {
+        std::vector<STMSensorsRecord> data;
+
+        for (size_t i = 0; i < count; ++i) {
+            data.push_back(record(handle, SensorType::ACCELEROMETER, start + i * periodNs));
+        }
+
+        return data;
+    }
+
+    void dispatch(std::vector<STMSensorsRecord> &data) {
+        data.resize(subscriptions.dispatch(data.data(), data.size()));
+    }
+};
+
+TEST_F(STMSensorsSubscriptionsTest, aggregatePlan)
+{
+    std::unique_ptr<ISTMSensorsSubscription> slow, fast;
+
+    EXPECT_EQ(0, subscriptions.setRate(1, 20000000, 100000000));
+    EXPECT_EQ(0, subscriptions.activate(1, true));
+    EXPECT_TRUE(hw[1].enable);
+    EXPECT_EQ(20000000, hw[1].periodNs);
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 100000000, 0, 16, slow));
+    EXPECT_EQ(20000000, hw[1].periodNs);
+    EXPECT_EQ(0, hw[1].latencyNs);
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 2500000, 200000000, 16, fast));
+    EXPECT_EQ(2500000, hw[1].periodNs);
+
+    fast.reset();
+    EXPECT_EQ(20000000, hw[1].periodNs);
+
+    EXPECT_EQ(0, subscriptions.activate(1, false));
+    EXPECT_TRUE(hw[1].enable);
+    EXPECT_EQ(100000000, hw[1].periodNs);
+
+    slow.reset();
+    EXPECT_FALSE(hw[1].enable);
+    EXPECT_EQ(20000000, hw[1].periodNs);
+    EXPECT_EQ(100000000, hw[1].latencyNs);
+}
+
+TEST_F(STMSensorsSubscriptionsTest, unchangedPlanNotApplied)
+{
+    std::unique_ptr<ISTMSensorsSubscription> a, b;
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 10000000, 0, 16, a));
+    EXPECT_EQ(0, subscriptions.subscribe(1, 20000000, 0, 16, b));
+    b.reset();
+    EXPECT_EQ(1, hw[1].batchCalls);
+}
+
+TEST_F(STMSensorsSubscriptionsTest, invalidArguments)
+{
+    std::unique_ptr<ISTMSensorsSubscription> s;
+
+    EXPECT_EQ(-EINVAL, subscriptions.subscribe(1, -1, 0, 16, s));
+    EXPECT_EQ(-EINVAL, subscriptions.subscribe(1, 10000000, -1, 16, s));
+    EXPECT_EQ(-EINVAL, subscriptions.subscribe(1, 10000000, 0, 0, s));
+    EXPECT_EQ(nullptr, s);
+}
+
+TEST_F(STMSensorsSubscriptionsTest, perSubscriberDecimation)
+{
+    std::unique_ptr<ISTMSensorsSubscription> s50, s400;
+    std::vector<ISTMSensorsCallbackData> out;
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 20000000, 0, 1024, s50));
+    EXPECT_EQ(0, subscriptions.subscribe(1, 2500000, 0, 1024, s400));
+
+    /* one second at 400Hz, with 2% timestamp jitter */
+    std::vector<STMSensorsRecord> data;
+    for (int i = 0; i < 400; ++i) {
+        int64_t jitter = (i % 2) ? 50000 : -50000;
+        data.push_back(record(1, SensorType::ACCELEROMETER, 1000000000LL + i * 2500000LL + jitter));
+    }
+    dispatch(data);
+
+    /* sensor only enabled by subscriptions, nothing for the legacy client */
+    EXPECT_TRUE(data.empty());
+
+    EXPECT_EQ(50, s50->read(out, 1024, 0));
+    for (size_t i = 1; i < out.size(); ++i) {
+        int64_t delta = out[i].getTimestamp() - out[i - 1].getTimestamp();
+        EXPECT_GE(delta, 19000000);
+        EXPECT_LE(delta, 21000000);
+    }
+
+    out.clear();
+    EXPECT_EQ(400, s400->read(out, 1024, 0));
+}
+
+TEST_F(STMSensorsSubscriptionsTest, boundedQueueDropsOldest)
+{
+    std::unique_ptr<ISTMSensorsSubscription> s;
+    std::vector<ISTMSensorsCallbackData> out;
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 10000000, 0, 4, s));
+
+    auto data = samples(1, 10000000, 10);
+    dispatch(data);
+
+    EXPECT_EQ(6U, s->getDroppedSamples());
+    EXPECT_EQ(4, s->read(out, 10, 0));
+    EXPECT_EQ(60000000, out.front().getTimestamp());
+    EXPECT_EQ(90000000, out.back().getTimestamp());
+    EXPECT_EQ(0, s->read(out, 10, 0));
+}
+
+TEST_F(STMSensorsSubscriptionsTest, legacyClientFiltering)
+{
+    std::unique_ptr<ISTMSensorsSubscription> s;
+    std::vector<ISTMSensorsCallbackData> out;
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 10000000, 0, 16, s));
+    EXPECT_EQ(0, subscriptions.activate(2, true));
+
+    auto data = samples(1, 10000000, 3);
+    auto other = samples(2, 10000000, 2);
+    data.insert(data.end(), other.begin(), other.end());
+    data.push_back(record(1, SensorType::META_DATA, 0));
+
+    dispatch(data);
+    ASSERT_EQ(3U, data.size());
+    EXPECT_EQ(2U, data[0].sensorHandle);
+    EXPECT_EQ(2U, data[1].sensorHandle);
+    EXPECT_EQ(SensorType::META_DATA, data[2].sensorType);
+
+    EXPECT_EQ(0, subscriptions.activate(1, true));
+    data = samples(1, 10000000, 3, 30000000);
+    dispatch(data);
+    EXPECT_EQ(3U, data.size());
+    EXPECT_EQ(6, s->read(out, 16, 0));
+}
+
+TEST_F(STMSensorsSubscriptionsTest, closedSubscription)
+{
+    std::unique_ptr<ISTMSensorsSubscription> s;
+    std::vector<ISTMSensorsCallbackData> out;
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 10000000, 0, 16, s));
+
+    auto data = samples(1, 10000000, 2);
+    dispatch(data);
+
+    subscriptions.remove(1);
+    EXPECT_EQ(2, s->read(out, 16, -1));
+    EXPECT_EQ(-ENODEV, s->read(out, 16, -1));
+
+    s.reset();
+    EXPECT_EQ(0, subscriptions.activate(1, false));
+    EXPECT_FALSE(hw[1].enable);
+}
+
+TEST_F(STMSensorsSubscriptionsTest, destroyedAfterClear)
+{
+    auto manager = std::make_unique<STMSensorsSubscriptions>(
+        [](uint32_t, bool) { return 0; },
+        [](uint32_t, int64_t, int64_t) { return 0; });
+    std::unique_ptr<ISTMSensorsSubscription> s;
+    std::vector<ISTMSensorsCallbackData> out;
+
+    EXPECT_EQ(0, manager->subscribe(1, 10000000, 0, 16, s));
+
+    auto data = samples(1, 10000000, 2);
+    data.resize(manager->dispatch(data.data(), data.size()));
+
+    manager->clear();
+    manager.reset();
+
+    EXPECT_EQ(2, s->read(out, 16, -1));
+    EXPECT_EQ(-ENODEV, s->read(out, 16, -1));
+    s.reset();
+}
+
+static bool eventReady(int fd)
+{
+    struct pollfd pfd = { fd, POLLIN, 0 };
+
+    return poll(&pfd, 1, 0) == 1;
+}
+
+TEST_F(STMSensorsSubscriptionsTest, pullModeWatermark)
+{
+    std::unique_ptr<ISTMSensorsSubscription> s;
+    STMSensorsRecord records[16];
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 10000000, 0, 64, s));
+    EXPECT_EQ(-EINVAL, s->setWatermark(0));
+    EXPECT_EQ(-EINVAL, s->setWatermark(65));
+    EXPECT_EQ(0, s->setWatermark(8));
+    ASSERT_GE(s->getEventFd(), 0);
+
+    auto data = samples(1, 10000000, 7);
+    dispatch(data);
+    EXPECT_FALSE(eventReady(s->getEventFd()));
+
+    data = samples(1, 10000000, 1, 70000000);
+    dispatch(data);
+    EXPECT_TRUE(eventReady(s->getEventFd()));
+
+    EXPECT_EQ(5, s->read(records, 5));
+    EXPECT_EQ(40000000, records[4].timestamp);
+    EXPECT_FALSE(eventReady(s->getEventFd()));
+
+    EXPECT_EQ(0, s->setWatermark(3));
+    EXPECT_TRUE(eventReady(s->getEventFd()));
+    EXPECT_EQ(0, s->setWatermark(8));
+    EXPECT_FALSE(eventReady(s->getEventFd()));
+
+    /* closed subscription wakes up the reader */
+    subscriptions.remove(1);
+    EXPECT_TRUE(eventReady(s->getEventFd()));
+    EXPECT_EQ(3, s->read(records, 16));
+    EXPECT_EQ(-ENODEV, s->read(records, 16));
+}
+
+TEST_F(STMSensorsSubscriptionsTest, ringWrapsAround)
+{
+    std::unique_ptr<ISTMSensorsSubscription> s;
+    STMSensorsRecord records[8];
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 10000000, 0, 4, s));
+
+    auto data = samples(1, 10000000, 3);
+    dispatch(data);
+    EXPECT_EQ(2, s->read(records, 2));
+
+    data = samples(1, 10000000, 3, 30000000);
+    dispatch(data);
+    EXPECT_EQ(4, s->read(records, 8));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(20000000 + i * 10000000, records[i].timestamp);
+    }
+    EXPECT_EQ(0U, s->getDroppedSamples());
+}
+
+TEST_F(STMSensorsSubscriptionsTest, overflowDropNewest)
+{
+    std::unique_ptr<ISTMSensorsSubscription> s;
+    STMSensorsRecord records[8];
+
+    EXPECT_EQ(0, subscriptions.subscribe(1, 10000000, 0, 4, s));
+    s->setOverflowPolicy(ISTMSensorsSubscription::OverflowPolicy::DROP_NEWEST);
+
+    auto data = samples(1, 10000000, 10);
+    dispatch(data);
+
+    EXPECT_EQ(6U, s->getDroppedSamples());
+    EXPECT_EQ(4, s->read(records, 8));
+    EXPECT_EQ(0, records[0].timestamp);
+    EXPECT_EQ(30000000, records[3].timestamp);
+}
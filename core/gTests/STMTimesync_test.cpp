@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2019-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <array>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <STMTimesync.h>
+
+/* hw clock 50ppm fast with a large offset from the system clock */
+static int64_t systemTime(int64_t hwTime)
+{
+    return 1000000000000LL + hwTime - hwTime / 20000;
+}
+
+TEST(STMTimesync, linearFit)
+{
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int64_t> latency(0, 20000);
+    STMTimesync timesync;
+    int64_t estimate;
+
+    EXPECT_GT(0, timesync.init(4));
+    ASSERT_EQ(0, timesync.init(16));
+    EXPECT_FALSE(timesync.estimate(0, estimate));
+
+    /* one pair: same rate assumed */
+    ASSERT_TRUE(timesync.add(systemTime(5000000000LL), 5000000000LL));
+    ASSERT_TRUE(timesync.estimate(5100000000LL, estimate));
+    EXPECT_NEAR(systemTime(5000000000LL) + 100000000LL, estimate, 1000);
+
+    /* sync pairs every 100ms with event latency, well past the window */
+    for (int64_t hw = 5100000000LL; hw < 20000000000LL; hw += 100000000LL) {
+        ASSERT_TRUE(timesync.add(systemTime(hw) + latency(gen), hw));
+    }
+
+    for (int64_t hw = 19000000000LL; hw < 21000000000LL; hw += 250000000LL) {
+        ASSERT_TRUE(timesync.estimate(hw, estimate));
+        EXPECT_NEAR(systemTime(hw) + 10000, estimate, 15000) << hw;
+    }
+
+    /* not monotonic */
+    EXPECT_FALSE(timesync.add(systemTime(19000000000LL), 19000000000LL));
+}
+
+TEST(STMTimesync, outliersAndJumps)
+{
+    STMTimesync timesync;
+    int64_t hw = 1000000000LL, estimate;
+
+    ASSERT_EQ(0, timesync.init(8));
+
+    for (int n = 0; n < 20; ++n, hw += 100000000LL) {
+        ASSERT_TRUE(timesync.add(systemTime(hw), hw));
+    }
+
+    /* late event is rejected and does not move the fit */
+    EXPECT_FALSE(timesync.add(systemTime(hw) + 5000000LL, hw));
+    hw += 100000000LL;
+    ASSERT_TRUE(timesync.estimate(hw, estimate));
+    EXPECT_NEAR(systemTime(hw), estimate, 100);
+    EXPECT_TRUE(timesync.add(systemTime(hw), hw));
+
+    /* system clock jump: the fit restarts after a few pairs */
+    for (int n = 0; n < 5; ++n) {
+        hw += 100000000LL;
+        timesync.add(systemTime(hw) + 3000000000LL, hw);
+    }
+
+    hw += 100000000LL;
+    ASSERT_TRUE(timesync.estimate(hw, estimate));
+    EXPECT_NEAR(systemTime(hw) + 3000000000LL, estimate, 1000);
+}
+
+TEST(STMTimesync, batchEstimate)
+{
+    std::array<int64_t, 64> hwTimestamps, timestamps;
+    STMTimesync timesync;
+
+    ASSERT_EQ(0, timesync.init(32));
+    EXPECT_FALSE(timesync.estimate(hwTimestamps.data(), timestamps.data(), timestamps.size()));
+
+    for (int64_t hw = 1000000000LL; hw < 5000000000LL; hw += 200000000LL) {
+        ASSERT_TRUE(timesync.add(systemTime(hw), hw));
+    }
+
+    for (auto i = 0U; i < hwTimestamps.size(); ++i) {
+        hwTimestamps[i] = 5000000000LL + i * 1250000LL;
+    }
+
+    timestamps = hwTimestamps;
+    ASSERT_TRUE(timesync.estimate(timestamps.data(), timestamps.data(), timestamps.size()));
+
+    for (auto i = 0U; i < hwTimestamps.size(); ++i) {
+        int64_t estimate;
+
+        ASSERT_TRUE(timesync.estimate(hwTimestamps[i], estimate));
+        EXPECT_EQ(estimate, timestamps[i]);
+        EXPECT_NEAR(systemTime(hwTimestamps[i]), timestamps[i], 100);
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2019-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <SWGravity.h>
+
+using stm::core::SensorBase;
+using stm::core::SWGravity;
+
+class SensorBaseTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+    }
+
+    void TearDown() override {
+    }
+};
+
+/**
+ * threadsLifecycle: threads are created on first enable, parked on disable
+ *                   and released only when the sensor is destroyed
+ */
+TEST_F(SensorBaseTest, threadsLifecycle)
+{
+    const int handle = 1;
+    int liveThreads = SensorBase::getLiveThreadsCount();
+
+    {
+        SWGravity gravity("gravity", handle, 0);
+
+        ASSERT_FALSE(gravity.threadsActive());
+        ASSERT_EQ(liveThreads, SensorBase::getLiveThreadsCount());
+
+        ASSERT_EQ(0, gravity.Enable(handle, true, true));
+        ASSERT_TRUE(gravity.threadsActive());
+        ASSERT_EQ(liveThreads + 1, SensorBase::getLiveThreadsCount());
+
+        ASSERT_EQ(0, gravity.Enable(handle, false, true));
+        ASSERT_FALSE(gravity.threadsActive());
+        ASSERT_EQ(liveThreads + 1, SensorBase::getLiveThreadsCount());
+
+        /* re-enable must reuse the parked thread */
+        ASSERT_EQ(0, gravity.Enable(handle, true, true));
+        ASSERT_TRUE(gravity.threadsActive());
+        ASSERT_EQ(liveThreads + 1, SensorBase::getLiveThreadsCount());
+
+        ASSERT_EQ(0, gravity.Enable(handle, false, true));
+    }
+
+    ASSERT_EQ(liveThreads, SensorBase::getLiveThreadsCount());
+}
+
+class FailingGravity : public SWGravity {
+public:
+    int failures;
+
+    FailingGravity(const char *name, int handle, int module)
+        : SWGravity(name, handle, module), failures(1) {}
+
+    int startThreads(void) override
+    {
+        if (failures > 0) {
+            failures--;
+            return -ENOMEM;
+        }
+
+        return SWGravity::startThreads();
+    }
+};
+
+/**
+ * threadsStartFailure: enable fails and leaves the sensor disabled if its
+ *                      threads cannot be started, the next enable retries
+ */
+TEST_F(SensorBaseTest, threadsStartFailure)
+{
+    const int handle = 1;
+    int liveThreads = SensorBase::getLiveThreadsCount();
+
+    {
+        FailingGravity gravity("gravity", handle, 0);
+
+        ASSERT_EQ(-ENOMEM, gravity.Enable(handle, true, true));
+        ASSERT_FALSE(gravity.GetStatus(true));
+        ASSERT_FALSE(gravity.threadsActive());
+        ASSERT_EQ(liveThreads, SensorBase::getLiveThreadsCount());
+
+        ASSERT_EQ(0, gravity.Enable(handle, true, true));
+        ASSERT_TRUE(gravity.GetStatus(true));
+        ASSERT_TRUE(gravity.threadsActive());
+        ASSERT_EQ(liveThreads + 1, SensorBase::getLiveThreadsCount());
+
+        ASSERT_EQ(0, gravity.Enable(handle, false, true));
+    }
+
+    ASSERT_EQ(liveThreads, SensorBase::getLiveThreadsCount());
+}
@@ -0,0 +1,612 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "SensorHAL.h"
+#include "sensors_legacy.h"
+
+using stm::core::AccelGyroFusion6XSensorType;
+using stm::core::AccelSensorType;
+using stm::core::GameRotationVecSensorType;
+using stm::core::GravitySensorType;
+using stm::core::GyroSensorType;
+using stm::core::LinearAccelSensorType;
+using stm::core::PressureSensorType;
+using stm::core::SensorBase;
+using stm::core::SensorType;
+using stm::core::STMSensorType;
+using stm::core::STMSensorsList;
+using stm::core::STSensorHAL_data;
+using stm::core::st_hal_alloc_node_id;
+using stm::core::st_hal_attach_sensors;
+using stm::core::st_hal_dev_activate;
+using stm::core::st_hal_dev_batch;
+using stm::core::st_hal_dev_flush;
+using stm::core::st_hal_dev_poll;
+using stm::core::st_hal_remove_sensors;
+
+static const int sensorsModule = 1;
+
+/* calls issued by the HAL on the fake sensors, as "sensor.call(requester)" */
+struct CallsLog {
+    std::map<int, std::string> names;
+    std::vector<std::string> calls;
+
+    void add(SensorBase *sensor, const std::string &call, int handle)
+    {
+        calls.push_back(std::string(sensor->GetName()) + "." + call + "(" + names[handle] + ")");
+    }
+
+    size_t count(const std::string &call) const
+    {
+        return std::count(calls.begin(), calls.end(), call);
+    }
+
+    /* index of the first occurrence at or after from, calls.size() if missing */
+    size_t find(const std::string &call, size_t from = 0) const
+    {
+        auto itr = std::find(calls.begin() + std::min(from, calls.size()), calls.end(), call);
+
+        return itr - calls.begin();
+    }
+};
+
+/*
+ * Node of the sensors graph without any device behind it, calls of the
+ * HAL are recorded and can be made to fail. Calls made by SensorBase on
+ * itself (without taking the enable lock) are not recorded.
+ */
+class FakeSensor : public SensorBase {
+public:
+    int enableFailures = 0;
+    int delayFailures = 0;
+
+    FakeSensor(CallsLog &log, const char *name, int nodeId, const STMSensorType &type,
+               int module, const std::vector<STMSensorType> &dependenciesType = {})
+        : SensorBase(name, nodeId, type, module), log(log)
+    {
+        sensor_t_data.resolution = 0.01f;
+        sensor_t_data.maxRange = 1.0f;
+        sensor_t_data.fifoMaxEventCount = 100;
+        sensor_t_data.minRateHz = 1.0f;
+        sensor_t_data.maxRateHz = 100.0f;
+
+        for (auto &dependencyType : dependenciesType) {
+            dependencies_type_list.push_back(dependencyType);
+        }
+        log.names[nodeId] = name;
+    }
+
+    int Enable(int handle, bool enable, bool lock_en_mutex) override
+    {
+        if (lock_en_mutex) {
+            log.add(this, enable ? "enable" : "disable", handle);
+
+            if (enable && (enableFailures > 0)) {
+                enableFailures--;
+                return -EIO;
+            }
+        }
+
+        return SensorBase::Enable(handle, enable, lock_en_mutex);
+    }
+
+    int SetDelay(int handle, int64_t period_ns, int64_t timeout, bool lock_en_mutex) override
+    {
+        if (lock_en_mutex) {
+            log.add(this, "delay", handle);
+
+            if (delayFailures > 0) {
+                delayFailures--;
+                return -EIO;
+            }
+        }
+
+        return SensorBase::SetDelay(handle, period_ns, timeout, lock_en_mutex);
+    }
+
+    int flushRequest(int handle, bool lock_en_mutex) override
+    {
+        (void)lock_en_mutex;
+
+        log.add(this, "flush", handle);
+
+        return 0;
+    }
+
+    void ProcessFlushData(int handle, int64_t timestamp) override
+    {
+        (void)handle;
+        (void)timestamp;
+    }
+
+    /* sample written to the HAL as the data thread of a device would */
+    void emit(int64_t timestamp)
+    {
+        sensors_event_t event = sensor_event;
+
+        event.timestamp = timestamp;
+        ASSERT_EQ(write(write_pipe_fd, &event, sizeof(event)), (ssize_t)sizeof(event));
+    }
+
+    int64_t periodOf(int handle)
+    {
+        int64_t period, timeout;
+
+        GetDelay(handle, &period, &timeout, true);
+
+        return period;
+    }
+
+private:
+    CallsLog &log;
+};
+
+class SensorHALTest : public ::testing::Test {
+protected:
+    CallsLog log;
+    STSensorHAL_data halData;
+    STMSensorsList sensorsList;
+    std::unordered_set<int> newNodes;
+    std::map<std::string, std::shared_ptr<FakeSensor>> sensors;
+
+    std::shared_ptr<FakeSensor> addSensor(const char *name, const STMSensorType &type,
+                                          const std::vector<STMSensorType> &dependenciesType = {})
+    {
+        int nodeId = ST_HAL_FIRST_NODE_ID + sensors.size();
+        auto sensor = std::make_shared<FakeSensor>(log, name, nodeId, type, sensorsModule,
+                                                     dependenciesType);
+
+        halData.graph.addNode(nodeId, sensor);
+        newNodes.insert(nodeId);
+        sensors[name] = sensor;
+
+        return sensor;
+    }
+
+    /*
+     * gravity, gameRV -> fusion -> accel, gyro
+     * linear -> gravity, accel
+     */
+    void SetUp() override
+    {
+        addSensor("accel", AccelSensorType);
+        addSensor("gyro", GyroSensorType);
+        addSensor("fusion", AccelGyroFusion6XSensorType, { AccelSensorType, GyroSensorType });
+        addSensor("gravity", GravitySensorType, { AccelGyroFusion6XSensorType });
+        addSensor("gameRV", GameRotationVecSensorType, { AccelGyroFusion6XSensorType });
+        addSensor("linear", LinearAccelSensorType, { GravitySensorType, AccelSensorType });
+
+        /* no module given, virtual sensors are the fake ones */
+        ASSERT_EQ(5, st_hal_attach_sensors(&halData, sensorsList, newNodes, {}));
+    }
+
+    uint32_t handleOf(const std::string &name)
+    {
+        return halData.sensorIdToHandle.at(sensors[name]->GetHandle());
+    }
+
+    int nodeIdOf(const std::string &name)
+    {
+        return sensors[name]->GetHandle();
+    }
+
+    bool isOn(const std::string &name)
+    {
+        return sensors[name]->GetStatus(true);
+    }
+
+    /* every enable applied (all but the failed one) is followed by the matching disable */
+    void expectEnablesUndone(const std::string &failed)
+    {
+        for (size_t i = 0; i < log.calls.size(); i++) {
+            std::string call = log.calls[i];
+            size_t pos = call.find(".enable(");
+
+            if ((pos == std::string::npos) || (call == failed)) {
+                continue;
+            }
+
+            call.replace(pos, 8, ".disable(");
+            EXPECT_LT(log.find(call, i + 1), log.calls.size()) << call << " missing";
+        }
+    }
+};
+
+/**
+ * activateWalksPlan: a sensor and its dependencies are enabled, each one
+ *                    after the sensors requesting it, and disabled back
+ */
+TEST_F(SensorHALTest, activateWalksPlan)
+{
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), true));
+
+    EXPECT_TRUE(isOn("gravity"));
+    EXPECT_TRUE(isOn("fusion"));
+    EXPECT_TRUE(isOn("accel"));
+    EXPECT_TRUE(isOn("gyro"));
+    EXPECT_FALSE(isOn("gameRV"));
+    EXPECT_FALSE(isOn("linear"));
+
+    ASSERT_EQ(4u, log.calls.size());
+    EXPECT_EQ(0u, log.find("gravity.enable(gravity)"));
+    EXPECT_EQ(1u, log.find("fusion.enable(gravity)"));
+    EXPECT_EQ(1u, log.count("accel.enable(fusion)"));
+    EXPECT_EQ(1u, log.count("gyro.enable(fusion)"));
+
+    log.calls.clear();
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), false));
+
+    EXPECT_FALSE(isOn("gravity"));
+    EXPECT_FALSE(isOn("fusion"));
+    EXPECT_FALSE(isOn("accel"));
+    EXPECT_FALSE(isOn("gyro"));
+    EXPECT_EQ(1u, log.count("accel.disable(fusion)"));
+    EXPECT_EQ(1u, log.count("gyro.disable(fusion)"));
+}
+
+/**
+ * activateSharedDependency: a dependency already enabled by another sensor
+ *                           only gets the new requester, its own dependencies
+ *                           are not touched; on disable they get the pollrate
+ *                           of the requesters left
+ */
+TEST_F(SensorHALTest, activateSharedDependency)
+{
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), true));
+
+    log.calls.clear();
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gameRV"), true));
+    EXPECT_EQ(std::vector<std::string>({ "gameRV.enable(gameRV)", "fusion.enable(gameRV)" }),
+              log.calls);
+
+    log.calls.clear();
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), false));
+    EXPECT_FALSE(isOn("gravity"));
+    EXPECT_TRUE(isOn("fusion"));
+    EXPECT_TRUE(isOn("accel"));
+    EXPECT_TRUE(isOn("gyro"));
+    EXPECT_EQ(0u, log.count("accel.disable(fusion)"));
+    EXPECT_EQ(1u, log.count("accel.delay(fusion)"));
+    EXPECT_EQ(1u, log.count("gyro.delay(fusion)"));
+
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gameRV"), false));
+    EXPECT_FALSE(isOn("fusion"));
+    EXPECT_FALSE(isOn("accel"));
+    EXPECT_FALSE(isOn("gyro"));
+}
+
+/**
+ * activateRollback: when a dependency fails to enable, the enables already
+ *                   applied are undone and the sensor is left disabled
+ */
+TEST_F(SensorHALTest, activateRollback)
+{
+    sensors["gyro"]->enableFailures = 1;
+
+    ASSERT_EQ(-EIO, st_hal_dev_activate(&halData, handleOf("gravity"), true));
+
+    EXPECT_FALSE(isOn("gravity"));
+    EXPECT_FALSE(isOn("fusion"));
+    EXPECT_FALSE(isOn("accel"));
+    EXPECT_FALSE(isOn("gyro"));
+    EXPECT_EQ(0u, log.count("gyro.disable(fusion)"));
+    expectEnablesUndone("gyro.enable(fusion)");
+
+    /* the failure is not sticky */
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), true));
+    EXPECT_TRUE(isOn("gyro"));
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), false));
+}
+
+/**
+ * activateRollbackShared: the rollback only undoes the steps of the failed
+ *                         activation, sensors enabled by others stay on
+ */
+TEST_F(SensorHALTest, activateRollbackShared)
+{
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gameRV"), true));
+
+    log.calls.clear();
+    sensors["accel"]->enableFailures = 1;
+
+    ASSERT_EQ(-EIO, st_hal_dev_activate(&halData, handleOf("linear"), true));
+
+    EXPECT_FALSE(isOn("linear"));
+    EXPECT_FALSE(isOn("gravity"));
+    EXPECT_TRUE(isOn("gameRV"));
+    EXPECT_TRUE(isOn("fusion"));
+    EXPECT_TRUE(isOn("accel"));
+    EXPECT_TRUE(isOn("gyro"));
+    EXPECT_EQ(0u, log.count("accel.disable(fusion)"));
+    EXPECT_EQ(0u, log.count("fusion.disable(gameRV)"));
+    EXPECT_EQ(0u, log.count("accel.disable(linear)"));
+    expectEnablesUndone("accel.enable(linear)");
+
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gameRV"), false));
+    EXPECT_FALSE(isOn("accel"));
+}
+
+/**
+ * batchSyncsMinPeriod: a dependency runs at the fastest pollrate requested
+ *                      by the sensors sharing it
+ */
+TEST_F(SensorHALTest, batchSyncsMinPeriod)
+{
+    auto fusion = sensors["fusion"];
+    auto accel = sensors["accel"];
+
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), true));
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gameRV"), true));
+
+    ASSERT_EQ(0, st_hal_dev_batch(&halData, handleOf("gravity"), 10000000, 0));
+    ASSERT_EQ(0, st_hal_dev_batch(&halData, handleOf("gameRV"), 20000000, 0));
+    EXPECT_EQ(10000000, fusion->periodOf(nodeIdOf("gravity")));
+    EXPECT_EQ(20000000, fusion->periodOf(nodeIdOf("gameRV")));
+    EXPECT_EQ(10000000, accel->periodOf(nodeIdOf("fusion")));
+
+    ASSERT_EQ(0, st_hal_dev_batch(&halData, handleOf("gravity"), 40000000, 0));
+    EXPECT_EQ(20000000, accel->periodOf(nodeIdOf("fusion")));
+    EXPECT_EQ(20000000, sensors["gyro"]->periodOf(nodeIdOf("fusion")));
+
+    /* the pollrate of a disabled sensor does not hold its dependencies */
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gameRV"), false));
+    EXPECT_EQ(40000000, accel->periodOf(nodeIdOf("fusion")));
+
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), false));
+}
+
+/**
+ * batchRestore: when a dependency rejects the new pollrate, the previous
+ *               one is restored along the whole plan
+ */
+TEST_F(SensorHALTest, batchRestore)
+{
+    auto fusion = sensors["fusion"];
+    auto accel = sensors["accel"];
+
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), true));
+    ASSERT_EQ(0, st_hal_dev_batch(&halData, handleOf("gravity"), 20000000, 0));
+
+    sensors["gyro"]->delayFailures = 1;
+    ASSERT_EQ(-EIO, st_hal_dev_batch(&halData, handleOf("gravity"), 5000000, 0));
+
+    EXPECT_EQ(20000000, sensors["gravity"]->periodOf(nodeIdOf("gravity")));
+    EXPECT_EQ(20000000, fusion->periodOf(nodeIdOf("gravity")));
+    EXPECT_EQ(20000000, accel->periodOf(nodeIdOf("fusion")));
+    EXPECT_EQ(20000000, sensors["gyro"]->periodOf(nodeIdOf("fusion")));
+
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("gravity"), false));
+}
+
+/**
+ * flushForwardsOnce: every node of the plan is flushed once for the handle
+ *                    forwarded, even when reached through several paths
+ */
+TEST_F(SensorHALTest, flushForwardsOnce)
+{
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("linear"), true));
+
+    log.calls.clear();
+    ASSERT_EQ(0, st_hal_dev_flush(&halData, handleOf("linear")));
+
+    ASSERT_EQ(5u, log.calls.size());
+    EXPECT_EQ(0u, log.find("linear.flush(linear)"));
+    EXPECT_EQ(1u, log.count("gravity.flush(linear)"));
+    EXPECT_EQ(1u, log.count("fusion.flush(linear)"));
+    EXPECT_EQ(1u, log.count("gyro.flush(linear)"));
+
+    /* reached from linear and from fusion */
+    EXPECT_EQ(1u, log.count("accel.flush(linear)"));
+    EXPECT_GT(log.find("accel.flush(linear)"), log.find("fusion.flush(linear)"));
+
+    EXPECT_EQ(-EINVAL, st_hal_dev_flush(&halData, 1000));
+
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, handleOf("linear"), false));
+}
+
+/*
+ * accel and gyro devices of module 1 with the virtual sensors created on
+ * top of them, pressure device of module 2 unrelated to them
+ */
+class SensorHALHotplugTest : public ::testing::Test {
+protected:
+    CallsLog log;
+    STSensorHAL_data halData;
+    STMSensorsList sensorsList;
+    std::shared_ptr<FakeSensor> accel, gyro, pressure;
+
+    std::shared_ptr<FakeSensor> addDevice(unsigned int iioDevice, const char *name,
+                                          const STMSensorType &type, int module,
+                                          std::unordered_set<int> &newNodes,
+                                          std::unordered_set<int> &modulesId)
+    {
+        int nodeId = st_hal_alloc_node_id(&halData);
+        auto sensor = std::make_shared<FakeSensor>(log, name, nodeId, type, module);
+
+        halData.graph.addNode(nodeId, sensor);
+        halData.iioDeviceToNodeId[iioDevice] = std::make_pair(std::string(name), nodeId);
+        newNodes.insert(nodeId);
+        modulesId.insert(module);
+
+        return sensor;
+    }
+
+    void SetUp() override
+    {
+        std::unordered_set<int> newNodes, modulesId;
+
+        accel = addDevice(0, "accel", AccelSensorType, 1, newNodes, modulesId);
+        gyro = addDevice(1, "gyro", GyroSensorType, 1, newNodes, modulesId);
+        pressure = addDevice(2, "pressure", PressureSensorType, 2, newNodes, modulesId);
+
+        ASSERT_GT(st_hal_attach_sensors(&halData, sensorsList, newNodes, modulesId), 3);
+    }
+
+    /* handle of a sensor in the list, 0 if not there */
+    uint32_t handleOf(SensorType type, int module)
+    {
+        for (auto &sensor : sensorsList.getList()) {
+            if ((sensor.getType() == type) && (sensor.getModuleId() == module)) {
+                return sensor.getHandle();
+            }
+        }
+
+        return 0;
+    }
+
+    uint32_t lastHandle(void)
+    {
+        uint32_t last = 0;
+
+        for (auto &sensor : sensorsList.getList()) {
+            last = std::max(last, sensor.getHandle());
+        }
+
+        return last;
+    }
+
+    size_t nodesCount(void)
+    {
+        return std::distance(halData.graph.begin(), halData.graph.end());
+    }
+
+    /* a pressure sample reaches the poll with the pressure handle */
+    bool pressureStreams(int64_t timestamp)
+    {
+        sensors_event_t events[16];
+        uint32_t handle = handleOf(SensorType::PRESSURE, 2);
+
+        pressure->emit(timestamp);
+
+        int count = st_hal_dev_poll(&halData, events, 16);
+        for (int i = 0; i < count; i++) {
+            if ((events[i].sensor == (int)handle) && (events[i].timestamp == timestamp)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /* every published sensor has its list entry, its handle and its poll fd */
+    void expectListConsistent(void)
+    {
+        size_t count = sensorsList.getList().size();
+
+        EXPECT_EQ(count, halData.handleToNodeId_.size());
+        EXPECT_EQ(count, halData.sensorIdToHandle.size());
+        EXPECT_EQ(count, halData.androidPollFd.size());
+
+        for (auto &sensor : sensorsList.getList()) {
+            auto nodeId = halData.handleToNodeId_.find(sensor.getHandle());
+
+            ASSERT_NE(nodeId, halData.handleToNodeId_.end());
+            EXPECT_NE(nullptr, halData.graph[nodeId->second]);
+            EXPECT_NE(nullptr, halData.compiledGraph.plan(nodeId->second));
+        }
+    }
+};
+
+/**
+ * removeAndAddDevice: a device goes away together with the sensors depending
+ *                     on it and comes back, unrelated sensors keep streaming,
+ *                     node ids are reused while list handles are not
+ */
+TEST_F(SensorHALHotplugTest, removeAndAddDevice)
+{
+    uint32_t pressureHandle = handleOf(SensorType::PRESSURE, 2);
+    uint32_t gyroHandle = handleOf(SensorType::GYROSCOPE, 1);
+    uint32_t gravityHandle = handleOf(SensorType::GRAVITY, 1);
+    uint32_t last = lastHandle();
+    size_t sensorsCount = sensorsList.getList().size();
+    size_t nodes = nodesCount();
+    int accelNodeId = accel->GetHandle();
+
+    ASSERT_NE(0u, pressureHandle);
+    ASSERT_NE(0u, gyroHandle);
+    ASSERT_NE(0u, gravityHandle);
+    expectListConsistent();
+
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, pressureHandle, true));
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, gravityHandle, true));
+    EXPECT_TRUE(accel->GetStatus(true));
+    EXPECT_TRUE(gyro->GetStatus(true));
+    EXPECT_TRUE(pressureStreams(100));
+
+    /* accel goes away with the virtual sensors depending on it */
+    log.calls.clear();
+    int removed = st_hal_remove_sensors(&halData, sensorsList, { accelNodeId });
+
+    EXPECT_GE(removed, 3);
+    EXPECT_EQ(sensorsCount - removed, sensorsList.getList().size());
+    EXPECT_EQ(0u, handleOf(SensorType::ACCELEROMETER, 1));
+    EXPECT_EQ(0u, handleOf(SensorType::ACCELEROMETER_UNCALIBRATED, 1));
+    EXPECT_EQ(0u, handleOf(SensorType::GRAVITY, 1));
+    EXPECT_EQ(0u, handleOf(SensorType::GAME_ROTATION_VECTOR, 1));
+    EXPECT_EQ(gyroHandle, handleOf(SensorType::GYROSCOPE, 1));
+    EXPECT_EQ(pressureHandle, handleOf(SensorType::PRESSURE, 2));
+    EXPECT_EQ(nullptr, halData.graph[accelNodeId]);
+    EXPECT_EQ(0u, halData.iioDeviceToNodeId.count(0));
+    EXPECT_EQ(-EINVAL, st_hal_dev_activate(&halData, gravityHandle, false));
+    expectListConsistent();
+
+    /* the device of a removed node is not touched, what it held is released */
+    EXPECT_TRUE(std::none_of(log.calls.begin(), log.calls.end(),
+                             [](const std::string &call) { return call.rfind("accel.", 0) == 0; }));
+    EXPECT_FALSE(gyro->GetStatus(true));
+
+    EXPECT_EQ(0u, log.count("pressure.disable(pressure)"));
+    EXPECT_TRUE(pressure->GetStatus(true));
+    EXPECT_TRUE(pressureStreams(200));
+
+    /* the device comes back on the lowest free node id, with new handles */
+    std::unordered_set<int> newNodes, modulesId;
+
+    ASSERT_EQ(accelNodeId, st_hal_alloc_node_id(&halData));
+    accel = addDevice(0, "accel", AccelSensorType, 1, newNodes, modulesId);
+    EXPECT_EQ(accelNodeId, accel->GetHandle());
+    EXPECT_EQ(removed, st_hal_attach_sensors(&halData, sensorsList, newNodes, modulesId));
+
+    EXPECT_EQ(sensorsCount, sensorsList.getList().size());
+    EXPECT_EQ(nodes, nodesCount());
+    EXPECT_GT(handleOf(SensorType::ACCELEROMETER, 1), last);
+    EXPECT_GT(handleOf(SensorType::GRAVITY, 1), last);
+    EXPECT_EQ(gyroHandle, handleOf(SensorType::GYROSCOPE, 1));
+    EXPECT_EQ(pressureHandle, handleOf(SensorType::PRESSURE, 2));
+    expectListConsistent();
+
+    gravityHandle = handleOf(SensorType::GRAVITY, 1);
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, gravityHandle, true));
+    EXPECT_TRUE(accel->GetStatus(true));
+    EXPECT_TRUE(gyro->GetStatus(true));
+    EXPECT_TRUE(pressureStreams(300));
+
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, gravityHandle, false));
+    ASSERT_EQ(0, st_hal_dev_activate(&halData, pressureHandle, false));
+    EXPECT_FALSE(accel->GetStatus(true));
+}
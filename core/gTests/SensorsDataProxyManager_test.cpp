@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <IUtils.h>
+
+#include "SensorsDataProxyManager.h"
+
+using stm::core::IUtils;
+
+static const int64_t streamPollrateNs = 10000000;
+
+class SensorsDataProxyManagerTest : public ::testing::Test {
+protected:
+    SensorsDataProxyManager proxy;
+
+    void SetUp() override
+    {
+        for (int32_t channel = 1; channel <= 3; channel++) {
+            ASSERT_EQ(0, proxy.addChannel(channel));
+        }
+    }
+
+    std::vector<int32_t> channelsOf(int64_t timestamp, int32_t sensorHandle)
+    {
+        std::vector<int32_t> channels;
+
+        proxy.forEachValidPushChannel(timestamp, sensorHandle, streamPollrateNs,
+                                      [&](int32_t channelHandle) {
+                                          channels.push_back(channelHandle);
+                                      });
+        std::sort(channels.begin(), channels.end());
+
+        return channels;
+    }
+
+    /* samples pushed to a channel, out of count samples of the stream */
+    int pushedTo(int32_t channelHandle, int32_t sensorHandle, int64_t timestamp, int count)
+    {
+        int pushed = 0;
+
+        for (int i = 0; i < count; i++) {
+            for (auto channel : channelsOf(timestamp + i * streamPollrateNs, sensorHandle)) {
+                pushed += (channel == channelHandle);
+            }
+        }
+
+        return pushed;
+    }
+};
+
+/**
+ * sparseHandles: routes are looked up by handle, handles without routes
+ *                (below, between, above the registered ones) get none
+ */
+TEST_F(SensorsDataProxyManagerTest, sparseHandles)
+{
+    ASSERT_EQ(0, proxy.registerSensorToChannel(3, 1));
+    ASSERT_EQ(0, proxy.registerSensorToChannel(1000, 1));
+    ASSERT_EQ(0, proxy.registerSensorToChannel(1000, 2));
+
+    EXPECT_EQ(std::vector<int32_t>({ 1 }), channelsOf(0, 3));
+    EXPECT_EQ(std::vector<int32_t>({ 1, 2 }), channelsOf(0, 1000));
+
+    for (int32_t handle : { -1, 0, 2, 4, 999, 1001, 100000 }) {
+        EXPECT_TRUE(channelsOf(0, handle).empty()) << "handle " << handle;
+    }
+
+    /* the largest handle goes away, the table shrinks */
+    ASSERT_EQ(0, proxy.unregisterSensorFromChannel(1000, 1));
+    ASSERT_EQ(0, proxy.unregisterSensorFromChannel(1000, 2));
+    EXPECT_TRUE(channelsOf(0, 1000).empty());
+    EXPECT_EQ(std::vector<int32_t>({ 1 }), channelsOf(0, 3));
+
+    proxy.reset();
+    EXPECT_TRUE(channelsOf(0, 3).empty());
+}
+
+/**
+ * pollrateSwitchByTimestamp: a new pollrate applies to the samples taken
+ *                            after the change, older samples still in the
+ *                            pipeline keep the previous decimation
+ */
+TEST_F(SensorsDataProxyManagerTest, pollrateSwitchByTimestamp)
+{
+    IUtils &utils = IUtils::getInstance();
+    const int32_t sensor = 5;
+
+    ASSERT_EQ(0, proxy.registerSensorToChannel(sensor, 1));
+    ASSERT_EQ(0, proxy.registerSensorToChannel(sensor, 2));
+
+    int64_t before = utils.getTime();
+    ASSERT_EQ(0, proxy.configureSensorInChannel(sensor, 1, 4 * streamPollrateNs));
+    int64_t after = utils.getTime();
+    EXPECT_EQ(4 * streamPollrateNs, proxy.getMaxPollrateNs(sensor));
+
+    /* samples older than the change: not decimated yet */
+    EXPECT_EQ(8, pushedTo(1, sensor, before - 100 * streamPollrateNs, 8));
+
+    /* newer samples: one out of four, the other channel is not affected */
+    EXPECT_EQ(2, pushedTo(1, sensor, after, 8));
+    EXPECT_EQ(8, pushedTo(2, sensor, after + 8 * streamPollrateNs, 8));
+
+    /* two changes pending, the latest wins once both are reached */
+    ASSERT_EQ(0, proxy.configureSensorInChannel(sensor, 1, 8 * streamPollrateNs));
+    ASSERT_EQ(0, proxy.configureSensorInChannel(sensor, 1, 2 * streamPollrateNs));
+    int64_t last = utils.getTime();
+
+    EXPECT_EQ(2 * streamPollrateNs, proxy.getMaxPollrateNs(sensor));
+    EXPECT_EQ(4, pushedTo(1, sensor, last, 8));
+
+    /* a stale sample does not bring the old pollrate back */
+    EXPECT_EQ(2, pushedTo(1, sensor, before, 4));
+}
+
+/**
+ * unregisterDuringPush: unregistering a route waits for the push using it,
+ *                       no push reaches the route once the call returns
+ */
+TEST_F(SensorsDataProxyManagerTest, unregisterDuringPush)
+{
+    const int32_t sensor = 7;
+    std::atomic<bool> inPush(false), pushDone(false), unregistered(false), stop(false);
+    std::atomic<int> latePushes(0);
+
+    ASSERT_EQ(0, proxy.registerSensorToChannel(sensor, 1));
+    ASSERT_EQ(0, proxy.registerSensorToChannel(sensor, 2));
+
+    std::thread reader([&] {
+        int64_t timestamp = 0;
+
+        while (!stop.load()) {
+            bool removed = unregistered.load();
+
+            proxy.forEachValidPushChannel(timestamp, sensor, streamPollrateNs,
+                                          [&](int32_t channelHandle) {
+                                              if (channelHandle != 2) {
+                                                  return;
+                                              }
+
+                                              if (removed) {
+                                                  latePushes++;
+                                              }
+
+                                              if (!pushDone.load() && !inPush.exchange(true)) {
+                                                  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                                                  pushDone = true;
+                                              }
+                                          });
+            timestamp += streamPollrateNs;
+        }
+    });
+
+    while (!inPush.load()) {
+        std::this_thread::yield();
+    }
+
+    ASSERT_EQ(0, proxy.unregisterSensorFromChannel(sensor, 2));
+    EXPECT_TRUE(pushDone.load());
+    unregistered = true;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stop = true;
+    reader.join();
+
+    EXPECT_EQ(0, latePushes.load());
+    EXPECT_EQ(std::vector<int32_t>({ 1 }), channelsOf(0, sensor));
+}
+
+/**
+ * concurrentReconfiguration: routes not touched by a writer reconfiguring
+ *                            the table keep receiving every sample
+ */
+TEST_F(SensorsDataProxyManagerTest, concurrentReconfiguration)
+{
+    const int32_t sensor = 1;
+    std::atomic<bool> stop(false);
+    int samples = 0, pushedStable = 0, unexpected = 0;
+
+    ASSERT_EQ(0, proxy.registerSensorToChannel(sensor, 1));
+    uint64_t version = proxy.getVersion();
+
+    std::thread reader([&] {
+        int64_t timestamp = 0;
+
+        while (!stop.load()) {
+            proxy.forEachValidPushChannel(timestamp, sensor, streamPollrateNs,
+                                          [&](int32_t channelHandle) {
+                                              if (channelHandle == 1) {
+                                                  pushedStable++;
+                                              } else if (channelHandle != 2) {
+                                                  unexpected++;
+                                              }
+                                          });
+            timestamp += streamPollrateNs;
+            samples++;
+        }
+    });
+
+    for (int i = 0; i < 2000; i++) {
+        int32_t other = 2 + (i % 64) * 17;
+
+        ASSERT_EQ(0, proxy.registerSensorToChannel(sensor, 2));
+        ASSERT_EQ(0, proxy.registerSensorToChannel(other, 3));
+        ASSERT_EQ(0, proxy.configureSensorInChannel(sensor, 2, (1 + i % 4) * streamPollrateNs));
+        ASSERT_EQ(0, proxy.configureSensorInChannel(other, 3, streamPollrateNs));
+        ASSERT_EQ(0, proxy.unregisterSensorFromChannel(other, 3));
+        ASSERT_EQ(0, proxy.unregisterSensorFromChannel(sensor, 2));
+    }
+
+    stop = true;
+    reader.join();
+
+    EXPECT_GT(samples, 0);
+    EXPECT_EQ(samples, pushedStable);
+    EXPECT_EQ(0, unexpected);
+    EXPECT_EQ(version + 2000 * 6, proxy.getVersion());
+    EXPECT_EQ(std::vector<int32_t>({ 1 }), channelsOf(0, sensor));
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2019-2020 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <SensorsGraph.h>
+
+using stm::core::Graph;
+using stm::core::CompiledGraph;
+
+class SensorsGraphTest : public ::testing::Test {
+protected:
+    Graph<int> graph;
+
+    void SetUp() override {
+        /*
+         * 1 --> 2 --> 4
+         *  \--> 3 --/
+         * 5 --> 3
+         */
+        for (int id = 1; id <= 5; id++) {
+            graph.addNode(id, std::make_shared<int>(id * 10));
+        }
+        graph.addEdge(1, 2);
+        graph.addEdge(1, 3);
+        graph.addEdge(2, 4);
+        graph.addEdge(3, 4);
+        graph.addEdge(5, 3);
+    }
+
+    void TearDown() override {
+    }
+};
+
+/**
+ * compileNodes: verify nodes and edges are all flattened
+ */
+TEST_F(SensorsGraphTest, compileNodes)
+{
+    CompiledGraph<int> compiled;
+
+    compiled.compile(graph);
+
+    ASSERT_EQ(5U, compiled.size());
+    ASSERT_EQ(5U, compiled.edgesCount());
+
+    for (int id = 1; id <= 5; id++) {
+        ASSERT_GE(compiled.index(id), 0);
+        ASSERT_EQ(id * 10, *compiled.payload(compiled.index(id)));
+    }
+
+    ASSERT_EQ(-1, compiled.index(0));
+    ASSERT_EQ(-1, compiled.index(6));
+    ASSERT_EQ(nullptr, compiled.plan(42));
+}
+
+/**
+ * planTopologicalOrder: verify plan visits a node after all its requesters
+ */
+TEST_F(SensorsGraphTest, planTopologicalOrder)
+{
+    CompiledGraph<int> compiled;
+
+    compiled.compile(graph);
+
+    auto plan = compiled.plan(1);
+    ASSERT_NE(nullptr, plan);
+    ASSERT_EQ(4U, plan->size());
+    ASSERT_EQ(10, *compiled.payload(plan->steps[0]));
+    ASSERT_EQ(40, *compiled.payload(plan->steps[3]));
+
+    /* root has no requesters, node 4 is requested by 2 and 3 */
+    ASSERT_EQ(plan->requestersOffset[0], plan->requestersOffset[1]);
+    ASSERT_EQ(2U, plan->requestersOffset[4] - plan->requestersOffset[3]);
+
+    for (uint32_t s = 0; s < plan->size(); s++) {
+        for (uint32_t r = plan->requestersOffset[s]; r < plan->requestersOffset[s + 1]; r++) {
+            ASSERT_LT(plan->requesters[r], s);
+        }
+    }
+
+    /* node 5 is not reachable from 1 */
+    for (auto step : plan->steps) {
+        ASSERT_NE(50, *compiled.payload(step));
+    }
+
+    auto leafPlan = compiled.plan(4);
+    ASSERT_NE(nullptr, leafPlan);
+    ASSERT_EQ(1U, leafPlan->size());
+}
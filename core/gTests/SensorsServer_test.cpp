@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <SensorsServer.h>
+#include <SensorsServerClient.h>
+#include <STMSensorsRecordsPool.h>
+#include <STMSensorsSubscriptions.h>
+
+using stm::core::STMSensor;
+using stm::core::STMSensorsList;
+using stm::core::STMSensorsRecordsPool;
+using stm::core::STMSensorsSubscriptions;
+using stm::core::SensorType;
+
+/*
+ * Sensors HAL with no hardware: subscriptions are served by the real
+ * subscriptions manager, samples are injected by the test.
+ */
+class FakeSensorsHAL : public ISTMSensorsHAL {
+public:
+    struct HWConfig {
+        bool enable = false;
+        int64_t periodNs = -1;
+        int64_t latencyNs = -1;
+    };
+
+    FakeSensorsHAL(void) {
+        STMSensor accel("accel", "STMicroelectronics", 1, SensorType::ACCELEROMETER,
+                        78.4f, 0.001f, 0.1f, 1.0f, 400.0f, 0, 0, false, 0);
+        STMSensor gyro("gyro", "STMicroelectronics", 1, SensorType::GYROSCOPE,
+                       34.9f, 0.001f, 0.1f, 1.0f, 400.0f, 0, 0, false, 0);
+
+        list.addSensor(accel);
+        list.addSensor(gyro);
+    }
+
+    ~FakeSensorsHAL(void) override {
+        subscriptions.clear();
+    }
+
+    int initialize(const ISTMSensorsCallback &sensorsCallback) override {
+        callback = const_cast<ISTMSensorsCallback *>(&sensorsCallback);
+        return 0;
+    }
+
+    STMSensorsList getSensorsList(void) override { return list; }
+
+    int32_t activate(uint32_t handle, bool enable) override {
+        return subscriptions.activate(handle, enable);
+    }
+
+    int32_t setRate(uint32_t handle, int64_t periodNs, int64_t latencyNs) override {
+        return subscriptions.setRate(handle, periodNs, latencyNs);
+    }
+
+    int32_t flushData(uint32_t handle) override {
+        STMSensorsRecord record = {};
+
+        record.sensorHandle = handle;
+        record.sensorType = SensorType::META_DATA;
+        deliver(&record, 1);
+
+        return 0;
+    }
+
+    int32_t setFullScale(uint32_t handle, float fullscale) override {
+        (void) handle;
+        (void) fullscale;
+        return 0;
+    }
+
+    int32_t subscribe(uint32_t handle, int64_t periodNs, int64_t latencyNs, size_t queueLength,
+                      std::unique_ptr<ISTMSensorsSubscription> &subscription) override {
+        return subscriptions.subscribe(handle, periodNs, latencyNs, queueLength, subscription);
+    }
+
+    /* sensors data thread */
+    void push(std::vector<STMSensorsRecord> data) {
+        deliver(data.data(), subscriptions.dispatch(data.data(), data.size()));
+    }
+
+    void remove(uint32_t handle) {
+        subscriptions.remove(handle);
+    }
+
+    HWConfig getConfig(uint32_t handle) {
+        std::lock_guard<std::mutex> lock(hwLock);
+        return hw[handle];
+    }
+
+private:
+    STMSensorsList list;
+    ISTMSensorsCallback *callback = nullptr;
+    std::mutex hwLock;
+    std::map<uint32_t, HWConfig> hw;
+    std::mutex poolLock;
+    STMSensorsRecordsPool pool { 64, 2 };
+
+    STMSensorsSubscriptions subscriptions {
+        [this](uint32_t handle, bool enable) {
+            std::lock_guard<std::mutex> lock(hwLock);
+            hw[handle].enable = enable;
+            return 0;
+        },
+        [this](uint32_t handle, int64_t periodNs, int64_t latencyNs) {
+            std::lock_guard<std::mutex> lock(hwLock);
+            hw[handle].periodNs = periodNs;
+            hw[handle].latencyNs = latencyNs;
+            return 0;
+        }
+    };
+
+    void deliver(const STMSensorsRecord *records, size_t count) {
+        std::lock_guard<std::mutex> lock(poolLock);
+
+        if ((count == 0) || (callback == nullptr)) {
+            return;
+        }
+
+        auto lease = pool.acquire();
+        memcpy(static_cast<void *>(lease.data()), records, count * sizeof(STMSensorsRecord));
+        lease.resize(count);
+        callback->onNewSensorsRecords(lease);
+    }
+};
+
+class SensorsServerTest : public ::testing::Test {
+protected:
+    static constexpr uint32_t accel = 1;
+    static constexpr uint32_t gyro = 2;
+
+    FakeSensorsHAL hal;
+    SensorsServer server { hal };
+    std::string socketPath = "/tmp/stm-sensors-server-test-" + std::to_string(getpid());
+
+    void SetUp() override {
+        ASSERT_EQ(0, server.start(socketPath));
+    }
+
+    void TearDown() override {
+        server.stop();
+    }
+
+    static std::vector<STMSensorsRecord> samples(uint32_t handle, int64_t periodNs,
+                                                 size_t count, size_t first = 0) {
+        std::vector<STMSensorsRecord> data(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = {};
+            data[i].timestamp = (first + i) * periodNs;
+            data[i].sensorHandle = handle;
+            data[i].sensorType = SensorType::ACCELEROMETER;
+            data[i].dataLen = 3;
+            data[i].data[0] = first + i;
+        }
+
+        return data;
+    }
+
+    template <typename F>
+    static bool waitFor(F condition) {
+        for (int i = 0; i < 2000; ++i) {
+            if (condition()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return condition();
+    }
+
+    /* read the DATA events of a sensor until count samples are received */
+    static std::vector<STMSensorsRecord> receive(SensorsServerClient &client,
+                                                 uint32_t handle, size_t count) {
+        std::vector<STMSensorsRecord> received;
+        SensorsServerClient::Event event;
+
+        while ((received.size() < count) && (client.readEvent(event, 2000000000LL) == 0)) {
+            if ((event.type == SensorsServerMessageType::DATA) && (event.sensorHandle == handle)) {
+                received.insert(received.end(), event.records.begin(), event.records.end());
+            }
+        }
+
+        return received;
+    }
+};
+
+TEST_F(SensorsServerTest, getSensors)
+{
+    SensorsServerClient client;
+    std::vector<SensorsServerSensorInfo> sensors;
+
+    ASSERT_EQ(0, client.connect(socketPath));
+    ASSERT_EQ(0, client.getSensors(sensors));
+    ASSERT_EQ(2U, sensors.size());
+    EXPECT_EQ(accel, sensors[0].handle);
+    EXPECT_EQ(static_cast<uint16_t>(SensorType::ACCELEROMETER), sensors[0].type);
+    EXPECT_STREQ("accel", sensors[0].name);
+    EXPECT_EQ(400.0f, sensors[1].maxRateHz);
+
+    EXPECT_EQ(-ENODEV, client.subscribe(10, 10000000, 0));
+    EXPECT_EQ(-ENOENT, client.unsubscribe(accel));
+    EXPECT_EQ(-ENOENT, client.flush(accel));
+}
+
+TEST_F(SensorsServerTest, aggregatePlan)
+{
+    SensorsServerClient slow, fast;
+
+    ASSERT_EQ(0, slow.connect(socketPath));
+    ASSERT_EQ(0, fast.connect(socketPath));
+
+    ASSERT_EQ(0, slow.subscribe(accel, 20000000, 100000000));
+    EXPECT_TRUE(hal.getConfig(accel).enable);
+    EXPECT_EQ(20000000, hal.getConfig(accel).periodNs);
+
+    ASSERT_EQ(0, fast.subscribe(accel, 2500000, 0));
+    EXPECT_EQ(2500000, hal.getConfig(accel).periodNs);
+    EXPECT_EQ(0, hal.getConfig(accel).latencyNs);
+
+    /* updated subscription replaces the previous one */
+    ASSERT_EQ(0, fast.subscribe(accel, 5000000, 0));
+    EXPECT_EQ(5000000, hal.getConfig(accel).periodNs);
+
+    ASSERT_EQ(0, fast.unsubscribe(accel));
+    EXPECT_EQ(20000000, hal.getConfig(accel).periodNs);
+    EXPECT_EQ(100000000, hal.getConfig(accel).latencyNs);
+
+    /* disconnected clients are unsubscribed */
+    slow.disconnect();
+    EXPECT_TRUE(waitFor([this] { return !hal.getConfig(accel).enable; }));
+}
+
+TEST_F(SensorsServerTest, dataBatches)
+{
+    SensorsServerClient full, half;
+
+    ASSERT_EQ(0, full.connect(socketPath));
+    ASSERT_EQ(0, half.connect(socketPath));
+    ASSERT_EQ(0, full.subscribe(accel, 10000000, 0));
+    ASSERT_EQ(0, half.subscribe(accel, 20000000, 0));
+
+    for (size_t i = 0; i < 1000; i += 100) {
+        hal.push(samples(accel, 10000000, 100, i));
+    }
+
+    auto received = receive(full, accel, 1000);
+    ASSERT_EQ(1000U, received.size());
+    for (size_t i = 0; i < received.size(); ++i) {
+        EXPECT_EQ((int64_t)i * 10000000, received[i].timestamp);
+        EXPECT_EQ((float)i, received[i].data[0]);
+    }
+
+    received = receive(half, accel, 500);
+    ASSERT_EQ(500U, received.size());
+    EXPECT_EQ(20000000, received[1].timestamp - received[0].timestamp);
+}
+
+TEST_F(SensorsServerTest, flushComplete)
+{
+    SensorsServerClient client;
+    SensorsServerClient::Event event;
+
+    ASSERT_EQ(0, client.connect(socketPath));
+
+    /* batching: the watermark is not reached by a few samples */
+    ASSERT_EQ(0, client.subscribe(accel, 10000000, 1000000000));
+    hal.push(samples(accel, 10000000, 5));
+    EXPECT_EQ(-ETIMEDOUT, client.readEvent(event, 20000000));
+
+    ASSERT_EQ(0, client.flush(accel));
+
+    ASSERT_EQ(0, client.readEvent(event, 2000000000LL));
+    EXPECT_EQ(SensorsServerMessageType::DATA, event.type);
+    EXPECT_EQ(5U, event.records.size());
+
+    ASSERT_EQ(0, client.readEvent(event, 2000000000LL));
+    EXPECT_EQ(SensorsServerMessageType::FLUSH_COMPLETE, event.type);
+    EXPECT_EQ(accel, event.sensorHandle);
+}
+
+TEST_F(SensorsServerTest, slowClientDropsSamples)
+{
+    const size_t total = 50000;
+    SensorsServerClient slow, other;
+    SensorsServerClient::Event event;
+    uint64_t dropped = 0;
+    size_t received = 0;
+    int64_t last = -1;
+
+    ASSERT_EQ(0, slow.connect(socketPath));
+    ASSERT_EQ(0, other.connect(socketPath));
+    ASSERT_EQ(0, slow.subscribe(accel, 10000000, 0, 16));
+    ASSERT_EQ(0, other.subscribe(gyro, 10000000, 0));
+
+    /* slow client does not read while the samples are produced */
+    for (size_t i = 0; i < total; i += 10) {
+        hal.push(samples(accel, 10000000, 10, i));
+    }
+
+    /* other clients are not blocked */
+    hal.push(samples(gyro, 10000000, 10));
+    EXPECT_EQ(10U, receive(other, gyro, 10).size());
+
+    while ((received + dropped < total) && (slow.readEvent(event, 2000000000LL) == 0)) {
+        ASSERT_EQ(SensorsServerMessageType::DATA, event.type);
+
+        for (const auto &record : event.records) {
+            EXPECT_GT(record.timestamp, last);
+            last = record.timestamp;
+        }
+        received += event.records.size();
+        dropped = event.dropped;
+    }
+
+    EXPECT_GT(dropped, 0U);
+    EXPECT_EQ(total, received + dropped);
+    EXPECT_EQ((int64_t)(total - 1) * 10000000, last);
+}
+
+TEST_F(SensorsServerTest, sensorRemoved)
+{
+    SensorsServerClient client;
+    SensorsServerClient::Event event;
+
+    ASSERT_EQ(0, client.connect(socketPath));
+    ASSERT_EQ(0, client.subscribe(gyro, 10000000, 0));
+
+    hal.push(samples(gyro, 10000000, 3));
+    hal.remove(gyro);
+
+    EXPECT_EQ(3U, receive(client, gyro, 3).size());
+
+    ASSERT_EQ(0, client.readEvent(event, 2000000000LL));
+    EXPECT_EQ(SensorsServerMessageType::SENSOR_REMOVED, event.type);
+    EXPECT_EQ(gyro, event.sensorHandle);
+    EXPECT_EQ(-ENOENT, client.flush(gyro));
+}
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <SensorsStreamClient.h>
+#include <SensorsStreamWriter.h>
+
+using stm::core::STMSensorsRecord;
+using stm::core::SensorType;
+
+class SensorsStreamTest : public ::testing::Test {
+protected:
+    SensorsStreamWriter writer;
+    SensorsStreamServer server { writer };
+    std::string socketPath = "/tmp/stm-sensors-stream-test-" + std::to_string(getpid());
+
+    void start(uint32_t slotsCount) {
+        ASSERT_EQ(0, writer.open(slotsCount));
+        ASSERT_EQ(0, server.start(socketPath));
+    }
+
+    void TearDown() override {
+        server.stop();
+        writer.close();
+    }
+
+    static std::vector<STMSensorsRecord> records(size_t count, size_t first) {
+        std::vector<STMSensorsRecord> data(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = {};
+            data[i].timestamp = (first + i) * 1000;
+            data[i].sensorHandle = 1;
+            data[i].sensorType = SensorType::ACCELEROMETER;
+            data[i].dataLen = 3;
+            data[i].data[0] = first + i;
+        }
+
+        return data;
+    }
+};
+
+TEST_F(SensorsStreamTest, invalidSlotsCount)
+{
+    EXPECT_EQ(-EINVAL, writer.open(0));
+    EXPECT_EQ(-EINVAL, writer.open(100));
+}
+
+TEST_F(SensorsStreamTest, publishRead)
+{
+    SensorsStreamClient client;
+    STMSensorsRecord out[16];
+
+    start(64);
+    ASSERT_EQ(0, client.connect(socketPath));
+
+    EXPECT_EQ(0, client.read(out, 16));
+    EXPECT_EQ(-ETIMEDOUT, client.wait(1000000));
+
+    auto data = records(10, 0);
+    writer.publish(data.data(), data.size());
+
+    EXPECT_EQ(0, client.wait(-1));
+    ASSERT_EQ(10, client.read(out, 16));
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(i * 1000, out[i].timestamp);
+        EXPECT_EQ(3, out[i].dataLen);
+        EXPECT_EQ((float)i, out[i].data[0]);
+    }
+    EXPECT_EQ(0U, client.getLostRecords());
+
+    writer.close();
+    EXPECT_EQ(-EPIPE, client.wait(-1));
+    EXPECT_EQ(-EPIPE, client.read(out, 16));
+}
+
+TEST_F(SensorsStreamTest, overrunDetected)
+{
+    SensorsStreamClient client;
+    STMSensorsRecord out[128];
+
+    start(64);
+    ASSERT_EQ(0, client.connect(socketPath));
+
+    auto data = records(200, 0);
+    writer.publish(data.data(), data.size());
+
+    ASSERT_EQ(64, client.read(out, 128));
+    EXPECT_EQ(136U, client.getLostRecords());
+    EXPECT_EQ(136000, out[0].timestamp);
+    EXPECT_EQ(199000, out[63].timestamp);
+}
+
+TEST_F(SensorsStreamTest, readersCanNotWrite)
+{
+    SensorsStreamClient client;
+    STMSensorsRecord out[16];
+    size_t size = sensorsStreamSize(64);
+    int fd;
+    void *addr;
+
+    start(64);
+    fd = writer.getReadOnlyFd();
+
+    EXPECT_EQ(MAP_FAILED, mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+
+    addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ASSERT_NE(MAP_FAILED, addr);
+    EXPECT_NE(0, mprotect(addr, size, PROT_READ | PROT_WRITE));
+    munmap(addr, size);
+
+    /* a descriptor reopened read-write does not give write access either */
+    std::string path = "/proc/self/fd/" + std::to_string(fd);
+    int rwFd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (rwFd >= 0) {
+        char zero = 0;
+
+        EXPECT_EQ(MAP_FAILED, mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, rwFd, 0));
+        EXPECT_EQ(EPERM, errno);
+        EXPECT_GT(0, pwrite(rwFd, &zero, 1, 0));
+        close(rwFd);
+    }
+
+    /* the writer mapping keeps working */
+    ASSERT_EQ(0, client.connect(socketPath));
+    auto data = records(4, 0);
+    writer.publish(data.data(), data.size());
+    EXPECT_EQ(4, client.read(out, 16));
+}
+
+TEST_F(SensorsStreamTest, multipleReaders)
+{
+    SensorsStreamClient first, second;
+    STMSensorsRecord out[16];
+
+    start(64);
+    ASSERT_EQ(0, first.connect(socketPath));
+
+    auto data = records(4, 0);
+    writer.publish(data.data(), data.size());
+
+    /* readers start from the records published after connect */
+    ASSERT_EQ(0, second.connect(socketPath));
+    data = records(4, 4);
+    writer.publish(data.data(), data.size());
+
+    EXPECT_EQ(8, first.read(out, 16));
+    EXPECT_EQ(4, second.read(out, 16));
+    EXPECT_EQ(4000, out[0].timestamp);
+}
+
+TEST_F(SensorsStreamTest, twoProcesses)
+{
+    const size_t total = 5000;
+    int ready[2];
+    pid_t pid;
+    int status;
+
+    start(8192);
+    ASSERT_EQ(0, pipe(ready));
+
+    pid = fork();
+    ASSERT_GE(pid, 0);
+
+    if (pid == 0) {
+        SensorsStreamClient client;
+        STMSensorsRecord out[256];
+        size_t received = 0;
+        char c = 0;
+        int n;
+
+        close(ready[0]);
+        if (client.connect(socketPath) < 0) {
+            _exit(2);
+        }
+        if (write(ready[1], &c, 1) != 1) {
+            _exit(2);
+        }
+
+        while (true) {
+            if (client.wait(5000000000LL) == -ETIMEDOUT) {
+                _exit(3);
+            }
+
+            n = client.read(out, 256);
+            if (n == -EPIPE) {
+                break;
+            }
+
+            for (int i = 0; i < n; ++i, ++received) {
+                if (out[i].timestamp != (int64_t)received * 1000) {
+                    _exit(4);
+                }
+            }
+        }
+
+        _exit((received == total) && (client.getLostRecords() == 0) ? 0 : 5);
+    }
+
+    char c;
+    close(ready[1]);
+    ASSERT_EQ(1, read(ready[0], &c, 1));
+    close(ready[0]);
+
+    for (size_t i = 0; i < total; i += 10) {
+        auto data = records(10, i);
+        writer.publish(data.data(), data.size());
+    }
+    writer.close();
+
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST_F(SensorsStreamTest, twoProcessesOverrun)
+{
+    const size_t total = 100000;
+    int ready[2];
+    pid_t pid;
+    int status;
+
+    start(64);
+    ASSERT_EQ(0, pipe(ready));
+
+    pid = fork();
+    ASSERT_GE(pid, 0);
+
+    if (pid == 0) {
+        SensorsStreamClient client;
+        STMSensorsRecord out[8];
+        int64_t last = -1;
+        size_t received = 0;
+        char c = 0;
+        int n;
+
+        close(ready[0]);
+        if ((client.connect(socketPath) < 0) || (write(ready[1], &c, 1) != 1)) {
+            _exit(2);
+        }
+
+        /* slow reader: records are either read in order or counted as lost */
+        while ((n = client.read(out, 8)) != -EPIPE) {
+            for (int i = 0; i < n; ++i, ++received) {
+                if ((out[i].timestamp <= last) || (out[i].data[0] * 1000 != out[i].timestamp)) {
+                    _exit(4);
+                }
+                last = out[i].timestamp;
+            }
+        }
+
+        _exit((received + client.getLostRecords() == total) ? 0 : 5);
+    }
+
+    char c;
+    close(ready[1]);
+    ASSERT_EQ(1, read(ready[0], &c, 1));
+    close(ready[0]);
+
+    for (size_t i = 0; i < total; i += 10) {
+        auto data = records(10, i);
+        writer.publish(data.data(), data.size());
+    }
+    writer.close();
+
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+}
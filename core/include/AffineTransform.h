@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "Matrix.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AFFINE_TRANSFORM_HAVE_VECTOR_KERNEL 1
+#else /* __GNUC__ || __clang__ */
+#define AFFINE_TRANSFORM_HAVE_VECTOR_KERNEL 0
+#endif /* __GNUC__ || __clang__ */
+
+/*
+ * 3-axis affine transform out = M * in + t applied to batches of samples,
+ * used for axis remapping. The type (identity, signed axes permutation or
+ * generic) is detected once when the transform is configured so that the
+ * common remapping cases cost a copy or a shuffle per sample.
+ *
+ * Generic transforms accumulate in the same order of Matrix operator*, so
+ * with t = 0 results are bit exact with Matrix<3, 3, float> * std::array.
+ * The vector kernel (SSE on x86, NEON on ARM) loads and stores 4 floats per
+ * sample, the 4th output float is written back unchanged.
+ */
+class AffineTransform {
+public:
+    enum class Type {
+        IDENTITY,
+        PERMUTATION,
+        GENERIC,
+    };
+
+    enum class Kernel {
+        SCALAR,
+        VECTOR,
+    };
+
+    AffineTransform(void)
+        : kernel(isVectorKernelSupported() ? Kernel::VECTOR : Kernel::SCALAR) {
+        configure({ 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },
+                  { 0.0f, 0.0f, 0.0f });
+    }
+
+    void configure(const Matrix<3, 3, float> &m) {
+        configure(m[0], m[1], m[2], { 0.0f, 0.0f, 0.0f });
+    }
+
+    /* 4x3 matrix: rows 0-2 linear part, row 3 translation */
+    void configure(const Matrix<4, 3, float> &m) {
+        configure(m[0], m[1], m[2], m[3]);
+    }
+
+    void configure(const Matrix<3, 3, float> &m, const std::array<float, 3> &t) {
+        configure(m[0], m[1], m[2], t);
+    }
+
+    /* rows of the linear part and translation */
+    void configure(const std::array<float, 3> &row0,
+                   const std::array<float, 3> &row1,
+                   const std::array<float, 3> &row2,
+                   const std::array<float, 3> &t) {
+        const std::array<float, 3> *m[3] = { &row0, &row1, &row2 };
+        bool identity = true, permutation = true;
+
+        for (int row = 0; row < 3; ++row) {
+            int ones = 0;
+
+            for (int col = 0; col < 3; ++col) {
+                float v = (*m[row])[col];
+
+                linear[row][col] = v;
+                if ((v == 1.0f) || (v == -1.0f)) {
+                    perm[row] = col;
+                    signMask[row] = (v < 0.0f) ? 0x80000000U : 0U;
+                    ones++;
+                } else if (v != 0.0f) {
+                    permutation = false;
+                }
+
+                identity = identity && (v == ((row == col) ? 1.0f : 0.0f));
+            }
+
+            translation[row] = t[row];
+            permutation = permutation && (ones == 1) && (t[row] == 0.0f);
+            identity = identity && (t[row] == 0.0f);
+        }
+
+        /* each input axis must be used once */
+        permutation = permutation && (perm[0] != perm[1]) &&
+                      (perm[0] != perm[2]) && (perm[1] != perm[2]);
+
+        if (identity) {
+            type = Type::IDENTITY;
+        } else if (permutation) {
+            type = Type::PERMUTATION;
+        } else {
+            type = Type::GENERIC;
+        }
+    }
+
+    Type getType(void) const { return type; }
+
+    int setKernel(Kernel kernel) {
+        if ((kernel == Kernel::VECTOR) && !isVectorKernelSupported()) {
+            return -1;
+        }
+
+        this->kernel = kernel;
+
+        return 0;
+    }
+
+    Kernel getKernel(void) const { return kernel; }
+
+    static bool isVectorKernelSupported(void) {
+        return AFFINE_TRANSFORM_HAVE_VECTOR_KERNEL != 0;
+    }
+
+    /* one sample, in and out can be the same array */
+    void transform(const float *in, float *out) const {
+        transformBatch(in, out, 1, 3 * sizeof(float));
+    }
+
+    /**
+     * transformBatch: transform n 3-axis samples
+     * @in: first input sample.
+     * @out: first output sample, can be the same of in.
+     * @n: number of samples.
+     * @stride: distance between samples [bytes], same for in and out.
+     */
+    void transformBatch(const float *in, float *out, size_t n,
+                        size_t stride = 3 * sizeof(float)) const {
+        const uint8_t *src = reinterpret_cast<const uint8_t *>(in);
+        uint8_t *dst = reinterpret_cast<uint8_t *>(out);
+        size_t vectorized = 0;
+
+        if (type == Type::IDENTITY) {
+            if (in != out) {
+                for (size_t i = 0; i < n; ++i) {
+                    memmove(dst + i * stride, src + i * stride, 3 * sizeof(float));
+                }
+            }
+
+            return;
+        }
+
+#if AFFINE_TRANSFORM_HAVE_VECTOR_KERNEL
+        if (kernel == Kernel::VECTOR) {
+            /* the 4th float of the last sample can be out of the buffers */
+            vectorized = (stride >= 4 * sizeof(float)) ? n : ((n > 0) ? n - 1 : 0);
+            transformVector(src, dst, vectorized, stride);
+        }
+#endif /* AFFINE_TRANSFORM_HAVE_VECTOR_KERNEL */
+
+        for (size_t i = vectorized; i < n; ++i) {
+            transformScalar(reinterpret_cast<const float *>(src + i * stride),
+                            reinterpret_cast<float *>(dst + i * stride));
+        }
+    }
+
+private:
+    std::array<std::array<float, 3>, 3> linear;
+    std::array<float, 3> translation;
+    std::array<int, 3> perm;
+    std::array<uint32_t, 3> signMask;
+    Type type;
+    Kernel kernel;
+
+    void transformScalar(const float *in, float *out) const {
+        std::array<float, 3> v = { in[0], in[1], in[2] };
+
+        if (type == Type::PERMUTATION) {
+            for (int row = 0; row < 3; ++row) {
+                out[row] = (signMask[row] != 0U) ? -v[perm[row]] : v[perm[row]];
+            }
+
+            return;
+        }
+
+        for (int row = 0; row < 3; ++row) {
+            float sum = 0;
+
+            for (int col = 0; col < 3; ++col) {
+                sum += linear[row][col] * v[col];
+            }
+
+            out[row] = sum + translation[row];
+        }
+    }
+
+#if AFFINE_TRANSFORM_HAVE_VECTOR_KERNEL
+    typedef float v4sf __attribute__((vector_size(16)));
+    typedef uint32_t v4su __attribute__((vector_size(16)));
+
+    void transformVector(const uint8_t *src, uint8_t *dst, size_t n, size_t stride) const {
+        const v4su keep = { 0U, 0U, 0U, 0xFFFFFFFFU };
+        v4sf v, w, r;
+
+        if (type == Type::PERMUTATION) {
+            const v4su sign = { signMask[0], signMask[1], signMask[2], 0U };
+            const int p0 = perm[0], p1 = perm[1], p2 = perm[2];
+
+            for (size_t i = 0; i < n; ++i, src += stride, dst += stride) {
+                memcpy(&v, src, sizeof(v));
+                memcpy(&w, dst, sizeof(w));
+                r = v4sf { v[p0], v[p1], v[p2], w[3] };
+                r = (v4sf)((v4su)r ^ sign);
+                memcpy(dst, &r, sizeof(r));
+            }
+
+            return;
+        }
+
+        const v4sf zero = { 0.0f, 0.0f, 0.0f, 0.0f };
+        const v4sf col0 = { linear[0][0], linear[1][0], linear[2][0], 0.0f };
+        const v4sf col1 = { linear[0][1], linear[1][1], linear[2][1], 0.0f };
+        const v4sf col2 = { linear[0][2], linear[1][2], linear[2][2], 0.0f };
+        const v4sf t = { translation[0], translation[1], translation[2], 0.0f };
+
+        for (size_t i = 0; i < n; ++i, src += stride, dst += stride) {
+            memcpy(&v, src, sizeof(v));
+            memcpy(&w, dst, sizeof(w));
+            r = zero + col0 * v4sf { v[0], v[0], v[0], v[0] };
+            r = r + col1 * v4sf { v[1], v[1], v[1], v[1] };
+            r = r + col2 * v4sf { v[2], v[2], v[2], v[2] };
+            r = r + t;
+            r = (v4sf)(((v4su)r & ~keep) | ((v4su)w & keep));
+            memcpy(dst, &r, sizeof(r));
+        }
+    }
+#endif /* AFFINE_TRANSFORM_HAVE_VECTOR_KERNEL */
+};
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Runs a calibration library on its own thread. The producer (sensor data
+ * thread) pushes samples into a bounded single producer single consumer
+ * ring and never blocks on the calibration: when the ring is full the
+ * newest samples are dropped and counted. An idle worker (empty ring) waits
+ * with no timeout and is woken up by the first push, then it lets samples
+ * accumulate for pollPeriodMs, or until the ring is half full, so that the
+ * producer does not pay a thread wake-up per batch and a disabled sensor
+ * costs no wake-ups. Results are published by the process callback
+ * (SeqLock).
+ */
+template <typename Sample>
+class CalibrationWorker {
+public:
+    using Process = std::function<void(const Sample *samples, size_t count)>;
+
+    CalibrationWorker(void)
+        : head(0), tail(0), dropped(0), idle(false), sleeping(false), stopping(false),
+          completed(0) {}
+
+    CalibrationWorker(const CalibrationWorker &) = delete;
+    CalibrationWorker &operator=(const CalibrationWorker &) = delete;
+
+    ~CalibrationWorker(void) {
+        stop();
+    }
+
+    /**
+     * start: allocate the ring and start the worker thread
+     * @capacity: ring length [samples], rounded up to a power of 2.
+     * @process: callback run on the worker thread for each chunk of samples.
+     */
+    int start(size_t capacity, Process process) {
+        size_t len = 1;
+
+        if (worker.joinable() || !process || (capacity == 0)) {
+            return -EINVAL;
+        }
+
+        while (len < capacity) {
+            len <<= 1;
+        }
+
+        ring.resize(len);
+        mask = len - 1;
+        chunk.resize(std::min(len, maxChunk));
+        this->process = process;
+        stopping = false;
+        worker = std::thread(&CalibrationWorker::run, this);
+
+        return 0;
+    }
+
+    /* remaining samples are processed before the thread exits */
+    void stop(void) {
+        if (!worker.joinable()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wakeup.notify_one();
+        worker.join();
+    }
+
+    bool isRunning(void) const {
+        return worker.joinable();
+    }
+
+    /* producer side, returns the number of samples queued */
+    size_t push(const Sample *samples, size_t count) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t n = std::min(count, ring.size() - (t - head.load(std::memory_order_acquire)));
+
+        for (size_t i = 0; i < n; ++i) {
+            ring[(t + i) & mask] = samples[i];
+        }
+
+        dropped.fetch_add(count - n, std::memory_order_relaxed);
+
+        if (n == 0) {
+            return 0;
+        }
+
+        /* pairs with the idle and sleeping flags stores of the worker */
+        tail.store(t + n, std::memory_order_seq_cst);
+        if (idle.load(std::memory_order_seq_cst) ||
+            ((t + n - head.load(std::memory_order_relaxed) >= ring.size() / 2) &&
+             sleeping.load(std::memory_order_seq_cst))) {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakeup.notify_one();
+        }
+
+        return n;
+    }
+
+    /* wait until all samples queued so far have been processed */
+    void flush(void) {
+        size_t target = tail.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex);
+
+        wakeup.notify_one();
+        done.wait(lock, [&] { return !worker.joinable() || (completed >= target); });
+    }
+
+    uint64_t getDropped(void) const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t maxChunk = 64;
+    static constexpr int pollPeriodMs = 10;
+
+    std::vector<Sample> ring;
+    size_t mask;
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    std::atomic<uint64_t> dropped;
+
+    std::vector<Sample> chunk;
+    Process process;
+    std::thread worker;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable done;
+    std::atomic<bool> idle;
+    std::atomic<bool> sleeping;
+    bool stopping;
+    size_t completed;
+
+    bool empty(void) const {
+        return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_seq_cst);
+    }
+
+    void run(void) {
+        while (true) {
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t n = std::min(chunk.size(), tail.load(std::memory_order_acquire) - h);
+
+            if (n == 0) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                idle.store(true, std::memory_order_seq_cst);
+                wakeup.wait(lock, [this] { return stopping || !empty(); });
+                idle.store(false, std::memory_order_relaxed);
+
+                if (stopping) {
+                    if (empty()) {
+                        break;
+                    }
+
+                    continue;
+                }
+
+                /* first samples after idle, wait for more of them */
+                sleeping.store(true, std::memory_order_seq_cst);
+                wakeup.wait_for(lock, std::chrono::milliseconds(pollPeriodMs));
+                sleeping.store(false, std::memory_order_relaxed);
+
+                continue;
+            }
+
+            for (size_t i = 0; i < n; ++i) {
+                chunk[i] = ring[(h + i) & mask];
+            }
+
+            head.store(h + n, std::memory_order_release);
+
+            process(chunk.data(), n);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                completed = h + n;
+            }
+
+            done.notify_all();
+        }
+
+        done.notify_all();
+    }
+};
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <IIORecording.h>
+
+namespace stm {
+namespace core {
+
+/*
+ * Recorder of the raw iio streams: buffers read from the iio char devices,
+ * iio events and control calls of the hardware sensors are appended to a
+ * recording file (IIORecording.h). The sensors threads copy the records to
+ * a bounded ring, a writer thread writes them to the file; records that do
+ * not fit in the ring are dropped rather than stalling the sensors. When not
+ * recording the cost is a flag test.
+ */
+class IIORecorder {
+public:
+    IIORecorder(void);
+    ~IIORecorder(void);
+
+    IIORecorder(const IIORecorder &) = delete;
+    IIORecorder &operator=(const IIORecorder &) = delete;
+
+    /**
+     * getInstance: recorder used by the hardware sensors
+     */
+    static IIORecorder &getInstance(void);
+
+    /**
+     * open: start recording, the file is replaced if it exists
+     * @path: recording file path.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int open(const std::string &path);
+
+    /* stop recording, write the queued records and the index */
+    void close(void);
+
+    bool isRecording(void) const { return recording.load(std::memory_order_relaxed); }
+
+    /**
+     * recordScan: buffer read from the iio char device
+     * @device: scan layout of the device, recorded before its first buffer
+     *          and whenever it changes.
+     * @handle: hardware sensor handle.
+     * @timestamp: read time.
+     */
+    void recordScan(const IIORecordingDevice &device, int32_t handle, int64_t timestamp,
+                    const void *data, size_t len);
+
+    /* device_iio_events read from the iio events fd */
+    void recordEvents(int32_t handle, int64_t timestamp, const void *events, size_t len);
+
+    void recordControl(int32_t handle, int64_t timestamp, const IIORecordingControl &control);
+
+private:
+    std::atomic<bool> recording;
+
+    /* serializes open and close */
+    std::mutex controlLock;
+
+    /* ring and recording state, the writer thread drops it to write */
+    std::mutex lock;
+    std::condition_variable ringCond;
+    std::vector<uint8_t> ring;
+    uint64_t ringHead;
+    uint64_t ringTail;
+    bool stopWriter;
+    bool writeFailed;
+    std::thread writer;
+
+    int fd;
+    uint64_t offset;
+    uint64_t records;
+    uint64_t dropped;
+    uint32_t sequence;
+    int64_t lastTimestamp;
+    std::vector<IIORecordingIndexEntry> index;
+    std::unordered_map<int32_t, IIORecordingDevice> devices;
+
+    int queue(IIORecordType type, int32_t handle, int64_t timestamp,
+              const void *payload, size_t len);
+    void ringCopy(const void *data, size_t len);
+    int writeRing(uint64_t from, uint64_t to);
+    void writerLoop(void);
+    int writeIndex(void);
+};
+
+} // namespace core
+} // namespace stm
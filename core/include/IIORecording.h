@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace stm {
+namespace core {
+
+/*
+ * Recording of the raw iio streams of the hardware sensors (IIORecorder).
+ *
+ * File layout, native endianness, all records 8 bytes aligned:
+ *  - IIORecordingFileHeader
+ *  - records: IIORecordHeader followed by size bytes of payload, appended in
+ *    the order they happen
+ *  - on close: an INDEX record (IIORecordingIndexEntry of one record out of
+ *    indexInterval, starting from the first) and IIORecordingFooter at the
+ *    end of the file
+ *
+ * A recording not closed (crash, power loss) has no index: records are read
+ * up to the last complete one.
+ */
+static constexpr uint32_t iioRecordingMagic = 0x52494953;       /* "SIIR" */
+static constexpr uint32_t iioRecordingFooterMagic = 0x58494953; /* "SIIX" */
+static constexpr uint16_t iioRecordingVersion = 2;
+static constexpr uint32_t iioRecordingIndexInterval = 1024;
+static constexpr int iioRecordingMaxChannels = 8;
+
+enum class IIORecordType : uint16_t {
+    DEVICE = 1,     /* IIORecordingDevice, before the first scan of the device */
+    SCAN = 2,       /* buffer read from /dev/iio:deviceN */
+    EVENTS = 3,     /* device_iio_events read from the device events fd */
+    CONTROL = 4,    /* IIORecordingControl */
+    INDEX = 5,      /* IIORecordingIndexEntry array */
+};
+
+enum class IIOControlOp : uint32_t {
+    ENABLE = 1,         /* arg0: enable */
+    SET_DELAY = 2,      /* arg0: period (ns), arg1: timeout (ns) */
+    FLUSH = 3,
+    SET_FULLSCALE = 4,  /* value: full scale */
+};
+
+struct IIORecordingFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    int64_t startTimestamp;
+};
+
+/*
+ * timestamp: time (IUtils::getTime) the data was read or the call was made,
+ * handle: hardware sensor handle,
+ * sequence: record number, gaps are records dropped by the recorder
+ */
+struct IIORecordHeader {
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t size;
+    int64_t timestamp;
+    int32_t handle;
+    uint32_t sequence;
+};
+
+/* scan layout of a channel, see device_iio_info_channel */
+struct IIORecordingChannel {
+    float scale;
+    float offset;
+    uint32_t bytes;
+    uint32_t bitsUsed;
+    uint32_t shift;
+    uint32_t be;
+    uint32_t sign;
+    uint32_t location;
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t mask;
+};
+
+struct IIORecordingDevice {
+    char name[32];
+    uint32_t iioDevNum;
+    uint32_t scanSize;
+    int32_t numChannels;
+    int32_t countsChannels;
+    IIORecordingChannel channels[iioRecordingMaxChannels];
+};
+
+/* handle: sensor handle the request is made for */
+struct IIORecordingControl {
+    uint32_t op;
+    int32_t handle;
+    int64_t arg0;
+    int64_t arg1;
+    float value;
+    uint32_t reserved;
+};
+
+/* timestamps of the index never decrease, they can be binary searched */
+struct IIORecordingIndexEntry {
+    int64_t timestamp;
+    uint64_t offset;
+};
+
+struct IIORecordingFooter {
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t recordCount;
+    uint32_t indexInterval;
+    uint32_t magic;
+};
+
+static inline constexpr uint64_t iioRecordAlign(uint64_t size)
+{
+    return (size + 7) & ~(uint64_t)7;
+}
+
+/*
+ * Read-only view of a recording, the file is memory mapped. Records are
+ * located by reading their headers once at open, the index of the file is
+ * checked against them.
+ */
+class IIORecording {
+public:
+    struct Record {
+        const IIORecordHeader *header;
+        const uint8_t *payload;
+    };
+
+    IIORecording(void);
+    ~IIORecording(void);
+
+    IIORecording(const IIORecording &) = delete;
+    IIORecording &operator=(const IIORecording &) = delete;
+
+    /**
+     * open: map a recording
+     * @path: recording file path.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int open(const std::string &path);
+
+    void close(void);
+
+    /* number of records, index excluded */
+    size_t size(void) const { return index.size(); }
+
+    Record at(size_t i) const;
+
+    /* recording was closed, records match the index of the file */
+    bool isComplete(void) const { return complete; }
+
+    /* first record not older than timestamp, size() if none */
+    size_t lowerBound(int64_t timestamp) const;
+
+    /* scan layout of a hardware sensor, nullptr if the device was not recorded */
+    const IIORecordingDevice *getDevice(int32_t handle) const;
+
+private:
+    const uint8_t *base;
+    size_t length;
+    bool complete;
+
+    /* timestamp and offset of every record */
+    std::vector<IIORecordingIndexEntry> index;
+
+    uint64_t readRecords(uint64_t end);
+    bool checkIndex(const IIORecordingFooter &footer, const IIORecordingIndexEntry *entries) const;
+};
+
+} // namespace core
+} // namespace stm
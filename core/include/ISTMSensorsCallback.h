@@ -21,6 +21,7 @@
 #include <string>
 
 #include <ISTMSensorsCallbackData.h>
+#include <STMSensorsRecords.h>
 
 namespace stm {
 namespace core {
@@ -35,6 +36,16 @@ public:
      */
     virtual void onNewSensorsData(const std::vector<ISTMSensorsCallbackData> &sensorsData) = 0;
 
+    /**
+     * onNewSensorsRecords: called whenever new data are available for consumers,
+     *                      records are valid until the function returns, unless
+     *                      the lease is moved out (valid until released).
+     *                      Default implementation converts the records and calls
+     *                      onNewSensorsData.
+     * @records: lease of the records buffer.
+     */
+    virtual void onNewSensorsRecords(STMSensorsRecordsLease &records);
+
     /**
      * onSaveDataRequest: called whenever a resource needs to be written to disk
      * @resourceID: identifier of the resource.
@@ -54,6 +65,12 @@ public:
      * Return value: number of bytes read on success, else a negative error code.
      */
     virtual int onLoadDataRequest(const std::string& resourceID, void *data, ssize_t len) = 0;
+
+    /**
+     * onSensorsListChanged: called whenever sensors are added or removed at run-time
+     *                       (IIO devices hotplug), the sensors list must be read again.
+     */
+    virtual void onSensorsListChanged(void) { };
 };
 
 } // namespace core
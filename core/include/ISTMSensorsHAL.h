@@ -18,12 +18,14 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include <IConsole.h>
 #include <STMSensor.h>
 #include <STMSensorsList.h>
 #include <ISTMSensorsCallback.h>
+#include <ISTMSensorsSubscription.h>
 
 namespace stm {
 namespace core {
@@ -53,9 +55,10 @@ public:
     /**
      * getSensorsList: retrieve sensors list
      *
-     * Return value: const reference of sensors list.
+     * Return value: copy of the sensors list, not affected by IIO devices
+     *               hotplug changing the list afterwards.
      */
-    virtual const STMSensorsList& getSensorsList(void) = 0;
+    virtual STMSensorsList getSensorsList(void) = 0;
 
     /**
      * activate: enable or disable specified sensor
@@ -95,6 +98,24 @@ public:
      * Return value: 0 on success, else a negative error code.
      */
     virtual int32_t setFullScale(uint32_t handle, float fullscale) = 0;
+
+    /**
+     * subscribe: enable specified sensor for an in-process client, the sensor
+     *            runs at the fastest period and shortest latency requested by
+     *            all its clients (activate/setRate and subscriptions)
+     * @handle: sensor handle ID (retrieved from sensors list).
+     * @samplingPeriodNanoSec: requested sensor data period in nanoseconds.
+     * @maxReportLatencyNanoSec: requested sensor data maximum reporting latency in nanoseconds.
+     * @queueLength: number of samples the subscription queue can hold.
+     * @subscription: created subscription, destroy it to unsubscribe.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    virtual int32_t subscribe(uint32_t handle,
+                              int64_t samplingPeriodNanoSec,
+                              int64_t maxReportLatencyNanoSec,
+                              size_t queueLength,
+                              std::unique_ptr<ISTMSensorsSubscription> &subscription) = 0;
 };
 
 } // namespace core
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <ISTMSensorsCallbackData.h>
+#include <STMSensorsRecords.h>
+
+namespace stm {
+namespace core {
+
+/*
+ * Subscription of an in-process client to one sensor, created with
+ * ISTMSensorsHAL::subscribe. Samples are decimated to the subscription
+ * period and queued in a bounded ring owned by the subscription, when the
+ * ring is full samples are dropped according to the overflow policy.
+ * Destroying the object unsubscribes, the sensor configuration is
+ * recomputed for the remaining clients.
+ *
+ * Samples can be read blocking the calling thread or in pull mode: the
+ * event file descriptor is readable (poll / epoll) while the number of
+ * queued samples reaches the watermark, samples are then drained with
+ * read(records, maxRecords) without blocking.
+ */
+class ISTMSensorsSubscription {
+public:
+    enum class OverflowPolicy {
+        DROP_OLDEST = 0,
+        DROP_NEWEST = 1,
+    };
+
+    virtual ~ISTMSensorsSubscription(void) = default;
+
+    /**
+     * getSensorHandle: sensor handle of the subscription
+     */
+    virtual uint32_t getSensorHandle(void) const = 0;
+
+    /**
+     * getSamplingPeriodNs: requested sensor data period in nanoseconds
+     */
+    virtual int64_t getSamplingPeriodNs(void) const = 0;
+
+    /**
+     * getMaxReportLatencyNs: requested maximum reporting latency in nanoseconds
+     */
+    virtual int64_t getMaxReportLatencyNs(void) const = 0;
+
+    /**
+     * read: move queued samples to the caller
+     * @sensorsData: vector where samples are appended.
+     * @maxSamples: maximum number of samples to read.
+     * @timeoutNs: maximum time to wait for the first sample in nanoseconds,
+     *             0 does not wait, negative values wait forever.
+     *
+     * Return value: number of samples read, -ENODEV if the sensor is no
+     *               longer available and the queue is empty.
+     */
+    virtual int read(std::vector<ISTMSensorsCallbackData> &sensorsData,
+                     size_t maxSamples,
+                     int64_t timeoutNs) = 0;
+
+    /**
+     * read: move queued samples to the caller, never blocks
+     * @records: destination array.
+     * @maxRecords: maximum number of records to read.
+     *
+     * Return value: number of records read, -ENODEV if the sensor is no
+     *               longer available and the queue is empty.
+     */
+    virtual int read(STMSensorsRecord *records, size_t maxRecords) = 0;
+
+    /**
+     * getEventFd: event file descriptor, readable while the watermark is
+     *             reached or the subscription is closed. Owned by the
+     *             subscription, must not be read or closed by the caller.
+     */
+    virtual int getEventFd(void) const = 0;
+
+    /**
+     * setWatermark: number of queued samples that makes the event file
+     *               descriptor readable, 1 by default
+     * @samples: watermark, from 1 to the queue length.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    virtual int setWatermark(size_t samples) = 0;
+
+    /**
+     * setOverflowPolicy: samples dropped when the queue is full,
+     *                    DROP_OLDEST by default
+     */
+    virtual void setOverflowPolicy(OverflowPolicy policy) = 0;
+
+    /**
+     * getDroppedSamples: number of samples dropped because the queue was full
+     */
+    virtual uint64_t getDroppedSamples(void) const = 0;
+};
+
+} // namespace core
+} // namespace stm
@@ -18,7 +18,9 @@
 #pragma once
 
 #include <array>
+#include <cmath>
 #include <string>
+#include <utility>
 
 template <ssize_t rows, ssize_t columns, typename T>
 class Matrix {
@@ -44,11 +46,12 @@ public:
         return columns;
     }
 
-    Matrix<rows, columns, T> & operator*(const Matrix<columns, rows, T>& rhl) {
-        Matrix<rows, columns, T> result;
+    template <ssize_t k>
+    Matrix<rows, k, T> operator*(const Matrix<columns, k, T>& rhl) const {
+        Matrix<rows, k, T> result;
 
         for (auto row = 0; row < rows; ++row) {
-            for (auto col = 0; col < columns; ++col) {
+            for (auto col = 0; col < k; ++col) {
                 result[row][col] = 0;
 
                 for (auto i = 0; i < columns; ++i) {
@@ -57,13 +60,11 @@ public:
             }
         }
 
-        *this = std::move(result);
-
-        return *this;
+        return result;
     }
 
-    std::array<T, columns> operator*(const std::array<T, columns>& rhl) {
-        std::array<T, columns> result;
+    std::array<T, rows> operator*(const std::array<T, columns>& rhl) const {
+        std::array<T, rows> result;
 
         for (auto row = 0; row < rows; ++row) {
             result[row] = 0;
@@ -76,7 +77,7 @@ public:
         return result;
     }
 
-    operator std::string() {
+    operator std::string() const {
         std::string text;
 
         for (auto i = 0; i < numRows(); ++i) {
@@ -94,12 +95,12 @@ public:
         return text;
     }
 
-    operator std::array<T, columns * rows>() {
+    operator std::array<T, columns * rows>() const {
         std::array<T, columns * rows> output;
 
         for (auto i = 0; i < numRows(); ++i) {
             for (auto j = 0; j < numColumns(); ++j) {
-                output[3 * i + j] = data[i][j];
+                output[columns * i + j] = data[i][j];
             }
         }
 
@@ -109,3 +110,61 @@ public:
 private:
     std::array<std::array<T, columns>, rows> data;
 };
+
+/**
+ * solveLinearSystem: solve a * x = b by gaussian elimination with partial
+ *                    pivoting, a and b are overwritten
+ * @a: n x n coefficients matrix.
+ * @b: known terms.
+ * @x: solution.
+ *
+ * Return value: 0 on success, -1 if the system is (close to) singular.
+ */
+template <size_t n, typename T>
+int solveLinearSystem(std::array<std::array<T, n>, n> &a,
+                      std::array<T, n> &b,
+                      std::array<T, n> &x)
+{
+    T maxDiag = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        maxDiag = std::fmax(maxDiag, std::fabs(a[i][i]));
+    }
+
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+
+        for (size_t row = col + 1; row < n; ++row) {
+            if (std::fabs(a[row][col]) > std::fabs(a[pivot][col])) {
+                pivot = row;
+            }
+        }
+
+        if (std::fabs(a[pivot][col]) <= 1e-12 * maxDiag) {
+            return -1;
+        }
+
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+
+        for (size_t row = col + 1; row < n; ++row) {
+            T k = a[row][col] / a[col][col];
+
+            for (size_t i = col; i < n; ++i) {
+                a[row][i] -= k * a[col][i];
+            }
+            b[row] -= k * b[col];
+        }
+    }
+
+    for (size_t i = n; i-- > 0;) {
+        T sum = b[i];
+
+        for (size_t j = i + 1; j < n; ++j) {
+            sum -= a[i][j] * x[j];
+        }
+        x[i] = sum / a[i][i];
+    }
+
+    return 0;
+}
@@ -35,6 +35,7 @@ enum class SensorPropertyId {
     ROTATION_MATRIX_2,
     SENSOR_PLACEMENT_2,
     MAX_RANGE,
+    DECIMATION_FILTER,
 };
 
 enum class PropertyId {
@@ -71,6 +72,8 @@ public:
 
     float getMaxOdr() const;
 
+    int getDecimationFilter(SensorType sensorType) const;
+
 private:
     enum class PropertyNum {
         ONE,
@@ -89,6 +92,8 @@ private:
 
     void loadMaxOdrs(const PropertiesLoader& loader);
 
+    void loadDecimationFilters(const PropertiesLoader& loader);
+
     void calculateFinalRotationMatrices();
 
     void calculateFinalSensorsPlacement();
@@ -117,6 +122,8 @@ private:
 
     std::unordered_map<SensorType, float> maxRanges;
 
+    std::unordered_map<SensorType, int> decimationFilters;
+
     float maxOdr;
 
     Matrix<3, 3, float> identityMatrix;
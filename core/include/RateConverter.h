@@ -0,0 +1,501 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RATE_CONVERTER_HAVE_VECTOR_KERNEL 1
+#else /* __GNUC__ || __clang__ */
+#define RATE_CONVERTER_HAVE_VECTOR_KERNEL 0
+#endif /* __GNUC__ || __clang__ */
+
+/*
+ * Output rate conversion of a multi-channel sensor stream.
+ *
+ * PICK keeps one sample every M (no filtering), FIR and CIC decimate by the
+ * same integer factor M after an anti-aliasing low-pass, RESAMPLE produces
+ * samples at exactly the requested period on a regular timestamp grid with
+ * a polyphase interpolation filter bank.
+ *
+ * FIR coefficients (Blackman windowed sinc, cut-off at the output Nyquist
+ * frequency) are computed by configure(), only the outputs that are emitted
+ * are computed. Each output is stamped with the timestamp of the input that
+ * produced it, the filter group delay is not compensated (as for the sensor
+ * digital low-pass filters). The first sample after configure(), reset() or
+ * a gap longer than two output periods primes the filter history and is
+ * emitted unchanged.
+ */
+class RateConverter {
+public:
+    enum class Mode {
+        PICK = 0,
+        FIR = 1,
+        CIC = 2,
+        RESAMPLE = 3,
+    };
+
+    static constexpr size_t maxChannels = 8;
+
+    /* taps of the decimation filter, of each phase for the resampler */
+    static constexpr size_t maxTaps = 256;
+
+    static constexpr size_t resamplerPhases = 32;
+    static constexpr int cicOrder = 3;
+    static constexpr int cicMaxFactor = 2048;
+
+    RateConverter(void)
+        : mode(Mode::PICK), channels(0), factor(1), inputPeriodNs(0),
+          outputPeriodNs(0), taps(0), historyLength(0), cicGain(1.0) {
+        reset();
+    }
+
+    /**
+     * decimationFactor: integer decimation used for PICK, FIR and CIC
+     * @inputPeriodNs: input sampling period [ns].
+     * @outputPeriodNs: requested output period [ns].
+     *
+     * Return value: ratio rounded down with 5% of tolerance, at least 1.
+     */
+    static int decimationFactor(int64_t inputPeriodNs, int64_t outputPeriodNs) {
+        float ratio;
+        int m;
+
+        if ((inputPeriodNs <= 0) || (outputPeriodNs <= inputPeriodNs)) {
+            return 1;
+        }
+
+        ratio = (float)outputPeriodNs / inputPeriodNs;
+        m = (int)(ratio + (ratio / 20));
+
+        return std::max(m, 1);
+    }
+
+    /**
+     * configure: design the filter and reset the converter
+     * @mode: conversion mode.
+     * @channels: number of floats per sample.
+     * @inputPeriodNs: nominal input sampling period [ns].
+     * @outputPeriodNs: requested output period [ns].
+     *
+     * Return value: 0 on success, -EINVAL on invalid arguments.
+     */
+    int configure(Mode mode, size_t channels, int64_t inputPeriodNs, int64_t outputPeriodNs) {
+        if ((channels == 0) || (channels > maxChannels) ||
+            (inputPeriodNs <= 0) || (outputPeriodNs <= 0)) {
+            return -EINVAL;
+        }
+
+        factor = decimationFactor(inputPeriodNs, outputPeriodNs);
+        if ((mode == Mode::CIC) && (factor > cicMaxFactor)) {
+            return -EINVAL;
+        }
+
+        this->mode = mode;
+        this->channels = channels;
+        this->inputPeriodNs = inputPeriodNs;
+
+        switch (mode) {
+        case Mode::FIR:
+            designDecimator();
+            break;
+        case Mode::RESAMPLE:
+            factor = 1;
+            designResampler((double)inputPeriodNs / std::max(outputPeriodNs, inputPeriodNs));
+            break;
+        default:
+            taps = 0;
+            historyLength = 0;
+            coefficients.clear();
+            break;
+        }
+
+        cicGain = 1.0 / (pow((double)factor, cicOrder) * cicScale);
+        this->outputPeriodNs = (mode == Mode::RESAMPLE) ?
+                               std::max(outputPeriodNs, inputPeriodNs) : factor * inputPeriodNs;
+        history.assign(channels * 2 * historyLength, 0.0f);
+
+        reset();
+
+        return 0;
+    }
+
+    /* drop the filter history, next sample primes the filter */
+    void reset(void) {
+        primed = false;
+        counter = 0;
+        historyPosition = 0;
+        previousTimestamp = 0;
+        nextOutputTimestamp = 0;
+    }
+
+    Mode getMode(void) const { return mode; }
+    size_t getChannels(void) const { return channels; }
+    int getFactor(void) const { return factor; }
+    size_t getTaps(void) const { return taps; }
+
+    /* period of the output samples [ns] */
+    int64_t getOutputPeriodNs(void) const { return outputPeriodNs; }
+
+    /**
+     * process: push one input sample
+     * @timestamp: sample timestamp [ns].
+     * @in: channels floats.
+     * @emit: callable void(int64_t timestamp, const float *out), called for
+     *        each output sample.
+     *
+     * Return value: number of output samples.
+     */
+    template <typename Emit>
+    size_t process(int64_t timestamp, const float *in, Emit &&emit) {
+        size_t count;
+
+        /* history is stale after a gap in the input stream */
+        if (!primed || (timestamp - previousTimestamp > 2 * outputPeriodNs)) {
+            prime(timestamp, in);
+            emit(timestamp, in);
+
+            return 1;
+        }
+
+        switch (mode) {
+        case Mode::FIR:
+            count = processFir(timestamp, in, emit);
+            break;
+        case Mode::CIC:
+            count = processCic(timestamp, in, emit);
+            break;
+        case Mode::RESAMPLE:
+            return processResampler(timestamp, in, emit);
+        default:
+            count = processPick(timestamp, in, emit);
+            break;
+        }
+
+        previousTimestamp = timestamp;
+
+        return count;
+    }
+
+private:
+    /* CIC input quantization [LSB/unit] */
+    static constexpr double cicScale = 65536.0;
+
+    Mode mode;
+    size_t channels;
+    int factor;
+    int64_t inputPeriodNs;
+    int64_t outputPeriodNs;
+
+    /* FIR taps and history window length (taps rounded up to 8) */
+    size_t taps;
+    size_t historyLength;
+
+    /*
+     * FIR: historyLength coefficients, oldest sample first.
+     * RESAMPLE: resamplerPhases + 1 phases of historyLength coefficients.
+     */
+    std::vector<float> coefficients;
+
+    /* per channel: 2 * historyLength samples, each sample stored twice */
+    std::vector<float> history;
+    size_t historyPosition;
+
+    bool primed;
+    int counter;
+    int64_t previousTimestamp;
+    int64_t nextOutputTimestamp;
+
+    uint64_t integrators[maxChannels][cicOrder];
+    uint64_t combs[maxChannels][cicOrder];
+    double cicGain;
+
+    float output[maxChannels];
+
+    static void blackmanSinc(std::vector<double> &h, double cutoff) {
+        const double pi = 3.14159265358979323846;
+        size_t n = h.size();
+        double center = (n - 1) / 2.0;
+
+        for (size_t i = 0; i < n; ++i) {
+            double x = i - center;
+            double sinc = (x == 0.0) ? 2.0 * cutoff :
+                          sin(2.0 * pi * cutoff * x) / (pi * x);
+            double w = (n > 1) ? 0.42 - 0.5 * cos(2.0 * pi * i / (n - 1)) +
+                                 0.08 * cos(4.0 * pi * i / (n - 1)) : 1.0;
+
+            h[i] = sinc * w;
+        }
+    }
+
+    static size_t roundUp8(size_t n) {
+        return (n + 7) & ~(size_t)7;
+    }
+
+    /* low-pass at the output Nyquist frequency, 10 taps per decimated sample */
+    void designDecimator(void) {
+        std::vector<double> h(std::min((size_t)(10 * factor + 1), maxTaps - 1));
+        double sum = 0.0;
+
+        blackmanSinc(h, 0.5 / factor);
+        for (auto v : h) {
+            sum += v;
+        }
+
+        taps = h.size();
+        historyLength = roundUp8(taps);
+        coefficients.assign(historyLength, 0.0f);
+        for (size_t i = 0; i < taps; ++i) {
+            coefficients[historyLength - 1 - i] = h[i] / sum;
+        }
+    }
+
+    /*
+     * Prototype low-pass h at resamplerPhases times the input rate. Phase p
+     * (0 <= p <= P) interpolates at p / P between the last two inputs x[i-1]
+     * and x[i]: y = sum_k h[(k - 1) * P + p] * x[i - k], k = 0 ... K.
+     */
+    void designResampler(double ratio) {
+        const size_t phases = resamplerPhases;
+        size_t perPhase = std::min((size_t)ceil(10.0 / ratio), maxTaps - 1);
+        std::vector<double> h(phases * perPhase);
+
+        blackmanSinc(h, 0.5 * ratio / phases);
+
+        taps = perPhase + 1;
+        historyLength = roundUp8(taps);
+        coefficients.assign((phases + 1) * historyLength, 0.0f);
+
+        for (size_t p = 0; p <= phases; ++p) {
+            float *c = &coefficients[p * historyLength];
+            double sum = 0.0;
+
+            for (size_t k = 0; k < taps; ++k) {
+                int64_t n = ((int64_t)k - 1) * phases + p;
+
+                if ((n >= 0) && (n < (int64_t)h.size())) {
+                    sum += h[n];
+                }
+            }
+
+            /* unity gain at DC for each phase */
+            for (size_t k = 0; k < taps; ++k) {
+                int64_t n = ((int64_t)k - 1) * phases + p;
+
+                if ((n >= 0) && (n < (int64_t)h.size())) {
+                    c[historyLength - 1 - k] = h[n] / sum;
+                }
+            }
+        }
+    }
+
+    void prime(int64_t timestamp, const float *in) {
+        for (size_t ch = 0; ch < channels; ++ch) {
+            std::fill_n(&history[ch * 2 * historyLength], 2 * historyLength, in[ch]);
+
+            if (mode == Mode::CIC) {
+                /* steady state for a constant input */
+                int64_t x = llrint(in[ch] * cicScale);
+
+                for (int i = 0; i < cicOrder; ++i) {
+                    integrators[ch][i] = 0U;
+                    combs[ch][i] = 0U;
+                }
+
+                for (int i = 0; i < cicOrder * factor; ++i) {
+                    cicIntegrate(ch, x);
+                    if ((i % factor) == (factor - 1)) {
+                        cicComb(ch);
+                    }
+                }
+            }
+        }
+
+        primed = true;
+        counter = 0;
+        historyPosition = 0;
+        previousTimestamp = timestamp;
+        nextOutputTimestamp = timestamp + outputPeriodNs;
+    }
+
+    /* newest sample at window(ch)[historyLength - 1] */
+    const float *window(size_t ch) const {
+        return &history[ch * 2 * historyLength + historyPosition];
+    }
+
+    void pushHistory(const float *in) {
+        historyPosition = (historyPosition + 1 == historyLength) ? 0 : historyPosition + 1;
+
+        for (size_t ch = 0; ch < channels; ++ch) {
+            float *h = &history[ch * 2 * historyLength];
+            size_t newest = historyPosition + historyLength - 1;
+
+            h[newest] = in[ch];
+            h[(newest >= historyLength) ? newest - historyLength : newest + historyLength] = in[ch];
+        }
+    }
+
+    void cicIntegrate(size_t ch, int64_t x) {
+        uint64_t v = (uint64_t)x;
+
+        /* modular arithmetic, wrap-around cancels in the combs */
+        for (int i = 0; i < cicOrder; ++i) {
+            integrators[ch][i] += v;
+            v = integrators[ch][i];
+        }
+    }
+
+    uint64_t cicComb(size_t ch) {
+        uint64_t v = integrators[ch][cicOrder - 1];
+
+        for (int i = 0; i < cicOrder; ++i) {
+            uint64_t delayed = combs[ch][i];
+
+            combs[ch][i] = v;
+            v -= delayed;
+        }
+
+        return v;
+    }
+
+    template <typename Emit>
+    size_t processPick(int64_t timestamp, const float *in, Emit &&emit) {
+        if (++counter < factor) {
+            return 0;
+        }
+
+        counter = 0;
+        emit(timestamp, in);
+
+        return 1;
+    }
+
+    template <typename Emit>
+    size_t processFir(int64_t timestamp, const float *in, Emit &&emit) {
+        pushHistory(in);
+        if (++counter < factor) {
+            return 0;
+        }
+
+        counter = 0;
+        for (size_t ch = 0; ch < channels; ++ch) {
+            output[ch] = dot(coefficients.data(), window(ch), historyLength);
+        }
+
+        emit(timestamp, output);
+
+        return 1;
+    }
+
+    template <typename Emit>
+    size_t processCic(int64_t timestamp, const float *in, Emit &&emit) {
+        bool decimate = (++counter >= factor);
+
+        for (size_t ch = 0; ch < channels; ++ch) {
+            cicIntegrate(ch, llrint(in[ch] * cicScale));
+            if (decimate) {
+                output[ch] = (int64_t)cicComb(ch) * cicGain;
+            }
+        }
+
+        if (!decimate) {
+            return 0;
+        }
+
+        counter = 0;
+        emit(timestamp, output);
+
+        return 1;
+    }
+
+    template <typename Emit>
+    size_t processResampler(int64_t timestamp, const float *in, Emit &&emit) {
+        int64_t dt = timestamp - previousTimestamp;
+        size_t count = 0;
+
+        if (dt <= 0) {
+            return 0;
+        }
+
+        pushHistory(in);
+
+        /* previousTimestamp < nextOutputTimestamp, position is in (0, P] */
+        while (nextOutputTimestamp <= timestamp) {
+            double position = (double)(nextOutputTimestamp - previousTimestamp) * resamplerPhases / dt;
+            size_t phase = std::min((size_t)position, resamplerPhases - 1);
+            float fraction = position - phase;
+            const float *c0 = &coefficients[phase * historyLength];
+            const float *c1 = c0 + historyLength;
+
+            for (size_t ch = 0; ch < channels; ++ch) {
+                float y0 = dot(c0, window(ch), historyLength);
+                float y1 = dot(c1, window(ch), historyLength);
+
+                output[ch] = y0 + fraction * (y1 - y0);
+            }
+
+            emit(nextOutputTimestamp, output);
+            nextOutputTimestamp += outputPeriodNs;
+            count++;
+        }
+
+        previousTimestamp = timestamp;
+
+        return count;
+    }
+
+#if RATE_CONVERTER_HAVE_VECTOR_KERNEL
+    typedef float v4sf __attribute__((vector_size(16)));
+
+    /* n is a multiple of 8 */
+    static float dot(const float *a, const float *b, size_t n) {
+        v4sf acc0 = { 0.0f, 0.0f, 0.0f, 0.0f };
+        v4sf acc1 = acc0;
+        v4sf a0, a1, b0, b1;
+
+        for (size_t i = 0; i < n; i += 8) {
+            memcpy(&a0, a + i, sizeof(a0));
+            memcpy(&a1, a + i + 4, sizeof(a1));
+            memcpy(&b0, b + i, sizeof(b0));
+            memcpy(&b1, b + i + 4, sizeof(b1));
+            acc0 += a0 * b0;
+            acc1 += a1 * b1;
+        }
+
+        acc0 += acc1;
+
+        return (acc0[0] + acc0[1]) + (acc0[2] + acc0[3]);
+    }
+#else /* RATE_CONVERTER_HAVE_VECTOR_KERNEL */
+    static float dot(const float *a, const float *b, size_t n) {
+        float sum = 0.0f;
+
+        for (size_t i = 0; i < n; ++i) {
+            sum += a[i] * b[i];
+        }
+
+        return sum;
+    }
+#endif /* RATE_CONVERTER_HAVE_VECTOR_KERNEL */
+};
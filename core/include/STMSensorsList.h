@@ -30,6 +30,10 @@ public:
 
     bool addSensor(STMSensor &sensor);
 
+    bool removeSensor(uint32_t handle);
+
+    bool hasHandle(uint32_t handle) const;
+
     const std::vector<STMSensor>& getList(void) const;
 
     void clear();
@@ -39,6 +43,11 @@ private:
      * List of available sensors
      */
     std::vector<STMSensor> list;
+
+    /**
+     * Last handle assigned, handles are never reused until clear()
+     */
+    uint32_t lastHandle = 0;
 };
 
 } // namespace core
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <SensorType.h>
+
+namespace stm {
+namespace core {
+
+/*
+ * Fixed layout sensor sample, same content of ISTMSensorsCallbackData
+ * without any heap allocated storage.
+ */
+struct STMSensorsRecord {
+    static constexpr size_t maxDataLen = 16;
+
+    int64_t timestamp;
+    uint32_t sensorHandle;
+    SensorType sensorType;
+    uint8_t wakeUpSensor;
+    uint8_t dataLen;
+    float data[maxDataLen];
+};
+
+class STMSensorsRecordsPool;
+
+/*
+ * Lease of a pool buffer holding sensors records. The buffer goes back to
+ * the pool when the lease is released or destroyed, a consumer can keep the
+ * records beyond the callback by moving the lease.
+ */
+class STMSensorsRecordsLease {
+public:
+    STMSensorsRecordsLease(void) = default;
+    ~STMSensorsRecordsLease(void) { release(); }
+
+    STMSensorsRecordsLease(STMSensorsRecordsLease &&other) noexcept { *this = std::move(other); }
+    STMSensorsRecordsLease &operator=(STMSensorsRecordsLease &&other) noexcept;
+
+    STMSensorsRecordsLease(const STMSensorsRecordsLease &) = delete;
+    STMSensorsRecordsLease &operator=(const STMSensorsRecordsLease &) = delete;
+
+    STMSensorsRecord *data(void) { return records; }
+    const STMSensorsRecord *data(void) const { return records; }
+    STMSensorsRecord &operator[](size_t i) { return records[i]; }
+    const STMSensorsRecord &operator[](size_t i) const { return records[i]; }
+    STMSensorsRecord *begin(void) { return records; }
+    STMSensorsRecord *end(void) { return records + count; }
+    const STMSensorsRecord *begin(void) const { return records; }
+    const STMSensorsRecord *end(void) const { return records + count; }
+
+    size_t size(void) const { return count; }
+    bool empty(void) const { return count == 0; }
+    size_t capacity(void) const { return maxCount; }
+
+    /* number of valid records, up to capacity */
+    void resize(size_t n) { count = (n < maxCount) ? n : maxCount; }
+
+    /**
+     * release: give the buffer back to the pool, records are not valid anymore
+     */
+    void release(void);
+
+private:
+    friend class STMSensorsRecordsPool;
+
+    STMSensorsRecordsPool *pool = nullptr;
+    STMSensorsRecord *records = nullptr;
+    size_t count = 0;
+    size_t maxCount = 0;
+};
+
+} // namespace core
+} // namespace stm
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*
+ * Single writer, multiple readers sequence lock. The writer never waits,
+ * readers retry while a write is in progress. Payload is stored as relaxed
+ * atomic words so that concurrent accesses are well defined.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock(void) : seq(0) {
+        for (auto &word : words) {
+            word.store(0U, std::memory_order_relaxed);
+        }
+    }
+
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    /* must not be called concurrently by different threads */
+    void write(const T &value) {
+        std::array<uint32_t, numWords> buffer = { 0U };
+        uint32_t s = seq.load(std::memory_order_relaxed);
+
+        memcpy(buffer.data(), &value, sizeof(T));
+
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < numWords; ++i) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    /* latest value written, false if never written */
+    bool read(T &value) const {
+        std::array<uint32_t, numWords> buffer;
+        uint32_t s0, s1;
+
+        do {
+            s0 = seq.load(std::memory_order_acquire);
+
+            for (size_t i = 0; i < numWords; ++i) {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1 = seq.load(std::memory_order_relaxed);
+        } while ((s0 & 1U) || (s0 != s1));
+
+        if (s0 == 0U) {
+            return false;
+        }
+
+        memcpy(static_cast<void *>(&value), buffer.data(), sizeof(T));
+
+        return true;
+    }
+
+    /* number of completed writes */
+    uint32_t getVersion(void) const {
+        return seq.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t numWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> seq;
+    std::array<std::atomic<uint32_t>, numWords> words;
+};
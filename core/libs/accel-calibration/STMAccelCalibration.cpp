@@ -15,11 +15,33 @@
  * limitations under the License.
  */
 
+#include <cmath>
+
 #include "STMAccelCalibration.h"
 
 static const int minFrequencyHz = 1;
 static const int maxFrequencyHz = 3000;
 
+static const float gravityEarth = 9.80665f;
+
+/* stationary block: duration, and max deviation / variance per axis */
+static const int64_t blockDurationNs = 500000000LL;
+static const unsigned int minBlockSamples = 8;
+static const float motionThreshold = 0.3f;
+static const float stillVariance = 0.05f * 0.05f;
+static const float maxGravityError = 1.5f;
+
+/* poses are averaged over at most maxPoseWeight stationary blocks */
+static const unsigned int maxPoseWeight = 8;
+static const int minOffsetPoses = 4;
+static const int minGainPoses = 7;
+
+/* accepted calibration range and fit quality [m/s^2] */
+static const float maxOffset = 1.5f;
+static const float minGain = 0.9f;
+static const float maxGain = 1.1f;
+static const float maxResidual = 0.1f;
+
 STMAccelCalibration& STMAccelCalibration::getInstance(void)
 {
     static STMAccelCalibration *accelCalib = new STMAccelCalibration();
@@ -27,14 +49,20 @@ STMAccelCalibration& STMAccelCalibration::getInstance(void)
 }
 
 STMAccelCalibration::STMAccelCalibration(void)
-    : lastTimestamp(1)
+    : lastTimestamp(1),
+      accelRange(0.0f),
+      accuracy(UNRELIABLE)
 {
+    resetBiasMatrix(outBias);
+    reset(outBias);
 }
 
 int STMAccelCalibration::init(float accelRange)
 {
     if (accelRange < 1.0f) return -1;
 
+    this->accelRange = accelRange;
+
     return 0;
 }
 
@@ -42,6 +70,16 @@ int STMAccelCalibration::reset(const Matrix<4, 3, float> &initialBias)
 {
     outBias = initialBias;
     lastTimestamp = 1;
+    blockCount = 0;
+    clearPoses();
+
+    /* a stored calibration is usable, but not verified yet */
+    accuracy = UNRELIABLE;
+    for (int i = 0; i < 3; ++i) {
+        if ((initialBias[3][i] != 0.0f) || (initialBias[i][i] != 1.0f)) {
+            accuracy = LOW;
+        }
+    }
 
     return 0;
 }
@@ -56,16 +94,347 @@ int STMAccelCalibration::setFrequency(int frequencyHz)
     return 0;
 }
 
+void STMAccelCalibration::clearPoses(void)
+{
+    poseWeight.fill(0);
+    posesCount = 0;
+
+    for (auto &row : offsetAtA) {
+        row.fill(0.0);
+    }
+    offsetAtb.fill(0.0);
+
+    for (auto &row : gainAtA) {
+        row.fill(0.0);
+    }
+    gainAtb.fill(0.0);
+}
+
+/*
+ * accumulate: add (weight = 1) or remove (weight = -1) a pose
+ *             from the normal equations of both fits
+ */
+void STMAccelCalibration::accumulate(const std::array<float, 3> &pose, double weight)
+{
+    const double x = pose[0], y = pose[1], z = pose[2];
+    const std::array<double, offsetTerms> offset = { x, y, z, 1.0 };
+    const std::array<double, gainTerms> gain = { x * x, y * y, z * z, x, y, z, 1.0 };
+    const double r2 = x * x + y * y + z * z;
+    const double g2 = (double)gravityEarth * gravityEarth;
+
+    /* offset only: |pose|^2 = 2 * offset . pose + k */
+    for (int i = 0; i < offsetTerms; ++i) {
+        for (int j = i; j < offsetTerms; ++j) {
+            offsetAtA[i][j] += weight * offset[i] * offset[j];
+        }
+        offsetAtb[i] += weight * offset[i] * r2;
+    }
+
+    /* offset and gain: sum(gain_i^2 * (pose_i - offset_i)^2) = g^2 */
+    for (int i = 0; i < gainTerms; ++i) {
+        for (int j = i; j < gainTerms; ++j) {
+            gainAtA[i][j] += weight * gain[i] * gain[j];
+        }
+        gainAtb[i] += weight * gain[i] * g2;
+    }
+}
+
+void STMAccelCalibration::addPose(const std::array<float, 3> &mean)
+{
+    float norm = std::sqrt(mean[0] * mean[0] + mean[1] * mean[1] + mean[2] * mean[2]);
+    int bin = 0;
+
+    /* 3 x 3 x 3 direction bins, the central one is never used */
+    for (int i = 0; i < 3; ++i) {
+        bin = 3 * bin + (mean[i] > 0.5f * norm ? 2 : (mean[i] < -0.5f * norm ? 0 : 1));
+    }
+
+    if (poseWeight[bin] > 0) {
+        accumulate(poses[bin], -1.0);
+
+        if (poseWeight[bin] < maxPoseWeight) {
+            poseWeight[bin]++;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            poses[bin][i] += (mean[i] - poses[bin][i]) / poseWeight[bin];
+        }
+    } else {
+        poseWeight[bin] = 1;
+        poses[bin] = mean;
+        posesCount++;
+    }
+
+    accumulate(poses[bin], 1.0);
+    updateFit();
+}
+
+/*
+ * endBlock: close current block, a stationary block becomes a pose
+ */
+void STMAccelCalibration::endBlock(void)
+{
+    std::array<float, 3> mean;
+    float norm = 0.0f;
+    unsigned int count = blockCount;
+
+    blockCount = 0;
+
+    if (blockMoving) {
+        return;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        float avg = blockSum[i] / count;
+
+        if (blockSumSq[i] / count - avg * avg > stillVariance) {
+            return;
+        }
+
+        mean[i] = blockRef[i] + avg;
+        norm += mean[i] * mean[i];
+
+        /* saturated axis, not a gravity measurement */
+        if ((accelRange > 0.0f) && (std::fabs(mean[i]) >= 0.95f * accelRange)) {
+            return;
+        }
+    }
+
+    if (std::fabs(std::sqrt(norm) - gravityEarth) > maxGravityError) {
+        return;
+    }
+
+    addPose(mean);
+}
+
+/*
+ * updateFit: solve offset (and gain if poses allow it), publish the
+ *            result if plausible and consistent with all the poses;
+ *            accuracy is LOW for an offset fit on few poses, MEDIUM for
+ *            an offset fit on enough poses and HIGH for a gain fit
+ */
+void STMAccelCalibration::updateFit(void)
+{
+    std::array<bool, 3> positive = { false, false, false };
+    std::array<bool, 3> negative = { false, false, false };
+    std::array<float, 3> offset, gain;
+    bool allDirections = true;
+    bool gainFit = false;
+    float residual = 0.0f;
+
+    if (posesCount < minOffsetPoses) {
+        return;
+    }
+
+    for (int bin = 0; bin < numPoses; ++bin) {
+        int index = bin;
+
+        if (poseWeight[bin] == 0) {
+            continue;
+        }
+
+        for (int i = 2; i >= 0; --i, index /= 3) {
+            positive[i] = positive[i] || (index % 3 == 2);
+            negative[i] = negative[i] || (index % 3 == 0);
+        }
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        allDirections = allDirections && positive[i] && negative[i];
+    }
+
+    if ((posesCount >= minGainPoses) && allDirections) {
+        std::array<std::array<double, gainTerms>, gainTerms> a;
+        std::array<double, gainTerms> b = gainAtb, p;
+        double radius2;
+
+        for (int i = 0; i < gainTerms; ++i) {
+            for (int j = 0; j < gainTerms; ++j) {
+                a[i][j] = i <= j ? gainAtA[i][j] : gainAtA[j][i];
+            }
+        }
+
+        if (solveLinearSystem(a, b, p) < 0) {
+            return;
+        }
+
+        /* p = { gain^2 * s, -2 * gain^2 * offset * s, k }, s fixed by g */
+        radius2 = (double)gravityEarth * gravityEarth - p[6];
+        for (int i = 0; i < 3; ++i) {
+            if (p[i] <= 0.0) {
+                return;
+            }
+
+            offset[i] = -p[3 + i] / (2.0 * p[i]);
+            radius2 += p[i] * offset[i] * offset[i];
+        }
+
+        if (radius2 <= 0.0) {
+            return;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            gain[i] = gravityEarth * std::sqrt(p[i] / radius2);
+        }
+
+        gainFit = true;
+    } else {
+        std::array<std::array<double, offsetTerms>, offsetTerms> a;
+        std::array<double, offsetTerms> b = offsetAtb, p;
+        double radius2;
+
+        for (int i = 0; i < offsetTerms; ++i) {
+            for (int j = 0; j < offsetTerms; ++j) {
+                a[i][j] = i <= j ? offsetAtA[i][j] : offsetAtA[j][i];
+            }
+        }
+
+        if (solveLinearSystem(a, b, p) < 0) {
+            return;
+        }
+
+        radius2 = p[3] + 0.25 * (p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (radius2 <= 0.0) {
+            return;
+        }
+
+        /* common gain only, per-axis gain needs both directions of each axis */
+        for (int i = 0; i < 3; ++i) {
+            offset[i] = 0.5 * p[i];
+            gain[i] = gravityEarth / std::sqrt(radius2);
+        }
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        if ((std::fabs(offset[i]) > maxOffset) || (gain[i] < minGain) || (gain[i] > maxGain)) {
+            return;
+        }
+    }
+
+    for (int bin = 0; bin < numPoses; ++bin) {
+        float norm = 0.0f;
+
+        if (poseWeight[bin] == 0) {
+            continue;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            float value = gain[i] * (poses[bin][i] - offset[i]);
+
+            norm += value * value;
+        }
+
+        residual += (std::sqrt(norm) - gravityEarth) * (std::sqrt(norm) - gravityEarth);
+    }
+
+    if (std::sqrt(residual / posesCount) > maxResidual) {
+        return;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            outBias[i][j] = i == j ? gain[i] : 0.0f;
+        }
+        outBias[3][i] = offset[i];
+    }
+
+    if (gainFit) {
+        accuracy = HIGH;
+    } else {
+        accuracy = posesCount >= minGainPoses ? MEDIUM : LOW;
+    }
+}
+
+/*
+ * addSamples: add samples to the open block until it ends or a sample is
+ *             not in timestamp order, block sums are kept in locals
+ *
+ * Return value: number of samples added.
+ */
+size_t STMAccelCalibration::addSamples(const std::array<float, 3> *accelData,
+                                       const int64_t *timestamp,
+                                       size_t count)
+{
+    const std::array<float, 3> ref = blockRef;
+    std::array<float, 3> sum = blockSum, sumSq = blockSumSq;
+    unsigned int samples = blockCount;
+    bool moving = blockMoving;
+    int64_t prevTimestamp = lastTimestamp;
+    bool blockEnded = false;
+    size_t n;
+
+    for (n = 0; (n < count) && !blockEnded; ++n) {
+        if (timestamp[n] <= prevTimestamp) {
+            break;
+        }
+
+        prevTimestamp = timestamp[n];
+        samples++;
+
+        /* fast path: block already discarded, wait for its end */
+        if (!moving) {
+            for (int i = 0; i < 3; ++i) {
+                float d = accelData[n][i] - ref[i];
+
+                if (std::fabs(d) > motionThreshold) {
+                    moving = true;
+                    break;
+                }
+
+                sum[i] += d;
+                sumSq[i] += d * d;
+            }
+        }
+
+        blockEnded = (timestamp[n] - blockStart >= blockDurationNs) &&
+                     (samples >= minBlockSamples);
+    }
+
+    blockSum = sum;
+    blockSumSq = sumSq;
+    blockCount = samples;
+    blockMoving = moving;
+    lastTimestamp = prevTimestamp;
+
+    if (blockEnded) {
+        endBlock();
+    }
+
+    return n;
+}
+
 int STMAccelCalibration::run(const std::array<float, 3> &accelData,
                              int64_t timestamp)
 {
-    if (timestamp <= lastTimestamp) return -1;
+    return run(&accelData, &timestamp, 1);
+}
 
-    (void) accelData;
+int STMAccelCalibration::run(const std::array<float, 3> *accelData,
+                             const int64_t *timestamp,
+                             size_t count)
+{
+    int ret = 0;
+    size_t n = 0;
 
-    lastTimestamp = timestamp;
+    while (n < count) {
+        if (timestamp[n] <= lastTimestamp) {
+            ret = -1;
+            n++;
+            continue;
+        }
 
-    return 0;
+        if (blockCount == 0) {
+            blockStart = timestamp[n];
+            blockMoving = false;
+            blockRef = accelData[n];
+            blockSum = { 0.0f, 0.0f, 0.0f };
+            blockSumSq = { 0.0f, 0.0f, 0.0f };
+        }
+
+        n += addSamples(&accelData[n], &timestamp[n], count - n);
+    }
+
+    return ret;
 }
 
 int STMAccelCalibration::getBias(Matrix<4, 3, float> &bias) const
@@ -75,9 +444,19 @@ int STMAccelCalibration::getBias(Matrix<4, 3, float> &bias) const
     return 0;
 }
 
+/**
+ * getAccuracy: accuracy of the published bias
+ *
+ * Return value: one of STMAccelCalibration::Accuracy levels.
+ */
+int STMAccelCalibration::getAccuracy(void) const
+{
+    return accuracy;
+}
+
 const std::string& STMAccelCalibration::getLibVersion(void) const
 {
-    static const std::string libVersion("stm-accel-lib-mock");
+    static const std::string libVersion("stm-accel-calibration-multipose");
 
     return libVersion;
 }
@@ -22,7 +22,33 @@
 
 #include <Matrix.h>
 
+/*
+ * Online accelerometer offset and gain calibration.
+ *
+ * Samples are grouped in blocks of about 0.5s: a block where the device does
+ * not move is a stationary pose, its mean is a gravity measurement. A block
+ * is dropped as soon as one sample deviates from its first one, so that
+ * while the device is moving each sample costs a few comparisons.
+ *
+ * Poses are kept in 26 gravity direction bins (fixed memory). The normal
+ * equations of |gain * (pose - offset)| = g are updated in O(1) when a bin
+ * changes and solved for offset only, or for offset and per-axis gain when
+ * both directions of every axis have been seen.
+ *
+ * Bias matrix: rows 0-2 gain (diagonal), row 3 offset;
+ * calibrated = gain * (raw - offset).
+ */
 struct STMAccelCalibration {
+    /* same values of the Android SENSOR_STATUS_* accuracy levels */
+    enum Accuracy : int {
+        UNRELIABLE = 0,
+        LOW = 1,
+        MEDIUM = 2,
+        HIGH = 3,
+    };
+
+    STMAccelCalibration(void);
+    /* shared calibration, the accelerometer module owns its own object */
     static STMAccelCalibration& getInstance(void);
     ~STMAccelCalibration(void) = default;
     STMAccelCalibration(const STMAccelCalibration &) = delete;
@@ -38,8 +64,15 @@ struct STMAccelCalibration {
 
     int run(const std::array<float, 3> &accelData, int64_t timestamp);
 
+    /* run on count samples, bias is updated at the end of each block */
+    int run(const std::array<float, 3> *accelData,
+            const int64_t *timestamp,
+            size_t count);
+
     int getBias(Matrix<4, 3, float> &bias) const;
 
+    int getAccuracy(void) const;
+
     const std::string& getLibVersion(void) const;
 
     static void resetBiasMatrix(Matrix<4, 3, float> &bias);
@@ -49,8 +82,40 @@ struct STMAccelCalibration {
     static int getMaxFrequencyHz(void);
 
 private:
+    static constexpr int numPoses = 27;
+    static constexpr int offsetTerms = 4;
+    static constexpr int gainTerms = 7;
+
     Matrix<4, 3, float> outBias;
     int64_t lastTimestamp;
+    float accelRange;
+    int accuracy;
 
-    STMAccelCalibration(void);
+    /* current block, accumulated as deviation from its first sample */
+    int64_t blockStart;
+    unsigned int blockCount;
+    bool blockMoving;
+    std::array<float, 3> blockRef;
+    std::array<float, 3> blockSum;
+    std::array<float, 3> blockSumSq;
+
+    /* stationary poses, indexed by gravity direction */
+    std::array<std::array<float, 3>, numPoses> poses;
+    std::array<unsigned int, numPoses> poseWeight;
+    int posesCount;
+
+    /* normal equations (upper triangle only) of the poses */
+    std::array<std::array<double, offsetTerms>, offsetTerms> offsetAtA;
+    std::array<double, offsetTerms> offsetAtb;
+    std::array<std::array<double, gainTerms>, gainTerms> gainAtA;
+    std::array<double, gainTerms> gainAtb;
+
+    void clearPoses(void);
+    void accumulate(const std::array<float, 3> &pose, double weight);
+    void addPose(const std::array<float, 3> &mean);
+    size_t addSamples(const std::array<float, 3> *accelData,
+                      const int64_t *timestamp,
+                      size_t count);
+    void endBlock(void);
+    void updateFit(void);
 };
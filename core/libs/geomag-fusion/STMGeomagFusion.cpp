@@ -15,6 +15,8 @@
  * limitations under the License.
  */
 
+#include <cmath>
+
 #include "STMGeomagFusion.h"
 
 STMGeomagFusion& STMGeomagFusion::getInstance(void)
@@ -26,32 +28,189 @@ STMGeomagFusion& STMGeomagFusion::getInstance(void)
 
 int STMGeomagFusion::init(float freq)
 {
-    (void)freq;
+    if (freq <= 0.0f) {
+        return -1;
+    }
+
+    defaultDeltaMs = 1000.0f / freq;
+    valid = false;
+    initialized = false;
 
     return 0;
 }
 
+/* after a gap longer than this the filters restart from the new sample */
+static const float maxDeltaMs = 1000.0f;
+static const float rad2deg = 57.29577951f;
+/* below this fraction of the expected norm the vector gives no direction */
+static const float minNormRatio = 0.1f;
+
+static float norm(const std::array<float, 3> &v)
+{
+    return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+static std::array<float, 3> cross(const std::array<float, 3> &a,
+                                  const std::array<float, 3> &b)
+{
+    return { a[1] * b[2] - a[2] * b[1],
+             a[2] * b[0] - a[0] * b[2],
+             a[0] * b[1] - a[1] * b[0] };
+}
+
+/*
+ * quaternion { x, y, z, w } of the rotation matrix with rows East, North
+ * and Up expressed in sensor frame (sensor to earth frame), w >= 0
+ */
+static void quaternionFromRows(const std::array<float, 3> &e,
+                               const std::array<float, 3> &n,
+                               const std::array<float, 3> &u,
+                               std::array<float, 4> &q)
+{
+    float trace = e[0] + n[1] + u[2], s;
+
+    if (trace > 0.0f) {
+        s = 0.5f / std::sqrt(trace + 1.0f);
+        q = { (u[1] - n[2]) * s, (e[2] - u[0]) * s, (n[0] - e[1]) * s, 0.25f / s };
+    } else if ((e[0] > n[1]) && (e[0] > u[2])) {
+        s = 0.5f / std::sqrt(1.0f + e[0] - n[1] - u[2]);
+        q = { 0.25f / s, (e[1] + n[0]) * s, (e[2] + u[0]) * s, (u[1] - n[2]) * s };
+    } else if (n[1] > u[2]) {
+        s = 0.5f / std::sqrt(1.0f + n[1] - e[0] - u[2]);
+        q = { (e[1] + n[0]) * s, 0.25f / s, (n[2] + u[1]) * s, (e[2] - u[0]) * s };
+    } else {
+        s = 0.5f / std::sqrt(1.0f + u[2] - e[0] - n[1]);
+        q = { (e[2] + u[0]) * s, (n[2] + u[1]) * s, 0.25f / s, (n[0] - e[1]) * s };
+    }
+
+    if (q[3] < 0.0f) {
+        for (auto &v : q) {
+            v = -v;
+        }
+    }
+}
+
 int STMGeomagFusion::run(const std::array<float, 3> &accelData,
                          const std::array<float, 3> &magData,
-                         int64_t delay)
+                         float delta_ms)
 {
-    (void)accelData;
-    (void)magData;
-    (void)delay;
+    std::array<float, 3> up, east, north;
+    float upNorm, eastNorm;
+
+    lastAccel = accelData;
+
+    if ((delta_ms <= 0.0f) && initialized) {
+        delta_ms = defaultDeltaMs;
+    }
+
+    if (!initialized || (delta_ms > maxDeltaMs)) {
+        gravity = accelData;
+        field = magData;
+        initialized = true;
+    } else {
+        float dt = delta_ms / 1000.0f;
+        float accelAlpha = dt / (accelTimeConstant + dt);
+        float magnAlpha = dt / (magnTimeConstant + dt);
+
+        for (int i = 0; i < 3; ++i) {
+            gravity[i] += accelAlpha * (accelData[i] - gravity[i]);
+            field[i] += magnAlpha * (magData[i] - field[i]);
+        }
+    }
+
+    /* East = field x Up is already tilt compensated */
+    upNorm = norm(gravity);
+    if (upNorm < minNormRatio * GRAVITY_EARTH) {
+        return -1;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        up[i] = gravity[i] / upNorm;
+    }
+
+    east = cross(field, up);
+    eastNorm = norm(east);
+    if (eastNorm < minNormRatio * LOCAL_EARTH_MAGNETIC_FIELD) {
+        return -1;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        east[i] /= eastNorm;
+    }
+
+    north = cross(up, east);
+
+    quaternionFromRows(east, north, up, quaternion);
+    valid = true;
 
     return 0;
 }
 
 const std::string& STMGeomagFusion::getLibVersion(void) const
 {
-    static const std::string libVersion("stm-geomag-fusion-lib-mock");
+    static const std::string libVersion("stm-geomag-fusion-ecompass");
 
     return libVersion;
 }
 
 int STMGeomagFusion::getQuaternion(std::array<float, 4> &data) const
 {
-    (void)data;
+    if (!valid) {
+        return -1;
+    }
+
+    data = quaternion;
+
+    return 0;
+}
+
+int STMGeomagFusion::getEulerAngles(std::array<float, 3> &data) const
+{
+    float x = quaternion[0], y = quaternion[1], z = quaternion[2], w = quaternion[3];
+    float azimuth;
+
+    if (!valid) {
+        return -1;
+    }
+
+    azimuth = std::atan2(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z)) * rad2deg;
+    if (azimuth < 0.0f) {
+        azimuth += 360.0f;
+    }
+
+    data[0] = azimuth;
+    data[1] = std::asin(std::fmax(-1.0f, std::fmin(1.0f, -2.0f * (y * z + w * x)))) * rad2deg;
+    data[2] = std::atan2(-2.0f * (x * z - w * y), 1.0f - 2.0f * (x * x + y * y)) * rad2deg;
+
+    return 0;
+}
+
+int STMGeomagFusion::getGravity(std::array<float, 3> &data) const
+{
+    float gravityNorm = norm(gravity);
+
+    if (!valid) {
+        return -1;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        data[i] = GRAVITY_EARTH * gravity[i] / gravityNorm;
+    }
+
+    return 0;
+}
+
+int STMGeomagFusion::getLinearAccel(std::array<float, 3> &data) const
+{
+    std::array<float, 3> g;
+
+    if (getGravity(g) < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        data[i] = lastAccel[i] - g[i];
+    }
 
     return 0;
 }
@@ -24,7 +24,14 @@
 #define LOCAL_EARTH_MAGNETIC_FIELD		(50.0f)
 #define DEG2RAD(deg)				(deg * M_PI / 180.0f)
 
+/*
+ * eCompass: orientation from accelerometer and magnetometer only.
+ * Gravity and magnetic field are smoothed by first order low-pass filters
+ * (time constants in seconds, so the response does not depend on the data
+ * rate) and the tilt-compensated East-North-Up frame is built from them.
+ */
 struct STMGeomagFusion {
+    /* shared filter state, for callers not owning a fusion object */
     static STMGeomagFusion& getInstance(void);
     STMGeomagFusion(const STMGeomagFusion &) = delete;
     STMGeomagFusion(STMGeomagFusion &&) = delete;
@@ -33,19 +40,49 @@ struct STMGeomagFusion {
     STMGeomagFusion(void) = default;
     ~STMGeomagFusion(void) = default;
 
+    /**
+     * init: reset the filter
+     * @freq: expected data rate [Hz], used when no time delta is available.
+     * Return value: 0 on success, else a negative error code.
+     */
     int init(float freq);
 
+    /**
+     * run: process one sample
+     * @accelData: accelerometer data [m/s^2].
+     * @magData: magnetometer data [uT].
+     * @delta_ms: time since the previous sample [ms], <= 0 if unknown.
+     * Return value: 0 on success, -1 if the sample gives no heading
+     *               (free fall, field parallel to gravity).
+     */
     int run(const std::array<float, 3> &accelData,
             const std::array<float, 3> &magData,
-            int64_t delay);
+            float delta_ms);
 
+    /* rotation vector, Android format { x, y, z, w } in East-North-Up frame */
     int getQuaternion(std::array<float, 4> &data) const;
 
+    /* azimuth, pitch and roll [deg] */
     int getEulerAngles(std::array<float, 3> &data) const;
 
+    /* gravity in sensor frame [m/s^2] */
     int getGravity(std::array<float, 3> &data) const;
 
+    /* last accelerometer sample without gravity [m/s^2] */
     int getLinearAccel(std::array<float, 3> &data) const;
 
     const std::string& getLibVersion(void) const;
+
+    /* low-pass time constants [s] */
+    static constexpr float accelTimeConstant = 0.1f;
+    static constexpr float magnTimeConstant = 0.25f;
+
+private:
+    std::array<float, 3> gravity { { 0.0f, 0.0f, 0.0f } };
+    std::array<float, 3> field { { 0.0f, 0.0f, 0.0f } };
+    std::array<float, 3> lastAccel { { 0.0f, 0.0f, 0.0f } };
+    std::array<float, 4> quaternion { { 0.0f, 0.0f, 0.0f, 1.0f } };
+    float defaultDeltaMs = 10.0f;
+    bool valid = false;
+    bool initialized = false;
 };
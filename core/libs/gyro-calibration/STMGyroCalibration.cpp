@@ -15,12 +15,30 @@
  * limitations under the License.
  */
 
+#include <cmath>
+
 #include "STMGyroCalibration.h"
 #include <Utils.h>
 
 static const int minFrequencyHz = 1;
 static const int maxFrequencyHz = 200;
 
+/* stillness window, and default thresholds (scaled by init() arguments) */
+static const int64_t windowDurationNs = 1000000000LL;
+static const unsigned int minWindowSamples = 10;
+static const float accelStillStd = 0.05f;
+static const float gyroStillStd = 0.01f;
+
+/* max bias [rad/s], and max distance from bias of gyroscope only windows */
+static const float maxBias = 0.2f;
+static const float gyroOnlyTolerance = 0.01f;
+
+/* bias tracking time constant, confidence gain and decay time constant */
+static const float biasTau = 10.0f;
+static const float confidenceGain = 0.3f;
+static const float confidenceTau = 600.0f;
+static const float convergedConfidence = 0.9f;
+
 STMGyroCalibration& STMGyroCalibration::getInstance(void)
 {
     static STMGyroCalibration *gyroCalib = new STMGyroCalibration();
@@ -28,10 +46,24 @@ STMGyroCalibration& STMGyroCalibration::getInstance(void)
 }
 
 STMGyroCalibration::STMGyroCalibration(void)
-    : lastTimestamp(1)
+    : lastTimestamp(1),
+      accelVarianceThreshold(accelStillStd * accelStillStd),
+      gyroVarianceThreshold(gyroStillStd * gyroStillStd),
+      gyroRange(0.0f)
 {
+    resetBiasMatrix(outBias);
+    reset(outBias);
 }
 
+/**
+ * init: setup stillness detection
+ * @accelThreshold: scale of the accelerometer stillness threshold (1 = default).
+ * @gyroThreshold: scale of the gyroscope stillness threshold (1 = default).
+ * @accelRange: accelerometer full scale [m/s^2].
+ * @gyroRange: gyroscope full scale [rad/s].
+ *
+ * Return value: 0 on success, else a negative error code.
+ */
 int STMGyroCalibration::init(float accelThreshold,
                              float gyroThreshold,
                              float accelRange,
@@ -42,6 +74,10 @@ int STMGyroCalibration::init(float accelThreshold,
         return -1;
     }
 
+    accelVarianceThreshold = accelStillStd * accelStillStd * accelThreshold * accelThreshold;
+    gyroVarianceThreshold = gyroStillStd * gyroStillStd * gyroThreshold * gyroThreshold;
+    this->gyroRange = gyroRange;
+
     return 0;
 }
 
@@ -49,6 +85,18 @@ int STMGyroCalibration::reset(const Matrix<4, 3, float> &initialBias)
 {
     outBias = initialBias;
     lastTimestamp = 1;
+    windowCount = 0;
+
+    /* a stored bias is a good starting point, but temperature may have changed */
+    if ((initialBias[3][0] != 0.0f) || (initialBias[3][1] != 0.0f) || (initialBias[3][2] != 0.0f)) {
+        confidence = 0.5f;
+    } else {
+        confidence = 0.0f;
+    }
+
+    firstTimestamp = 0;
+    lastStillTimestamp = 0;
+    convergedTimestamp = 0;
 
     return 0;
 }
@@ -63,17 +111,189 @@ int STMGyroCalibration::setFrequency(int frequencyHz)
     return 0;
 }
 
+/*
+ * endWindow: close current window, a still window updates the bias
+ */
+void STMGyroCalibration::endWindow(void)
+{
+    const unsigned int count = windowCount;
+    const bool withAccel = windowAccelCount == count;
+    std::array<float, 3> mean;
+    float alpha, distance = 0.0f;
+
+    windowCount = 0;
+
+    for (int i = 0; i < 3; ++i) {
+        float avg = gyroSum[i] / count;
+
+        if (gyroSumSq[i] / count - avg * avg > gyroVarianceThreshold) {
+            return;
+        }
+
+        mean[i] = gyroRef[i] + avg;
+        if (std::fabs(mean[i]) > maxBias) {
+            return;
+        }
+
+        distance = std::fmax(distance, std::fabs(mean[i] - outBias[3][i]));
+    }
+
+    if (withAccel) {
+        for (int i = 0; i < 3; ++i) {
+            float avg = accelSum[i] / count;
+
+            if (accelSumSq[i] / count - avg * avg > accelVarianceThreshold) {
+                return;
+            }
+        }
+    } else if ((confidence < convergedConfidence) || (distance > gyroOnlyTolerance)) {
+        return;
+    }
+
+    /* low confidence estimates are replaced quickly */
+    confidence = getConfidence();
+    alpha = std::fmax(1.0f - std::exp(-(lastTimestamp - windowStart) * 1e-9f / biasTau),
+                      1.0f - confidence);
+
+    for (int i = 0; i < 3; ++i) {
+        outBias[3][i] += alpha * (mean[i] - outBias[3][i]);
+    }
+
+    /* a still window far from the estimate means the bias moved */
+    if (withAccel && (distance > gyroOnlyTolerance)) {
+        confidence *= 0.5f;
+    }
+    confidence += confidenceGain * (1.0f - confidence);
+    lastStillTimestamp = lastTimestamp;
+
+    if ((convergedTimestamp == 0) && (confidence >= convergedConfidence)) {
+        convergedTimestamp = lastTimestamp;
+    }
+}
+
+/*
+ * startWindow: open a new window at its first sample
+ */
+void STMGyroCalibration::startWindow(const std::array<float, 3> *accelData,
+                                     const std::array<float, 3> &gyroData,
+                                     int64_t timestamp)
+{
+    windowStart = timestamp;
+    windowAccelCount = 0;
+    gyroRef = gyroData;
+    gyroSum = { 0.0f, 0.0f, 0.0f };
+    gyroSumSq = { 0.0f, 0.0f, 0.0f };
+    accelSum = { 0.0f, 0.0f, 0.0f };
+    accelSumSq = { 0.0f, 0.0f, 0.0f };
+
+    if (accelData != nullptr) {
+        accelRef = *accelData;
+    }
+}
+
+/*
+ * addSamples: add samples to the open window until it ends or a sample is
+ *             not in timestamp order, window sums are kept in locals
+ *
+ * Return value: number of samples added.
+ */
+size_t STMGyroCalibration::addSamples(const std::array<float, 3> *accelData,
+                                      const std::array<float, 3> *gyroData,
+                                      const int64_t *timestamp,
+                                      size_t count)
+{
+    const std::array<float, 3> gRef = gyroRef, aRef = accelRef;
+    std::array<float, 3> gSum = gyroSum, gSumSq = gyroSumSq;
+    std::array<float, 3> aSum = accelSum, aSumSq = accelSumSq;
+    unsigned int samples = windowCount, accelSamples = windowAccelCount;
+    int64_t prevTimestamp = lastTimestamp;
+    bool windowEnded = false;
+    size_t n;
+
+    for (n = 0; (n < count) && !windowEnded; ++n) {
+        if (timestamp[n] <= prevTimestamp) {
+            break;
+        }
+
+        prevTimestamp = timestamp[n];
+
+        if ((accelData != nullptr) && (accelSamples == samples)) {
+            for (int i = 0; i < 3; ++i) {
+                float d = accelData[n][i] - aRef[i];
+
+                aSum[i] += d;
+                aSumSq[i] += d * d;
+            }
+            accelSamples++;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            float d = gyroData[n][i] - gRef[i];
+
+            gSum[i] += d;
+            gSumSq[i] += d * d;
+        }
+        samples++;
+
+        windowEnded = (timestamp[n] - windowStart >= windowDurationNs) &&
+                      (samples >= minWindowSamples);
+    }
+
+    gyroSum = gSum;
+    gyroSumSq = gSumSq;
+    accelSum = aSum;
+    accelSumSq = aSumSq;
+    windowCount = samples;
+    windowAccelCount = accelSamples;
+    lastTimestamp = prevTimestamp;
+
+    if (windowEnded) {
+        endWindow();
+    }
+
+    return n;
+}
+
 int STMGyroCalibration::run(const std::array<float, 3> &accelData,
                             const std::array<float, 3> &gyroData,
                             int64_t timestamp)
 {
-    if (timestamp <= lastTimestamp) return -1;
+    return run(&accelData, &gyroData, &timestamp, 1);
+}
 
-    (void) accelData;
-    (void) gyroData;
-    lastTimestamp = timestamp;
+int STMGyroCalibration::run(const std::array<float, 3> &gyroData, int64_t timestamp)
+{
+    return run(nullptr, &gyroData, &timestamp, 1);
+}
 
-    return 0;
+int STMGyroCalibration::run(const std::array<float, 3> *accelData,
+                            const std::array<float, 3> *gyroData,
+                            const int64_t *timestamp,
+                            size_t count)
+{
+    int ret = 0;
+    size_t n = 0;
+
+    while (n < count) {
+        if (timestamp[n] <= lastTimestamp) {
+            ret = -1;
+            n++;
+            continue;
+        }
+
+        if (firstTimestamp == 0) {
+            firstTimestamp = timestamp[n];
+        }
+
+        if (windowCount == 0) {
+            startWindow((accelData != nullptr) ? &accelData[n] : nullptr, gyroData[n], timestamp[n]);
+        }
+
+        n += addSamples((accelData != nullptr) ? &accelData[n] : nullptr,
+                        &gyroData[n], &timestamp[n], count - n);
+    }
+
+    return ret;
 }
 
 int STMGyroCalibration::getBias(Matrix<4, 3, float> &bias) const
@@ -83,9 +303,38 @@ int STMGyroCalibration::getBias(Matrix<4, 3, float> &bias) const
     return 0;
 }
 
+/**
+ * getConfidence: confidence in the bias estimate, it grows with each still
+ *                window and decays while the device is not still
+ *
+ * Return value: confidence in [0, 1].
+ */
+float STMGyroCalibration::getConfidence(void) const
+{
+    if (lastStillTimestamp == 0) {
+        return confidence;
+    }
+
+    return confidence * std::exp(-(lastTimestamp - lastStillTimestamp) * 1e-9f / confidenceTau);
+}
+
+/**
+ * getConvergenceTime: time from first sample to converged bias estimate
+ *
+ * Return value: time [ns], -1 if not converged yet.
+ */
+int64_t STMGyroCalibration::getConvergenceTime(void) const
+{
+    if (convergedTimestamp == 0) {
+        return -1;
+    }
+
+    return convergedTimestamp - firstTimestamp;
+}
+
 const std::string& STMGyroCalibration::getLibVersion(void) const
 {
-    static const std::string libVersion("stm-gyro-lib-mock");
+    static const std::string libVersion("stm-gyro-calibration-stillness");
 
     return libVersion;
 }
@@ -21,7 +21,21 @@
 #include <string>
 #include <Matrix.h>
 
+/*
+ * Gyroscope bias estimation.
+ *
+ * Samples are grouped in windows of about 1s, accumulated as running sums
+ * (mean and variance per axis, no window re-scan). A window where both
+ * accelerometer and gyroscope variances are below the stillness thresholds
+ * measures the gyroscope bias, which is tracked with an exponential filter.
+ *
+ * Once the bias is known with enough confidence, gyroscope only windows are
+ * accepted as well: besides low variance their mean must be close to the
+ * current bias, which rejects slow constant rotations.
+ */
 struct STMGyroCalibration {
+    STMGyroCalibration(void);
+    /* shared bias state, for callers not owning a calibration object */
     static STMGyroCalibration& getInstance(void);
     ~STMGyroCalibration(void) = default;
     STMGyroCalibration(const STMGyroCalibration &) = delete;
@@ -42,8 +56,21 @@ struct STMGyroCalibration {
             const std::array<float, 3> &gyroData,
             int64_t timestamp);
 
+    /* gyroscope only, see getConfidence() */
+    int run(const std::array<float, 3> &gyroData, int64_t timestamp);
+
+    /* batch version, accel and gyro samples are time aligned, accelData can be nullptr */
+    int run(const std::array<float, 3> *accelData,
+            const std::array<float, 3> *gyroData,
+            const int64_t *timestamp,
+            size_t count);
+
     int getBias(Matrix<4, 3, float> &bias) const;
 
+    float getConfidence(void) const;
+
+    int64_t getConvergenceTime(void) const;
+
     const std::string& getLibVersion(void) const;
 
     static void resetBiasMatrix(Matrix<4, 3, float> &bias);
@@ -56,5 +83,32 @@ private:
     Matrix<4, 3, float> outBias;
     int64_t lastTimestamp;
 
-    STMGyroCalibration(void);
+    float accelVarianceThreshold;
+    float gyroVarianceThreshold;
+    float gyroRange;
+
+    /* current window, accumulated as deviation from its first sample */
+    int64_t windowStart;
+    unsigned int windowCount;
+    unsigned int windowAccelCount;
+    std::array<float, 3> accelRef;
+    std::array<float, 3> accelSum;
+    std::array<float, 3> accelSumSq;
+    std::array<float, 3> gyroRef;
+    std::array<float, 3> gyroSum;
+    std::array<float, 3> gyroSumSq;
+
+    float confidence;
+    int64_t firstTimestamp;
+    int64_t lastStillTimestamp;
+    int64_t convergedTimestamp;
+
+    void startWindow(const std::array<float, 3> *accelData,
+                     const std::array<float, 3> &gyroData,
+                     int64_t timestamp);
+    size_t addSamples(const std::array<float, 3> *accelData,
+                      const std::array<float, 3> *gyroData,
+                      const int64_t *timestamp,
+                      size_t count);
+    void endWindow(void);
 };
@@ -15,6 +15,10 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #include "STMGyroTempCalibration.h"
 
 STMGyroTempCalibration& STMGyroTempCalibration::getInstance(void)
@@ -24,56 +28,195 @@ STMGyroTempCalibration& STMGyroTempCalibration::getInstance(void)
 }
 
 STMGyroTempCalibration::STMGyroTempCalibration(void)
+{
+    initialize();
+}
+
+STMGyroTempCalibration::~STMGyroTempCalibration(void)
 {
 }
 
+/* bin weight is capped so that the table keeps following slow aging */
+static const float maxBinWeight = 64.0f;
+/* weight needed before a bin is used for prediction (seconds at 1Hz) */
+static const float minBinWeight = 4.0f;
+/* fixed point resolution of the saved bias [rad/s] and temperature [Celsius] */
+static const float stateBiasScale = 1e-5f;
+static const float stateTempScale = 1.0f / 16.0f;
+static const uint8_t stateVersion = 1;
+
+/* serialized state, must fit STMGyroTempCalibrationStateSize bytes */
+struct GyroTempState {
+    uint8_t version;
+    uint8_t validMask;
+    int8_t tempMin;
+    uint8_t tempStep;
+    int16_t bias[STMGyroTempCalibration::tableSize][3];
+    /* bin mean temperature, from the bin lower bound */
+    uint8_t temp[STMGyroTempCalibration::tableSize];
+};
+
+static_assert(sizeof(GyroTempState) <= STMGyroTempCalibration::STMGyroTempCalibrationStateSize,
+              "gyro temperature state does not fit the saved state size");
+
 int STMGyroTempCalibration::initialize(void)
 {
-    outBias = { 0 };
-    bias_update = 0;
+    tempMin = tableTempMin;
+    tempStep = tableTempStep;
+    lastUpdateTime = 0;
+
+    for (int k = 0; k < tableSize; ++k) {
+        tableBias[k] = { 0.0f, 0.0f, 0.0f };
+        tableTemp[k] = tempMin + (k + 0.5f) * tempStep;
+        tableWeight[k] = 0.0f;
+    }
 
     return 0;
 }
 
+bool STMGyroTempCalibration::isValid(int bin) const
+{
+    return tableWeight[bin] >= minBinWeight;
+}
+
 int STMGyroTempCalibration::run(std::array<float, 3> &gyroData,
                                 float temperature,
                                 uint64_t timestamp,
                                 int *b_update)
 {
-    (void) gyroData;
-    (void) temperature;
+    float gain;
+    int bin;
+
+    if (!std::isfinite(temperature) || (timestamp <= lastUpdateTime)) {
+        return -1;
+    }
 
     lastUpdateTime = timestamp;
-    *b_update = bias_update;
+
+    bin = (int)std::floor((temperature - tempMin) / tempStep);
+    bin = std::min(std::max(bin, 0), tableSize - 1);
+
+    tableWeight[bin] = std::min(tableWeight[bin] + 1.0f, maxBinWeight);
+    gain = 1.0f / tableWeight[bin];
+
+    tableTemp[bin] += gain * (temperature - tableTemp[bin]);
+    for (int i = 0; i < 3; ++i) {
+        tableBias[bin][i] += gain * (gyroData[i] - tableBias[bin][i]);
+    }
+
+    if (b_update != nullptr) {
+        std::array<float, 3> bias;
+
+        *b_update = getBias(&temperature, bias) == 0;
+    }
 
     return 0;
 }
 
 int STMGyroTempCalibration::getBias(float *temp, std::array<float, 3> &bias)
 {
-    (void)temp;
-    bias = outBias;
+    int lo = -1, hi = -1;
+
+    /* closest learned bins below and above the temperature, bins do not
+     * overlap so their mean temperatures are sorted */
+    for (int k = 0; k < tableSize; ++k) {
+        if (!isValid(k)) {
+            continue;
+        }
+
+        if (tableTemp[k] <= *temp) {
+            lo = k;
+        } else if (hi < 0) {
+            hi = k;
+        }
+    }
+
+    if ((lo < 0) && (hi < 0)) {
+        return -1;
+    }
+
+    if ((lo < 0) || (hi < 0)) {
+        /* out of the learned range: hold the closest bin */
+        bias = tableBias[lo < 0 ? hi : lo];
+    } else {
+        float frac = (*temp - tableTemp[lo]) / (tableTemp[hi] - tableTemp[lo]);
+
+        for (int i = 0; i < 3; ++i) {
+            bias[i] = tableBias[lo][i] + frac * (tableBias[hi][i] - tableBias[lo][i]);
+        }
+    }
 
     return 0;
 }
 
-int STMGyroTempCalibration::getState(void *state)
+int STMGyroTempCalibration::getState(void *state) const
 {
-  (void)state;
+    GyroTempState out;
 
-  return 0;
+    memset(&out, 0, sizeof(out));
+    out.version = stateVersion;
+    out.tempMin = (int8_t)tempMin;
+    out.tempStep = (uint8_t)tempStep;
+
+    for (int k = 0; k < tableSize; ++k) {
+        float offset;
+
+        if (!isValid(k)) {
+            continue;
+        }
+
+        out.validMask |= 1 << k;
+        for (int i = 0; i < 3; ++i) {
+            float value = std::round(tableBias[k][i] / stateBiasScale);
+
+            value = std::min(std::max(value, (float)INT16_MIN), (float)INT16_MAX);
+            out.bias[k][i] = (int16_t)value;
+        }
+
+        offset = std::round((tableTemp[k] - (tempMin + k * tempStep)) / stateTempScale);
+        out.temp[k] = (uint8_t)std::min(std::max(offset, 0.0f), (float)UINT8_MAX);
+    }
+
+    memset(state, 0, STMGyroTempCalibrationStateSize);
+    memcpy(state, &out, sizeof(out));
+
+    return 0;
 }
 
 int STMGyroTempCalibration::setState(void *state)
 {
-  (void)state;
+    GyroTempState in;
+
+    initialize();
+
+    memcpy(&in, state, sizeof(in));
+    if ((in.version != stateVersion) || (in.tempStep == 0)) {
+        return -1;
+    }
+
+    tempMin = in.tempMin;
+    tempStep = in.tempStep;
 
-  return 0;
+    /* restored bins count as just learned, new samples refine them quickly */
+    for (int k = 0; k < tableSize; ++k) {
+        if (!(in.validMask & (1 << k))) {
+            tableTemp[k] = tempMin + (k + 0.5f) * tempStep;
+            continue;
+        }
+
+        tableWeight[k] = minBinWeight;
+        tableTemp[k] = tempMin + k * tempStep + in.temp[k] * stateTempScale;
+        for (int i = 0; i < 3; ++i) {
+            tableBias[k][i] = in.bias[k][i] * stateBiasScale;
+        }
+    }
+
+    return 0;
 }
 
 const std::string& STMGyroTempCalibration::getLibVersion(void)
 {
-    static const std::string libVersion("stm-motion-gt-lib-mock");
+    static const std::string libVersion("stm-gyro-temperature-calibration-table");
 
     return libVersion;
 }
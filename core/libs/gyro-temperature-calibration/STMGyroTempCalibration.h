@@ -18,9 +18,19 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <string>
 
+/*
+ * Gyroscope bias versus temperature model: the bias estimated by the gyro
+ * calibration is learned into a table of temperature bins (incremental
+ * average of temperature and bias of the samples falling in each bin) and
+ * predicted by linear interpolation between the learned bins, so that it can
+ * follow temperature changes before the gyro calibration re-converges.
+ */
 struct STMGyroTempCalibration {
+    STMGyroTempCalibration(void);
+    /* shared temperature table, for callers not owning a model */
     static STMGyroTempCalibration& getInstance(void);
     ~STMGyroTempCalibration(void);
     STMGyroTempCalibration(const STMGyroTempCalibration &) = delete;
@@ -30,19 +40,46 @@ struct STMGyroTempCalibration {
 
     int initialize(void);
 
+    /**
+     * run: learn the gyroscope bias at the given temperature
+     * @gyroData: bias estimated by the gyro calibration [rad/s].
+     * @temperature: sensor temperature [Celsius].
+     * @timestamp: timestamp of the estimate [ns].
+     * @b_update: set to 1 when the model can predict the bias.
+     * Return value: 0 on success, else a negative error code.
+     */
     int run(std::array<float, 3> &gyroData,
             float temperature,
             uint64_t timestamp,
             int *b_update);
+
+    /**
+     * getBias: predict the gyroscope bias at a given temperature
+     * @temp: temperature [Celsius].
+     * @bias: predicted bias [rad/s].
+     * Return value: 0 on success, -1 if nothing has been learned yet.
+     */
     int getBias(float *temp, std::array<float, 3> &bias);
-    int getState(void *state);
+
+    /* state is STMGyroTempCalibrationStateSize bytes: header and fixed
+     * point temperature and bias of the learned bins */
+    int getState(void *state) const;
     int setState(void *state);
     const std::string& getLibVersion(void);
     static const int STMGyroTempCalibrationStateSize = 40;
 
+    /* bin k covers tableTempMin + [k, k + 1) * tableTempStep [Celsius] */
+    static const int tableSize = 5;
+    static const int tableTempMin = -20;
+    static const int tableTempStep = 16;
+
 private:
-    std::array<float, 3> outBias;
-    int bias_update;
+    std::array<std::array<float, 3>, tableSize> tableBias;
+    std::array<float, tableSize> tableTemp;
+    std::array<float, tableSize> tableWeight;
+    float tempMin;
+    float tempStep;
     uint64_t lastUpdateTime;
-    STMGyroTempCalibration(void);
+
+    bool isValid(int bin) const;
 };
@@ -15,11 +15,91 @@
  * limitations under the License.
  */
 
+#include <cmath>
+
 #include "STMMagnCalibration.h"
 
 static const int minFrequencyHz = 17;
 static const int maxFrequencyHz = 100;
 
+/* fits are computed in units of typical earth field, for conditioning */
+static const float fitScale = 1.0f / 50.0f;
+static const float minFieldUt = 15.0f;
+static const float maxFieldUt = 100.0f;
+
+/* reservoir coverage needed by sphere fit and by ellipsoid fit */
+static const int minSphereBins = 12;
+static const int minMediumBins = 24;
+static const int minEllipsoidBins = 36;
+
+/* soft-iron is expected to be mild, larger distortions are rejected */
+static const float maxAxesRatio = 1.5f;
+
+/* relative rms of the reservoir radii mapped to accuracy levels */
+static const float highResidual = 0.03f;
+static const float mediumResidual = 0.06f;
+static const float lowResidual = 0.15f;
+
+/* relative field magnitude change reported as magnetic disturbance */
+static const float disturbanceThreshold = 0.25f;
+
+/*
+ * symmetricEigen3: eigen decomposition of a symmetric 3x3 matrix (Jacobi),
+ *                  m = v * diag(eig) * v^T, eigenvectors are columns of v
+ */
+static void symmetricEigen3(std::array<std::array<double, 3>, 3> m,
+                            std::array<double, 3> &eig,
+                            std::array<std::array<double, 3>, 3> &v)
+{
+    v = {{ { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } }};
+
+    for (int sweep = 0; sweep < 16; ++sweep) {
+        double off = m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+
+        if (off < 1e-24) {
+            break;
+        }
+
+        for (int p = 0; p < 2; ++p) {
+            for (int q = p + 1; q < 3; ++q) {
+                double theta, t, c, s;
+
+                if (m[p][q] == 0.0) {
+                    continue;
+                }
+
+                theta = (m[q][q] - m[p][p]) / (2.0 * m[p][q]);
+                t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                c = 1.0 / std::sqrt(t * t + 1.0);
+                s = t * c;
+
+                for (int k = 0; k < 3; ++k) {
+                    double mkp = m[k][p], mkq = m[k][q];
+
+                    m[k][p] = c * mkp - s * mkq;
+                    m[k][q] = s * mkp + c * mkq;
+                }
+
+                for (int k = 0; k < 3; ++k) {
+                    double mpk = m[p][k], mqk = m[q][k];
+
+                    m[p][k] = c * mpk - s * mqk;
+                    m[q][k] = s * mpk + c * mqk;
+                }
+
+                for (int k = 0; k < 3; ++k) {
+                    double vkp = v[k][p], vkq = v[k][q];
+
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    eig = { m[0][0], m[1][1], m[2][2] };
+}
+
 STMMagnCalibration& STMMagnCalibration::getInstance(void)
 {
     static STMMagnCalibration *magnCalib = new STMMagnCalibration();
@@ -27,14 +107,20 @@ STMMagnCalibration& STMMagnCalibration::getInstance(void)
 }
 
 STMMagnCalibration::STMMagnCalibration(void)
-    : lastTimestamp(1)
+    : lastTimestamp(1),
+      magnRange(0.0f),
+      frequencyHz(minFrequencyHz)
 {
+    resetBiasMatrix(outBias);
+    reset(outBias);
 }
 
 int STMMagnCalibration::init(float magnRange)
 {
     if (magnRange < 1.0f) return -1;
 
+    this->magnRange = magnRange;
+
     return 0;
 }
 
@@ -43,6 +129,18 @@ int STMMagnCalibration::reset(const Matrix<4, 3, float> &initialBias)
     outBias = initialBias;
     lastTimestamp = 1;
 
+    /* a stored calibration is usable, but not verified yet */
+    center = { initialBias[3][0], initialBias[3][1], initialBias[3][2] };
+    centerValid = (center[0] != 0.0f) || (center[1] != 0.0f) || (center[2] != 0.0f);
+    accuracy = centerValid ? LOW : UNRELIABLE;
+    fitAccuracy = accuracy;
+    fieldRadius = 0.0f;
+
+    rawMin = { INFINITY, INFINITY, INFINITY };
+    rawMax = { -INFINITY, -INFINITY, -INFINITY };
+    fitOrigin = center;
+    clearReservoir();
+
     return 0;
 }
 
@@ -53,18 +151,468 @@ int STMMagnCalibration::setFrequency(int frequencyHz)
         return -1;
     }
 
+    this->frequencyHz = frequencyHz;
+
     return 0;
 }
 
+void STMMagnCalibration::clearReservoir(void)
+{
+    binUsed.fill(false);
+    binsCount = 0;
+    samplesSinceFit = 0;
+    binsChanged = false;
+
+    for (auto &row : sphereAtA) {
+        row.fill(0.0);
+    }
+    sphereAtb.fill(0.0);
+
+    for (auto &row : ellipsoidAtA) {
+        row.fill(0.0);
+    }
+    ellipsoidAtb.fill(0.0);
+}
+
+/*
+ * binIndex: direction bin of a sample around current center,
+ *           cube map with binsPerSide x binsPerSide bins per face
+ *
+ * Return value: bin index, -1 if the direction is undefined.
+ */
+int STMMagnCalibration::binIndex(const std::array<float, 3> &sample) const
+{
+    std::array<float, 3> d;
+    int axis = 0, face, u, v;
+
+    for (int i = 0; i < 3; ++i) {
+        d[i] = sample[i] - center[i];
+        if (std::fabs(d[i]) > std::fabs(d[axis])) {
+            axis = i;
+        }
+    }
+
+    if (std::fabs(d[axis]) < 1e-3f) {
+        return -1;
+    }
+
+    face = 2 * axis + (d[axis] < 0.0f ? 1 : 0);
+    u = (int)((d[(axis + 1) % 3] / std::fabs(d[axis]) + 1.0f) * 0.5f * binsPerSide);
+    v = (int)((d[(axis + 2) % 3] / std::fabs(d[axis]) + 1.0f) * 0.5f * binsPerSide);
+    u = u < binsPerSide ? u : binsPerSide - 1;
+    v = v < binsPerSide ? v : binsPerSide - 1;
+
+    return (face * binsPerSide + u) * binsPerSide + v;
+}
+
+/*
+ * accumulate: add (weight = 1) or remove (weight = -1) a sample
+ *             from the normal equations of both fits
+ */
+void STMMagnCalibration::accumulate(const std::array<float, 3> &sample, double weight)
+{
+    const double x = (sample[0] - fitOrigin[0]) * fitScale;
+    const double y = (sample[1] - fitOrigin[1]) * fitScale;
+    const double z = (sample[2] - fitOrigin[2]) * fitScale;
+    const std::array<double, sphereTerms> sphere = { x, y, z, 1.0 };
+    const std::array<double, ellipsoidTerms> ellipsoid = {
+        x * x, y * y, z * z, 2.0 * x * y, 2.0 * x * z, 2.0 * y * z, 2.0 * x, 2.0 * y, 2.0 * z
+    };
+    const double r2 = x * x + y * y + z * z;
+
+    /* sphere: |p|^2 = 2 * c . p + k */
+    for (int i = 0; i < sphereTerms; ++i) {
+        for (int j = i; j < sphereTerms; ++j) {
+            sphereAtA[i][j] += weight * sphere[i] * sphere[j];
+        }
+        sphereAtb[i] += weight * sphere[i] * r2;
+    }
+
+    /* ellipsoid: p^T * A * p + 2 * v . p = 1 */
+    for (int i = 0; i < ellipsoidTerms; ++i) {
+        for (int j = i; j < ellipsoidTerms; ++j) {
+            ellipsoidAtA[i][j] += weight * ellipsoid[i] * ellipsoid[j];
+        }
+        ellipsoidAtb[i] += weight * ellipsoid[i];
+    }
+}
+
+void STMMagnCalibration::insertSample(const std::array<float, 3> &sample)
+{
+    int bin = binIndex(sample);
+
+    if (bin < 0) {
+        return;
+    }
+
+    if (binUsed[bin]) {
+        accumulate(binSamples[bin], -1.0);
+    } else {
+        binUsed[bin] = true;
+        binsCount++;
+    }
+
+    binSamples[bin] = sample;
+    accumulate(sample, 1.0);
+    binsChanged = true;
+}
+
+/*
+ * rebin: distribute the reservoir again around a new center,
+ *        samples falling in the same bin are dropped but the newest
+ */
+void STMMagnCalibration::rebin(void)
+{
+    std::array<std::array<float, 3>, numBins> samples;
+    int count = 0;
+
+    for (int i = 0; i < numBins; ++i) {
+        if (binUsed[i]) {
+            samples[count++] = binSamples[i];
+        }
+    }
+
+    fitOrigin = center;
+    clearReservoir();
+
+    for (int i = 0; i < count; ++i) {
+        insertSample(samples[i]);
+    }
+}
+
+int STMMagnCalibration::fitSphere(std::array<float, 3> &offset, float &radius) const
+{
+    std::array<std::array<double, sphereTerms>, sphereTerms> a;
+    std::array<double, sphereTerms> b = sphereAtb, p;
+    double r2;
+
+    for (int i = 0; i < sphereTerms; ++i) {
+        for (int j = 0; j < sphereTerms; ++j) {
+            a[i][j] = i <= j ? sphereAtA[i][j] : sphereAtA[j][i];
+        }
+    }
+
+    if (solveLinearSystem(a, b, p) < 0) {
+        return -1;
+    }
+
+    r2 = p[3] + 0.25 * (p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    if (r2 <= 0.0) {
+        return -1;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        offset[i] = fitOrigin[i] + 0.5 * p[i] / fitScale;
+    }
+    radius = std::sqrt(r2) / fitScale;
+
+    return 0;
+}
+
+int STMMagnCalibration::fitEllipsoid(std::array<float, 3> &offset,
+                                     std::array<std::array<float, 3>, 3> &softIron,
+                                     float &radius) const
+{
+    std::array<std::array<double, ellipsoidTerms>, ellipsoidTerms> a;
+    std::array<double, ellipsoidTerms> b = ellipsoidAtb, p;
+    std::array<std::array<double, 3>, 3> m, inv, v;
+    std::array<double, 3> c, eig;
+    double det, s, axesProduct;
+
+    for (int i = 0; i < ellipsoidTerms; ++i) {
+        for (int j = 0; j < ellipsoidTerms; ++j) {
+            a[i][j] = i <= j ? ellipsoidAtA[i][j] : ellipsoidAtA[j][i];
+        }
+    }
+
+    if (solveLinearSystem(a, b, p) < 0) {
+        return -1;
+    }
+
+    m = {{ { p[0], p[3], p[4] }, { p[3], p[1], p[5] }, { p[4], p[5], p[2] } }};
+
+    det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+          m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+          m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    if (det == 0.0) {
+        return -1;
+    }
+
+    inv = {{ { (m[1][1] * m[2][2] - m[1][2] * m[2][1]) / det,
+               (m[0][2] * m[2][1] - m[0][1] * m[2][2]) / det,
+               (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / det },
+             { (m[1][2] * m[2][0] - m[1][0] * m[2][2]) / det,
+               (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / det,
+               (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / det },
+             { (m[1][0] * m[2][1] - m[1][1] * m[2][0]) / det,
+               (m[0][1] * m[2][0] - m[0][0] * m[2][1]) / det,
+               (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / det } }};
+
+    /* center c = -A^-1 * v, then (p - c)^T * (A / s) * (p - c) = 1 */
+    for (int i = 0; i < 3; ++i) {
+        c[i] = -(inv[i][0] * p[6] + inv[i][1] * p[7] + inv[i][2] * p[8]);
+    }
+
+    s = 1.0;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            s += c[i] * m[i][j] * c[j];
+        }
+    }
+
+    if (s <= 0.0) {
+        return -1;
+    }
+
+    for (auto &row : m) {
+        for (auto &value : row) {
+            value /= s;
+        }
+    }
+
+    symmetricEigen3(m, eig, v);
+
+    for (int i = 0; i < 3; ++i) {
+        if (eig[i] <= 0.0) {
+            return -1;
+        }
+    }
+
+    /* semi-axes are 1 / sqrt(eig) */
+    if (std::fmax(eig[0], std::fmax(eig[1], eig[2])) >
+        maxAxesRatio * maxAxesRatio * std::fmin(eig[0], std::fmin(eig[1], eig[2]))) {
+        return -1;
+    }
+
+    axesProduct = 1.0 / std::sqrt(eig[0] * eig[1] * eig[2]);
+    radius = std::cbrt(axesProduct) / fitScale;
+
+    /* softIron = radius * fitScale * (A / s)^1/2, unit determinant */
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            double sum = 0.0;
+
+            for (int k = 0; k < 3; ++k) {
+                sum += v[i][k] * std::sqrt(eig[k]) * v[j][k];
+            }
+            softIron[i][j] = radius * fitScale * sum;
+        }
+
+        offset[i] = fitOrigin[i] + c[i] / fitScale;
+    }
+
+    return 0;
+}
+
+/*
+ * updateFit: solve the fits on the current reservoir and publish the best
+ *            acceptable one, accuracy follows the residual of the fit
+ */
+void STMMagnCalibration::updateFit(void)
+{
+    std::array<std::array<float, 3>, 3> softIron = {{ { 1.0f, 0.0f, 0.0f },
+                                                      { 0.0f, 1.0f, 0.0f },
+                                                      { 0.0f, 0.0f, 1.0f } }};
+    std::array<bool, 6> faces = { false, false, false, false, false, false };
+    std::array<float, 3> offset;
+    float radius, residual = 0.0f;
+    bool allFaces = true;
+    int level;
+
+    samplesSinceFit = 0;
+    binsChanged = false;
+
+    if (binsCount < minSphereBins) {
+        return;
+    }
+
+    for (int i = 0; i < numBins; ++i) {
+        if (binUsed[i]) {
+            faces[i / (binsPerSide * binsPerSide)] = true;
+        }
+    }
+
+    for (auto face : faces) {
+        allFaces = allFaces && face;
+    }
+
+    /* ellipsoid needs samples all around, fall back to hard-iron only */
+    if ((binsCount < minEllipsoidBins) || !allFaces ||
+        (fitEllipsoid(offset, softIron, radius) < 0) ||
+        (radius < minFieldUt) || (radius > maxFieldUt)) {
+        softIron = {{ { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }};
+        if (fitSphere(offset, radius) < 0) {
+            return;
+        }
+    }
+
+    if ((radius < minFieldUt) || (radius > maxFieldUt)) {
+        return;
+    }
+
+    for (int i = 0; i < numBins; ++i) {
+        std::array<float, 3> d;
+        float norm = 0.0f;
+
+        if (!binUsed[i]) {
+            continue;
+        }
+
+        for (int j = 0; j < 3; ++j) {
+            d[j] = binSamples[i][j] - offset[j];
+        }
+
+        for (int j = 0; j < 3; ++j) {
+            float value = softIron[j][0] * d[0] + softIron[j][1] * d[1] + softIron[j][2] * d[2];
+
+            norm += value * value;
+        }
+
+        residual += (std::sqrt(norm) / radius - 1.0f) * (std::sqrt(norm) / radius - 1.0f);
+    }
+    residual = std::sqrt(residual / binsCount);
+
+    if ((residual <= highResidual) && (binsCount >= minEllipsoidBins)) {
+        level = HIGH;
+    } else if ((residual <= mediumResidual) && (binsCount >= minMediumBins)) {
+        level = MEDIUM;
+    } else if (residual <= lowResidual) {
+        level = LOW;
+    } else {
+        return;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            outBias[i][j] = softIron[i][j];
+        }
+        outBias[3][i] = offset[i];
+    }
+
+    fitAccuracy = level;
+    accuracy = level;
+    fieldRadius = radius;
+
+    /* keep bins centered on the field sphere */
+    if (std::sqrt((offset[0] - center[0]) * (offset[0] - center[0]) +
+                  (offset[1] - center[1]) * (offset[1] - center[1]) +
+                  (offset[2] - center[2]) * (offset[2] - center[2])) > 0.25f * radius) {
+        center = offset;
+        rebin();
+    } else {
+        center = offset;
+    }
+    centerValid = true;
+}
+
+/*
+ * addSamples: add samples until a fit is due or a sample is not in
+ *             timestamp order, fit results do not change meanwhile so that
+ *             saturation and disturbance limits are computed once
+ *
+ * Return value: number of samples added.
+ */
+size_t STMMagnCalibration::addSamples(const std::array<float, 3> *magnData,
+                                      const int64_t *timestamp,
+                                      size_t count)
+{
+    const Matrix<4, 3, float> bias = outBias;
+    const float saturation = (magnRange > 0.0f) ? 0.98f * magnRange : INFINITY;
+    const float minNorm = fieldRadius * fieldRadius *
+                          (1.0f - disturbanceThreshold) * (1.0f - disturbanceThreshold);
+    const float maxNorm = fieldRadius * fieldRadius *
+                          (1.0f + disturbanceThreshold) * (1.0f + disturbanceThreshold);
+    const int disturbedAccuracy = fitAccuracy < LOW ? fitAccuracy : LOW;
+    int64_t prevTimestamp = lastTimestamp;
+    bool fitDue = false;
+    size_t n;
+
+    for (n = 0; (n < count) && !fitDue; ++n) {
+        const std::array<float, 3> &sample = magnData[n];
+        bool saturated = false;
+
+        if (timestamp[n] <= prevTimestamp) {
+            break;
+        }
+
+        prevTimestamp = timestamp[n];
+
+        /* saturated samples are not on the field sphere */
+        for (int i = 0; i < 3; ++i) {
+            saturated |= std::fabs(sample[i]) >= saturation;
+        }
+
+        if (saturated) {
+            continue;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            rawMin[i] = std::fmin(rawMin[i], sample[i]);
+            rawMax[i] = std::fmax(rawMax[i], sample[i]);
+        }
+
+        /* before the first fit, bins are centered on the data bounding box */
+        if (!centerValid) {
+            for (int i = 0; i < 3; ++i) {
+                center[i] = 0.5f * (rawMin[i] + rawMax[i]);
+            }
+        }
+
+        insertSample(sample);
+
+        if (fieldRadius > 0.0f) {
+            std::array<float, 3> d;
+            float norm = 0.0f;
+
+            for (int i = 0; i < 3; ++i) {
+                d[i] = sample[i] - bias[3][i];
+            }
+
+            for (int i = 0; i < 3; ++i) {
+                float value = bias[i][0] * d[0] + bias[i][1] * d[1] + bias[i][2] * d[2];
+
+                norm += value * value;
+            }
+
+            accuracy = ((norm < minNorm) || (norm > maxNorm)) ? disturbedAccuracy : fitAccuracy;
+        }
+
+        fitDue = (++samplesSinceFit >= frequencyHz) && binsChanged;
+    }
+
+    lastTimestamp = prevTimestamp;
+
+    if (fitDue) {
+        updateFit();
+    }
+
+    return n;
+}
+
 int STMMagnCalibration::run(const std::array<float, 3> &magnData,
                             int64_t timestamp)
 {
-    if (timestamp <= lastTimestamp) return -1;
+    return run(&magnData, &timestamp, 1);
+}
 
-    (void) magnData;
-    lastTimestamp = timestamp;
+int STMMagnCalibration::run(const std::array<float, 3> *magnData,
+                            const int64_t *timestamp,
+                            size_t count)
+{
+    int ret = 0;
+    size_t n = 0;
 
-    return 0;
+    while (n < count) {
+        if (timestamp[n] <= lastTimestamp) {
+            ret = -1;
+            n++;
+            continue;
+        }
+
+        n += addSamples(&magnData[n], &timestamp[n], count - n);
+    }
+
+    return ret;
 }
 
 int STMMagnCalibration::getBias(Matrix<4, 3, float> &bias) const
@@ -74,9 +622,20 @@ int STMMagnCalibration::getBias(Matrix<4, 3, float> &bias) const
     return 0;
 }
 
+/**
+ * getAccuracy: calibration accuracy, lowered to LOW while the field
+ *              magnitude does not match the fitted one (disturbance)
+ *
+ * Return value: one of STMMagnCalibration::Accuracy levels.
+ */
+int STMMagnCalibration::getAccuracy(void) const
+{
+    return accuracy;
+}
+
 const std::string& STMMagnCalibration::getLibVersion(void) const
 {
-    static const std::string libVersion("stm-magn-lib-mock");
+    static const std::string libVersion("stm-magn-calibration-ellipsoid");
 
     return libVersion;
 }
@@ -22,7 +22,30 @@
 
 #include <Matrix.h>
 
+/*
+ * Hard-iron and soft-iron magnetometer calibration.
+ *
+ * Samples are kept in a fixed size reservoir, one per direction bin (cube map
+ * around the current center estimate), so that the fit is not biased toward
+ * orientations the device rests in. Each accepted sample updates the normal
+ * equations of a sphere fit and of an ellipsoid fit in O(1), replacing the
+ * contribution of the sample previously stored in the same bin. Both fits are
+ * solved about once per second.
+ *
+ * Bias matrix: rows 0-2 soft-iron correction (unit determinant), row 3
+ * hard-iron offset; calibrated = softIron * (raw - offset).
+ */
 struct STMMagnCalibration {
+    /* same values of the Android SENSOR_STATUS_* accuracy levels */
+    enum Accuracy : int {
+        UNRELIABLE = 0,
+        LOW = 1,
+        MEDIUM = 2,
+        HIGH = 3,
+    };
+
+    STMMagnCalibration(void);
+    /* shared calibration, the magnetometer module owns its own object */
     static STMMagnCalibration& getInstance(void);
     ~STMMagnCalibration(void) = default;
     STMMagnCalibration(const STMMagnCalibration &) = delete;
@@ -39,8 +62,15 @@ struct STMMagnCalibration {
     int run(const std::array<float, 3> &magnData,
             int64_t timestamp);
 
+    /* run on count samples, bias is updated at most once per second of data */
+    int run(const std::array<float, 3> *magnData,
+            const int64_t *timestamp,
+            size_t count);
+
     int getBias(Matrix<4, 3, float> &bias) const;
 
+    int getAccuracy(void) const;
+
     const std::string& getLibVersion(void) const;
 
     static void resetBiasMatrix(Matrix<4, 3, float> &bias);
@@ -50,8 +80,47 @@ struct STMMagnCalibration {
     static int getMaxFrequencyHz(void);
 
 private:
+    static constexpr int binsPerSide = 4;
+    static constexpr int numBins = 6 * binsPerSide * binsPerSide;
+    static constexpr int sphereTerms = 4;
+    static constexpr int ellipsoidTerms = 9;
+
     Matrix<4, 3, float> outBias;
     int64_t lastTimestamp;
+    float magnRange;
+    int frequencyHz;
+    int accuracy;
+    int fitAccuracy;
+    float fieldRadius;
 
-    STMMagnCalibration(void);
+    std::array<std::array<float, 3>, numBins> binSamples;
+    std::array<bool, numBins> binUsed;
+    int binsCount;
+    int samplesSinceFit;
+    bool binsChanged;
+    bool centerValid;
+    std::array<float, 3> center;
+    std::array<float, 3> fitOrigin;
+    std::array<float, 3> rawMin;
+    std::array<float, 3> rawMax;
+
+    /* normal equations (upper triangle only) of the reservoir samples */
+    std::array<std::array<double, sphereTerms>, sphereTerms> sphereAtA;
+    std::array<double, sphereTerms> sphereAtb;
+    std::array<std::array<double, ellipsoidTerms>, ellipsoidTerms> ellipsoidAtA;
+    std::array<double, ellipsoidTerms> ellipsoidAtb;
+
+    void clearReservoir(void);
+    int binIndex(const std::array<float, 3> &sample) const;
+    void accumulate(const std::array<float, 3> &sample, double weight);
+    void insertSample(const std::array<float, 3> &sample);
+    size_t addSamples(const std::array<float, 3> *magnData,
+                      const int64_t *timestamp,
+                      size_t count);
+    void rebin(void);
+    int fitSphere(std::array<float, 3> &offset, float &radius) const;
+    int fitEllipsoid(std::array<float, 3> &offset,
+                     std::array<std::array<float, 3>, 3> &softIron,
+                     float &radius) const;
+    void updateFit(void);
 };
@@ -33,6 +33,7 @@ LOCAL_CFLAGS += \
     -Wextra
 
 LOCAL_SRC_FILES := \
+    MadgwickFilter.cpp \
     STMSensorsFusion.cpp \
     STMSensorsFusion6Axis.cpp \
     STMSensorsFusion9Axis.cpp
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2021 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+
+#include "MadgwickFilter.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MADGWICK_HAVE_VECTOR_KERNEL 1
+typedef float v4sf __attribute__((vector_size(16)));
+#else /* __GNUC__ || __clang__ */
+#define MADGWICK_HAVE_VECTOR_KERNEL 0
+#endif /* __GNUC__ || __clang__ */
+
+static const float defaultBeta = 0.05f;
+
+/*
+ * madgwickResiduals: objective function of the gradient descent step
+ * @q: current orientation.
+ * @a: accelerometer data.
+ * @m: magnetometer data, can be nullptr.
+ * @f: residuals output (3 for accel only, 6 with magnetometer).
+ * @b: earth magnetic field reference { bx, bz } output.
+ *
+ * Return value: number of residuals, 0 if accel data are not usable.
+ */
+static int madgwickResiduals(const std::array<float, 4> &q,
+                             const float *a, const float *m,
+                             float f[6], float b[2])
+{
+    float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    float norm, ax, ay, az, mx, my, mz, hx, hy;
+
+    norm = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+    if (norm == 0.0f) {
+        return 0;
+    }
+
+    norm = 1.0f / std::sqrt(norm);
+    ax = a[0] * norm;
+    ay = a[1] * norm;
+    az = a[2] * norm;
+
+    f[0] = 2.0f * (q1 * q3 - q0 * q2) - ax;
+    f[1] = 2.0f * (q0 * q1 + q2 * q3) - ay;
+    f[2] = 2.0f * (0.5f - q1 * q1 - q2 * q2) - az;
+
+    if (m == nullptr) {
+        return 3;
+    }
+
+    norm = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+    if (norm == 0.0f) {
+        return 3;
+    }
+
+    norm = 1.0f / std::sqrt(norm);
+    mx = m[0] * norm;
+    my = m[1] * norm;
+    mz = m[2] * norm;
+
+    /* magnetic field in earth frame, then projected on the x-z plane */
+    hx = 2.0f * (mx * (0.5f - q2 * q2 - q3 * q3) + my * (q1 * q2 - q0 * q3) + mz * (q1 * q3 + q0 * q2));
+    hy = 2.0f * (mx * (q1 * q2 + q0 * q3) + my * (0.5f - q1 * q1 - q3 * q3) + mz * (q2 * q3 - q0 * q1));
+    b[0] = std::sqrt(hx * hx + hy * hy);
+    b[1] = 2.0f * (mx * (q1 * q3 - q0 * q2) + my * (q2 * q3 + q0 * q1) + mz * (0.5f - q1 * q1 - q2 * q2));
+
+    f[3] = 2.0f * b[0] * (0.5f - q2 * q2 - q3 * q3) + 2.0f * b[1] * (q1 * q3 - q0 * q2) - mx;
+    f[4] = 2.0f * b[0] * (q1 * q2 - q0 * q3) + 2.0f * b[1] * (q0 * q1 + q2 * q3) - my;
+    f[5] = 2.0f * b[0] * (q0 * q2 + q1 * q3) + 2.0f * b[1] * (0.5f - q1 * q1 - q2 * q2) - mz;
+
+    return 6;
+}
+
+MadgwickFilter::MadgwickFilter(void)
+    : beta(defaultBeta),
+      kernel(isVectorKernelSupported() ? Kernel::VECTOR : Kernel::SCALAR)
+{
+    reset();
+}
+
+void MadgwickFilter::reset(void)
+{
+    q = { 1.0f, 0.0f, 0.0f, 0.0f };
+}
+
+void MadgwickFilter::setGain(float beta)
+{
+    this->beta = beta;
+}
+
+int MadgwickFilter::setKernel(Kernel kernel)
+{
+    if ((kernel == Kernel::VECTOR) && !isVectorKernelSupported()) {
+        return -1;
+    }
+
+    this->kernel = kernel;
+
+    return 0;
+}
+
+bool MadgwickFilter::isVectorKernelSupported(void)
+{
+    return MADGWICK_HAVE_VECTOR_KERNEL != 0;
+}
+
+/*
+ * alignTo: set orientation from up and north directions (sensor frame),
+ *          north does not need to be orthogonal to up.
+ */
+void MadgwickFilter::alignTo(const std::array<float, 3> &up,
+                             const std::array<float, 3> &north)
+{
+    std::array<float, 3> u, e, n;
+    float norm, trace, s;
+
+    norm = std::sqrt(up[0] * up[0] + up[1] * up[1] + up[2] * up[2]);
+    if (norm == 0.0f) {
+        return;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        u[i] = up[i] / norm;
+    }
+
+    e = { north[1] * u[2] - north[2] * u[1],
+          north[2] * u[0] - north[0] * u[2],
+          north[0] * u[1] - north[1] * u[0] };
+    norm = std::sqrt(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+    if (norm == 0.0f) {
+        return;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        e[i] /= norm;
+    }
+
+    n = { u[1] * e[2] - u[2] * e[1],
+          u[2] * e[0] - u[0] * e[2],
+          u[0] * e[1] - u[1] * e[0] };
+
+    /* rows of the sensor to earth (North-West-Up) rotation matrix */
+    const float r[3][3] = {
+        { n[0], n[1], n[2] },
+        { -e[0], -e[1], -e[2] },
+        { u[0], u[1], u[2] },
+    };
+
+    trace = r[0][0] + r[1][1] + r[2][2];
+    if (trace > 0.0f) {
+        s = 2.0f * std::sqrt(trace + 1.0f);
+        q = { 0.25f * s, (r[2][1] - r[1][2]) / s,
+              (r[0][2] - r[2][0]) / s, (r[1][0] - r[0][1]) / s };
+    } else if ((r[0][0] > r[1][1]) && (r[0][0] > r[2][2])) {
+        s = 2.0f * std::sqrt(1.0f + r[0][0] - r[1][1] - r[2][2]);
+        q = { (r[2][1] - r[1][2]) / s, 0.25f * s,
+              (r[0][1] + r[1][0]) / s, (r[0][2] + r[2][0]) / s };
+    } else if (r[1][1] > r[2][2]) {
+        s = 2.0f * std::sqrt(1.0f + r[1][1] - r[0][0] - r[2][2]);
+        q = { (r[0][2] - r[2][0]) / s, (r[0][1] + r[1][0]) / s,
+              0.25f * s, (r[1][2] + r[2][1]) / s };
+    } else {
+        s = 2.0f * std::sqrt(1.0f + r[2][2] - r[0][0] - r[1][1]);
+        q = { (r[1][0] - r[0][1]) / s, (r[0][2] + r[2][0]) / s,
+              (r[1][2] + r[2][1]) / s, 0.25f * s };
+    }
+}
+
+/**
+ * alignToGravity: set orientation from accelerometer only,
+ *                 heading is taken from sensor y axis
+ * @accel: accelerometer data.
+ */
+void MadgwickFilter::alignToGravity(const std::array<float, 3> &accel)
+{
+    float norm = std::sqrt(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+
+    if ((norm > 0.0f) && (std::fabs(accel[1] / norm) > 0.9f)) {
+        alignTo(accel, { 0.0f, 0.0f, -accel[1] });
+    } else {
+        alignTo(accel, { 0.0f, 1.0f, 0.0f });
+    }
+}
+
+/**
+ * alignToGravityAndMagn: set orientation from accelerometer and magnetometer
+ * @accel: accelerometer data.
+ * @magn: magnetometer data.
+ */
+void MadgwickFilter::alignToGravityAndMagn(const std::array<float, 3> &accel,
+                                           const std::array<float, 3> &magn)
+{
+    alignTo(accel, magn);
+}
+
+/**
+ * update: run one 6-axis filter step
+ * @accel: accelerometer data (any unit).
+ * @gyro: gyroscope data [rad/s].
+ * @dt: time elapsed since previous step [s].
+ */
+void MadgwickFilter::update(const std::array<float, 3> &accel,
+                            const std::array<float, 3> &gyro,
+                            float dt)
+{
+    if (kernel == Kernel::VECTOR) {
+        updateVector(accel.data(), nullptr, gyro.data(), dt);
+    } else {
+        updateScalar(accel.data(), nullptr, gyro.data(), dt);
+    }
+}
+
+/**
+ * update: run one 9-axis filter step
+ * @accel: accelerometer data (any unit).
+ * @magn: magnetometer data (any unit).
+ * @gyro: gyroscope data [rad/s].
+ * @dt: time elapsed since previous step [s].
+ */
+void MadgwickFilter::update(const std::array<float, 3> &accel,
+                            const std::array<float, 3> &magn,
+                            const std::array<float, 3> &gyro,
+                            float dt)
+{
+    if (kernel == Kernel::VECTOR) {
+        updateVector(accel.data(), magn.data(), gyro.data(), dt);
+    } else {
+        updateScalar(accel.data(), magn.data(), gyro.data(), dt);
+    }
+}
+
+/**
+ * rotate: apply a body frame rotation to the orientation, no correction
+ * @delta: rotation quaternion { w, x, y, z }, e.g. integrated gyroscope data.
+ */
+void MadgwickFilter::rotate(const std::array<float, 4> &delta)
+{
+    float q0, q1, q2, q3, norm;
+
+    q0 = q[0] * delta[0] - q[1] * delta[1] - q[2] * delta[2] - q[3] * delta[3];
+    q1 = q[0] * delta[1] + q[1] * delta[0] + q[2] * delta[3] - q[3] * delta[2];
+    q2 = q[0] * delta[2] - q[1] * delta[3] + q[2] * delta[0] + q[3] * delta[1];
+    q3 = q[0] * delta[3] + q[1] * delta[2] - q[2] * delta[1] + q[3] * delta[0];
+
+    norm = 1.0f / std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q = { q0 * norm, q1 * norm, q2 * norm, q3 * norm };
+}
+
+void MadgwickFilter::updateScalar(const float *a, const float *m, const float *g, float dt)
+{
+    float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    float qDot0, qDot1, qDot2, qDot3;
+    float s0, s1, s2, s3, norm;
+    float f[6], b[2];
+    int residuals;
+
+    qDot0 = 0.5f * (-q1 * g[0] - q2 * g[1] - q3 * g[2]);
+    qDot1 = 0.5f * (q0 * g[0] + q2 * g[2] - q3 * g[1]);
+    qDot2 = 0.5f * (q0 * g[1] - q1 * g[2] + q3 * g[0]);
+    qDot3 = 0.5f * (q0 * g[2] + q1 * g[1] - q2 * g[0]);
+
+    residuals = madgwickResiduals(q, a, m, f, b);
+    if (residuals > 0) {
+        /* gradient: transposed jacobian times residuals */
+        s0 = -2.0f * q2 * f[0] + 2.0f * q1 * f[1];
+        s1 = 2.0f * q3 * f[0] + 2.0f * q0 * f[1] - 4.0f * q1 * f[2];
+        s2 = -2.0f * q0 * f[0] + 2.0f * q3 * f[1] - 4.0f * q2 * f[2];
+        s3 = 2.0f * q1 * f[0] + 2.0f * q2 * f[1];
+
+        if (residuals > 3) {
+            float bx = b[0], bz = b[1];
+
+            s0 += -2.0f * bz * q2 * f[3] +
+                  (-2.0f * bx * q3 + 2.0f * bz * q1) * f[4] +
+                  2.0f * bx * q2 * f[5];
+            s1 += 2.0f * bz * q3 * f[3] +
+                  (2.0f * bx * q2 + 2.0f * bz * q0) * f[4] +
+                  (2.0f * bx * q3 - 4.0f * bz * q1) * f[5];
+            s2 += (-4.0f * bx * q2 - 2.0f * bz * q0) * f[3] +
+                  (2.0f * bx * q1 + 2.0f * bz * q3) * f[4] +
+                  (2.0f * bx * q0 - 4.0f * bz * q2) * f[5];
+            s3 += (-4.0f * bx * q3 + 2.0f * bz * q1) * f[3] +
+                  (-2.0f * bx * q0 + 2.0f * bz * q2) * f[4] +
+                  2.0f * bx * q1 * f[5];
+        }
+
+        norm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (norm > 0.0f) {
+            norm = beta / std::sqrt(norm);
+            qDot0 -= norm * s0;
+            qDot1 -= norm * s1;
+            qDot2 -= norm * s2;
+            qDot3 -= norm * s3;
+        }
+    }
+
+    q0 += qDot0 * dt;
+    q1 += qDot1 * dt;
+    q2 += qDot2 * dt;
+    q3 += qDot3 * dt;
+
+    norm = 1.0f / std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q = { q0 * norm, q1 * norm, q2 * norm, q3 * norm };
+}
+
+#if MADGWICK_HAVE_VECTOR_KERNEL
+static inline float v4sf_dot(v4sf a, v4sf b)
+{
+    v4sf p = a * b;
+
+    return (p[0] + p[1]) + (p[2] + p[3]);
+}
+
+void MadgwickFilter::updateVector(const float *a, const float *m, const float *g, float dt)
+{
+    const float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    const v4sf vq = { q0, q1, q2, q3 };
+    v4sf qDot, s;
+    float f[6], b[2], norm;
+    int residuals;
+
+    /* 0.5 * q (x) (0, g) as a linear combination of q components */
+    qDot = v4sf{ 0.0f, g[0], g[1], g[2] } * q0 +
+           v4sf{ -g[0], 0.0f, -g[2], g[1] } * q1 +
+           v4sf{ -g[1], g[2], 0.0f, -g[0] } * q2 +
+           v4sf{ -g[2], -g[1], g[0], 0.0f } * q3;
+    qDot *= 0.5f;
+
+    residuals = madgwickResiduals(q, a, m, f, b);
+    if (residuals > 0) {
+        /* gradient: sum of jacobian rows weighted by residuals */
+        s = v4sf{ -q2, q3, -q0, q1 } * (2.0f * f[0]) +
+            v4sf{ q1, q0, q3, q2 } * (2.0f * f[1]) +
+            v4sf{ 0.0f, q1, q2, 0.0f } * (-4.0f * f[2]);
+
+        if (residuals > 3) {
+            const v4sf bx2 = { 2.0f * b[0], 2.0f * b[0], 2.0f * b[0], 2.0f * b[0] };
+            const v4sf bz2 = { 2.0f * b[1], 2.0f * b[1], 2.0f * b[1], 2.0f * b[1] };
+
+            s += (bz2 * v4sf{ -q2, q3, -q0, q1 } +
+                  bx2 * v4sf{ 0.0f, 0.0f, -2.0f * q2, -2.0f * q3 }) * f[3] +
+                 (bx2 * v4sf{ -q3, q2, q1, -q0 } +
+                  bz2 * v4sf{ q1, q0, q3, q2 }) * f[4] +
+                 (bx2 * v4sf{ q2, q3, q0, q1 } +
+                  bz2 * v4sf{ 0.0f, -2.0f * q1, -2.0f * q2, 0.0f }) * f[5];
+        }
+
+        norm = v4sf_dot(s, s);
+        if (norm > 0.0f) {
+            qDot -= s * (beta / std::sqrt(norm));
+        }
+    }
+
+    v4sf vqNew = vq + qDot * dt;
+    vqNew *= 1.0f / std::sqrt(v4sf_dot(vqNew, vqNew));
+
+    q = { vqNew[0], vqNew[1], vqNew[2], vqNew[3] };
+}
+#else /* MADGWICK_HAVE_VECTOR_KERNEL */
+void MadgwickFilter::updateVector(const float *a, const float *m, const float *g, float dt)
+{
+    updateScalar(a, m, g, dt);
+}
+#endif /* MADGWICK_HAVE_VECTOR_KERNEL */
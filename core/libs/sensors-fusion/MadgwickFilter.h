@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2021 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+
+/*
+ * Gradient descent orientation filter (S. Madgwick, "An efficient orientation
+ * filter for inertial and inertial/magnetic sensor arrays", 2010).
+ *
+ * The estimated quaternion { w, x, y, z } rotates vectors from the sensor
+ * frame to the earth frame. The earth frame is North-West-Up: x is aligned
+ * with the horizontal component of the magnetic field (9-axis) or with the
+ * initial heading (6-axis).
+ *
+ * Two implementations of the update step are available: a scalar reference
+ * and a 4-lanes vectorized one (SSE on x86, NEON on ARM) working on whole
+ * quaternions. They produce the same estimate up to float rounding.
+ */
+class MadgwickFilter {
+public:
+    enum class Kernel {
+        SCALAR,
+        VECTOR,
+    };
+
+    MadgwickFilter(void);
+
+    void reset(void);
+
+    void setGain(float beta);
+
+    int setKernel(Kernel kernel);
+
+    Kernel getKernel(void) const { return kernel; }
+
+    static bool isVectorKernelSupported(void);
+
+    void alignToGravity(const std::array<float, 3> &accel);
+
+    void alignToGravityAndMagn(const std::array<float, 3> &accel,
+                               const std::array<float, 3> &magn);
+
+    void update(const std::array<float, 3> &accel,
+                const std::array<float, 3> &gyro,
+                float dt);
+
+    void update(const std::array<float, 3> &accel,
+                const std::array<float, 3> &magn,
+                const std::array<float, 3> &gyro,
+                float dt);
+
+    void rotate(const std::array<float, 4> &delta);
+
+    const std::array<float, 4>& getQuaternion(void) const { return q; }
+
+private:
+    std::array<float, 4> q;
+    float beta;
+    Kernel kernel;
+
+    void alignTo(const std::array<float, 3> &up,
+                 const std::array<float, 3> &north);
+
+    void updateScalar(const float *a, const float *m, const float *g, float dt);
+
+    void updateVector(const float *a, const float *m, const float *g, float dt);
+};
@@ -15,32 +15,390 @@
  * limitations under the License.
  */
 
+#include <cmath>
+
 #include "STMSensorsFusion.h"
 
+#define STM_FUSION_GRAVITY_EARTH        (9.80665f)
+#define STM_FUSION_RAD2DEG(rad)         ((rad) * 180.0f / (float)M_PI)
+
+/* above this gap between samples the filter is re-aligned to the references */
+static const int64_t maxDeltaTimeNs = 500000000LL;
+
+/*
+ * slowest filter step rate: longer correction steps make the accelerometer
+ * and magnetometer feedback lag behind fast motion
+ */
+static const int64_t maxUpdatePeriodNs = 20000000LL;
+
+STMSensorsFusion::STMSensorsFusion(void)
+    : updatePeriodNs(0)
+{
+    resetState();
+}
+
+void STMSensorsFusion::resetState(void)
+{
+    filter.reset();
+    lastAccel = { 0.0f, 0.0f, 0.0f };
+    lastTimestamp = 0;
+    aligned = false;
+    gyroDelta = { 1.0f, 0.0f, 0.0f, 0.0f };
+    gyroDeltaSamples = 0;
+    lastUpdateTimestamp = 0;
+}
+
+/**
+ * setUpdatePeriod: run the filter step at most once per period, gyroscope
+ *                  samples in between are only integrated
+ * @periodNs: filter step period [ns], 0 to run it on every sample.
+ *
+ * Return value: period actually used [ns].
+ */
+int64_t STMSensorsFusion::setUpdatePeriod(int64_t periodNs)
+{
+    if (periodNs < 0) {
+        periodNs = 0;
+    } else if (periodNs > maxUpdatePeriodNs) {
+        periodNs = maxUpdatePeriodNs;
+    }
+
+    updatePeriodNs = periodNs;
+
+    return updatePeriodNs;
+}
+
+/**
+ * setKernel: select filter implementation (scalar or vectorized)
+ * @kernel: kernel to use.
+ *
+ * Return value: 0 on success, else a negative error code.
+ */
+int STMSensorsFusion::setKernel(MadgwickFilter::Kernel kernel)
+{
+    return filter.setKernel(kernel);
+}
+
+static void rotationVectorFromOrientation(const std::array<float, 4> &q,
+                                         std::array<float, 4> &data)
+{
+    static const float halfSqrt2 = 0.70710678f;
+
+    /* rotate filter frame (North-West-Up) by +90deg around z */
+    data[0] = halfSqrt2 * (q[1] - q[2]);
+    data[1] = halfSqrt2 * (q[2] + q[1]);
+    data[2] = halfSqrt2 * (q[3] + q[0]);
+    data[3] = halfSqrt2 * (q[0] - q[3]);
+
+    if (data[3] < 0.0f) {
+        for (auto &v : data) {
+            v = -v;
+        }
+    }
+}
+
+/**
+ * getQuaternion: rotation vector, Android format { x, y, z, w }
+ *                in East-North-Up earth frame
+ */
 int STMSensorsFusion::getQuaternion(std::array<float, 4> &data) const
 {
-    (void) data;
+    if (!aligned) {
+        return -1;
+    }
+
+    rotationVectorFromOrientation(getOrientation(), data);
 
     return 0;
 }
 
+static void eulerFromRotationVector(const std::array<float, 4> &rv,
+                                    std::array<float, 3> &data)
+{
+    float x = rv[0], y = rv[1], z = rv[2], w = rv[3], azimuth;
+
+    azimuth = STM_FUSION_RAD2DEG(std::atan2(2.0f * (x * y - w * z),
+                                            1.0f - 2.0f * (x * x + z * z)));
+    if (azimuth < 0.0f) {
+        azimuth += 360.0f;
+    }
+
+    data[0] = azimuth;
+    data[1] = STM_FUSION_RAD2DEG(std::asin(std::fmax(-1.0f, std::fmin(1.0f, -2.0f * (y * z + w * x)))));
+    data[2] = STM_FUSION_RAD2DEG(std::atan2(-2.0f * (x * z - w * y),
+                                            1.0f - 2.0f * (x * x + y * y)));
+}
+
+/**
+ * getEulerAngles: azimuth, pitch and roll [deg],
+ *                 same convention of Android SensorManager.getOrientation()
+ */
 int STMSensorsFusion::getEulerAngles(std::array<float, 3> &data) const
 {
-    (void) data;
+    std::array<float, 4> rv;
+
+    if (getQuaternion(rv) < 0) {
+        return -1;
+    }
+
+    eulerFromRotationVector(rv, data);
 
     return 0;
 }
 
+static void gravityFromOrientation(const std::array<float, 4> &q,
+                                   std::array<float, 3> &data)
+{
+    data[0] = STM_FUSION_GRAVITY_EARTH * 2.0f * (q[1] * q[3] - q[0] * q[2]);
+    data[1] = STM_FUSION_GRAVITY_EARTH * 2.0f * (q[0] * q[1] + q[2] * q[3]);
+    data[2] = STM_FUSION_GRAVITY_EARTH * (1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]));
+}
+
+/**
+ * getGravity: gravity vector in sensor frame [m/s^2]
+ */
 int STMSensorsFusion::getGravity(std::array<float, 3> &data) const
 {
-    (void) data;
+    if (!aligned) {
+        return -1;
+    }
+
+    gravityFromOrientation(getOrientation(), data);
 
     return 0;
 }
 
+/**
+ * getLinearAccel: last accelerometer sample without gravity [m/s^2]
+ */
 int STMSensorsFusion::getLinearAccel(std::array<float, 3> &data) const
 {
-    (void) data;
+    std::array<float, 3> gravity;
+
+    if (getGravity(gravity) < 0) {
+        return -1;
+    }
+
+    for (auto i = 0U; i < data.size(); ++i) {
+        data[i] = lastAccel[i] - gravity[i];
+    }
+
+    return 0;
+}
+
+/*
+ * computeOutputs: outputs in mask for an orientation and an accelerometer
+ *                 sample, intermediate results are shared among outputs
+ */
+static void computeOutputs(const std::array<float, 4> &q,
+                           const std::array<float, 3> &accel,
+                           unsigned int mask,
+                           STMSensorsFusionOutput &output)
+{
+    output.mask = 0;
+
+    if (mask & (STMSensorsFusionOutput::QUATERNION | STMSensorsFusionOutput::EULER_ANGLES)) {
+        rotationVectorFromOrientation(q, output.quaternion);
+        output.mask |= mask & STMSensorsFusionOutput::QUATERNION;
+
+        if (mask & STMSensorsFusionOutput::EULER_ANGLES) {
+            eulerFromRotationVector(output.quaternion, output.eulerAngles);
+            output.mask |= STMSensorsFusionOutput::EULER_ANGLES;
+        }
+    }
+
+    if (mask & (STMSensorsFusionOutput::GRAVITY | STMSensorsFusionOutput::LINEAR_ACCEL)) {
+        gravityFromOrientation(q, output.gravity);
+        output.mask |= mask & STMSensorsFusionOutput::GRAVITY;
+
+        if (mask & STMSensorsFusionOutput::LINEAR_ACCEL) {
+            for (auto i = 0U; i < output.linearAccel.size(); ++i) {
+                output.linearAccel[i] = accel[i] - output.gravity[i];
+            }
+            output.mask |= STMSensorsFusionOutput::LINEAR_ACCEL;
+        }
+    }
+}
+
+static void integrateGyro(std::array<float, 4> &delta,
+                          const std::array<float, 3> &gyroData, float dt)
+{
+    const float hx = 0.5f * gyroData[0] * dt;
+    const float hy = 0.5f * gyroData[1] * dt;
+    const float hz = 0.5f * gyroData[2] * dt;
+    float q0 = delta[0], q1 = delta[1], q2 = delta[2], q3 = delta[3];
+    float norm;
+
+    /* first order, as the filter step: delta += 0.5 * delta (x) (0, gyro) * dt */
+    q0 += -delta[1] * hx - delta[2] * hy - delta[3] * hz;
+    q1 += delta[0] * hx + delta[2] * hz - delta[3] * hy;
+    q2 += delta[0] * hy - delta[1] * hz + delta[3] * hx;
+    q3 += delta[0] * hz + delta[1] * hy - delta[2] * hx;
+
+    norm = 1.0f / std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    delta = { q0 * norm, q1 * norm, q2 * norm, q3 * norm };
+}
+
+/*
+ * predictOrientation: filter orientation with gyroscope data not yet fused
+ */
+static std::array<float, 4> predictOrientation(const MadgwickFilter &filter,
+                                               const std::array<float, 4> &delta,
+                                               unsigned int deltaSamples)
+{
+    MadgwickFilter predicted = filter;
+
+    if (deltaSamples == 0) {
+        return filter.getQuaternion();
+    }
+
+    predicted.rotate(delta);
+
+    return predicted.getQuaternion();
+}
+
+std::array<float, 4> STMSensorsFusion::getOrientation(void) const
+{
+    return predictOrientation(filter, gyroDelta, gyroDeltaSamples);
+}
+
+/**
+ * update: feed one sample to the orientation filter
+ * @accelData: accelerometer data [m/s^2].
+ * @magnData: magnetometer data [uT], nullptr for 6-axis fusion.
+ * @gyroData: gyroscope data [rad/s].
+ * @timestamp: sample timestamp [ns].
+ *
+ * Return value: 0 on success, else a negative error code.
+ */
+int STMSensorsFusion::update(const std::array<float, 3> &accelData,
+                             const std::array<float, 3> *magnData,
+                             const std::array<float, 3> &gyroData,
+                             int64_t timestamp)
+{
+    return update(&accelData, magnData, &gyroData, &timestamp, 1, 0, nullptr);
+}
+
+/**
+ * update: feed count samples to the orientation filter, filter step state
+ *         is kept in locals for the whole batch
+ * @accelData: accelerometer data [m/s^2].
+ * @magnData: magnetometer data [uT], nullptr for 6-axis fusion.
+ * @gyroData: gyroscope data [rad/s].
+ * @timestamp: samples timestamp [ns].
+ * @count: number of samples.
+ * @outputMask: STMSensorsFusionOutput flags of outputs to compute.
+ * @outputs: if not nullptr, outputs[i] are the outputs after sample i.
+ *
+ * Return value: 0 on success, else a negative error code (some samples
+ * were not in timestamp order and were discarded).
+ */
+int STMSensorsFusion::update(const std::array<float, 3> *accelData,
+                             const std::array<float, 3> *magnData,
+                             const std::array<float, 3> *gyroData,
+                             const int64_t *timestamp,
+                             size_t count,
+                             unsigned int outputMask,
+                             STMSensorsFusionOutput *outputs)
+{
+    static const std::array<float, 3> noRotation = { 0.0f, 0.0f, 0.0f };
+    const int64_t periodNs = updatePeriodNs;
+    std::array<float, 4> delta = gyroDelta;
+    unsigned int deltaSamples = gyroDeltaSamples;
+    int64_t prevTimestamp = lastTimestamp;
+    int64_t stepTimestamp = lastUpdateTimestamp;
+    bool isAligned = aligned;
+    const std::array<float, 3> *accel = &lastAccel;
+    int ret = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const int64_t deltaTime = timestamp[i] - prevTimestamp;
+
+        if (isAligned && (deltaTime <= 0)) {
+            ret = -1;
+        } else {
+            accel = &accelData[i];
+            prevTimestamp = timestamp[i];
+
+            if (!isAligned || (deltaTime > maxDeltaTimeNs)) {
+                if (magnData != nullptr) {
+                    filter.alignToGravityAndMagn(accelData[i], magnData[i]);
+                } else {
+                    filter.alignToGravity(accelData[i]);
+                }
+                isAligned = true;
+                delta = { 1.0f, 0.0f, 0.0f, 0.0f };
+                deltaSamples = 0;
+                stepTimestamp = timestamp[i];
+            } else if (periodNs == 0) {
+                if (magnData != nullptr) {
+                    filter.update(accelData[i], magnData[i], gyroData[i], deltaTime * 1e-9f);
+                } else {
+                    filter.update(accelData[i], gyroData[i], deltaTime * 1e-9f);
+                }
+                stepTimestamp = timestamp[i];
+            } else {
+                integrateGyro(delta, gyroData[i], deltaTime * 1e-9f);
+                deltaSamples++;
+
+                /* half sample of tolerance not to skip steps because of timestamp jitter */
+                if (timestamp[i] - stepTimestamp + deltaTime / 2 >= periodNs) {
+                    /* gyroscope prediction, then correction step over the whole interval */
+                    float dt = (timestamp[i] - stepTimestamp) * 1e-9f;
+
+                    filter.rotate(delta);
+                    if (magnData != nullptr) {
+                        filter.update(accelData[i], magnData[i], noRotation, dt);
+                    } else {
+                        filter.update(accelData[i], noRotation, dt);
+                    }
+
+                    delta = { 1.0f, 0.0f, 0.0f, 0.0f };
+                    deltaSamples = 0;
+                    stepTimestamp = timestamp[i];
+                }
+            }
+        }
+
+        if (outputs == nullptr) {
+            continue;
+        }
+
+        if (isAligned) {
+            computeOutputs(predictOrientation(filter, delta, deltaSamples),
+                           *accel, outputMask, outputs[i]);
+        } else {
+            outputs[i].mask = 0;
+        }
+    }
+
+    lastAccel = *accel;
+    lastTimestamp = prevTimestamp;
+    lastUpdateTimestamp = stepTimestamp;
+    gyroDelta = delta;
+    gyroDeltaSamples = deltaSamples;
+    aligned = isAligned;
+
+    return ret;
+}
+
+/**
+ * getOutputs: compute the requested outputs of last sample at once,
+ *             intermediate results are shared among outputs
+ * @mask: STMSensorsFusionOutput flags of outputs to compute.
+ * @output: outputs, output.mask reports the computed ones.
+ *
+ * Return value: 0 on success, else a negative error code.
+ */
+int STMSensorsFusion::getOutputs(unsigned int mask, STMSensorsFusionOutput &output) const
+{
+    output.mask = 0;
+
+    if (!aligned) {
+        return -1;
+    }
+
+    computeOutputs(getOrientation(), lastAccel, mask, output);
 
     return 0;
 }
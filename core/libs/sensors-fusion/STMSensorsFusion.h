@@ -20,6 +20,27 @@
 #include <array>
 #include <string>
 
+#include "MadgwickFilter.h"
+
+/*
+ * fusion outputs of one sample, only outputs in mask are computed
+ */
+struct STMSensorsFusionOutput {
+    enum : unsigned int {
+        QUATERNION = 1U << 0,
+        EULER_ANGLES = 1U << 1,
+        GRAVITY = 1U << 2,
+        LINEAR_ACCEL = 1U << 3,
+        ALL = QUATERNION | EULER_ANGLES | GRAVITY | LINEAR_ACCEL,
+    };
+
+    unsigned int mask = 0;
+    std::array<float, 4> quaternion;
+    std::array<float, 3> eulerAngles;
+    std::array<float, 3> gravity;
+    std::array<float, 3> linearAccel;
+};
+
 struct STMSensorsFusion {
     STMSensorsFusion(const STMSensorsFusion &) = delete;
     STMSensorsFusion(STMSensorsFusion &&) = delete;
@@ -38,9 +59,43 @@ struct STMSensorsFusion {
 
     int getLinearAccel(std::array<float, 3> &data) const;
 
+    int getOutputs(unsigned int mask, STMSensorsFusionOutput &output) const;
+
     virtual const std::string& getLibVersion(void) const = 0;
 
+    int setKernel(MadgwickFilter::Kernel kernel);
+
+    int64_t setUpdatePeriod(int64_t periodNs);
+
 protected:
-    STMSensorsFusion(void) = default;
+    MadgwickFilter filter;
+    std::array<float, 3> lastAccel;
+    int64_t lastTimestamp;
+    bool aligned;
+
+    /* gyroscope rotation integrated since last filter step */
+    std::array<float, 4> gyroDelta;
+    unsigned int gyroDeltaSamples;
+    int64_t lastUpdateTimestamp;
+    int64_t updatePeriodNs;
+
+    STMSensorsFusion(void);
     virtual ~STMSensorsFusion(void) = default;
+
+    void resetState(void);
+
+    std::array<float, 4> getOrientation(void) const;
+
+    int update(const std::array<float, 3> &accelData,
+               const std::array<float, 3> *magnData,
+               const std::array<float, 3> &gyroData,
+               int64_t timestamp);
+
+    int update(const std::array<float, 3> *accelData,
+               const std::array<float, 3> *magnData,
+               const std::array<float, 3> *gyroData,
+               const int64_t *timestamp,
+               size_t count,
+               unsigned int outputMask,
+               STMSensorsFusionOutput *outputs);
 };
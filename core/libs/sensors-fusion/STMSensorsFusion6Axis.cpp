@@ -25,6 +25,8 @@ STMSensorsFusion6Axis& STMSensorsFusion6Axis::getInstance(void)
 
 int STMSensorsFusion6Axis::init(void)
 {
+    resetState();
+
     return 0;
 }
 
@@ -32,6 +34,8 @@ int STMSensorsFusion6Axis::reset(void *data)
 {
     (void) data;
 
+    resetState();
+
     return 0;
 }
 
@@ -39,16 +43,22 @@ int STMSensorsFusion6Axis::run(const std::array<float, 3> &accelData,
                                const std::array<float, 3> &gyroData,
                                int64_t timestamp)
 {
-    (void) accelData;
-    (void) gyroData;
-    (void) timestamp;
+    return update(accelData, nullptr, gyroData, timestamp);
+}
 
-    return 0;
+int STMSensorsFusion6Axis::run(const std::array<float, 3> *accelData,
+                               const std::array<float, 3> *gyroData,
+                               const int64_t *timestamp,
+                               size_t count,
+                               unsigned int outputMask,
+                               STMSensorsFusionOutput *outputs)
+{
+    return update(accelData, nullptr, gyroData, timestamp, count, outputMask, outputs);
 }
 
 const std::string& STMSensorsFusion6Axis::getLibVersion(void) const
 {
-    static const std::string libVersion("stm-sensors-fusion-6X-lib-mock");
+    static const std::string libVersion("stm-sensors-fusion-6X-madgwick");
 
     return libVersion;
 }
@@ -23,6 +23,8 @@
 #include "STMSensorsFusion.h"
 
 struct STMSensorsFusion6Axis: public STMSensorsFusion {
+    STMSensorsFusion6Axis(void) = default;
+    /* shared 6-axis filter, each fusion sensor module owns its own */
     static STMSensorsFusion6Axis& getInstance(void);
     virtual ~STMSensorsFusion6Axis(void) = default;
     STMSensorsFusion6Axis(const STMSensorsFusion6Axis &) = delete;
@@ -38,8 +40,16 @@ struct STMSensorsFusion6Axis: public STMSensorsFusion {
             const std::array<float, 3> &gyroData,
             int64_t timestamp);
 
-    virtual const std::string& getLibVersion(void) const override;
+    /*
+     * run on a batch of count samples: if set, outputs[i] are the outputs in
+     * outputMask after sample i, getters return the outputs of last sample.
+     */
+    int run(const std::array<float, 3> *accelData,
+            const std::array<float, 3> *gyroData,
+            const int64_t *timestamp,
+            size_t count,
+            unsigned int outputMask = 0,
+            STMSensorsFusionOutput *outputs = nullptr);
 
-private:
-    STMSensorsFusion6Axis(void) = default;
+    virtual const std::string& getLibVersion(void) const override;
 };
@@ -25,6 +25,8 @@ STMSensorsFusion9Axis& STMSensorsFusion9Axis::getInstance(void)
 
 int STMSensorsFusion9Axis::init(void)
 {
+    resetState();
+
     return 0;
 }
 
@@ -32,6 +34,8 @@ int STMSensorsFusion9Axis::reset(void *data)
 {
     (void) data;
 
+    resetState();
+
     return 0;
 }
 
@@ -40,17 +44,23 @@ int STMSensorsFusion9Axis::run(const std::array<float, 3> &accelData,
                                const std::array<float, 3> &gyroData,
                                int64_t timestamp)
 {
-    (void) accelData;
-    (void) magnData;
-    (void) gyroData;
-    (void) timestamp;
+    return update(accelData, &magnData, gyroData, timestamp);
+}
 
-    return 0;
+int STMSensorsFusion9Axis::run(const std::array<float, 3> *accelData,
+                               const std::array<float, 3> *magnData,
+                               const std::array<float, 3> *gyroData,
+                               const int64_t *timestamp,
+                               size_t count,
+                               unsigned int outputMask,
+                               STMSensorsFusionOutput *outputs)
+{
+    return update(accelData, magnData, gyroData, timestamp, count, outputMask, outputs);
 }
 
 const std::string& STMSensorsFusion9Axis::getLibVersion(void) const
 {
-    static const std::string libVersion("stm-sensors-fusion-9X-lib-mock");
+    static const std::string libVersion("stm-sensors-fusion-9X-madgwick");
 
     return libVersion;
 }
@@ -23,6 +23,8 @@
 #include "STMSensorsFusion.h"
 
 struct STMSensorsFusion9Axis: public STMSensorsFusion {
+    STMSensorsFusion9Axis(void) = default;
+    /* shared 9-axis filter, each fusion sensor module owns its own */
     static STMSensorsFusion9Axis& getInstance(void);
     virtual ~STMSensorsFusion9Axis(void) = default;
     STMSensorsFusion9Axis(const STMSensorsFusion9Axis &) = delete;
@@ -39,8 +41,14 @@ struct STMSensorsFusion9Axis: public STMSensorsFusion {
             const std::array<float, 3> &gyroData,
             int64_t timestamp);
 
-    virtual const std::string& getLibVersion(void) const override;
+    /* batch version, see STMSensorsFusion6Axis */
+    int run(const std::array<float, 3> *accelData,
+            const std::array<float, 3> *magnData,
+            const std::array<float, 3> *gyroData,
+            const int64_t *timestamp,
+            size_t count,
+            unsigned int outputMask = 0,
+            STMSensorsFusionOutput *outputs = nullptr);
 
-private:
-    STMSensorsFusion9Axis(void) = default;
+    virtual const std::string& getLibVersion(void) const override;
 };
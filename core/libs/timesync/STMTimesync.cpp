@@ -17,12 +17,20 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <deque>
 #include <cerrno>
+#include <cmath>
+#include <algorithm>
 
 #include "STMTimesync.h"
 
 static const int maxPointsMin = 5;
+/* below this number of pairs the clocks are assumed to run at the same rate */
+static const unsigned int minFitPoints = 3;
+/* a pair is an outlier if its residual exceeds both limits */
+static const double outlierRmsRatio = 4.0;
+static const double outlierMinNs = 200000.0;
+/* consecutive outliers meaning that the clocks jumped: restart the fit */
+static const unsigned int maxRejected = 3;
 
 int STMTimesync::init(uint8_t maxPoints)
 {
@@ -30,37 +38,154 @@ int STMTimesync::init(uint8_t maxPoints)
         return -EINVAL;
     }
 
+    this->maxPoints = maxPoints;
+    points1.assign(maxPoints, 0);
+    points2.assign(maxPoints, 0);
+    reset();
+
     return 0;
 }
 
 void STMTimesync::reset(void)
 {
+    head = 0;
+    count = 0;
+    rejected = 0;
+    sum1 = sum2 = sum22 = sum12 = sum11 = 0.0;
+    mean1 = mean2 = residualRms = 0.0;
+    slope = 1.0;
+    lastTimestamp1 = 0;
+    lastTimestamp2 = 0;
+}
+
+void STMTimesync::accumulate(unsigned int index, double sign)
+{
+    double x = (double)(points2[index] - origin2);
+    double y = (double)(points1[index] - origin1);
+
+    sum1 += sign * y;
+    sum2 += sign * x;
+    sum22 += sign * x * x;
+    sum12 += sign * x * y;
+    sum11 += sign * y * y;
+}
+
+/* sums from scratch, relative to the oldest pair to limit rounding errors */
+void STMTimesync::recompute(void)
+{
+    unsigned int oldest = (head + maxPoints - count) % maxPoints;
+
+    origin1 = points1[oldest];
+    origin2 = points2[oldest];
+    sum1 = sum2 = sum22 = sum12 = sum11 = 0.0;
+
+    for (unsigned int i = 0; i < count; ++i) {
+        accumulate((oldest + i) % maxPoints, 1.0);
+    }
+}
+
+void STMTimesync::updateFit(void)
+{
+    double var2, cov12, sse;
+
+    mean1 = sum1 / count;
+    mean2 = sum2 / count;
+    slope = 1.0;
+    residualRms = 0.0;
+
+    if (count < minFitPoints) {
+        return;
+    }
+
+    var2 = sum22 - sum2 * mean2;
+    cov12 = sum12 - sum2 * mean1;
+    if (var2 <= 0.0) {
+        return;
+    }
+
+    slope = cov12 / var2;
+    sse = sum11 - sum1 * mean1 - slope * cov12;
+    residualRms = std::sqrt(std::max(sse, 0.0) / (count - 2));
+}
+
+int64_t STMTimesync::predict(int64_t timestamp2) const
+{
+    double dx = (double)(timestamp2 - origin2) - mean2;
 
+    return origin1 + std::llround(mean1 + slope * dx);
 }
 
 bool STMTimesync::add(int64_t timestamp1, int64_t timestamp2)
 {
-    if ((timestamp1 <= lastTimestamp1) || (timestamp2 <= lastTimestamp2)) {
+    if ((maxPoints == 0) ||
+        (timestamp1 <= lastTimestamp1) || (timestamp2 <= lastTimestamp2)) {
         return false;
     }
 
     lastTimestamp1 = timestamp1;
     lastTimestamp2 = timestamp2;
 
+    if (count >= minFitPoints) {
+        double residual = std::fabs((double)(timestamp1 - predict(timestamp2)));
+
+        if ((residual > outlierMinNs) && (residual > outlierRmsRatio * residualRms)) {
+            if (++rejected < maxRejected) {
+                return false;
+            }
+
+            /* keep last pair only */
+            count = 0;
+            head = 0;
+        }
+    }
+
+    rejected = 0;
+
+    if (count == 0) {
+        origin1 = timestamp1;
+        origin2 = timestamp2;
+        sum1 = sum2 = sum22 = sum12 = sum11 = 0.0;
+    } else if (count == maxPoints) {
+        accumulate(head, -1.0);
+        count--;
+    }
+
+    points1[head] = timestamp1;
+    points2[head] = timestamp2;
+    accumulate(head, 1.0);
+    head = (head + 1) % maxPoints;
+    count++;
+
+    if (head == 0) {
+        recompute();
+    }
+
+    updateFit();
+
     return true;
 }
 
 bool STMTimesync::estimate(int64_t timestamp2, int64_t &timestamp1)
 {
-    (void) timestamp2;
-    (void) timestamp1;
+    return estimate(&timestamp2, &timestamp1, 1);
+}
+
+bool STMTimesync::estimate(const int64_t *timestamp2, int64_t *timestamp1, unsigned int count)
+{
+    if (this->count == 0) {
+        return false;
+    }
 
-    return false;
+    for (unsigned int i = 0; i < count; ++i) {
+        timestamp1[i] = predict(timestamp2[i]);
+    }
+
+    return true;
 }
 
 const std::string& STMTimesync::getLibVersion(void)
 {
-    static const std::string libVersion("stm-timesync-lib-mock");
+    static const std::string libVersion("stm-timesync-least-squares");
 
     return libVersion;
 }
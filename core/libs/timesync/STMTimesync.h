@@ -17,8 +17,15 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
+/*
+ * Maps a hw clock (timestamp2) to the system clock (timestamp1): linear
+ * least squares fit of the last maxPoints sync pairs, with running sums
+ * updated in O(1) per pair and pairs far from the current fit rejected.
+ */
 struct STMTimesync {
     STMTimesync(void) = default;
     ~STMTimesync(void) = default;
@@ -31,13 +38,49 @@ struct STMTimesync {
 
     void reset(void);
 
+    /**
+     * add: add a sync pair
+     * @timestamp1: system timestamp [ns].
+     * @timestamp2: hw timestamp [ns].
+     * Return value: true if the pair is used by the fit, false if it is not
+     *               monotonic or is an outlier.
+     */
     bool add(int64_t timestamp1, int64_t timestamp2);
 
     bool estimate(int64_t timestamp2, int64_t& timestamp1);
 
+    /**
+     * estimate: convert a batch of hw timestamps with the same fit
+     * @timestamp2: hw timestamps [ns].
+     * @timestamp1: system timestamps [ns], can be the same array.
+     * @count: number of timestamps.
+     * Return value: false if there are no sync pairs yet.
+     */
+    bool estimate(const int64_t *timestamp2, int64_t *timestamp1, unsigned int count);
+
     static const std::string& getLibVersion(void);
 
 private:
-    int64_t lastTimestamp1;
-    int64_t lastTimestamp2;
+    std::vector<int64_t> points1;
+    std::vector<int64_t> points2;
+    unsigned int maxPoints = 0;
+    unsigned int head = 0;
+    unsigned int count = 0;
+    unsigned int rejected = 0;
+
+    /* running sums of the points relative to origin */
+    int64_t origin1 = 0;
+    int64_t origin2 = 0;
+    double sum1 = 0.0, sum2 = 0.0, sum22 = 0.0, sum12 = 0.0, sum11 = 0.0;
+
+    /* fit: timestamp1 = origin1 + mean1 + slope * (timestamp2 - origin2 - mean2) */
+    double mean1 = 0.0, mean2 = 0.0, slope = 1.0, residualRms = 0.0;
+
+    int64_t lastTimestamp1 = 0;
+    int64_t lastTimestamp2 = 0;
+
+    void accumulate(unsigned int index, double sign);
+    void recompute(void);
+    void updateFit(void);
+    int64_t predict(int64_t timestamp2) const;
 };
@@ -43,5 +43,7 @@ int st_hal_dev_set_fullscale(void *data, uint32_t handle, float fullscale);
 
 int st_hal_dev_poll(void *data, sensors_event_t *sdata, int count);
 
+int st_hal_dev_hotplug(void *data, STMSensorsList &sensorsList);
+
 } // namespace core
 } // namespace stm
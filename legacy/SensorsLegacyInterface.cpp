@@ -64,7 +64,8 @@ int SensorsLegacyInterface::initialize(void)
  */
 unsigned int SensorsLegacyInterface::getSensorsList(struct sensor_t const **sensorsList) const
 {
-    const std::vector<stm::core::STMSensor> &list = sensorsCore.getSensorsList().getList();
+    const stm::core::STMSensorsList coreSensorsList = sensorsCore.getSensorsList();
+    const std::vector<stm::core::STMSensor> &list = coreSensorsList.getList();
     auto count = list.size();
     auto n {0U};
 
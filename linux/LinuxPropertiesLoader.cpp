@@ -29,6 +29,7 @@ static const std::unordered_map<std::string, PropertyId> configsRegex = {
 
 static const std::unordered_map<std::string, SensorPropertyId> sensorsConfigsRegex = {
     { initialSpacesRegex + "max-range.(accel|gyro|magn)-\\d+[ \t\r\f]*=.*", SensorPropertyId::MAX_RANGE },
+    { initialSpacesRegex + "decimation-filter.(accel|gyro|magn)(-\\d+)?[ \t\r\f]*=.*", SensorPropertyId::DECIMATION_FILTER },
     { initialSpacesRegex + "rot-matrix-1.(accel|gyro|magn)-\\d+[ \t\r\f]*=.*", SensorPropertyId::ROTATION_MATRIX_1 },
     { initialSpacesRegex + "rot-matrix-2.(accel|gyro|magn)-\\d+[ \t\r\f]*=.*", SensorPropertyId::ROTATION_MATRIX_2 },
     { initialSpacesRegex + "placement-1.(accel|gyro|magn)-\\d+[ \t\r\f]*=.*", SensorPropertyId::SENSOR_PLACEMENT_1 },
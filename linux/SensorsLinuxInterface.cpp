@@ -35,6 +35,11 @@ SensorsLinuxInterface::SensorsLinuxInterface(void)
 {
 }
 
+SensorsLinuxInterface::~SensorsLinuxInterface(void)
+{
+    stopStream();
+}
+
 /**
  * initialize: initialize the interface
  *
@@ -55,12 +60,66 @@ int SensorsLinuxInterface::initialize(void)
     return 0;
 }
 
+/**
+ * startStream: publish every sensors record to a shared memory stream,
+ *              whose readers connect to a unix socket (SensorsStreamClient)
+ * @socketPath: unix socket path, replaced if it exists.
+ * @slotsCount: number of records in the stream ring, power of two.
+ *
+ * Return value: 0 on success, else a negative error code.
+ */
+int SensorsLinuxInterface::startStream(const std::string &socketPath, uint32_t slotsCount)
+{
+    std::unique_ptr<SensorsStreamWriter> writer = std::make_unique<SensorsStreamWriter>();
+    std::unique_ptr<SensorsStreamServer> server;
+    int err;
+
+    stopStream();
+
+    err = writer->open(slotsCount);
+    if (err < 0) {
+        return err;
+    }
+
+    server = std::make_unique<SensorsStreamServer>(*writer);
+
+    err = server->start(socketPath);
+    if (err < 0) {
+        return err;
+    }
+
+    std::lock_guard<std::mutex> lock(streamLock);
+    streamWriter = std::move(writer);
+    streamServer = std::move(server);
+
+    return 0;
+}
+
+/**
+ * stopStream: stop serving the stream, connected readers see it closed
+ */
+void SensorsLinuxInterface::stopStream(void)
+{
+    std::unique_ptr<SensorsStreamWriter> writer;
+    std::unique_ptr<SensorsStreamServer> server;
+
+    {
+        std::lock_guard<std::mutex> lock(streamLock);
+        writer = std::move(streamWriter);
+        server = std::move(streamServer);
+    }
+
+    /* the server refers to the writer */
+    server.reset();
+    writer.reset();
+}
+
 /**
  * getSensorsList: retrieve sensors list
  *
- * Return value: const reference of sensors list.
+ * Return value: copy of sensors list.
  */
-const std::vector<STMSensor>& SensorsLinuxInterface::getSensorsList(void) const
+std::vector<STMSensor> SensorsLinuxInterface::getSensorsList(void) const
 {
     return sensorsCore.getSensorsList().getList();
 }
@@ -121,6 +180,23 @@ SensorsLinuxInterface::onNewSensorsData(const std::vector<ISTMSensorsCallbackDat
     }
 }
 
+/**
+ * onNewSensorsRecords: publish the records to the stream (if started),
+ *                      then dump them as onNewSensorsData
+ */
+void SensorsLinuxInterface::onNewSensorsRecords(STMSensorsRecordsLease &records)
+{
+    {
+        std::lock_guard<std::mutex> lock(streamLock);
+
+        if (streamWriter != nullptr) {
+            streamWriter->publish(records.data(), records.size());
+        }
+    }
+
+    ISTMSensorsCallback::onNewSensorsRecords(records);
+}
+
 /**
  * onSaveDataRequest: receive data to store,
  *                    reference: ISTMSensorsCallbackData class
@@ -148,3 +224,13 @@ int SensorsLinuxInterface::onLoadDataRequest(const std::string& resourceID,
 
     return 0;
 }
+
+/**
+ * onSensorsListChanged: sensors list changed after IIO devices hotplug,
+ *                       reference: ISTMSensorsCallback class
+ */
+void SensorsLinuxInterface::onSensorsListChanged(void)
+{
+    console.info("sensors list changed, " +
+                 std::to_string(getSensorsList().size()) + " sensors available");
+}
@@ -17,11 +17,15 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include <ISTMSensorsHAL.h>
 #include <IUtils.h>
 #include <PropertiesManager.h>
+#include <SensorsStreamWriter.h>
 
 using stm::core::ISTMSensorsHAL;
 using stm::core::ISTMSensorsCallback;
@@ -29,15 +33,20 @@ using stm::core::ISTMSensorsCallbackData;
 using stm::core::STMSensor;
 using stm::core::IConsole;
 using stm::core::PropertiesManager;
+using stm::core::STMSensorsRecordsLease;
 
 struct SensorsLinuxInterface : public ISTMSensorsCallback {
 public:
     SensorsLinuxInterface(void);
-    ~SensorsLinuxInterface(void) = default;
+    ~SensorsLinuxInterface(void);
 
     int initialize(void);
 
-    const std::vector<STMSensor>& getSensorsList(void) const;
+    int startStream(const std::string &socketPath, uint32_t slotsCount);
+
+    void stopStream(void);
+
+    std::vector<STMSensor> getSensorsList(void) const;
 
     int enable(uint32_t handle, bool enable);
 
@@ -49,10 +58,14 @@ public:
 
     void onNewSensorsData(const std::vector<ISTMSensorsCallbackData> &sensorsData) override;
 
+    void onNewSensorsRecords(STMSensorsRecordsLease &records) override;
+
     int onSaveDataRequest(const std::string& resourceID, const void *data, ssize_t len) override;
 
     int onLoadDataRequest(const std::string& resourceID, void *data, ssize_t len) override;
 
+    void onSensorsListChanged(void) override;
+
 private:
     /**
      * Core library object interface
@@ -65,4 +78,11 @@ private:
     IConsole &console;
 
     PropertiesManager& propertiesManager;
+
+    /**
+     * Shared memory stream of the sensors records, served on a unix socket
+     */
+    std::mutex streamLock;
+    std::unique_ptr<SensorsStreamWriter> streamWriter;
+    std::unique_ptr<SensorsStreamServer> streamServer;
 };
@@ -21,6 +21,7 @@
 #include <thread>
 #include <getopt.h>
 #include <regex>
+#include <iterator>
 #include <sstream>
 
 #include "SensorsLinuxInterface.h"
@@ -34,9 +35,13 @@ static option longopts[] = {
     { "listshort", no_argument, NULL, 'L' },
     { "timeout", required_argument, NULL, 't' },
     { "sensor", required_argument, NULL, 's' },
+    { "stream", required_argument, NULL, 'S' },
     { nullptr, no_argument, nullptr, 0 }
 };
-static const char *options = "hlLt:s:";
+static const char *options = "hlLt:s:S:";
+
+/* records in the shared memory ring of --stream */
+static const uint32_t streamSlotsCount = 4096;
 
 class sensor_test {
 public:
@@ -147,6 +152,8 @@ static void help(char *name)
     console.info("\t--sensor (-s):\t\tselect a sensor configuration");
     console.info("\t              \t\twhere a sensor configuration consists in a string:");
     console.info("\t              \t\t\"sensor=<type> odr=<odr> id=<instance> fullscale=<fs>\"");
+    console.info("\t--stream (-S):\t\tpublish the sensors records to a shared memory stream");
+    console.info("\t              \t\tserved on the given unix socket path");
     console.info("\t--help (-h):\t\tshow this help");
 }
 
@@ -224,6 +231,7 @@ int main(int argc, char** argv)
 {
     std::vector<sensor_test *> sensor_config_array;
     std::vector<std::string> sensor_options;
+    std::string streamPath;
     bool shortformat = false;
     bool getlist = false;
     int timeout = 1;
@@ -251,6 +259,9 @@ int main(int argc, char** argv)
                 std::cout << "Parametro s: " + std::string(optarg);
                 sensor_options.push_back(optarg);
                 break;
+            case 'S':
+                streamPath = optarg;
+                break;
             default:
                 help(argv[0]);
                 exit(0);
@@ -269,6 +280,19 @@ int main(int argc, char** argv)
     std::unique_ptr<SensorsLinuxInterface> sensors = std::make_unique<SensorsLinuxInterface>();
     int err;
 
+    /* started before the HAL so that readers get the first records */
+    if (!streamPath.empty()) {
+        err = sensors->startStream(streamPath, streamSlotsCount);
+        if (err < 0) {
+            console.error("failed to start sensors stream on " + streamPath +
+                          " (" + std::to_string(err) + ")");
+
+            return err;
+        }
+
+        console.info("sensors stream served on " + streamPath);
+    }
+
     err = sensors->initialize();
     if (err) {
         console.error("failed to initialize the sensors interface");
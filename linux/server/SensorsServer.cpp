@@ -0,0 +1,739 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <IConsole.h>
+
+#include "SensorsServer.h"
+
+using stm::core::IConsole;
+using stm::core::STMSensor;
+using stm::core::STMSensorsList;
+using stm::core::SensorType;
+
+static IConsole &console { IConsole::getInstance() };
+
+static constexpr int maxEpollEvents = 32;
+static constexpr int maxRequestsPerEvent = 16;
+
+SensorsServer::SensorsServer(ISTMSensorsHAL &hal)
+    : hal(hal),
+      listenFd(-1),
+      stopFd(-1),
+      flushFd(-1),
+      epollFd(-1),
+      lastToken(0),
+      lastClientId(0)
+{
+}
+
+SensorsServer::~SensorsServer(void)
+{
+    stop();
+}
+
+int SensorsServer::start(const std::string &socketPath)
+{
+    struct sockaddr_un addr;
+    uint64_t token;
+    int err;
+
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        return -ENAMETOOLONG;
+    }
+
+    stop();
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        return -errno;
+    }
+
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (stopFd < 0) {
+        err = -errno;
+        goto close_epoll_fd;
+    }
+
+    flushFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (flushFd < 0) {
+        err = -errno;
+        goto close_stop_fd;
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        err = -errno;
+        goto close_flush_fd;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    unlink(socketPath.c_str());
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        err = -errno;
+        goto close_listen_fd;
+    }
+    path = socketPath;
+
+    if (listen(listenFd, 16) < 0) {
+        err = -errno;
+        goto close_listen_fd;
+    }
+
+    err = addSource(listenFd, EPOLLIN, { SourceType::LISTEN, 0, 0 }, token);
+    if (err < 0) {
+        goto close_listen_fd;
+    }
+
+    err = addSource(stopFd, EPOLLIN, { SourceType::STOP, 0, 0 }, token);
+    if (err < 0) {
+        goto close_listen_fd;
+    }
+
+    err = addSource(flushFd, EPOLLIN, { SourceType::FLUSH, 0, 0 }, token);
+    if (err < 0) {
+        goto close_listen_fd;
+    }
+
+    err = hal.initialize(*this);
+    if (err < 0) {
+        console.error("failed to initialize sensors HAL");
+        goto close_listen_fd;
+    }
+
+    thread = std::make_unique<std::thread>(&SensorsServer::run, this);
+
+    return 0;
+
+close_listen_fd:
+    ::close(listenFd);
+    listenFd = -1;
+    if (!path.empty()) {
+        unlink(path.c_str());
+        path.clear();
+    }
+close_flush_fd:
+    ::close(flushFd);
+    flushFd = -1;
+close_stop_fd:
+    ::close(stopFd);
+    stopFd = -1;
+close_epoll_fd:
+    ::close(epollFd);
+    epollFd = -1;
+    sources.clear();
+
+    return err;
+}
+
+void SensorsServer::stop(void)
+{
+    uint64_t value = 1;
+
+    if (thread) {
+        (void)!write(stopFd, &value, sizeof(value));
+        thread->join();
+        thread.reset();
+    }
+
+    while (!clients.empty()) {
+        closeClient(clients.begin()->first);
+    }
+    flushes.clear();
+    sources.clear();
+
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        unlink(path.c_str());
+        path.clear();
+    }
+
+    if (stopFd >= 0) {
+        ::close(stopFd);
+        stopFd = -1;
+    }
+
+    {
+        /* HAL data thread may still report flush events */
+        std::lock_guard<std::mutex> lock(flushLock);
+
+        if (flushFd >= 0) {
+            ::close(flushFd);
+            flushFd = -1;
+        }
+        completedFlushes.clear();
+    }
+
+    if (epollFd >= 0) {
+        ::close(epollFd);
+        epollFd = -1;
+    }
+}
+
+void SensorsServer::onNewSensorsData(const std::vector<ISTMSensorsCallbackData> &sensorsData)
+{
+    (void) sensorsData;
+}
+
+/**
+ * onNewSensorsRecords: clients data is read from the subscriptions, only
+ *                      flush complete events are handled here
+ */
+void SensorsServer::onNewSensorsRecords(STMSensorsRecordsLease &records)
+{
+    uint64_t value = 1;
+    bool found = false;
+
+    std::lock_guard<std::mutex> lock(flushLock);
+
+    for (const auto &record : records) {
+        if (record.sensorType == SensorType::META_DATA) {
+            completedFlushes.push_back(record.sensorHandle);
+            found = true;
+        }
+    }
+
+    if (found && (flushFd >= 0)) {
+        (void)!write(flushFd, &value, sizeof(value));
+    }
+}
+
+int SensorsServer::onSaveDataRequest(const std::string &resourceID, const void *data, ssize_t len)
+{
+    (void) resourceID;
+    (void) data;
+    (void) len;
+
+    return 0;
+}
+
+int SensorsServer::onLoadDataRequest(const std::string &resourceID, void *data, ssize_t len)
+{
+    (void) resourceID;
+    (void) data;
+    (void) len;
+
+    return 0;
+}
+
+int SensorsServer::addSource(int fd, uint32_t events, const Source &source, uint64_t &token)
+{
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = ++lastToken;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        return -errno;
+    }
+
+    sources[event.data.u64] = source;
+    token = event.data.u64;
+
+    return 0;
+}
+
+void SensorsServer::removeSource(int fd, uint64_t token)
+{
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    sources.erase(token);
+}
+
+void SensorsServer::run(void)
+{
+    struct epoll_event events[maxEpollEvents];
+    int n;
+
+    while (true) {
+        n = epoll_wait(epollFd, events, maxEpollEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            console.error("sensors server event loop failed (" + std::to_string(errno) + ")");
+            return;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            auto src = sources.find(events[i].data.u64);
+            if (src == sources.end()) {
+                continue;
+            }
+
+            Source source = src->second;
+
+            switch (source.type) {
+            case SourceType::STOP:
+                return;
+            case SourceType::LISTEN:
+                acceptClient();
+                break;
+            case SourceType::FLUSH:
+                handleCompletedFlushes();
+                break;
+            case SourceType::CLIENT:
+            case SourceType::SUBSCRIPTION: {
+                auto itr = clients.find(source.clientId);
+                if (itr == clients.end()) {
+                    break;
+                }
+
+                Client &client = *itr->second;
+
+                if (source.type == SourceType::CLIENT) {
+                    handleClient(client, events[i].events);
+                } else if (client.pending.empty()) {
+                    drain(client, source.sensorHandle, false);
+                }
+
+                if (client.failed) {
+                    closeClient(client.id);
+                }
+                break;
+            }
+            }
+        }
+    }
+}
+
+void SensorsServer::acceptClient(void)
+{
+    std::unique_ptr<Client> client;
+    int fd;
+
+    while (true) {
+        fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        client = std::make_unique<Client>();
+        client->id = ++lastClientId;
+        client->fd = fd;
+        client->failed = false;
+        client->pendingBytes = 0;
+
+        if (addSource(fd, EPOLLIN, { SourceType::CLIENT, client->id, 0 }, client->token) < 0) {
+            ::close(fd);
+            continue;
+        }
+
+        clients[client->id] = std::move(client);
+    }
+}
+
+void SensorsServer::closeClient(uint32_t clientId)
+{
+    auto itr = clients.find(clientId);
+    if (itr == clients.end()) {
+        return;
+    }
+
+    Client &client = *itr->second;
+
+    for (auto &s : client.subscriptions) {
+        removeSource(s.second.subscription->getEventFd(), s.second.token);
+    }
+
+    removeSource(client.fd, client.token);
+    ::close(client.fd);
+
+    /* destroying the subscriptions updates the sensors configuration */
+    clients.erase(itr);
+}
+
+void SensorsServer::handleClient(Client &client, uint32_t events)
+{
+    SensorsServerRequest request;
+    ssize_t len;
+
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        client.failed = true;
+        return;
+    }
+
+    if (events & EPOLLOUT) {
+        flushPending(client);
+    }
+
+    if (!(events & EPOLLIN)) {
+        return;
+    }
+
+    for (int i = 0; (i < maxRequestsPerEvent) && !client.failed; ++i) {
+        len = recv(client.fd, &request, sizeof(request), MSG_DONTWAIT);
+        if (len < 0) {
+            if ((errno != EAGAIN) && (errno != EINTR)) {
+                client.failed = true;
+            }
+            return;
+        }
+
+        if (len == 0) {
+            client.failed = true;
+            return;
+        }
+
+        if ((size_t)len != sizeof(request)) {
+            SensorsServerMessageHeader header = {};
+
+            header.type = static_cast<uint32_t>(SensorsServerMessageType::REPLY);
+            header.result = -EINVAL;
+            send(client, header, nullptr, 0);
+            continue;
+        }
+
+        handleRequest(client, request);
+    }
+}
+
+void SensorsServer::handleRequest(Client &client, const SensorsServerRequest &request)
+{
+    SensorsServerMessageHeader header = {};
+
+    header.type = static_cast<uint32_t>(SensorsServerMessageType::REPLY);
+    header.sensorHandle = request.sensorHandle;
+
+    switch (static_cast<SensorsServerCommand>(request.command)) {
+    case SensorsServerCommand::GET_SENSORS:
+        /* replies with the sensors list */
+        getSensors(client);
+        return;
+    case SensorsServerCommand::SUBSCRIBE:
+        header.result = subscribe(client, request);
+        break;
+    case SensorsServerCommand::UNSUBSCRIBE:
+        header.result = unsubscribe(client, request.sensorHandle);
+        break;
+    case SensorsServerCommand::FLUSH:
+        header.result = flush(client, request.sensorHandle);
+        break;
+    default:
+        header.result = -EOPNOTSUPP;
+        break;
+    }
+
+    send(client, header, nullptr, 0);
+}
+
+int SensorsServer::getSensors(Client &client)
+{
+    const STMSensorsList sensorsList = hal.getSensorsList();
+    const std::vector<STMSensor> &list = sensorsList.getList();
+    std::vector<SensorsServerSensorInfo> infos;
+    SensorsServerMessageHeader header = {};
+
+    for (const auto &sensor : list) {
+        SensorsServerSensorInfo info = {};
+
+        if (infos.size() == sensorsServerMaxSensors) {
+            break;
+        }
+
+        info.handle = sensor.getHandle();
+        info.type = static_cast<uint16_t>(sensor.getType());
+        info.minRateHz = sensor.getMinRateHz();
+        info.maxRateHz = sensor.getMaxRateHz();
+        strncpy(info.name, sensor.getName().c_str(), sizeof(info.name) - 1);
+
+        infos.push_back(info);
+    }
+
+    header.type = static_cast<uint32_t>(SensorsServerMessageType::REPLY);
+    header.count = infos.size();
+    send(client, header, infos.data(), infos.size() * sizeof(SensorsServerSensorInfo));
+
+    return 0;
+}
+
+int SensorsServer::subscribe(Client &client, const SensorsServerRequest &request)
+{
+    const STMSensorsList sensorsList = hal.getSensorsList();
+    const std::vector<STMSensor> &list = sensorsList.getList();
+    size_t queueLength = request.queueLength ? request.queueLength : defaultQueueLength;
+    std::unique_ptr<ISTMSensorsSubscription> subscription;
+    ClientSubscription entry;
+    int64_t watermark = 1;
+    int err;
+
+    auto sensor = std::find_if(list.begin(), list.end(), [&request](const STMSensor &s) {
+        return s.getHandle() == request.sensorHandle;
+    });
+    if (sensor == list.end()) {
+        return -ENODEV;
+    }
+
+    if (queueLength > maxQueueLength) {
+        return -EINVAL;
+    }
+
+    /* the new subscription is added before the previous one is removed,
+     * so the sensor is not disabled in between */
+    err = hal.subscribe(request.sensorHandle, request.samplingPeriodNs,
+                        request.maxReportLatencyNs, queueLength, subscription);
+    if (err < 0) {
+        return err;
+    }
+
+    /* wake up the loop once per latency period */
+    if ((request.samplingPeriodNs > 0) && !sensor->isOnChange()) {
+        watermark = request.maxReportLatencyNs / request.samplingPeriodNs;
+        watermark = std::max<int64_t>(1, std::min<int64_t>(watermark, queueLength / 2));
+    }
+    subscription->setWatermark(watermark);
+
+    err = addSource(subscription->getEventFd(), EPOLLIN | EPOLLET,
+                    { SourceType::SUBSCRIPTION, client.id, request.sensorHandle }, entry.token);
+    if (err < 0) {
+        return err;
+    }
+
+    /* samples queued by the previous subscription are still delivered */
+    drain(client, request.sensorHandle, true);
+
+    auto itr = client.subscriptions.find(request.sensorHandle);
+    if (itr != client.subscriptions.end()) {
+        removeSource(itr->second.subscription->getEventFd(), itr->second.token);
+    }
+
+    entry.subscription = std::move(subscription);
+    client.subscriptions[request.sensorHandle] = std::move(entry);
+
+    return 0;
+}
+
+int SensorsServer::unsubscribe(Client &client, uint32_t sensorHandle)
+{
+    auto itr = client.subscriptions.find(sensorHandle);
+    if (itr == client.subscriptions.end()) {
+        return -ENOENT;
+    }
+
+    removeSource(itr->second.subscription->getEventFd(), itr->second.token);
+    client.subscriptions.erase(itr);
+
+    return 0;
+}
+
+int SensorsServer::flush(Client &client, uint32_t sensorHandle)
+{
+    int err;
+
+    if (client.subscriptions.find(sensorHandle) == client.subscriptions.end()) {
+        return -ENOENT;
+    }
+
+    err = hal.flushData(sensorHandle);
+    if (err < 0) {
+        return err;
+    }
+
+    flushes.push_back({ client.id, sensorHandle });
+
+    return 0;
+}
+
+void SensorsServer::handleCompletedFlushes(void)
+{
+    std::vector<uint32_t> completed;
+    uint64_t value;
+
+    {
+        std::lock_guard<std::mutex> lock(flushLock);
+
+        (void)!read(flushFd, &value, sizeof(value));
+        completed.swap(completedFlushes);
+    }
+
+    for (auto handle : completed) {
+        auto pos = std::find_if(flushes.begin(), flushes.end(), [handle](const PendingFlush &f) {
+            return f.sensorHandle == handle;
+        });
+        if (pos == flushes.end()) {
+            /* requested by another HAL client */
+            continue;
+        }
+
+        uint32_t clientId = pos->clientId;
+        flushes.erase(pos);
+
+        auto itr = clients.find(clientId);
+        if (itr == clients.end()) {
+            continue;
+        }
+
+        Client &client = *itr->second;
+        SensorsServerMessageHeader header = {};
+
+        /* samples before the flush event are sent before its completion */
+        drain(client, handle, true);
+
+        header.type = static_cast<uint32_t>(SensorsServerMessageType::FLUSH_COMPLETE);
+        header.sensorHandle = handle;
+        send(client, header, nullptr, 0);
+
+        if (client.failed) {
+            closeClient(clientId);
+        }
+    }
+}
+
+/**
+ * drain: send the samples queued in a subscription of the client
+ * @client: client.
+ * @sensorHandle: sensor handle of the subscription.
+ * @all: read the whole queue even if the client socket is full.
+ *
+ * The event file descriptor is edge triggered: the queue is read until it is
+ * empty (or closed), so that no later event is missed.
+ */
+void SensorsServer::drain(Client &client, uint32_t sensorHandle, bool all)
+{
+    SensorsServerMessageHeader header = {};
+    int n;
+
+    auto itr = client.subscriptions.find(sensorHandle);
+    if (itr == client.subscriptions.end()) {
+        return;
+    }
+
+    ISTMSensorsSubscription &subscription = *itr->second.subscription;
+
+    header.sensorHandle = sensorHandle;
+
+    while (!client.failed && (all || client.pending.empty())) {
+        n = subscription.read(records, sensorsServerMaxBatch);
+        if (n == -ENODEV) {
+            header.type = static_cast<uint32_t>(SensorsServerMessageType::SENSOR_REMOVED);
+            header.dropped = subscription.getDroppedSamples();
+            send(client, header, nullptr, 0);
+
+            removeSource(subscription.getEventFd(), itr->second.token);
+            client.subscriptions.erase(itr);
+            return;
+        }
+
+        if (n <= 0) {
+            return;
+        }
+
+        header.type = static_cast<uint32_t>(SensorsServerMessageType::DATA);
+        header.count = n;
+        header.dropped = subscription.getDroppedSamples();
+        send(client, header, records, n * sizeof(STMSensorsRecord));
+    }
+}
+
+void SensorsServer::flushPending(Client &client)
+{
+    struct epoll_event event;
+    ssize_t ret;
+
+    while (!client.pending.empty()) {
+        auto &message = client.pending.front();
+
+        ret = ::send(client.fd, message.data(), message.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (errno != EAGAIN) {
+                client.failed = true;
+            }
+            return;
+        }
+
+        client.pendingBytes -= message.size();
+        client.pending.pop_front();
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = client.token;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+
+    /* subscriptions were not read while the client was blocked */
+    for (auto itr = client.subscriptions.begin(); itr != client.subscriptions.end();) {
+        uint32_t handle = (itr++)->first;
+
+        drain(client, handle, false);
+    }
+}
+
+void SensorsServer::send(Client &client, const SensorsServerMessageHeader &header,
+                         const void *payload, size_t payloadLen)
+{
+    struct iovec iov[2] = {
+        { const_cast<SensorsServerMessageHeader *>(&header), sizeof(header) },
+        { const_cast<void *>(payload), payloadLen },
+    };
+    struct epoll_event event;
+    struct msghdr msg;
+    ssize_t ret;
+
+    if (client.failed) {
+        return;
+    }
+
+    if (client.pending.empty()) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = payloadLen ? 2 : 1;
+
+        ret = sendmsg(client.fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret >= 0) {
+            return;
+        }
+
+        if (errno != EAGAIN) {
+            client.failed = true;
+            return;
+        }
+
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.u64 = client.token;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+    }
+
+    if (client.pendingBytes + sizeof(header) + payloadLen > maxPendingBytes) {
+        console.warning("sensors server client " + std::to_string(client.id) +
+                        " is not reading, disconnecting");
+        client.failed = true;
+        return;
+    }
+
+    std::vector<uint8_t> message(sizeof(header) + payloadLen);
+    memcpy(message.data(), &header, sizeof(header));
+    if (payloadLen) {
+        memcpy(message.data() + sizeof(header), payload, payloadLen);
+    }
+
+    client.pendingBytes += message.size();
+    client.pending.push_back(std::move(message));
+}
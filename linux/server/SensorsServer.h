@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <ISTMSensorsHAL.h>
+#include <SensorsServerProtocol.h>
+
+using stm::core::ISTMSensorsCallback;
+using stm::core::ISTMSensorsCallbackData;
+using stm::core::ISTMSensorsHAL;
+using stm::core::ISTMSensorsSubscription;
+using stm::core::STMSensorsRecord;
+using stm::core::STMSensorsRecordsLease;
+
+/*
+ * Sensors server: owns the sensors HAL and serves local clients on a unix
+ * socket (SensorsServerProtocol.h). Each client subscription is a HAL
+ * subscription, so the HAL runs the sensors at the fastest rate requested
+ * by the clients and decimates the samples for each of them.
+ *
+ * A single thread runs the sockets and subscriptions event loop. Messages
+ * are sent without blocking: when a client socket is full its messages are
+ * kept until it becomes writable and its subscriptions are not read in the
+ * meantime, samples that do not fit the subscription queue are dropped and
+ * reported to the client.
+ */
+class SensorsServer : public ISTMSensorsCallback {
+public:
+    /* samples queued for each subscription when the client does not specify it */
+    static constexpr uint32_t defaultQueueLength = 1024;
+    static constexpr uint32_t maxQueueLength = 65536;
+
+    /* a client with more pending bytes than this is disconnected */
+    static constexpr size_t maxPendingBytes = 4 * 1024 * 1024;
+
+    explicit SensorsServer(ISTMSensorsHAL &hal);
+    ~SensorsServer(void);
+
+    SensorsServer(const SensorsServer &) = delete;
+    SensorsServer &operator=(const SensorsServer &) = delete;
+
+    /**
+     * start: initialize the HAL and start serving clients
+     * @socketPath: unix socket path, replaced if it exists.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int start(const std::string &socketPath);
+
+    /* disconnect the clients and stop serving */
+    void stop(void);
+
+    void onNewSensorsData(const std::vector<ISTMSensorsCallbackData> &sensorsData) override;
+    void onNewSensorsRecords(STMSensorsRecordsLease &records) override;
+    int onSaveDataRequest(const std::string &resourceID, const void *data, ssize_t len) override;
+    int onLoadDataRequest(const std::string &resourceID, void *data, ssize_t len) override;
+
+private:
+    enum class SourceType {
+        LISTEN,
+        STOP,
+        FLUSH,
+        CLIENT,
+        SUBSCRIPTION,
+    };
+
+    /* epoll registrations refer to a source by token, stale tokens are ignored */
+    struct Source {
+        SourceType type;
+        uint32_t clientId;
+        uint32_t sensorHandle;
+    };
+
+    struct ClientSubscription {
+        std::unique_ptr<ISTMSensorsSubscription> subscription;
+        uint64_t token;
+    };
+
+    struct Client {
+        uint32_t id;
+        int fd;
+        uint64_t token;
+        bool failed;
+        size_t pendingBytes;
+        std::deque<std::vector<uint8_t>> pending;
+        std::map<uint32_t, ClientSubscription> subscriptions;
+    };
+
+    struct PendingFlush {
+        uint32_t clientId;
+        uint32_t sensorHandle;
+    };
+
+    ISTMSensorsHAL &hal;
+
+    std::string path;
+    int listenFd;
+    int stopFd;
+    int flushFd;
+    int epollFd;
+    std::unique_ptr<std::thread> thread;
+
+    uint64_t lastToken;
+    uint32_t lastClientId;
+    std::unordered_map<uint64_t, Source> sources;
+    std::map<uint32_t, std::unique_ptr<Client>> clients;
+
+    /* flush requests sent to the HAL, completed in order for each sensor */
+    std::deque<PendingFlush> flushes;
+
+    /* flush completions received from the HAL data thread */
+    std::mutex flushLock;
+    std::vector<uint32_t> completedFlushes;
+
+    STMSensorsRecord records[sensorsServerMaxBatch];
+
+    void run(void);
+
+    int addSource(int fd, uint32_t events, const Source &source, uint64_t &token);
+    void removeSource(int fd, uint64_t token);
+
+    void acceptClient(void);
+    void closeClient(uint32_t clientId);
+    void handleClient(Client &client, uint32_t events);
+    void handleRequest(Client &client, const SensorsServerRequest &request);
+    void handleCompletedFlushes(void);
+
+    int getSensors(Client &client);
+    int subscribe(Client &client, const SensorsServerRequest &request);
+    int unsubscribe(Client &client, uint32_t sensorHandle);
+    int flush(Client &client, uint32_t sensorHandle);
+
+    void drain(Client &client, uint32_t sensorHandle, bool all);
+    void flushPending(Client &client);
+    void send(Client &client, const SensorsServerMessageHeader &header,
+              const void *payload, size_t payloadLen);
+};
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <csignal>
+#include <string>
+
+#include <getopt.h>
+#include <pthread.h>
+
+#include <IConsole.h>
+#include <IIORecorder.h>
+#include <PropertiesManager.h>
+
+#include "LinuxPropertiesLoader.h"
+#include "SensorsServer.h"
+
+using stm::core::IConsole;
+using stm::core::IIORecorder;
+using stm::core::PropertiesManager;
+
+static const std::string configFilename = "/etc/stm-sensors-hal/config";
+static const std::string defaultSocketPath = "/run/stm-sensors-server.sock";
+
+static IConsole &console = IConsole::getInstance();
+static option longopts[] = {
+    { "help", no_argument, NULL, 'h' },
+    { "socket", required_argument, NULL, 's' },
+    { "record", required_argument, NULL, 'r' },
+    { nullptr, no_argument, nullptr, 0 }
+};
+static const char *options = "hs:r:";
+
+static void help(char *name)
+{
+    console.info("Usage: " + std::string(name) + " [options]");
+    console.info("\t--socket (-s):\t\tunix socket path (default " + defaultSocketPath + ")");
+    console.info("\t--record (-r):\t\trecord the raw iio streams to file");
+    console.info("\t--help (-h):\t\tshow this help");
+}
+
+int main(int argc, char** argv)
+{
+    std::string socketPath = defaultSocketPath;
+    std::string recordPath;
+    LinuxPropertiesLoader linuxPropertiesLoader;
+    sigset_t signals;
+    int signal;
+    int err;
+
+    while (1) {
+        const int opt = getopt_long(argc, argv, options, longopts, 0);
+
+        if (opt == -1) {
+            break;
+        }
+
+        switch (opt) {
+            case 's':
+                socketPath = optarg;
+                break;
+            case 'r':
+                recordPath = optarg;
+                break;
+            default:
+                help(argv[0]);
+                exit(0);
+        }
+    }
+
+    /* signals are handled by sigwait, block them before any thread starts */
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    if (!linuxPropertiesLoader.loadFromConfigFile(configFilename)) {
+        PropertiesManager::getInstance().getMaxRanges(linuxPropertiesLoader);
+    }
+
+    /* started before the HAL so the whole session is recorded */
+    if (!recordPath.empty()) {
+        err = IIORecorder::getInstance().open(recordPath);
+        if (err < 0) {
+            console.error("failed to open iio recording " + recordPath +
+                          " (" + std::to_string(err) + ")");
+
+            return -err;
+        }
+    }
+
+    SensorsServer server(ISTMSensorsHAL::getInstance());
+
+    err = server.start(socketPath);
+    if (err < 0) {
+        console.error("failed to start sensors server on " + socketPath +
+                      " (" + std::to_string(err) + ")");
+        IIORecorder::getInstance().close();
+
+        return -err;
+    }
+
+    console.info("sensors server listening on " + socketPath);
+
+    sigwait(&signals, &signal);
+
+    server.stop();
+    IIORecorder::getInstance().close();
+
+    return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "SensorsServerClient.h"
+
+using stm::core::STMSensorsRecord;
+
+SensorsServerClient::SensorsServerClient(void)
+    : sock(-1),
+      buffer(sensorsServerMaxMessage)
+{
+}
+
+SensorsServerClient::~SensorsServerClient(void)
+{
+    disconnect();
+}
+
+int SensorsServerClient::connect(const std::string &socketPath)
+{
+    struct sockaddr_un addr;
+
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        return -ENAMETOOLONG;
+    }
+
+    disconnect();
+
+    sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        return -errno;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (::connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        int err = -errno;
+
+        close(sock);
+        sock = -1;
+
+        return err;
+    }
+
+    return 0;
+}
+
+void SensorsServerClient::disconnect(void)
+{
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+
+    events.clear();
+}
+
+/**
+ * receive: receive one message in buffer
+ * @timeoutNs: maximum time to wait in nanoseconds, negative waits forever.
+ * @len: received message length.
+ *
+ * Return value: 0 on success, else a negative error code.
+ */
+int SensorsServerClient::receive(int64_t timeoutNs, size_t &len)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(timeoutNs);
+    struct pollfd pfd = { sock, POLLIN, 0 };
+    ssize_t ret;
+    int timeoutMs;
+
+    if (sock < 0) {
+        return -ENOTCONN;
+    }
+
+    while (true) {
+        timeoutMs = -1;
+        if (timeoutNs >= 0) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 deadline - std::chrono::steady_clock::now()).count();
+            timeoutMs = (remaining > 0) ? remaining : 0;
+        }
+
+        ret = poll(&pfd, 1, timeoutMs);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (ret == 0) {
+            return -ETIMEDOUT;
+        }
+
+        ret = recv(sock, buffer.data(), buffer.size(), 0);
+        if (ret < 0) {
+            if ((errno == EINTR) || (errno == EAGAIN)) {
+                continue;
+            }
+            return -errno;
+        }
+        if (ret == 0) {
+            return -ECONNRESET;
+        }
+        if ((size_t)ret < sizeof(SensorsServerMessageHeader)) {
+            return -EPROTO;
+        }
+
+        len = ret;
+
+        return 0;
+    }
+}
+
+void SensorsServerClient::queueEvent(size_t len)
+{
+    SensorsServerMessageHeader header;
+    Event event;
+
+    memcpy(&header, buffer.data(), sizeof(header));
+
+    event.type = static_cast<SensorsServerMessageType>(header.type);
+    event.sensorHandle = header.sensorHandle;
+    event.dropped = header.dropped;
+
+    if (event.type == SensorsServerMessageType::DATA) {
+        size_t count = std::min<size_t>(header.count,
+                                        (len - sizeof(header)) / sizeof(STMSensorsRecord));
+
+        event.records.resize(count);
+        memcpy(static_cast<void *>(event.records.data()),
+               buffer.data() + sizeof(header), count * sizeof(STMSensorsRecord));
+    }
+
+    events.push_back(std::move(event));
+}
+
+/**
+ * request: send a request and wait for its reply (left in buffer)
+ *
+ * Return value: result of the request, else a negative error code.
+ */
+int SensorsServerClient::request(const SensorsServerRequest &request)
+{
+    SensorsServerMessageHeader header;
+    size_t len = 0;
+    int err;
+
+    if (sock < 0) {
+        return -ENOTCONN;
+    }
+
+    if (send(sock, &request, sizeof(request), MSG_NOSIGNAL) < 0) {
+        return -errno;
+    }
+
+    while (true) {
+        err = receive(-1, len);
+        if (err < 0) {
+            return err;
+        }
+
+        memcpy(&header, buffer.data(), sizeof(header));
+        if (header.type == static_cast<uint32_t>(SensorsServerMessageType::REPLY)) {
+            return header.result;
+        }
+
+        queueEvent(len);
+    }
+}
+
+int SensorsServerClient::getSensors(std::vector<SensorsServerSensorInfo> &sensors)
+{
+    SensorsServerRequest req = {};
+    SensorsServerMessageHeader header;
+    int err;
+
+    req.command = static_cast<uint32_t>(SensorsServerCommand::GET_SENSORS);
+
+    err = request(req);
+    if (err < 0) {
+        return err;
+    }
+
+    memcpy(&header, buffer.data(), sizeof(header));
+    sensors.resize(std::min<size_t>(header.count, sensorsServerMaxSensors));
+    memcpy(sensors.data(), buffer.data() + sizeof(header),
+           sensors.size() * sizeof(SensorsServerSensorInfo));
+
+    return 0;
+}
+
+int SensorsServerClient::subscribe(uint32_t sensorHandle,
+                                   int64_t samplingPeriodNs,
+                                   int64_t maxReportLatencyNs,
+                                   uint32_t queueLength)
+{
+    SensorsServerRequest req = {};
+
+    req.command = static_cast<uint32_t>(SensorsServerCommand::SUBSCRIBE);
+    req.sensorHandle = sensorHandle;
+    req.samplingPeriodNs = samplingPeriodNs;
+    req.maxReportLatencyNs = maxReportLatencyNs;
+    req.queueLength = queueLength;
+
+    return request(req);
+}
+
+int SensorsServerClient::unsubscribe(uint32_t sensorHandle)
+{
+    SensorsServerRequest req = {};
+
+    req.command = static_cast<uint32_t>(SensorsServerCommand::UNSUBSCRIBE);
+    req.sensorHandle = sensorHandle;
+
+    return request(req);
+}
+
+int SensorsServerClient::flush(uint32_t sensorHandle)
+{
+    SensorsServerRequest req = {};
+
+    req.command = static_cast<uint32_t>(SensorsServerCommand::FLUSH);
+    req.sensorHandle = sensorHandle;
+
+    return request(req);
+}
+
+int SensorsServerClient::readEvent(Event &event, int64_t timeoutNs)
+{
+    size_t len = 0;
+    int err;
+
+    while (events.empty()) {
+        err = receive(timeoutNs, len);
+        if (err < 0) {
+            return err;
+        }
+
+        /* replies are only expected by request */
+        queueEvent(len);
+        if (events.back().type == SensorsServerMessageType::REPLY) {
+            events.pop_back();
+        }
+    }
+
+    event = std::move(events.front());
+    events.pop_front();
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "SensorsServerProtocol.h"
+
+/*
+ * Client of stm-sensors-server. Requests are synchronous, messages received
+ * while waiting for a reply are kept for readEvent. Not thread safe.
+ */
+class SensorsServerClient {
+public:
+    struct Event {
+        SensorsServerMessageType type;
+        uint32_t sensorHandle;
+        uint64_t dropped;
+        std::vector<stm::core::STMSensorsRecord> records;
+    };
+
+    SensorsServerClient(void);
+    ~SensorsServerClient(void);
+
+    SensorsServerClient(const SensorsServerClient &) = delete;
+    SensorsServerClient &operator=(const SensorsServerClient &) = delete;
+
+    /**
+     * connect: connect to the server
+     * @socketPath: unix socket path of the server.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int connect(const std::string &socketPath);
+
+    void disconnect(void);
+
+    /**
+     * getSensors: retrieve the sensors served
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int getSensors(std::vector<SensorsServerSensorInfo> &sensors);
+
+    /**
+     * subscribe: start (or update) a subscription of the client
+     * @sensorHandle: sensor handle (from getSensors).
+     * @samplingPeriodNs: requested sensor data period in nanoseconds.
+     * @maxReportLatencyNs: requested maximum reporting latency in nanoseconds.
+     * @queueLength: samples queued by the server for the client, 0 for default.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int subscribe(uint32_t sensorHandle,
+                  int64_t samplingPeriodNs,
+                  int64_t maxReportLatencyNs,
+                  uint32_t queueLength = 0);
+
+    int unsubscribe(uint32_t sensorHandle);
+
+    /**
+     * flush: request the queued data of a subscribed sensor, a FLUSH_COMPLETE
+     *        event follows its data
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int flush(uint32_t sensorHandle);
+
+    /**
+     * readEvent: next DATA, FLUSH_COMPLETE or SENSOR_REMOVED event
+     * @event: received event.
+     * @timeoutNs: maximum time to wait in nanoseconds, negative waits forever.
+     *
+     * Return value: 0 on success, -ETIMEDOUT, else a negative error code.
+     */
+    int readEvent(Event &event, int64_t timeoutNs);
+
+    /* socket, readable when a message is available (poll / epoll) */
+    int getFd(void) const { return sock; }
+
+private:
+    int sock;
+    std::vector<uint8_t> buffer;
+    std::deque<Event> events;
+
+    int request(const SensorsServerRequest &request);
+    int receive(int64_t timeoutNs, size_t &len);
+    void queueEvent(size_t len);
+};
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <STMSensorsRecords.h>
+
+/*
+ * stm-sensors-server protocol, unix SOCK_SEQPACKET socket: one request or
+ * one message per packet. Requests are answered in order with a REPLY,
+ * DATA / FLUSH_COMPLETE / SENSOR_REMOVED messages are sent asynchronously
+ * for the subscriptions of the client.
+ */
+
+enum class SensorsServerCommand : uint32_t {
+    GET_SENSORS = 1,
+    SUBSCRIBE = 2,
+    UNSUBSCRIBE = 3,
+    FLUSH = 4,
+};
+
+enum class SensorsServerMessageType : uint32_t {
+    REPLY = 1,
+    DATA = 2,
+    FLUSH_COMPLETE = 3,
+    SENSOR_REMOVED = 4,
+};
+
+struct SensorsServerRequest {
+    uint32_t command;
+    uint32_t sensorHandle;
+    int64_t samplingPeriodNs;
+    int64_t maxReportLatencyNs;
+
+    /* samples queued by the server for the client, 0 for default */
+    uint32_t queueLength;
+    uint32_t reserved;
+};
+
+/*
+ * Header of each server message:
+ *  - REPLY: result of the request, followed by count SensorsServerSensorInfo
+ *           for GET_SENSORS
+ *  - DATA: followed by count STMSensorsRecord of sensorHandle, dropped is the
+ *          number of samples dropped so far because the client was too slow
+ */
+struct SensorsServerMessageHeader {
+    uint32_t type;
+    uint32_t sensorHandle;
+    uint32_t count;
+    int32_t result;
+    uint64_t dropped;
+};
+
+struct SensorsServerSensorInfo {
+    uint32_t handle;
+    uint16_t type;
+    uint16_t reserved;
+    float minRateHz;
+    float maxRateHz;
+    char name[64];
+};
+
+/* records in a DATA message */
+static constexpr size_t sensorsServerMaxBatch = 256;
+
+/* largest message: GET_SENSORS reply or full DATA batch */
+static constexpr size_t sensorsServerMaxSensors = 256;
+static constexpr size_t sensorsServerMaxMessage =
+    sizeof(SensorsServerMessageHeader) +
+    ((sensorsServerMaxBatch * sizeof(stm::core::STMSensorsRecord) >
+      sensorsServerMaxSensors * sizeof(SensorsServerSensorInfo)) ?
+     sensorsServerMaxBatch * sizeof(stm::core::STMSensorsRecord) :
+     sensorsServerMaxSensors * sizeof(SensorsServerSensorInfo));
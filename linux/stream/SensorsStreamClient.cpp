@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "SensorsStreamClient.h"
+
+using stm::core::STMSensorsRecord;
+
+SensorsStreamClient::SensorsStreamClient(void)
+    : size(0),
+      slotsCount(0),
+      header(nullptr),
+      slots(nullptr),
+      readIndex(0),
+      lostRecords(0)
+{
+}
+
+SensorsStreamClient::~SensorsStreamClient(void)
+{
+    disconnect();
+}
+
+int SensorsStreamClient::connect(const std::string &socketPath)
+{
+    SensorsStreamHello hello;
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { &hello, sizeof(hello) };
+    struct sockaddr_un addr;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    int sock, fd = -1, err;
+    ssize_t len;
+
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        return -ENAMETOOLONG;
+    }
+
+    disconnect();
+
+    sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        return -errno;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (::connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        err = -errno;
+        goto close_sock;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    do {
+        len = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while ((len < 0) && (errno == EINTR));
+
+    if (len < 0) {
+        err = -errno;
+        goto close_sock;
+    }
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if ((cmsg != nullptr) && (cmsg->cmsg_level == SOL_SOCKET) &&
+        (cmsg->cmsg_type == SCM_RIGHTS) && (cmsg->cmsg_len == CMSG_LEN(sizeof(int)))) {
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+
+    if ((len != sizeof(hello)) || (fd < 0)) {
+        err = -EPROTO;
+        goto close_fd;
+    }
+
+    if ((hello.magic != sensorsStreamMagic) || (hello.version != sensorsStreamVersion)) {
+        err = -EPROTONOSUPPORT;
+        goto close_fd;
+    }
+
+    err = map(fd, hello.slotsCount);
+
+close_fd:
+    if (fd >= 0) {
+        close(fd);
+    }
+close_sock:
+    close(sock);
+
+    return err;
+}
+
+int SensorsStreamClient::map(int fd, uint32_t slotsCount)
+{
+    struct stat st;
+    void *addr;
+
+    if ((slotsCount == 0) || (slotsCount & (slotsCount - 1))) {
+        return -EPROTO;
+    }
+
+    size = sensorsStreamSize(slotsCount);
+
+    /* ring is sealed by the writer, size can not change after this check */
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size != size)) {
+        return -EPROTO;
+    }
+
+    addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        return -errno;
+    }
+
+    header = static_cast<const SensorsStreamHeader *>(addr);
+    if ((header->magic != sensorsStreamMagic) || (header->slotsCount != slotsCount) ||
+        (header->slotSize != sizeof(SensorsStreamSlot))) {
+        munmap(addr, size);
+        header = nullptr;
+        return -EPROTO;
+    }
+
+    slots = reinterpret_cast<const SensorsStreamSlot *>(header + 1);
+    this->slotsCount = slotsCount;
+    readIndex = header->writeIndex.load(std::memory_order_acquire);
+    lostRecords = 0;
+
+    return 0;
+}
+
+void SensorsStreamClient::disconnect(void)
+{
+    if (header != nullptr) {
+        munmap(const_cast<SensorsStreamHeader *>(header), size);
+        header = nullptr;
+        slots = nullptr;
+    }
+}
+
+int SensorsStreamClient::read(STMSensorsRecord *records, size_t maxRecords)
+{
+    uint32_t buffer[SensorsStreamSlot::numWords];
+    uint64_t writeIndex, s0, s1;
+    size_t n = 0;
+
+    if (header == nullptr) {
+        return -ENOTCONN;
+    }
+
+    writeIndex = header->writeIndex.load(std::memory_order_acquire);
+
+    while ((n < maxRecords) && (readIndex < writeIndex)) {
+        /* lapped by the writer, oldest available record */
+        if (writeIndex - readIndex > slotsCount) {
+            lostRecords += writeIndex - slotsCount - readIndex;
+            readIndex = writeIndex - slotsCount;
+        }
+
+        const SensorsStreamSlot &slot = slots[readIndex & (slotsCount - 1)];
+
+        s0 = slot.seq.load(std::memory_order_acquire);
+        for (size_t w = 0; w < SensorsStreamSlot::numWords; ++w) {
+            buffer[w] = slot.words[w].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        s1 = slot.seq.load(std::memory_order_relaxed);
+
+        if ((s0 != 2 * (readIndex + 1)) || (s0 != s1)) {
+            /* slot reused while reading it */
+            lostRecords++;
+            readIndex++;
+            writeIndex = header->writeIndex.load(std::memory_order_acquire);
+            continue;
+        }
+
+        memcpy(static_cast<void *>(&records[n++]), buffer, sizeof(STMSensorsRecord));
+        readIndex++;
+    }
+
+    if ((n == 0) && header->closed.load(std::memory_order_acquire) &&
+        (readIndex >= header->writeIndex.load(std::memory_order_acquire))) {
+        return -EPIPE;
+    }
+
+    return n;
+}
+
+int SensorsStreamClient::wait(int64_t timeoutNs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(timeoutNs);
+
+    if (header == nullptr) {
+        return -ENOTCONN;
+    }
+
+    while (true) {
+        uint32_t wakeup = header->wakeup.load(std::memory_order_seq_cst);
+        struct timespec ts, *timeout = nullptr;
+
+        if (readIndex < header->writeIndex.load(std::memory_order_acquire)) {
+            return 0;
+        }
+
+        if (header->closed.load(std::memory_order_acquire)) {
+            return -EPIPE;
+        }
+
+        if (timeoutNs >= 0) {
+            auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                return -ETIMEDOUT;
+            }
+
+            ts.tv_sec = remaining / 1000000000LL;
+            ts.tv_nsec = remaining % 1000000000LL;
+            timeout = &ts;
+        }
+
+        syscall(SYS_futex, &header->wakeup, FUTEX_WAIT, wakeup, timeout, nullptr, 0);
+    }
+}
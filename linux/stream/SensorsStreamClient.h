@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "SensorsStreamFormat.h"
+
+/*
+ * Reader side of the sensors stream, the ring is mapped read-only. Reading
+ * starts from the records published after connect, if the writer laps the
+ * reader the overwritten records are skipped and counted as lost.
+ */
+class SensorsStreamClient {
+public:
+    SensorsStreamClient(void);
+    ~SensorsStreamClient(void);
+
+    SensorsStreamClient(const SensorsStreamClient &) = delete;
+    SensorsStreamClient &operator=(const SensorsStreamClient &) = delete;
+
+    /**
+     * connect: receive and map the stream of a server
+     * @socketPath: unix socket path of the server.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int connect(const std::string &socketPath);
+
+    void disconnect(void);
+
+    /**
+     * read: copy the available records, never blocks
+     * @records: destination array.
+     * @maxRecords: maximum number of records to read.
+     *
+     * Return value: number of records read, -EPIPE if the stream ended and
+     *               all records were read, -ENOTCONN if not connected.
+     */
+    int read(stm::core::STMSensorsRecord *records, size_t maxRecords);
+
+    /**
+     * wait: wait for records to read
+     * @timeoutNs: maximum time to wait in nanoseconds, negative waits forever.
+     *
+     * Return value: 0 if records are available, -ETIMEDOUT, -EPIPE if the
+     *               stream ended, -ENOTCONN if not connected.
+     */
+    int wait(int64_t timeoutNs);
+
+    /* records overwritten by the writer before being read */
+    uint64_t getLostRecords(void) const { return lostRecords; }
+
+private:
+    size_t size;
+    uint32_t slotsCount;
+    const SensorsStreamHeader *header;
+    const SensorsStreamSlot *slots;
+    uint64_t readIndex;
+    uint64_t lostRecords;
+
+    int map(int fd, uint32_t slotsCount);
+};
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <STMSensorsRecords.h>
+
+/*
+ * Layout of the shared memory sensors stream: a header followed by a power
+ * of two number of slots, written by one process and read by any number of
+ * processes. Each slot is a sequence lock tagged with the index of the
+ * record it holds, readers detect overruns by themselves comparing the
+ * slot sequence with the index they expect, the writer never waits for
+ * them. Record payload is stored as relaxed atomic words as in SeqLock.h.
+ */
+
+static constexpr uint32_t sensorsStreamMagic = 0x53544d53; /* "STMS" */
+static constexpr uint32_t sensorsStreamVersion = 1;
+
+struct SensorsStreamHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotsCount;
+    uint32_t slotSize;
+
+    /* records published, index of the next record */
+    alignas(64) std::atomic<uint64_t> writeIndex;
+
+    /* futex word, incremented after each publish */
+    std::atomic<uint32_t> wakeup;
+
+    /* writer gone, no more records */
+    std::atomic<uint32_t> closed;
+};
+
+struct SensorsStreamSlot {
+    static constexpr size_t numWords =
+        (sizeof(stm::core::STMSensorsRecord) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    /* 2 * (index + 1) when the record of index is valid, odd while written */
+    std::atomic<uint64_t> seq;
+    std::array<std::atomic<uint32_t>, numWords> words;
+};
+
+static_assert((ATOMIC_LLONG_LOCK_FREE == 2) && (ATOMIC_INT_LOCK_FREE == 2),
+              "shared memory atomics must be lock free");
+
+/* sent with the stream file descriptor to each connected client */
+struct SensorsStreamHello {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotsCount;
+    uint32_t reserved;
+};
+
+static inline size_t sensorsStreamSize(uint32_t slotsCount)
+{
+    return sizeof(SensorsStreamHeader) + (size_t)slotsCount * sizeof(SensorsStreamSlot);
+}
+
+static inline SensorsStreamSlot *sensorsStreamSlots(SensorsStreamHeader *header)
+{
+    return reinterpret_cast<SensorsStreamSlot *>(header + 1);
+}
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "SensorsStreamWriter.h"
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+using stm::core::STMSensorsRecord;
+
+SensorsStreamWriter::SensorsStreamWriter(void)
+    : fd(-1),
+      readOnlyFd(-1),
+      size(0),
+      slotsCount(0),
+      header(nullptr),
+      slots(nullptr)
+{
+}
+
+SensorsStreamWriter::~SensorsStreamWriter(void)
+{
+    close();
+}
+
+int SensorsStreamWriter::open(uint32_t slotsCount)
+{
+    std::string roPath;
+    void *addr;
+    int err;
+
+    if ((slotsCount == 0) || (slotsCount & (slotsCount - 1))) {
+        return -EINVAL;
+    }
+
+    close();
+
+    size = sensorsStreamSize(slotsCount);
+
+    fd = memfd_create("stm-sensors-stream", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    if (ftruncate(fd, size) < 0) {
+        err = -errno;
+        goto close_fd;
+    }
+
+    /* readers can not resize it under the writer */
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) < 0) {
+        err = -errno;
+        goto close_fd;
+    }
+
+    roPath = "/proc/self/fd/" + std::to_string(fd);
+    readOnlyFd = ::open(roPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (readOnlyFd < 0) {
+        err = -errno;
+        goto close_fd;
+    }
+
+    addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        err = -errno;
+        goto close_ro_fd;
+    }
+
+    /*
+     * the writer mapping is the only writable one: a reader reopening its
+     * descriptor read-write (/proc/<pid>/fd) can not map the ring writable
+     * nor write it. F_SEAL_WRITE would fail with the writer mapping in place.
+     */
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_FUTURE_WRITE | F_SEAL_SEAL) < 0) {
+        err = -errno;
+        goto unmap;
+    }
+
+    /* memfd is zero filled: no valid slot */
+    header = new (addr) SensorsStreamHeader;
+    header->magic = sensorsStreamMagic;
+    header->version = sensorsStreamVersion;
+    header->slotsCount = slotsCount;
+    header->slotSize = sizeof(SensorsStreamSlot);
+    header->writeIndex.store(0, std::memory_order_relaxed);
+    header->wakeup.store(0, std::memory_order_relaxed);
+    header->closed.store(0, std::memory_order_release);
+
+    slots = sensorsStreamSlots(header);
+    this->slotsCount = slotsCount;
+
+    return 0;
+
+unmap:
+    munmap(addr, size);
+close_ro_fd:
+    ::close(readOnlyFd);
+    readOnlyFd = -1;
+close_fd:
+    ::close(fd);
+    fd = -1;
+
+    return err;
+}
+
+void SensorsStreamWriter::close(void)
+{
+    if (header != nullptr) {
+        header->closed.store(1, std::memory_order_release);
+        header->wakeup.fetch_add(1, std::memory_order_seq_cst);
+        syscall(SYS_futex, &header->wakeup, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+
+        munmap(header, size);
+        header = nullptr;
+        slots = nullptr;
+    }
+
+    if (readOnlyFd >= 0) {
+        ::close(readOnlyFd);
+        readOnlyFd = -1;
+    }
+
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+
+    slotsCount = 0;
+}
+
+void SensorsStreamWriter::publish(const STMSensorsRecord *records, size_t count)
+{
+    uint32_t buffer[SensorsStreamSlot::numWords];
+    uint64_t index;
+
+    if ((header == nullptr) || (count == 0)) {
+        return;
+    }
+
+    index = header->writeIndex.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < count; ++i, ++index) {
+        SensorsStreamSlot &slot = slots[index & (slotsCount - 1)];
+
+        memset(buffer, 0, sizeof(buffer));
+        memcpy(buffer, &records[i], sizeof(STMSensorsRecord));
+
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t w = 0; w < SensorsStreamSlot::numWords; ++w) {
+            slot.words[w].store(buffer[w], std::memory_order_relaxed);
+        }
+
+        slot.seq.store(2 * (index + 1), std::memory_order_release);
+    }
+
+    header->writeIndex.store(index, std::memory_order_release);
+    header->wakeup.fetch_add(1, std::memory_order_seq_cst);
+    syscall(SYS_futex, &header->wakeup, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+SensorsStreamServer::SensorsStreamServer(const SensorsStreamWriter &writer)
+    : writer(writer),
+      listenFd(-1),
+      stopFd(-1)
+{
+}
+
+SensorsStreamServer::~SensorsStreamServer(void)
+{
+    stop();
+}
+
+int SensorsStreamServer::start(const std::string &socketPath)
+{
+    struct sockaddr_un addr;
+    int err;
+
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        return -ENAMETOOLONG;
+    }
+
+    stop();
+
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (stopFd < 0) {
+        return -errno;
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        err = -errno;
+        goto close_stop_fd;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    unlink(socketPath.c_str());
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        err = -errno;
+        goto close_listen_fd;
+    }
+
+    if (listen(listenFd, 8) < 0) {
+        err = -errno;
+        goto unlink_path;
+    }
+
+    path = socketPath;
+    thread = std::make_unique<std::thread>(&SensorsStreamServer::run, this);
+
+    return 0;
+
+unlink_path:
+    unlink(socketPath.c_str());
+close_listen_fd:
+    ::close(listenFd);
+    listenFd = -1;
+close_stop_fd:
+    ::close(stopFd);
+    stopFd = -1;
+
+    return err;
+}
+
+void SensorsStreamServer::stop(void)
+{
+    uint64_t value = 1;
+
+    if (thread) {
+        (void)!write(stopFd, &value, sizeof(value));
+        thread->join();
+        thread.reset();
+    }
+
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        unlink(path.c_str());
+    }
+
+    if (stopFd >= 0) {
+        ::close(stopFd);
+        stopFd = -1;
+    }
+}
+
+void SensorsStreamServer::run(void)
+{
+    struct pollfd fds[2] = {
+        { listenFd, POLLIN, 0 },
+        { stopFd, POLLIN, 0 },
+    };
+
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        if (fds[1].revents) {
+            return;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int clientFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (clientFd >= 0) {
+                sendStream(clientFd);
+                ::close(clientFd);
+            }
+        }
+    }
+}
+
+void SensorsStreamServer::sendStream(int clientFd)
+{
+    SensorsStreamHello hello = { sensorsStreamMagic, sensorsStreamVersion, writer.getSlotsCount(), 0 };
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { &hello, sizeof(hello) };
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    int fd = writer.getReadOnlyFd();
+
+    if (fd < 0) {
+        return;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    memset(control, 0, sizeof(control));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    sendmsg(clientFd, &msg, MSG_NOSIGNAL);
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * Copyright (C) 2025 STMicroelectronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "SensorsStreamFormat.h"
+
+/*
+ * Writer side of the sensors stream: memfd backed ring, sealed against
+ * resizing and against writes other than through the writer mapping,
+ * readers receive a read-only descriptor of it.
+ */
+class SensorsStreamWriter {
+public:
+    SensorsStreamWriter(void);
+    ~SensorsStreamWriter(void);
+
+    SensorsStreamWriter(const SensorsStreamWriter &) = delete;
+    SensorsStreamWriter &operator=(const SensorsStreamWriter &) = delete;
+
+    /**
+     * open: create the shared memory ring
+     * @slotsCount: number of records in the ring, power of two.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int open(uint32_t slotsCount);
+
+    /**
+     * close: notify readers that the stream ended and release the ring
+     */
+    void close(void);
+
+    /**
+     * publish: append records to the ring, never blocks, single writer
+     * @records: records to publish.
+     * @count: number of records.
+     */
+    void publish(const stm::core::STMSensorsRecord *records, size_t count);
+
+    /* read-only descriptor to share with readers, -1 if not open */
+    int getReadOnlyFd(void) const { return readOnlyFd; }
+
+    uint32_t getSlotsCount(void) const { return slotsCount; }
+
+private:
+    int fd;
+    int readOnlyFd;
+    size_t size;
+    uint32_t slotsCount;
+    SensorsStreamHeader *header;
+    SensorsStreamSlot *slots;
+};
+
+/*
+ * Unix socket server of a sensors stream: each connected client receives
+ * the stream descriptor (SCM_RIGHTS) and the connection is closed, readers
+ * then only use the shared memory.
+ */
+class SensorsStreamServer {
+public:
+    SensorsStreamServer(const SensorsStreamWriter &writer);
+    ~SensorsStreamServer(void);
+
+    SensorsStreamServer(const SensorsStreamServer &) = delete;
+    SensorsStreamServer &operator=(const SensorsStreamServer &) = delete;
+
+    /**
+     * start: listen for clients
+     * @socketPath: unix socket path, replaced if it exists.
+     *
+     * Return value: 0 on success, else a negative error code.
+     */
+    int start(const std::string &socketPath);
+
+    void stop(void);
+
+private:
+    const SensorsStreamWriter &writer;
+    std::string path;
+    int listenFd;
+    int stopFd;
+    std::unique_ptr<std::thread> thread;
+
+    void run(void);
+    void sendStream(int clientFd);
+};
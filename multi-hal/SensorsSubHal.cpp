@@ -69,14 +69,15 @@ Return<void> SensorsSubHalBase<SubHalClass>::getSensorsList_(V2_1::ISensors::get
     }
 
     /* load must be called after sensor core initialization because needs sensor list */
-    propertiesManager.load(androidPropertiesLoader, sensorsCore.getSensorsList());
+    coreSensorsList = sensorsCore.getSensorsList();
+    propertiesManager.load(androidPropertiesLoader, coreSensorsList);
 
-    const std::vector<::stm::core::STMSensor> &list = sensorsCore.getSensorsList().getList();
+    const std::vector<::stm::core::STMSensor> &list = coreSensorsList.getList();
     hidl_vec<V2_1::SensorInfo> sensorsList(list.size());
     size_t n = 0, count = list.size();
 
     sensorsList.resize(count);
-    addInfoMng = std::make_unique<AdditionalInfoManager>(sensorsCore.getSensorsList());
+    addInfoMng = std::make_unique<AdditionalInfoManager>(coreSensorsList);
 
     for (size_t i = 0; i < count; i++) {
         if (convertFromSTMSensor(list.at(i), &sensorsList[n])) {
@@ -109,6 +110,7 @@ Return<V1_0::Result> SensorsSubHalBase<SubHalClass>::initialize(std::unique_ptr<
             return V1_0::Result::BAD_VALUE;
         }
 
+        coreSensorsList = sensorsCore.getSensorsList();
         initializedOnce = true;
     }
 
@@ -425,12 +427,10 @@ void SensorsSubHalBase<SubHalClass>::onNewSensorsData(const std::vector<ISTMSens
             if (sensor->isOnChange()) {
                 eventsList.push_back(event);
             } else {
-                auto channelsHandles =
-                    mSensorProxyMngr.getValidPushChannels(sdata.getTimestamp(),
-                                                          sdata.getSensorHandle(),
-                                                          sensorCurrentPollrateNs[sdata.getSensorHandle()]);
-
-                for (auto &channel : channelsHandles) {
+                mSensorProxyMngr.forEachValidPushChannel(sdata.getTimestamp(),
+                                                         sdata.getSensorHandle(),
+                                                         sensorCurrentPollrateNs[sdata.getSensorHandle()],
+                                                         [&](int32_t channel) {
                     if (channel == frameworkChHandle) {
                         eventsList.push_back(event);
                     } else {
@@ -439,7 +439,7 @@ void SensorsSubHalBase<SubHalClass>::onNewSensorsData(const std::vector<ISTMSens
                             mDirectChannelBufferLock.unlock();
                         }
                     }
-                }
+                });
             }
         }
     }
@@ -508,7 +508,7 @@ void SensorsSubHalBase<SubHalClass>::postEvents(const std::vector<V2_1::Event>&
 template <class SubHalClass>
 const ::stm::core::STMSensor *SensorsSubHalBase<SubHalClass>::getSTMSensor(int32_t sensorHandle) const
 {
-    const std::vector<::stm::core::STMSensor>& list = sensorsCore.getSensorsList().getList();
+    const std::vector<::stm::core::STMSensor>& list = coreSensorsList.getList();
 
     for (const auto &sensor : list) {
         if ((int32_t)sensor.getHandle() == sensorHandle) {
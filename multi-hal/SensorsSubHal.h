@@ -113,6 +113,11 @@ private:
 
     PropertiesManager& propertiesManager;
 
+    /**
+     * Sensors list of the core, copied at initialization
+     */
+    ::stm::core::STMSensorsList coreSensorsList;
+
     /**
      * Sensors additional info manager
      */